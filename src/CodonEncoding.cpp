@@ -0,0 +1,48 @@
+#include "include/CodonEncoding.h"
+
+
+// out of class definitions, needed by C++11 when the tables are used at run time
+constexpr unsigned GeneticCode::numCodons;
+constexpr unsigned GeneticCode::maxNumAA;
+constexpr unsigned GeneticCode::maxCodonsPerAA;
+constexpr unsigned GeneticCode::invalidNucleotide;
+constexpr unsigned GeneticCode::invalidCodon;
+constexpr unsigned GeneticCode::invalidAA;
+constexpr GeneticCode CodonEncoding::standardCode;
+
+const GeneticCode *CodonEncoding::active = &CodonEncoding::standardCode;
+GeneticCode CodonEncoding::selected;
+
+
+static_assert(CodonEncoding::standardCode.codonIndex("GCA") == 0u && CodonEncoding::standardCode.codonIndex("TGA") == 63u,
+	"codon indices must follow SequenceSummary::codonArray");
+static_assert(CodonEncoding::standardCode.codonIndex("ugg") == 56u &&
+	CodonEncoding::standardCode.codonIndex("GNA") == GeneticCode::invalidCodon,
+	"lower case and U must be accepted, unknown nucleotides rejected");
+static_assert(CodonEncoding::standardCode.codonToAAIndex(CodonEncoding::standardCode.codonIndex("AGT")) ==
+	CodonEncoding::standardCode.aaIndex('Z'), "AGC and AGT must code for the second serine");
+static_assert(CodonEncoding::standardCode.parameterToCodonIndex(CodonEncoding::standardCode.codonToParameterIndex(59u))
+	== 59u, "parameter and codon indices must be inverse");
+static_assert(CodonEncoding::standardCode.aaCodonEnd(CodonEncoding::standardCode.aaIndex('X')) == GeneticCode::numCodons
+	&& CodonEncoding::standardCode.aaParameterEnd(CodonEncoding::standardCode.aaIndex('X')) ==
+	CodonEncoding::standardCode.numParameterCodons && CodonEncoding::standardCode.numSenseCodons() == 61u,
+	"amino acid ranges must cover all codons");
+
+
+/* setActiveCode (NOT EXPOSED)
+ * Arguments: genetic code
+ * Copies the code and makes it the one used by all lookups. Table 1 selects standardCode itself, which keeps the fast
+ * paths.
+*/
+void CodonEncoding::setActiveCode(const GeneticCode &code)
+{
+	if (code.tableId == standardCode.tableId)
+	{
+		active = &standardCode;
+	}
+	else
+	{
+		selected = code;
+		active = &selected;
+	}
+}
@@ -1,4 +1,5 @@
 #include "include/CodonTable.h"
+#include "include/SequenceSummary.h"
 #ifndef STANDALONE
 #include <Rcpp.h>
 using namespace Rcpp;
@@ -11,6 +12,7 @@ CodonTable::CodonTable()
 {
     tableId = 1; //standard codon table by NCBI
     splitAA = true;
+    code = CodonEncoding::standardCode;
 }
 
 
@@ -18,13 +20,14 @@ CodonTable::CodonTable(unsigned _tableId, bool _splitAA) : tableId(_tableId), sp
 {
 	if(tableId == 7 || tableId == 8 || tableId == 15 || tableId == 17 || tableId == 18 || tableId == 19 || tableId == 20 || tableId > 25 || tableId < 1)
 	{
-		tableId = 1; //standard codon table by NCBI
 #ifndef STANDALONE
 		Rf_warning("Invalid codon table: %d using default codon table (NCBI codon table 1)\n", tableId);
 #else
 		std::cerr << "Invalid codon table: " << tableId << " using default codon table (NCBI codon table 1)\n";
 #endif
+		tableId = 1; //standard codon table by NCBI
 	}
+	setupCodonTable();
 }
 
 
@@ -38,6 +41,7 @@ CodonTable::CodonTable(const CodonTable& other)
 {
 	tableId = other.tableId;
 	splitAA = other.splitAA;
+	code = other.code;
 }
 
 
@@ -46,6 +50,7 @@ CodonTable& CodonTable::operator=(const CodonTable& rhs)
 	if (this == &rhs) return *this; // handle self assignment
 	tableId = rhs.tableId;
 	splitAA = rhs.splitAA;
+	code = rhs.code;
 	return *this;
 }
 
@@ -54,58 +59,8 @@ CodonTable& CodonTable::operator=(const CodonTable& rhs)
 const std::string CodonTable::Ser2 = "Z";
 const std::string CodonTable::Ser1 = "J";
 const std::string CodonTable::Thr4_1 = "O";
-const std::string CodonTable::Thr4_2 = "B";
 const std::string CodonTable::Leu1 = "U";
 
-const std::string CodonTable::AminoAcidArray[] = {
-	"A", "C", "D", "E", "F", "G", "H", "I", "K", "L", CodonTable::Leu1, "M", "N", "P", "Q", "R",
-	CodonTable::Ser1, CodonTable::Ser2, "S", "T", CodonTable::Thr4_1, CodonTable::Thr4_2, "V", "W", "Y", "X"};
-
-/* const std::map<std::string, unsigned> CodonTable::aaToIndex = {{"A", 0}, {"C", 1}, {"D", 2}, {"E", 3}, {"F", 4},
-	{"G", 5}, {"H", 6}, {"I", 7}, {"K", 8}, {"L", 9}, {"M", 10}, {"N", 11}, {"P", 12}, {"Q", 13}, {"R", 14}, {"S", 15},
-	{"T", 16}, {"V", 17}, {"W", 18}, {"Y", 19}, {CodonTable::Ser2, 20}, {"X", 21}};
-*/
-
-const std::map<std::string, unsigned> CodonTable::aaToIndex = {{"A", 0}, {"C", 1}, {"D", 2}, {"E", 3}, {"F", 4},
- {"G", 5}, {"H", 6}, {"I", 7}, {"K", 8}, {"L",9}, {CodonTable::Leu1, 10}, {"M", 11}, {"N", 12}, {"P", 13}, {"Q", 14}, {"R", 15},
-															   {CodonTable::Ser1, 16}, {CodonTable::Ser2, 17}, {"S", 18},
- {"T", 19}, {CodonTable::Thr4_1, 20}, {CodonTable::Thr4_2, 21}, {"V", 22}, {"W", 23}, {"Y", 24}, {"X", 25}};
-
-const std::map<std::string, unsigned> CodonTable::codonToIndexWithReference = {{"GCA", 0}, {"GCC", 1}, {"GCG", 2},
-	{"GCT", 3}, {"TGC", 4}, {"TGT", 5}, {"GAC", 6}, {"GAT", 7}, {"GAA", 8}, {"GAG", 9}, {"TTC", 10}, {"TTT", 11},
-	{"GGA", 12}, {"GGC", 13}, {"GGG", 14}, {"GGT", 15}, {"CAC", 16}, {"CAT", 17}, {"ATA", 18}, {"ATC", 19}, {"ATT", 20},
-	{"AAA", 21}, {"AAG", 22}, {"CTA", 23}, {"CTC", 24}, {"CTG", 25}, {"CTT", 26}, {"TTA", 27}, {"TTG", 28}, {"ATG", 29},
-	{"AAC", 30}, {"AAT", 31}, {"CCA", 32}, {"CCC", 33}, {"CCG", 34}, {"CCT", 35}, {"CAA", 36}, {"CAG", 37}, {"AGA", 38},
-	{"AGG", 39}, {"CGA", 40}, {"CGC", 41}, {"CGG", 42}, {"CGT", 43}, {"TCA", 44}, {"TCC", 45}, {"TCG", 46}, {"TCT", 47},
-	{"ACA", 48}, {"ACC", 49}, {"ACG", 50}, {"ACT", 51}, {"GTA", 52}, {"GTC", 53}, {"GTG", 54}, {"GTT", 55}, {"TGG", 56},
-	{"TAC", 57}, {"TAT", 58}, {"AGC", 59}, {"AGT", 60}, {"TAA", 61}, {"TAG", 62}, {"TGA", 63}};
-
-const std::map<std::string, unsigned> CodonTable::codonToIndexWithoutReference = {{"GCA", 0}, {"GCC", 1},
-	{"GCG", 2}, {"TGC", 3}, {"GAC", 4}, {"GAA", 5}, {"TTC", 6}, {"GGA", 7}, {"GGC", 8}, {"GGG", 9}, {"CAC", 10},
-	{"ATA", 11}, {"ATC", 12}, {"AAA", 13}, {"CTA", 14}, {"CTC", 15}, {"CTG", 16}, {"CTT", 17}, {"TTA", 18}, {"AAC", 19},
-	{"CCA", 20}, {"CCC", 21}, {"CCG", 22}, {"CAA", 23}, {"AGA", 24}, {"AGG", 25}, {"CGA", 26}, {"CGC", 27}, {"CGG", 28},
-	{"TCA", 29}, {"TCC", 30}, {"TCG", 31}, {"ACA", 32}, {"ACC", 33}, {"ACG", 34}, {"GTA", 35}, {"GTC", 36}, {"GTG", 37},
-	{"TAC", 38}, {"AGC", 39}};
-
-const std::string CodonTable::codonArray[] =
-	{"GCA", "GCC", "GCG", "GCT", "TGC", "TGT", "GAC", "GAT", "GAA", "GAG",
-	"TTC", "TTT", "GGA", "GGC", "GGG", "GGT", "CAC", "CAT", "ATA", "ATC",
-	"ATT", "AAA", "AAG", "CTA", "CTC", "CTG", "CTT", "TTA", "TTG", "ATG",
-	"AAC", "AAT", "CCA", "CCC", "CCG", "CCT", "CAA", "CAG", "AGA", "AGG",
-	"CGA", "CGC", "CGG", "CGT", "TCA", "TCC", "TCG", "TCT", "ACA", "ACC",
-	"ACG", "ACT", "GTA", "GTC", "GTG", "GTT", "TGG", "TAC", "TAT", "AGC",
-	"AGT", "TAA", "TAG", "TGA"};
-
-const std::string CodonTable::codonArrayParameter[] =
-	{"GCA", "GCC", "GCG", "TGC", "GAC",
-	"GAA", "TTC", "GGA", "GGC", "GGG",
-	"CAC", "ATA", "ATC", "AAA", "CTA",
-	"CTC", "CTG", "CTT", "TTA", "AAC",
-	"CCA", "CCC", "CCG", "CAA", "AGA",
-	"AGG", "CGA", "CGC", "CGG", "TCA",
-	"TCC", "TCG", "ACA", "ACC", "ACG",
-	"GTA", "GTC", "GTG", "TAC", "AGC"};
-
 // TODO NOTE: THERE IS NO CODON TABLE 7, 8, 15, 17, 18, 19, 20 ACCORDING TO NCBI !
 // http://www.ncbi.nlm.nih.gov/Taxonomy/Utils/wprintgc.cgi
 const std::string CodonTable::codonTableDefinition[] = {"1. The Standard Code", "2. The Vertebrate Mitochondrial Code",
@@ -118,422 +73,245 @@ const std::string CodonTable::codonTableDefinition[] = {"1. The Standard Code",
 	"21. Trematode Mitochondrial Code", "22. Scenedesmus obliquus Mitochondrial Code", "23. Thraustochytrium Mitochondrial Code",
 	"24. Pterobranchia Mitochondrial Code",	"25. Candidate Division SR1 and Gracilibacteria Code"};
 
-
-// {"A", "C", "D", "E", "F", "G", "H", "I", "K", "L", "M", "N", "P", "Q", "R", "S", "T", "V", "W", "Y", "Z", "X"};
-const unsigned CodonTable::numCodonsPerAAForTable[25][26] = {
-		{4,2,2,2,2,4,2,3,2,6,0,1,2,4,2,6,0,2,4,4,0,0,4,1,2,3}, // 1. The Standard Code
-		{4,2,2,2,2,4,2,2,2,6,0,2,2,4,2,4,0,2,4,4,0,0,4,2,2,4}, // 2. The Vertebrate Mitochondrial Code
-		{4,2,2,2,2,4,2,2,2,2,0,2,2,4,2,4,0,2,4,0,4,4,4,2,2,2}, // 3. The Yeast Mitochondrial Code
-		{4,2,2,2,2,4,2,3,2,6,0,1,2,4,2,6,0,2,4,4,0,0,4,2,2,2}, // 4. The Mold, Protozoan, and Coelenterate Mitochondrial Code and the Mycoplasma/Spiroplasma Code
-		{4,2,2,2,2,4,2,2,2,6,0,2,2,4,2,4,0,4,4,4,0,0,4,2,2,2}, // 5. The Invertebrate Mitochondrial Code
-		{4,2,2,2,2,4,2,3,2,6,0,1,2,4,4,6,0,2,4,4,0,0,4,1,2,1}, // 6. The Ciliate, Dasycladacean and Hexamita Nuclear Code
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 7. Invalid Codon Table
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 8. Invalid Codon Table
-		{4,2,2,2,2,4,2,3,1,6,0,1,3,4,2,4,0,4,4,4,0,0,4,2,2,2}, // 9. The Echinoderm and Flatworm Mitochondrial Code
-		{4,3,2,2,2,4,2,3,2,6,0,1,2,4,2,6,0,2,4,4,0,0,4,1,2,2}, // 10. The Euplotid Nuclear Code
-		{4,2,2,2,2,4,2,3,2,6,0,1,2,4,2,6,0,2,4,4,0,0,4,1,2,3}, // 11. The Bacterial, Archaeal and Plant Plastid Codee
-		{4,2,2,2,2,4,2,3,2,5,0,1,2,4,2,6,1,2,4,4,0,0,4,1,2,3}, // 12. The Alternative Yeast Nuclear Code
-		{4,2,2,2,2,6,2,2,2,6,0,2,2,4,2,4,0,2,4,4,0,0,4,2,2,2}, // 13. The Ascidian Mitochondrial Code
-		{4,2,2,2,2,4,2,3,1,6,0,1,3,4,2,4,0,4,4,4,0,0,4,2,3,1}, // 14. The Alternative Flatworm Mitochondrial Code
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 15. Invalid Codon Table
-		{4,2,2,2,2,4,2,3,2,6,1,1,2,4,2,6,0,2,4,4,0,0,4,1,2,2}, // 16. Chlorophycean Mitochondrial Code
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 17. Invalid Codon Table
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 18. Invalid Codon Table
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 19. Invalid Codon Table
-		{0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}, // 20. Invalid Codon Table
-		{4,2,2,2,2,4,2,2,1,6,0,2,3,4,2,4,0,4,4,4,0,0,4,2,2,2}, // 21. Trematode Mitochondrial Code
-		{4,2,2,2,2,4,2,3,2,6,1,1,2,4,2,6,0,2,3,4,0,0,4,1,2,3}, // 22. Scenedesmus obliquus Mitochondrial Code
-		{4,2,2,2,2,4,2,3,2,5,0,1,2,4,2,6,0,2,4,4,0,0,4,1,2,4}, // 23. Thraustochytrium Mitochondrial Code
-		{4,2,2,2,2,4,2,3,3,6,0,1,2,4,2,4,0,3,4,4,0,0,4,2,2,2}, // 24. Pterobranchia Mitochondrial Code
-		{4,2,2,2,2,5,2,3,2,6,0,1,2,4,2,6,0,2,4,4,0,0,4,1,2,2}, // 25. Candidate Division SR1 and Gracilibacteria Code
+// amino acids of the codons TTT, TTC, TTA, TTG, TCT, ..., GGG as listed by NCBI, * for stop codons
+const char *CodonTable::translationTables[25] = {
+	"FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 1
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSS**VVVVAAAADDEEGGGG", // 2
+	"FFLLSSSSYY**CCWWTTTTPPPPHHQQRRRRIIMMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 3
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 4
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSSSVVVVAAAADDEEGGGG", // 5
+	"FFLLSSSSYYQQCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 6
+	NULL, NULL,
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG", // 9
+	"FFLLSSSSYY**CCCWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 10
+	"FFLLSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 11
+	"FFLLSSSSYY**CC*WLLLSPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 12
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNKKSSGGVVVVAAAADDEEGGGG", // 13
+	"FFLLSSSSYYY*CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNNKSSSSVVVVAAAADDEEGGGG", // 14
+	NULL,
+	"FFLLSSSSYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 16
+	NULL, NULL, NULL, NULL,
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIMMTTTTNNNKSSSSVVVVAAAADDEEGGGG", // 21
+	"FFLLSS*SYY*LCC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 22
+	"FF*LSSSSYY**CC*WLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG", // 23
+	"FFLLSSSSYY**CCWWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSSKVVVVAAAADDEEGGGG", // 24
+	"FFLLSSSSYY**CCGWLLLLPPPPHHQQRRRRIIIMTTTTNNKKSSRRVVVVAAAADDEEGGGG"  // 25
 };
 
+
+
 // --- CODON TABLE SPECIFIC MAPPER FUNCTIONS ------
 
+/* setupCodonTable (NOT EXPOSED)
+ * Arguments: None
+ * Generates the lookup tables of the genetic code (see GeneticCode). Serine codons outside TCN and AGY are Ser2
+ * (AGN) or Ser1, threonine codons outside ACN Thr4_1 and leucine codons outside CTN and TTR Leu1. Without splitAA
+ * these are merged back into their amino acid unless it would get more codons than the models can handle. Amino acids
+ * are ordered as in the standard code, followed by the split ones and the stop codons, so table 1 reproduces
+ * CodonEncoding::standardCode.
+*/
+void CodonTable::setupCodonTable()
+{
+	const char *translation = translationTables[tableId - 1];
+	const char nucleotides[] = "ACGT";
+	const unsigned ncbiOrder[4] = {2u, 1u, 3u, 0u}; // position of A, C, G, T in TCAG
+	char aaOfCodon[GeneticCode::numCodons];
+	unsigned numCodons[26] = {0u};
+	for (unsigned packed = 0u; packed < GeneticCode::numCodons; packed++)
+	{
+		char codon[4] = {nucleotides[packed >> 4], nucleotides[(packed >> 2) & 3u], nucleotides[packed & 3u], 0};
+		char aa = translation[ncbiOrder[packed >> 4] * 16u + ncbiOrder[(packed >> 2) & 3u] * 4u + ncbiOrder[packed & 3u]];
+		if (aa == '*') aa = 'X';
+		else if (aa == 'S' && !(codon[0] == 'T' && codon[1] == 'C'))
+			aa = (codon[0] == 'A' && codon[1] == 'G') ? Ser2[0] : Ser1[0];
+		else if (aa == 'T' && !(codon[0] == 'A' && codon[1] == 'C')) aa = Thr4_1[0];
+		else if (aa == 'L' && !(codon[0] == 'C' && codon[1] == 'T') && !(codon[0] == 'T' && codon[1] == 'T'))
+			aa = Leu1[0];
+		aaOfCodon[packed] = aa;
+		numCodons[aa - 'A']++;
+	}
+
+	const char splitLetters[] = {Leu1[0], Ser1[0], Thr4_1[0]};
+	const char mergedLetters[] = {'L', 'S', 'T'};
+	for (unsigned i = 0u; i < 3u; i++)
+	{
+		unsigned split = splitLetters[i] - 'A';
+		unsigned merged = mergedLetters[i] - 'A';
+		if (splitAA || numCodons[split] == 0u) continue;
+		if (numCodons[split] + numCodons[merged] > GeneticCode::maxCodonsPerAA)
+		{
+			my_printError("WARNING: Codon table % can not merge % into %, keeping it as separate amino acid\n", tableId,
+				splitLetters[i], mergedLetters[i]);
+			continue;
+		}
+		for (unsigned packed = 0u; packed < GeneticCode::numCodons; packed++)
+		{
+			if (aaOfCodon[packed] == splitLetters[i]) aaOfCodon[packed] = mergedLetters[i];
+		}
+		numCodons[merged] += numCodons[split];
+		numCodons[split] = 0u;
+	}
+
+	std::string alphabet = "ACDEFGHIKLMNPQRSTVWY" + Ser2;
+	for (unsigned i = 0u; i < 3u; i++)
+	{
+		if (numCodons[splitLetters[i] - 'A'] != 0u) alphabet += splitLetters[i];
+	}
+	alphabet += 'X';
+
+	code.tableId = tableId;
+	code.splitAA = splitAA;
+	code.numAA = alphabet.size();
+	code.numParameterCodons = 0u;
+	std::fill(code.letterToAA, code.letterToAA + 26, (unsigned char)GeneticCode::invalidAA);
+	std::fill(code.aaLetters, code.aaLetters + GeneticCode::maxNumAA + 1, '\0');
+	unsigned codonIndex = 0u;
+	for (unsigned a = 0u; a < code.numAA; a++)
+	{
+		char aa = alphabet[a];
+		code.aaLetters[a] = aa;
+		code.letterToAA[aa - 'A'] = a;
+		code.aaCodonStart[a] = codonIndex;
+		code.aaParameterStart[a] = code.numParameterCodons;
+		if (numCodons[aa - 'A'] > GeneticCode::maxCodonsPerAA)
+			my_printError("WARNING: Amino acid % has % codons in codon table %, the models handle at most %\n", aa,
+				numCodons[aa - 'A'], tableId, GeneticCode::maxCodonsPerAA);
+		// codons in alphabetical order, the last one is the reference codon
+		for (unsigned packed = 0u; packed < GeneticCode::numCodons; packed++)
+		{
+			if (aaOfCodon[packed] != aa) continue;
+			code.packedToCodonIndex[packed] = codonIndex;
+			code.codonToAA[codonIndex] = a;
+			code.codonNames[codonIndex][0] = nucleotides[packed >> 4];
+			code.codonNames[codonIndex][1] = nucleotides[(packed >> 2) & 3u];
+			code.codonNames[codonIndex][2] = nucleotides[packed & 3u];
+			code.codonNames[codonIndex][3] = '\0';
+			bool hasParameter = aa != 'X' && codonIndex + 1u < code.aaCodonStart[a] + numCodons[aa - 'A'];
+			code.codonToParameter[codonIndex] = hasParameter ? code.numParameterCodons : GeneticCode::invalidCodon;
+			if (hasParameter) code.parameterToCodon[code.numParameterCodons++] = codonIndex;
+			codonIndex++;
+		}
+	}
+	code.aaCodonStart[code.numAA] = codonIndex;
+	code.aaParameterStart[code.numAA] = code.numParameterCodons;
+	for (unsigned i = code.numParameterCodons; i < GeneticCode::numCodons; i++)
+	{
+		code.parameterToCodon[i] = GeneticCode::invalidCodon;
+	}
+	for (unsigned a = code.numAA + 1u; a <= GeneticCode::maxNumAA; a++)
+	{
+		code.aaCodonStart[a] = codonIndex;
+		code.aaParameterStart[a] = code.numParameterCodons;
+	}
+}
+
+
+unsigned CodonTable::getTableId()
+{
+	return tableId;
+}
+
+
+bool CodonTable::getSplitAA()
+{
+	return splitAA;
+}
+
+
+const GeneticCode& CodonTable::getGeneticCode()
+{
+	return code;
+}
+
+
 unsigned CodonTable::AAToAAIndex(std::string aa)
 {
-        return CodonTable::aaToIndex.find(aa) -> second;
+	return code.aaIndex(aa[0]);
 }
 
+
 unsigned CodonTable::getNumCodons(std::string aa)
 {
 	return getNumCodons(AAToAAIndex(aa));
 }
 
+
 unsigned CodonTable::getNumCodons(unsigned aa)
 {
-	return numCodonsPerAAForTable[tableId][aa];
+	return code.numCodonsForAA(aa);
 }
 
-void CodonTable::setupCodonTable()
+
+std::vector<std::string> CodonTable::getAminoAcids()
+{
+	std::vector<std::string> RV;
+	for (unsigned a = 0u; a < code.numAA; a++) RV.push_back(std::string(1, code.aaLetters[a]));
+	return RV;
+}
+
+
+std::vector<std::string> CodonTable::AAToCodon(std::string aa, bool forParamVector)
 {
-	unsigned numAA = 21;
-	if(tableId >= 1 && tableId <= 6  && !splitAA) numAA = 20; //If not splitting AAs, tables 1-6 all have 20 AA, excluding stop codes
-    else if (tableId >= 9 && tableId <= 14  && !splitAA) numAA = 20;
-    else if (tableId == 16 && !splitAA) numAA = 20;
-    else if (tableId >= 21 && tableId <= 25 && !splitAA) numAA = 20;
-
-
-	codon_mapping.resize(numAA);
-
-    unsigned aaIndex = 0;
-    unsigned filled = 0;
-    while (filled != numAA)
-    {
-        unsigned numCodons = getNumCodons(aaIndex);
-        if (numCodons != 0)
-        {
-            if (aaIndex == 0) //A
-            {
-                for (unsigned i = 0; i < 4; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 1) //C
-            {
-                for (unsigned i = 4; i < 6; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-                if (tableId == 10)
-                {
-                    codon_mapping[filled].push_back(63);
-                }
-            }
-            else if (aaIndex == 2) //D
-            {
-                for (unsigned i = 6; i < 8; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 3) //E
-            {
-                for (unsigned i = 8; i < 10; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 4) //F
-            {
-                for (unsigned i = 10; i < 12; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 5) //G
-            {
-                for (unsigned i = 12; i < 16; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-                if (tableId == 13)
-                {
-                    codon_mapping[filled].push_back(38);
-                    codon_mapping[filled].push_back(39);
-                }
-                else if (tableId == 25)
-                {
-                    codon_mapping[filled].push_back(63);
-                }
-            }
-            else if (aaIndex == 6) //H
-            {
-                for (unsigned i = 16; i < 18; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 7) //I
-            {
-                if (tableId == 1 || tableId == 4 || tableId == 6 || tableId == 9 || tableId == 10 || tableId == 11
-                        || tableId == 12 || tableId == 14 || tableId == 16 || tableId >= 22)
-                {
-                    codon_mapping[filled].push_back(18);
-                }
-                for (unsigned i = 19; i < 21; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 8) //K
-            {
-                if ((tableId >= 1 && tableId <= 6) || (tableId >= 10 && tableId <= 13) || (tableId == 16) ||
-                        (tableId >= 22))
-                {
-                    for (unsigned i = 21; i < 23; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-                else if (tableId == 9 || tableId == 14 || tableId == 21)
-                {
-                    codon_mapping[filled].push_back(22);
-                }
-
-                if (tableId == 24)
-                {
-                    codon_mapping[filled].push_back(39);
-                }
-            }
-            else if (aaIndex == 9) //L
-            {
-                if (tableId != 3 && tableId != 23)
-                {
-                    for (unsigned i = 23; i < 29; i++)
-                    {
-                        if (i == 25 && tableId != 12)
-                        {
-                            codon_mapping[filled].push_back(i);
-                        }
-                        else
-                        {
-                            codon_mapping[filled].push_back(i);
-                        }
-                    }
-                    if ((tableId == 16 || tableId == 22) && !splitAA)
-                    {
-                        codon_mapping[filled].push_back(62);
-                    }
-                }
-                else if (tableId == 3)
-                {
-                    for (unsigned i = 27; i < 29; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-                else if (tableId == 23)
-                {
-                    for (unsigned i = 23; i < 27; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                    codon_mapping[filled].push_back(28);
-                }
-            }
-            else if (aaIndex == 10) //Leu1
-            {
-                if (splitAA)
-                {
-                    codon_mapping[filled].push_back(62);
-                }
-                else
-                {
-                    filled--;
-                }
-            }
-            else if (aaIndex == 11) //M
-            {
-                codon_mapping[filled].push_back(29);
-                if (tableId == 2 || tableId == 3 || tableId == 5 || tableId == 13 || tableId == 21)
-                {
-                    codon_mapping[filled].push_back(18);
-                }
-            }
-            else if (aaIndex == 12) //N
-            {
-                for (unsigned i = 30; i < 32; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-                if (tableId == 9 || tableId == 14 || tableId == 21)
-                {
-                    codon_mapping[filled].push_back(21);
-                }
-            }
-            else if (aaIndex == 13) //P
-            {
-                for (unsigned i = 32; i < 36; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 14) //Q
-            {
-                for (unsigned i = 36; i < 38; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-                if (tableId == 6)
-                {
-                    codon_mapping[filled].push_back(61);
-                    codon_mapping[filled].push_back(62);
-                }
-            }
-            else if (aaIndex == 15) //R
-            {
-                if (tableId == 1 || tableId == 3 || tableId == 4 || tableId == 6 || (tableId >= 10 && tableId <= 12) || tableId == 16 ||
-                        tableId == 22 || tableId == 23 || tableId == 25)
-                {
-                    codon_mapping[filled].push_back(38);
-                    codon_mapping[filled].push_back(39);
-                }
-
-                if (tableId == 3)
-                {
-                    codon_mapping[filled].push_back(42);
-                    codon_mapping[filled].push_back(43);
-                }
-                else
-                {
-                    for (unsigned i = 40; i < 44; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-            }
-            else if (aaIndex == 16) //Ser1
-            {
-                if(splitAA)
-                {
-                    codon_mapping[filled].push_back(25); //table 12
-                }
-                else
-                {
-                    filled--;
-                }
-            }
-            else if (aaIndex == 17) //Ser2
-            {
-                if (splitAA)
-                {
-                    codon_mapping[filled].push_back(59);
-                    codon_mapping[filled].push_back(60);
-
-                    if (tableId == 5 || tableId == 9 || tableId == 14 || tableId == 21)
-                    {
-                        codon_mapping[filled].push_back(38);
-                        codon_mapping[filled].push_back(39);
-                    }
-                    else if (tableId == 24)
-                    {
-                        codon_mapping[filled].push_back(38);
-                    }
-                }
-                else
-                {
-                    filled--;
-                }
-            }
-            else if (aaIndex == 18) //Ser (Ser4)
-            {
-                if (tableId != 22)
-                {
-                    for(unsigned i = 44; i < 48; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-                else
-                {
-                    for(unsigned i = 45; i < 48; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-
-                if (!splitAA)
-                {
-                    if (tableId == 12)
-                    {
-                        codon_mapping[filled].push_back(25);
-                    }
-
-                    codon_mapping[filled].push_back(59);
-                    codon_mapping[filled].push_back(60);
-
-                    if (tableId == 5 || tableId == 9 || tableId == 14 || tableId == 21)
-                    {
-                        codon_mapping[filled].push_back(38);
-                        codon_mapping[filled].push_back(39);
-                    }
-                    else if (tableId == 24)
-                    {
-                        codon_mapping[filled].push_back(38);
-                    }
-                }
-            }
-            else if (aaIndex == 19) //T
-            {
-                if (tableId != 3)
-                {
-                    for (unsigned i = 48; i < 52; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-                else if (tableId == 3 && !splitAA)
-                {
-                    for (unsigned i = 48; i < 52; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-
-                    for (unsigned i = 23; i < 27; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-            }
-            else if (aaIndex == 20) //Thr1
-            {
-                if (splitAA)
-                {
-                    for (unsigned i = 48; i < 52; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-                else
-                {
-                    filled--;
-                }
-            }
-            else if (aaIndex == 21) //Thr2
-            {
-                if (splitAA)
-                {
-                    for (unsigned i = 23; i < 27; i++)
-                    {
-                        codon_mapping[filled].push_back(i);
-                    }
-                }
-                else
-                {
-                    filled--;
-                }
-            }
-            else if (aaIndex == 22) //V
-            {
-                for (unsigned i = 52; i < 56; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-            }
-            else if (aaIndex == 23) //W
-            {
-                codon_mapping[filled].push_back(56);
-                if ((tableId >= 2 && tableId <= 5) || (tableId == 9) || (tableId == 13) || (tableId == 14) || (tableId == 21))
-                {
-                    codon_mapping[filled].push_back(63);
-                }
-            }
-            else if (aaIndex == 24) //Y
-            {
-                for (unsigned i = 56; i < 58; i++)
-                {
-                    codon_mapping[filled].push_back(i);
-                }
-                if (tableId == 14) codon_mapping[filled].push_back(61);
-            }
-            //ignoring stop amino acid for now
-            filled++;
-        }
-        aaIndex++;
-    }
+	std::vector<std::string> RV;
+	unsigned aaIndex = AAToAAIndex(aa);
+	for (unsigned i = code.aaCodonBegin(aaIndex); i < code.aaCodonEnd(aaIndex); i++)
+	{
+		if (!forParamVector || code.codonToParameterIndex(i) != GeneticCode::invalidCodon)
+			RV.push_back(code.codonNames[i]);
+	}
+	return RV;
+}
+
+
+/* activate (NOT EXPOSED)
+ * Arguments: None
+ * Makes this the genetic code of the analysis: SequenceSummary lookups, codon and amino acid names, parameter group
+ * lists and trace layouts all follow it. Has to be called before genomes are read.
+*/
+void CodonTable::activate()
+{
+	SequenceSummary::setGeneticCode(code);
 }
 
 
+/* useCodonTable (RCPP EXPOSED)
+ * Arguments: NCBI codon table number, whether amino acids coded by more than one codon box are split
+ * Selects the genetic code of the analysis, see activate. Table 1 is the default.
+*/
+void CodonTable::useCodonTable(unsigned tableId, bool splitAA)
+{
+	CodonTable table(tableId, splitAA);
+	table.activate();
+}
 
+
+unsigned CodonTable::getActiveCodonTable()
+{
+	return CodonEncoding::activeCode().tableId;
+}
+
+
+
+
+
+// -----------------------------------------------------------------------------------------------------//
+// ---------------------------------------- R SECTION --------------------------------------------------//
+// -----------------------------------------------------------------------------------------------------//
+
+
+
+#ifndef STANDALONE
+
+
+//---------------------------------//
+//---------- RCPP Module ----------//
+//---------------------------------//
+
+
+RCPP_MODULE(CodonTable_mod)
+{
+	Rcpp::function("useCodonTable", &CodonTable::useCodonTable, List::create(_["tableId"] = 1, _["splitAA"] = true),
+		"selects the NCBI codon table used for all following genomes, parameters and models");
+	Rcpp::function("getActiveCodonTable", &CodonTable::getActiveCodonTable, "returns the NCBI codon table in use");
+}
+#endif
@@ -31,6 +31,7 @@ CovarianceMatrix::CovarianceMatrix(std::vector <double> &matrix)
     numVariates = (int)std::sqrt(matrix.size());
     covMatrix = matrix;
     choleskiMatrix.resize(matrix.size(), 0.0);
+    packedCholeskiMatrix.resize(numVariates * (numVariates + 1) / 2, 0.0);
 }
 
 
@@ -39,6 +40,7 @@ CovarianceMatrix::CovarianceMatrix(const CovarianceMatrix& other)
     numVariates = other.numVariates;
     covMatrix = other.covMatrix;
     choleskiMatrix = other.choleskiMatrix;
+    packedCholeskiMatrix = other.packedCholeskiMatrix;
 }
 
 
@@ -48,6 +50,7 @@ CovarianceMatrix& CovarianceMatrix::operator=(const CovarianceMatrix& rhs)
     numVariates = rhs.numVariates;
     covMatrix = rhs.covMatrix;
 	choleskiMatrix = rhs.choleskiMatrix;
+	packedCholeskiMatrix = rhs.packedCholeskiMatrix;
     return *this;
 }
 
@@ -101,6 +104,7 @@ void CovarianceMatrix::initCovarianceMatrix(unsigned _numVariates)
     unsigned vectorLength = numVariates * numVariates;
     covMatrix.resize(vectorLength);
     choleskiMatrix.resize(vectorLength);
+    packedCholeskiMatrix.assign(numVariates * (numVariates + 1) / 2, 0.0);
 
 	double diag_const = 0.01 / (double)numVariates;
     for(unsigned i = 0u; i < vectorLength; i++)
@@ -120,8 +124,11 @@ void CovarianceMatrix::setDiag(double val)
 
 // addaptatoin of http://en.wikipedia.org/wiki/Cholesky_decomposition
 // http://rosettacode.org/wiki/Cholesky_decomposition#C
+// The lower triangle is also stored packed by rows for transformIidNumersIntoCovaryingNumbers.
 void CovarianceMatrix::choleskiDecomposition()
 {
+    packedCholeskiMatrix.resize(numVariates * (numVariates + 1) / 2);
+    unsigned packedIndex = 0u;
     for(int i = 0; i < numVariates; i++)
     {
         for(int j = 0; j < (i + 1); j++)
@@ -133,11 +140,67 @@ void CovarianceMatrix::choleskiDecomposition()
             }
             choleskiMatrix[i * numVariates + j] = (i == j) ? std::sqrt(covMatrix[i * numVariates + i] - LsubstractSum) :
                 (1.0 / choleskiMatrix[j * numVariates + j]) * (covMatrix[i * numVariates + j] - LsubstractSum);
+            packedCholeskiMatrix[packedIndex++] = choleskiMatrix[i * numVariates + j];
         }
     }
 }
 
 
+/* invert (NOT EXPOSED)
+ * Arguments: None
+ * Replaces the matrix by its inverse (Gauss-Jordan elimination with partial pivoting), e.g. to turn the Hessian of a
+ * negative log posterior into a covariance matrix. Returns false and leaves the matrix unchanged if it is singular.
+ * The choleski decomposition has to be redone afterwards.
+*/
+bool CovarianceMatrix::invert()
+{
+    std::vector<double> matrix = covMatrix;
+    std::vector<double> inverse(numVariates * numVariates, 0.0);
+    for (int i = 0; i < numVariates; i++)
+    {
+        inverse[i * numVariates + i] = 1.0;
+    }
+
+    for (int column = 0; column < numVariates; column++)
+    {
+        int pivot = column;
+        for (int i = column + 1; i < numVariates; i++)
+        {
+            if (std::fabs(matrix[i * numVariates + column]) > std::fabs(matrix[pivot * numVariates + column])) pivot = i;
+        }
+        if (!(std::fabs(matrix[pivot * numVariates + column]) > 0.0)) return false;
+        if (pivot != column)
+        {
+            for (int j = 0; j < numVariates; j++)
+            {
+                std::swap(matrix[pivot * numVariates + j], matrix[column * numVariates + j]);
+                std::swap(inverse[pivot * numVariates + j], inverse[column * numVariates + j]);
+            }
+        }
+
+        double scale = 1.0 / matrix[column * numVariates + column];
+        for (int j = 0; j < numVariates; j++)
+        {
+            matrix[column * numVariates + j] *= scale;
+            inverse[column * numVariates + j] *= scale;
+        }
+        for (int i = 0; i < numVariates; i++)
+        {
+            if (i == column) continue;
+            double factor = matrix[i * numVariates + column];
+            if (factor == 0.0) continue;
+            for (int j = 0; j < numVariates; j++)
+            {
+                matrix[i * numVariates + j] -= factor * matrix[column * numVariates + j];
+                inverse[i * numVariates + j] -= factor * inverse[column * numVariates + j];
+            }
+        }
+    }
+    covMatrix = inverse;
+    return true;
+}
+
+
 void CovarianceMatrix::printCovarianceMatrix()
 {
 
@@ -208,26 +271,37 @@ int CovarianceMatrix::getNumVariates()
 
 std::vector<double> CovarianceMatrix::transformIidNumersIntoCovaryingNumbers(std::vector <double> iidnumbers)
 {
-    std::vector<double> covnumbers;
-    for(int i = 0; i < numVariates; i++)
+    std::vector<double> covnumbers(numVariates);
+    transformIidNumersIntoCovaryingNumbers(&iidnumbers[0], &covnumbers[0]);
+    return covnumbers;
+}
+
+
+// covnumbers = transpose(L) * iidnumbers. Walking the packed rows of L keeps the inner loop contiguous (and
+// vectorizable) and still adds the terms of each covnumbers[i] in order of k.
+void CovarianceMatrix::transformIidNumersIntoCovaryingNumbers(const double *iidnumbers, double *covnumbers)
+{
+    for (int i = 0; i < numVariates; i++)
     {
-        double sum = 0.0;
-        for (int k = 0; k < numVariates; k++)
+        covnumbers[i] = 0.0;
+    }
+    const double *row = &packedCholeskiMatrix[0];
+    for (int k = 0; k < numVariates; k++)
+    {
+        double iid = iidnumbers[k];
+        for (int i = 0; i <= k; i++)
         {
-			// testing if [i * numVariates + k] or [k * numVariates + i], first option was default
-            sum += choleskiMatrix[k * numVariates + i] * iidnumbers[k];
+            covnumbers[i] += row[i] * iid;
         }
-
-        covnumbers.push_back(sum);
+        row += k + 1;
     }
-    return covnumbers;
 }
 
-void CovarianceMatrix::calculateSampleCovariance(std::vector<std::vector<std::vector<std::vector<double>>>> codonSpecificParameterTrace, std::string aa, unsigned samples, unsigned lastIteration)
+void CovarianceMatrix::calculateSampleCovariance(std::vector<std::vector<std::vector<std::vector<double>>>> &codonSpecificParameterTrace, std::string aa, unsigned samples, unsigned lastIteration)
 {
 	//order of codonSpecificParameterTrace: paramType, category, numparam, samples
+	//parameter types can have different numbers of categories if mutation or selection is shared between mixtures
 	unsigned numParamTypesInModel = codonSpecificParameterTrace.size();
-	unsigned numCategoriesInModel = codonSpecificParameterTrace[0].size();
 
 	unsigned start = lastIteration - samples;
 	
@@ -238,14 +312,14 @@ void CovarianceMatrix::calculateSampleCovariance(std::vector<std::vector<std::ve
 	unsigned IDX = 0;
 	for (unsigned paramType1 = 0; paramType1 < numParamTypesInModel; paramType1++)
 	{
-		for (unsigned category1 = 0; category1 < numCategoriesInModel; category1++)
+		for (unsigned category1 = 0; category1 < codonSpecificParameterTrace[paramType1].size(); category1++)
 		{
 			for (unsigned param1 = aaStart; param1 < aaEnd; param1++)
 			{
 				double mean1 = sampleMean(codonSpecificParameterTrace[paramType1][category1][param1], samples, lastIteration);
 				for (unsigned paramType2 = 0; paramType2 < numParamTypesInModel; paramType2++)
 				{
-					for (unsigned category2 = 0; category2 < numCategoriesInModel; category2++)
+					for (unsigned category2 = 0; category2 < codonSpecificParameterTrace[paramType2].size(); category2++)
 					{
 						for (unsigned param2 = aaStart; param2 < aaEnd; param2++)
 						{
@@ -265,7 +339,7 @@ void CovarianceMatrix::calculateSampleCovariance(std::vector<std::vector<std::ve
 	}
 }
 
-double CovarianceMatrix::sampleMean(std::vector<double> sampleVector, unsigned samples, unsigned lastIteration)
+double CovarianceMatrix::sampleMean(std::vector<double> &sampleVector, unsigned samples, unsigned lastIteration)
 {
 	double posteriorMean = 0.0;
 	unsigned start = lastIteration - samples;
@@ -0,0 +1,288 @@
+#include "include/CrossValidation.h"
+
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
+
+//--------------------------------------------------//
+// ---------- Constructors & Destructors ---------- //
+//--------------------------------------------------//
+
+
+/* CrossValidation (NOT EXPOSED)
+ * Arguments: quadrature step of the synthesis rate integrals, in standard deviations of the integrand at its mode
+*/
+CrossValidation::CrossValidation(double _stepWidth)
+{
+	stepWidth = _stepWidth > 0.0 ? _stepWidth : 0.5;
+}
+
+
+CrossValidation::~CrossValidation()
+{
+	//dtor
+}
+
+
+
+
+
+//------------------------------------------//
+//---------- Gene Set Functions ----------//
+//------------------------------------------//
+
+
+/* createFolds (NOT EXPOSED)
+ * Arguments: number of genes, number of folds, seed, vectors to store the training and held-out genes of every fold in
+ * Assigns the genes to numFolds folds of (almost) equal size in random order. Fold f holds out its genes and trains
+ * on all others, so every gene is held out exactly once. Indices are in genome order.
+*/
+void CrossValidation::createFolds(unsigned numGenes, unsigned numFolds, unsigned seed,
+		std::vector<std::vector<unsigned>> &trainingGenes, std::vector<std::vector<unsigned>> &heldOutGenes)
+{
+	std::vector<unsigned> order(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		order[i] = i;
+	}
+	std::default_random_engine generator(seed);
+	for (unsigned i = numGenes; i > 1u; i--)
+	{
+		std::uniform_int_distribution<unsigned> distribution(0u, i - 1u);
+		std::swap(order[i - 1u], order[distribution(generator)]);
+	}
+
+	std::vector<unsigned> fold(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		fold[order[i]] = (unsigned)((unsigned long long)i * numFolds / numGenes);
+	}
+	trainingGenes.assign(numFolds, std::vector<unsigned>());
+	heldOutGenes.assign(numFolds, std::vector<unsigned>());
+	for (unsigned f = 0u; f < numFolds; f++)
+	{
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			if (fold[i] == f)
+				heldOutGenes[f].push_back(i);
+			else
+				trainingGenes[f].push_back(i);
+		}
+	}
+}
+
+
+/* createBootstrapSample (NOT EXPOSED)
+ * Arguments: number of genes, seed, vectors to store the training and held-out genes in
+ * Draws numGenes genes with replacement as training genes (a gene drawn twice is listed twice) and holds out the
+ * genes that were not drawn (out of bag).
+*/
+void CrossValidation::createBootstrapSample(unsigned numGenes, unsigned seed, std::vector<unsigned> &trainingGenes,
+		std::vector<unsigned> &heldOutGenes)
+{
+	std::vector<unsigned> draws(numGenes, 0u);
+	std::default_random_engine generator(seed);
+	std::uniform_int_distribution<unsigned> distribution(0u, numGenes == 0u ? 0u : numGenes - 1u);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		draws[distribution(generator)]++;
+	}
+
+	trainingGenes.clear();
+	heldOutGenes.clear();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		if (draws[i] == 0u)
+			heldOutGenes.push_back(i);
+		else
+			trainingGenes.insert(trainingGenes.end(), draws[i], i);
+	}
+}
+
+
+
+
+
+//-------------------------------------------//
+//---------- Predictive Functions ----------//
+//-------------------------------------------//
+
+
+/* calculatePredictiveLogLikelihoods (NOT EXPOSED)
+ * Arguments: genome of held-out genes, model and parameter after a run on the training genes, number of samples at
+ * the end of the traces to use (0 for all)
+ * Returns the posterior predictive log likelihood of every gene of the genome,
+ *   log( 1/S sum_s sum_k p_k,s integral p(gene | phi, theta_k,s) p(phi | sd_k,s) dphi )
+ * over the posterior samples s and mixture elements k. Samples are evaluated one after the other (the parameter is
+ * set to each sample, see Parameter::setToTraceSample), the genes of a sample in parallel. Like in the MCMC, the
+ * likelihood leaves out the terms that only depend on the data (e.g. multinomial coefficients), so the values compare
+ * runs of one model on the same genes, not different models.
+*/
+std::vector<double> CrossValidation::calculatePredictiveLogLikelihoods(Genome& genome, Model& model, Parameter& parameter,
+		unsigned samples)
+{
+	int numGenes = (int)genome.getGenomeSize();
+	unsigned numMixtures = model.getNumMixtureElements();
+	unsigned traceLength = parameter.getLastIteration() + 1u;
+	if (samples == 0u || samples > traceLength) samples = traceLength;
+
+	const double negativeInfinity = -std::numeric_limits<double>::infinity();
+	std::vector<double> sampleLogLikelihoods(numGenes * samples); // [gene][sample]
+	std::vector<double> modes(numGenes * numMixtures, std::numeric_limits<double>::quiet_NaN()); // [gene][mixture]
+	std::vector<double> logMixtureProbabilities(numMixtures);
+	std::vector<double> means(numMixtures);
+	std::vector<double> sds(numMixtures);
+	for (unsigned s = 0u; s < samples; s++)
+	{
+		parameter.setToTraceSample(traceLength - samples + s);
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			double probability = model.getCategoryProbability(k);
+			logMixtureProbabilities[k] = probability > 0.0 ? std::log(probability) : negativeInfinity;
+			sds[k] = model.getStdDevSynthesisRate(model.getSynthesisRateCategory(k), false);
+			means[k] = -(sds[k] * sds[k]) * 0.5;
+		}
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+		{
+			std::vector<double> phiValues;
+			std::vector<double> logLikelihoods;
+			std::vector<double> logTerms;
+			std::vector<double> terms(numMixtures);
+#ifndef __APPLE__
+#pragma omp for schedule(dynamic, 8)
+#endif
+			for (int i = 0; i < numGenes; i++)
+			{
+				Gene &gene = genome.getGene(i);
+				double maxTerm = negativeInfinity;
+				for (unsigned k = 0u; k < numMixtures; k++)
+				{
+					terms[k] = negativeInfinity;
+					if (logMixtureProbabilities[k] == negativeInfinity) continue;
+					terms[k] = logMixtureProbabilities[k] + integrateSynthesisRate(gene, model, k, means[k], sds[k],
+						modes[i * numMixtures + k], phiValues, logLikelihoods, logTerms);
+					if (terms[k] > maxTerm) maxTerm = terms[k];
+				}
+				double sum = 0.0;
+				for (unsigned k = 0u; k < numMixtures; k++)
+				{
+					sum += std::exp(terms[k] - maxTerm);
+				}
+				sampleLogLikelihoods[i * samples + s] = maxTerm + std::log(sum);
+			}
+		}
+	}
+
+	std::vector<double> predictiveLogLikelihoods(numGenes);
+	for (int i = 0; i < numGenes; i++)
+	{
+		double *geneSamples = &sampleLogLikelihoods[i * samples];
+		double maxValue = negativeInfinity;
+		for (unsigned s = 0u; s < samples; s++)
+		{
+			if (geneSamples[s] > maxValue) maxValue = geneSamples[s];
+		}
+		double sum = 0.0;
+		for (unsigned s = 0u; s < samples; s++)
+		{
+			sum += std::exp(geneSamples[s] - maxValue);
+		}
+		predictiveLogLikelihoods[i] = maxValue + std::log(sum / samples);
+	}
+	return predictiveLogLikelihoods;
+}
+
+
+double CrossValidation::getStepWidth()
+{
+	return stepWidth;
+}
+
+
+/* integrateSynthesisRate (NOT EXPOSED)
+ * Arguments: reference to a gene, model, mixture element, mean and standard deviation of the normal prior of
+ * log(phi), start of the mode search (set to the mode found, NaN to start at the prior mean), scratch vectors
+ * Returns the log of the integral of likelihood(phi) * prior over log(phi). The mode of the integrand and its curvature
+ * there are found by Newton steps on finite differences, then the trapezoid rule walks out from the mode in steps of
+ * stepWidth standard deviations until the integrand has dropped by exp(-40) on both sides. The likelihood of a long
+ * gene is much narrower than the prior, and it levels off for small phi where the integrand follows the prior. The
+ * trapezoid rule copes with both, Gauss-Hermite nodes around the mode do not fit the skewed shape.
+*/
+double CrossValidation::integrateSynthesisRate(Gene& gene, Model& model, unsigned mixtureElement, double mean,
+		double sd, double &mode, std::vector<double> &phiValues, std::vector<double> &logLikelihoods,
+		std::vector<double> &logTerms)
+{
+	const double log_sqrt_2pi = 0.9189385332046727;
+	const double delta = 1e-3;
+	const double negligible = 40.0;
+	const unsigned blockSize = 8u;
+	const unsigned maxSteps = 2000u;
+	double inverseVariance = 1.0 / (sd * sd);
+	double logPhi = std::isfinite(mode) ? mode : mean;
+	double curvature = inverseVariance;
+
+	phiValues.resize(3u);
+	for (unsigned iteration = 0u; iteration < 50u; iteration++)
+	{
+		phiValues[0] = std::exp(logPhi - delta);
+		phiValues[1] = std::exp(logPhi);
+		phiValues[2] = std::exp(logPhi + delta);
+		model.calculateLogLikelihoodPerGene(gene, mixtureElement, phiValues, logLikelihoods);
+
+		// first and negative second derivative of log likelihood + log prior in log(phi)
+		double slope = (logLikelihoods[2] - logLikelihoods[0]) / (2.0 * delta) - (logPhi - mean) * inverseVariance;
+		curvature = -(logLikelihoods[2] - 2.0 * logLikelihoods[1] + logLikelihoods[0]) / (delta * delta)
+			+ inverseVariance;
+		double step = curvature > 0.0 ? slope / curvature : (slope > 0.0 ? 1.0 : -1.0);
+		step = std::max(-1.0, std::min(1.0, step));
+		logPhi += step;
+		if (std::fabs(step) < 1e-6) break;
+	}
+	if (!(curvature > 0.0)) curvature = inverseVariance;
+	mode = logPhi;
+
+	// blocks of points alternate between the upper (direction 0) and lower side of the mode, the mode itself is the
+	// first point of the upper side
+	double step = stepWidth / std::sqrt(curvature);
+	double maxTerm = -std::numeric_limits<double>::infinity();
+	unsigned numSteps[2] = {0u, 1u};
+	bool done[2] = {false, false};
+	logTerms.clear();
+	phiValues.resize(blockSize);
+	while (!done[0] || !done[1])
+	{
+		for (unsigned direction = 0u; direction < 2u; direction++)
+		{
+			if (done[direction]) continue;
+			double sign = direction == 0u ? 1.0 : -1.0;
+			for (unsigned j = 0u; j < blockSize; j++)
+			{
+				phiValues[j] = std::exp(logPhi + sign * step * (numSteps[direction] + j));
+			}
+			model.calculateLogLikelihoodPerGene(gene, mixtureElement, phiValues, logLikelihoods);
+			for (unsigned j = 0u; j < blockSize; j++)
+			{
+				double a = sign * step * (numSteps[direction] + j) + logPhi - mean;
+				double logTerm = logLikelihoods[j] - 0.5 * a * a * inverseVariance;
+				if (logTerm > maxTerm) maxTerm = logTerm;
+				logTerms.push_back(logTerm);
+				if (j == blockSize - 1u && logTerm < maxTerm - negligible) done[direction] = true;
+			}
+			numSteps[direction] += blockSize;
+			if (numSteps[direction] >= maxSteps) done[direction] = true;
+		}
+	}
+
+	double sum = 0.0;
+	for (unsigned i = 0u; i < logTerms.size(); i++)
+	{
+		sum += std::exp(logTerms[i] - maxTerm);
+	}
+	return maxTerm + std::log(sum * step) - log_sqrt_2pi - std::log(sd);
+}
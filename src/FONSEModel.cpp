@@ -1,6 +1,12 @@
 #include "include/FONSE/FONSEModel.h"
 
 
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
 //--------------------------------------------------//
 //----------- Constructors & Destructors ---------- //
 //--------------------------------------------------//
@@ -100,12 +106,8 @@ void FONSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
 	double phiValue_proposed = parameter->getSynthesisRate(geneIndex, expressionCategory, true);
 
 
-	/* This loop causes a compiler warning because i is an int, but openMP won't compile if I change i to unsigned.
-		Maybe worth looking into? */
-#ifndef __APPLE__
-#pragma omp parallel for private(mutation, selection, positions, curAA) reduction(+:likelihood,likelihood_proposed)
-#endif
-	for (int i = 0; i < getGroupListSize(); i++)
+	// no parallel region here, this is called from within the parallel gene loop of the MCMC
+	for (unsigned i = 0u; i < getGroupListSize(); i++)
 	{
 		curAA = getGrouping(i);
 
@@ -147,6 +149,33 @@ void FONSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneInd
 }
 
 
+/* calculateLogLikelihoodPerGene (NOT EXPOSED)
+ * Arguments: reference to a gene, mixture element, synthesis rates, vector to store the log likelihoods in
+ * Log likelihood of the codon positions of the gene for each synthesis rate, see Model::calculateLogLikelihoodPerGene.
+ * Like calculateLogLikelihoodRatioPerGene, but for any number of synthesis rates and without their prior.
+*/
+void FONSEModel::calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+		std::vector<double> &logLikelihoods)
+{
+	unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+	unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+
+	double mutation[5];
+	double selection[5];
+	logLikelihoods.assign(phiValues.size(), 0.0);
+	for (unsigned i = 0u; i < getGroupListSize(); i++)
+	{
+		std::string curAA = getGrouping(i);
+		parameter->getParameterForCategory(mutationCategory, FONSEParameter::dM, curAA, false, mutation);
+		parameter->getParameterForCategory(selectionCategory, FONSEParameter::dOmega, curAA, false, selection);
+		for (unsigned j = 0u; j < phiValues.size(); j++)
+		{
+			logLikelihoods[j] += calculateLogLikelihoodRatioPerAA(gene, curAA, mutation, selection, phiValues[j]);
+		}
+	}
+}
+
+
 void FONSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, double& logAcceptanceRatioForAllMixtures)
 {
 	int numGenes = genome.getGenomeSize();
@@ -203,10 +232,10 @@ void FONSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, u
 {
 	double lpr = 0.0;
 	unsigned selectionCategory = getNumSynthesisRateCategories();
-	std::vector<double> currentStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> currentMphi(selectionCategory, 0.0);
-	std::vector<double> proposedStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> proposedMphi(selectionCategory, 0.0);
+	currentStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	currentMphi.assign(selectionCategory, 0.0);
+	proposedStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	proposedMphi.assign(selectionCategory, 0.0);
 	for(unsigned i = 0u; i < selectionCategory; i++)
 	{
 		currentStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, false);
@@ -233,6 +262,132 @@ void FONSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, u
 }
 
 
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, vector to store one log acceptance ratio per amino acid in
+ * Same as calling calculateLogLikelihoodRatioPerGroupingPerCategory for every amino acid, but done in a single
+ * parallel pass over the genes.
+*/
+void FONSEModel::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios)
+{
+	calculateLogLikelihoodRatioForGroupings(genome, 0u, 1u, NULL, logAcceptanceRatios);
+}
+
+
+/* calculateLogLikelihoodRatioForGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, first gene and stride of the genes to use, one flag per amino acid (NULL for all),
+ * vector to store one log acceptance ratio per amino acid in
+ * Calculates the log acceptance ratio of the flagged amino acids in a single parallel pass over every geneStride-th
+ * gene, scaled by numGenes / number of genes used. Each thread accumulates into its own row of partial sums, which
+ * are added up in thread order afterwards.
+*/
+void FONSEModel::calculateLogLikelihoodRatioForGroupings(Genome& genome, unsigned firstGene, unsigned geneStride,
+		const char* groupingMask, std::vector<double> &logAcceptanceRatios)
+{
+	int numGenes = genome.getGenomeSize();
+	int numSampledGenes = (numGenes > (int)firstGene) ? (numGenes - firstGene + geneStride - 1) / geneStride : 0;
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+
+	std::vector<std::string> &groupings = groupingNames;
+	std::vector<unsigned> &aaIndex = groupingAAIndex;
+	std::vector<double> &mutation = groupingMutation, &mutation_proposed = groupingMutationProposed;
+	std::vector<double> &selection = groupingSelection, &selection_proposed = groupingSelectionProposed;
+	groupings.resize(numGroupings);
+	aaIndex.resize(numGroupings);
+	mutation.resize(numGroupings * numMutationCategories * 5);
+	mutation_proposed.resize(numGroupings * numMutationCategories * 5);
+	selection.resize(numGroupings * numSelectionCategories * 5);
+	selection_proposed.resize(numGroupings * numSelectionCategories * 5);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		groupings[g] = getGrouping(g);
+		aaIndex[g] = SequenceSummary::AAToAAIndex(groupings[g]);
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			parameter->getParameterForCategory(k, FONSEParameter::dM, groupings[g], false, &mutation[(g * numMutationCategories + k) * 5]);
+			parameter->getParameterForCategory(k, FONSEParameter::dM, groupings[g], true, &mutation_proposed[(g * numMutationCategories + k) * 5]);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			parameter->getParameterForCategory(k, FONSEParameter::dOmega, groupings[g], false, &selection[(g * numSelectionCategories + k) * 5]);
+			parameter->getParameterForCategory(k, FONSEParameter::dOmega, groupings[g], true, &selection_proposed[(g * numSelectionCategories + k) * 5]);
+		}
+	}
+
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	// per thread: current likelihood of every grouping followed by the proposed ones
+	partialLikelihood.assign(numThreads * numGroupings * 2, 0.0);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		double *likelihood = &partialLikelihood[omp_get_thread_num() * numGroupings * 2];
+#else
+		double *likelihood = &partialLikelihood[0];
+#endif
+		double *likelihood_proposed = likelihood + numGroupings;
+
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int n = 0; n < numSampledGenes; n++)
+		{
+			int i = firstGene + n * geneStride;
+			Gene *gene = &genome.getGene(i);
+
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+			unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+			unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			double phiValue = parameter->getSynthesisRate(i, expressionCategory, false);
+
+			for (unsigned g = 0u; g < numGroupings; g++)
+			{
+				if (groupingMask != NULL && !groupingMask[g]) continue;
+				if (gene->geneData.getAACountForAA(aaIndex[g]) == 0) continue;
+
+				unsigned mutationIndex = (g * numMutationCategories + mutationCategory) * 5;
+				unsigned selectionIndex = (g * numSelectionCategories + selectionCategory) * 5;
+				likelihood[g] += calculateLogLikelihoodRatioPerAA(*gene, groupings[g], &mutation[mutationIndex],
+						&selection[selectionIndex], phiValue);
+				likelihood_proposed[g] += calculateLogLikelihoodRatioPerAA(*gene, groupings[g], &mutation_proposed[mutationIndex],
+						&selection_proposed[selectionIndex], phiValue);
+			}
+		}
+	}
+
+	// estimate the likelihood of the whole genome from the genes used
+	double scale = numSampledGenes > 0 ? (double)numGenes / numSampledGenes : 1.0;
+	logAcceptanceRatios.resize(numGroupings);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		if (groupingMask != NULL && !groupingMask[g]) continue;
+		double likelihood = 0.0;
+		double likelihood_proposed = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			likelihood += partialLikelihood[(t * 2) * numGroupings + g];
+			likelihood_proposed += partialLikelihood[(t * 2 + 1) * numGroupings + g];
+		}
+		logAcceptanceRatios[g] = scale * likelihood_proposed - scale * likelihood;
+	}
+}
+
+
+bool FONSEModel::hasSubsampleSurrogate()
+{
+	return true;
+}
+
+
+
 
 
 
@@ -566,73 +721,109 @@ void FONSEModel::updateHyperParameter(unsigned hp)
 }
 
 
-void FONSEModel::simulateGenome(Genome & genome)
+void FONSEModel::simulateGenome(Genome &genome)
 {
-	unsigned codonIndex;
-	std::string curAA;
-
-	std::string tmpDesc = "Simulated Gene";
-
-	for (unsigned geneIndex = 0; geneIndex < genome.getGenomeSize(); geneIndex++) //loop over all genes in the genome
-	{
-		if (geneIndex % 100 == 0) std::cout << "Simulating Gene " << geneIndex << std::endl;
-		Gene gene = genome.getGene(geneIndex);
-		SequenceSummary seqSum = gene.geneData;
-		std::string tmpSeq = "ATG"; //Always will have the start amino acid
+	simulateGenomeInBlocks(genome, "");
+}
 
 
-		unsigned mixtureElement = getMixtureAssignment(geneIndex);
-		unsigned mutationCategory = getMutationCategory(mixtureElement);
-		unsigned selectionCategory = getSelectionCategory(mixtureElement);
-		unsigned synthesisRateCategory = getSynthesisRateCategory(mixtureElement);
-		double phi = getSynthesisRate(geneIndex, synthesisRateCategory, false);
+/* simulateCodonSequences (NOT EXPOSED)
+ * Arguments: see Model::simulateCodonSequences
+ * Like ROCModel::simulateCodonSequences, but the codon probabilities depend on the position, so they are calculated
+ * for every codon from parameters that are read once. The first codon is always ATG, stop codons within the sequence
+ * are dropped and the last codon is a stop codon drawn uniformly.
+*/
+void FONSEModel::simulateCodonSequences(Genome &genome, unsigned firstGene, unsigned numGenes, unsigned seed,
+		std::vector<std::string> &sequences)
+{
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	unsigned numAA = SequenceSummary::numAminoAcids();
+	unsigned numSenseCodons = SequenceSummary::numSenseCodons();
+	unsigned aaStart[GeneticCode::maxNumAA];
+	unsigned aaEnd[GeneticCode::maxNumAA];
+	unsigned codonAA[64];
 
-		std::string geneSeq = gene.getSequence();
-		for (unsigned position = 1; position < (geneSeq.size() / 3); position++)
+	// [category][amino acid][codon], read once instead of per codon
+	std::vector<double> mutation(numMutationCategories * numAA * 5, 0.0);
+	std::vector<double> selection(numSelectionCategories * numAA * 5, 0.0);
+	std::vector<unsigned> maxIndexValues(numSelectionCategories * numAA, 0u); // as in calculateLogLikelihoodRatioPerAA
+	for (unsigned aaIndex = 0u; aaIndex < numAA; aaIndex++)
+	{
+		SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart[aaIndex], aaEnd[aaIndex], false);
+		for (unsigned codonIndex = aaStart[aaIndex]; codonIndex < aaEnd[aaIndex]; codonIndex++)
+			codonAA[codonIndex] = aaIndex;
+
+		std::string aa = SequenceSummary::indexToAA(aaIndex);
+		if (SequenceSummary::GetNumCodonsForAA(aa, true) == 0u) continue; // no parameters, e.g. M, W and X
+		unsigned numCodons = aaEnd[aaIndex] - aaStart[aaIndex];
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+			getParameterForCategory(k, FONSEParameter::dM, aa, false, &mutation[(k * numAA + aaIndex) * 5]);
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
 		{
-			std::string codon = geneSeq.substr((position * 3), 3);
-			curAA = SequenceSummary::codonToAA(codon);
-
-			if (curAA == "X") continue;
-
-			unsigned numCodons = SequenceSummary::GetNumCodonsForAA(curAA);
-
-			double* codonProb = new double[numCodons](); //size the arrays to the proper size based on # of codons.
-			double* mutation = new double[numCodons - 1]();
-			double* selection = new double[numCodons - 1]();
-
-
-			if (curAA == "M" || curAA == "W")
+			double *aaSelection = &selection[(k * numAA + aaIndex) * 5];
+			getParameterForCategory(k, FONSEParameter::dOmega, aa, false, aaSelection);
+			unsigned maxIndexVal = 0u;
+			for (unsigned j = 1u; j < (numCodons - 1); j++)
 			{
-				codonProb[0] = 1;
+				if (aaSelection[maxIndexVal] < aaSelection[j]) maxIndexVal = j;
 			}
-			else
+			maxIndexValues[k * numAA + aaIndex] = maxIndexVal;
+		}
+	}
+
+	sequences.resize(numGenes);
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+		double codonProb[6];
+		std::vector<unsigned> codonIndices;
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+#ifndef __APPLE__
+#pragma omp for schedule(dynamic, 16)
+#endif
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			unsigned geneIndex = firstGene + i;
+			unsigned mixtureElement = getMixtureAssignment(geneIndex);
+			unsigned mutationCategory = getMutationCategory(mixtureElement);
+			unsigned selectionCategory = getSelectionCategory(mixtureElement);
+			unsigned synthesisRateCategory = getSynthesisRateCategory(mixtureElement);
+			double phi = getSynthesisRate(geneIndex, synthesisRateCategory, false);
+
+			genome.getGene(geneIndex).geneData.getCodonIndexSequence(codonIndices);
+			std::seed_seq seedSequence{seed, geneIndex};
+			std::default_random_engine generator(seedSequence);
+
+			std::string &sequence = sequences[i];
+			sequence.clear();
+			sequence.reserve(3 * codonIndices.size() + 6);
+			sequence.append("ATG"); //Always will have the start amino acid
+			for (unsigned position = 1u; position < codonIndices.size(); position++)
 			{
-				unsigned maxIndexVal = 0u;
-				for (unsigned i = 1; i < (numCodons - 1); i++)
+				unsigned codonIndex = codonIndices[position];
+				if (codonIndex >= numSenseCodons) continue; // stop codon or not recognized
+
+				unsigned aaIndex = codonAA[codonIndex];
+				unsigned numCodons = aaEnd[aaIndex] - aaStart[aaIndex];
+				double draw = uniform(generator);
+				unsigned drawn = 0u;
+				if (numCodons > 1)
 				{
-					if (selection[maxIndexVal] < selection[i])
-					{
-						maxIndexVal = i;
-					}
+					calculateCodonProbabilityVector(numCodons, position, maxIndexValues[selectionCategory * numAA + aaIndex],
+							&mutation[(mutationCategory * numAA + aaIndex) * 5], &selection[(selectionCategory * numAA + aaIndex) * 5],
+							phi, codonProb);
+					double sum = codonProb[0];
+					while (drawn < numCodons - 1 && draw >= sum) sum += codonProb[++drawn];
 				}
-				getParameterForCategory(mutationCategory, FONSEParameter::dM, curAA, false, mutation);
-				getParameterForCategory(selectionCategory, FONSEParameter::dOmega, curAA, false, selection);
-				calculateCodonProbabilityVector(numCodons, position, maxIndexVal, mutation, selection, phi, codonProb);
+				sequence.append(SequenceSummary::codonArray[aaStart[aaIndex] + drawn]);
 			}
-
-
-			codonIndex = Parameter::randMultinom(codonProb, numCodons);
-			unsigned aaStart;
-			unsigned aaEnd;
-			SequenceSummary::AAToCodonRange(curAA, aaStart, aaEnd, false);  //need the first spot in the array where the codons for curAA are
-			codon = seqSum.indexToCodon(aaStart + codonIndex);//get the correct codon based off codonIndex
-			tmpSeq += codon;
+			unsigned numStopCodons = 64u - numSenseCodons;
+			unsigned stopCodon = std::min(numSenseCodons + (unsigned)(uniform(generator) * numStopCodons), 63u);
+			sequence.append(SequenceSummary::codonArray[stopCodon]);
 		}
-		std::string codon = seqSum.indexToCodon((unsigned)Parameter::randUnif(61.0, 63.0)); //randomly choose a stop codon, from range 61-63
-		tmpSeq += codon;
-		Gene simulatedGene(tmpSeq, tmpDesc, gene.getId());
-		genome.addGene(simulatedGene, true);
 	}
 }
 
@@ -27,7 +27,7 @@ FONSEParameter::FONSEParameter() : Parameter()
 }
 
 
-FONSEParameter::FONSEParameter(std::string filename) : Parameter(22)
+FONSEParameter::FONSEParameter(std::string filename) : Parameter(SequenceSummary::numAminoAcids())
 {
 	currentCodonSpecificParameter.resize(2);
 	proposedCodonSpecificParameter.resize(2);
@@ -37,7 +37,7 @@ FONSEParameter::FONSEParameter(std::string filename) : Parameter(22)
 
 FONSEParameter::FONSEParameter(std::vector<double> stdDevSynthesisRate, unsigned _numMixtures, std::vector<unsigned> geneAssignment,
 	std::vector<std::vector<unsigned>> thetaKMatrix, bool splitSer, std::string _mutationSelectionState) :
-	Parameter(22)
+	Parameter(SequenceSummary::numAminoAcids())
 {
 	initParameterSet(stdDevSynthesisRate, _numMixtures, geneAssignment, thetaKMatrix, splitSer, _mutationSelectionState);
 	initFONSEParameterSet();
@@ -88,7 +88,7 @@ FONSEParameter::~FONSEParameter()
 void FONSEParameter::initFONSEParameterSet()
 {
 	mutation_prior_sd = 0.35;
-	groupList = { "A", "C", "D", "E", "F", "G", "H", "I", "K", "L", "N", "P", "Q", "R", "S", "T", "V", "Y", "Z" };
+	groupList = SequenceSummary::aminoAcidsWithParameters();
 	// proposal bias and std for codon specific parameter
 	bias_csp = 0;
 	std_csp.resize(numParam, 0.1);
@@ -260,7 +260,7 @@ void FONSEParameter::initFONSEValuesFromFile(std::string filename)
 		proposedCodonSpecificParameter[dOmega][i] = currentCodonSpecificParameter[dOmega][i];
 	}
 
-	groupList = { "A", "C", "D", "E", "F", "G", "H", "I", "K", "L", "N", "P", "Q", "R", "S", "T", "V", "Y", "Z" };
+	groupList = SequenceSummary::aminoAcidsWithParameters();
 	//groupList = { "C", "D", "E", "F", "H", "K", "M", "N", "Q", "W", "Y" };
 }
 
@@ -454,7 +454,7 @@ void FONSEParameter::updateCodonSpecificParameterTrace(unsigned sample, std::str
 CovarianceMatrix& FONSEParameter::getCovarianceMatrixForAA(std::string aa)
 {
     aa[0] = (char)std::toupper(aa[0]);
-    unsigned aaIndex = SequenceSummary::aaToIndex.find(aa)->second;
+    unsigned aaIndex = SequenceSummary::AAToAAIndex(aa);
     return covarianceMatrix[aaIndex];
 }
 
@@ -475,37 +475,7 @@ double FONSEParameter::getCurrentCodonSpecificProposalWidth(unsigned aa)
 
 void FONSEParameter::proposeCodonSpecificParameter()
 {
-    for (unsigned k = 0; k < getGroupListSize(); k++)
-    {
-        std::vector<double> iidProposed;
-        std::string aa = getGrouping(k);
-		unsigned aaStart;
-		unsigned aaEnd;
-		SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, true);
-        unsigned numCodons = aaEnd - aaStart;
-        for (unsigned i = 0u; i < numCodons * (numMutationCategories + numSelectionCategories); i++)
-        {
-            iidProposed.push_back(randNorm(0.0, 1.0));
-        }
-        
-        std::vector<double> covaryingNums;
-        covaryingNums = covarianceMatrix[SequenceSummary::AAToAAIndex(aa)].transformIidNumersIntoCovaryingNumbers(iidProposed);
-        for (unsigned i = 0; i < numMutationCategories; i++)
-        {
-            for (unsigned j = i * numCodons, l = aaStart; j < (i * numCodons) + numCodons; j++, l++)
-            {
-                proposedCodonSpecificParameter[dM][i][l] = currentCodonSpecificParameter[dM][i][l] + covaryingNums[j];
-            }
-        }
-        for (unsigned i = 0; i < numSelectionCategories; i++)
-        {
-            for (unsigned j = i * numCodons, l = aaStart; j < (i * numCodons) + numCodons; j++, l++)
-            {
-                proposedCodonSpecificParameter[dOmega][i][l] = currentCodonSpecificParameter[dOmega][i][l]
-                + covaryingNums[(numMutationCategories * numCodons) + j];
-            }
-        }
-    }
+    proposeCovaryingCodonSpecificParameters(dM, dOmega);
 }
 
 
@@ -514,7 +484,7 @@ void FONSEParameter::updateCodonSpecificParameter(std::string grouping)
 	unsigned aaStart;
 	unsigned aaEnd;
 	SequenceSummary::AAToCodonRange(grouping, aaStart, aaEnd, true);
-    unsigned aaIndex = SequenceSummary::aaToIndex.find(grouping)->second;
+    unsigned aaIndex = SequenceSummary::AAToAAIndex(grouping);
 	numAcceptForCodonSpecificParameters[aaIndex]++;
     
     for (unsigned k = 0u; k < numMutationCategories; k++)
@@ -604,7 +574,7 @@ void FONSEParameter::proposeHyperParameters()
 
 
 FONSEParameter::FONSEParameter(std::vector<double> stdDevSynthesisRate, std::vector<unsigned> geneAssignment,
-                               std::vector<unsigned> _matrix, bool splitSer) : Parameter(22)
+                               std::vector<unsigned> _matrix, bool splitSer) : Parameter(SequenceSummary::numAminoAcids())
 {
     unsigned _numMixtures = _matrix.size() / 2;
     std::vector<std::vector<unsigned>> thetaKMatrix;
@@ -625,7 +595,7 @@ FONSEParameter::FONSEParameter(std::vector<double> stdDevSynthesisRate, std::vec
 
 
 FONSEParameter::FONSEParameter(std::vector<double> stdDevSynthesisRate, unsigned _numMixtures, std::vector<unsigned> geneAssignment,
-                               bool splitSer, std::string _mutationSelectionState) : Parameter(22)
+                               bool splitSer, std::string _mutationSelectionState) : Parameter(SequenceSummary::numAminoAcids())
 {
     std::vector<std::vector<unsigned>> thetaKMatrix;
     initParameterSet(stdDevSynthesisRate, _numMixtures, geneAssignment, thetaKMatrix, splitSer, _mutationSelectionState);
@@ -648,7 +618,7 @@ void FONSEParameter::initCovarianceMatrix(SEXP _matrix, std::string aa)
     
     for (unsigned i = 0u; i < aa.length(); i++)	aa[i] = (char)std::toupper(aa[i]);
     
-    unsigned aaIndex = SequenceSummary::aaToIndex.find(aa)->second;
+    unsigned aaIndex = SequenceSummary::AAToAAIndex(aa);
     unsigned numRows = matrix.nrow();
     std::vector<double> covMatrix(numRows * numRows);
     
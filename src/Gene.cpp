@@ -197,6 +197,16 @@ void Gene::setSequence(std::string _seq)
 }
 
 
+//setSummarizedSequence (NOT EXPOSED)
+//Arguments: sequence
+//Sets the sequence string as is, without cleaning or processing it. The sequence summary
+//has to be filled to match it by the caller (see Genome::readGenomeCache).
+void Gene::setSummarizedSequence(std::string _seq)
+{
+    seq = _seq;
+}
+
+
 std::vector <unsigned> Gene::getRFP_count()
 {
     return geneData.getRFP_count();
@@ -350,7 +360,7 @@ unsigned Gene::getAACount(std::string aa)
 {
     unsigned rv = 0;
 
-    if (SequenceSummary::aaToIndex.end() != SequenceSummary::aaToIndex.find(aa))
+    if (aa.length() == 1 && SequenceSummary::AAToAAIndex(aa) != GeneticCode::invalidAA)
     {
         rv = geneData.getAACountForAA(aa);
     }
@@ -362,11 +372,27 @@ unsigned Gene::getAACount(std::string aa)
 }
 
 
+/* isCodonName (NOT EXPOSED)
+ * Arguments: codon
+ * Returns true if codon is a codon of the genetic code written in upper case A, C, G and T. The codon encoding also
+ * takes lower case and U, the R accessors below keep rejecting those like the codon name lookup did before.
+*/
+static bool isCodonName(const std::string &codon)
+{
+    if (codon.length() != 3) return false;
+    for (unsigned i = 0u; i < 3u; i++)
+    {
+        if (codon[i] != 'A' && codon[i] != 'C' && codon[i] != 'G' && codon[i] != 'T') return false;
+    }
+    return SequenceSummary::codonToIndex(codon) != GeneticCode::invalidCodon;
+}
+
+
 unsigned Gene::getCodonCount(std::string& codon)
 {
     unsigned rv = 0;
 
-    if (SequenceSummary::codonToIndexWithReference.end() != SequenceSummary::codonToIndexWithReference.find(codon))
+    if (isCodonName(codon))
     {
         rv = geneData.getCodonCountForCodon(codon);
     }
@@ -381,7 +407,7 @@ unsigned Gene::getRFPObserved(std::string codon)
 {
     unsigned rv = 0;
 
-    if (SequenceSummary::codonToIndexWithReference.end() != SequenceSummary::codonToIndexWithReference.find(codon))
+    if (isCodonName(codon))
     {
         rv = geneData.getRFPObserved(codon);
     }
@@ -400,7 +426,7 @@ std::vector <unsigned> Gene::getCodonPositions(std::string codon)
     tmp = &rv; //So if an invalid codon is given, tmp will point to an empty vector.
 
 
-    if (SequenceSummary::codonToIndexWithReference.end() != SequenceSummary::codonToIndexWithReference.find(codon))
+    if (isCodonName(codon))
     {
         tmp = geneData.getCodonPositions(codon);
     }
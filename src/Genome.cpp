@@ -1,10 +1,25 @@
 #include "include/Genome.h"
 
+#include <cstring>
+#include <algorithm>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 #ifndef STANDALONE
 #include <Rcpp.h>
 using namespace Rcpp;
 #endif
 
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
 
 
 
@@ -16,15 +31,18 @@ using namespace Rcpp;
 
 Genome::Genome()
 {
-	//ctor
+	geneSet.storage = std::make_shared<std::vector<Gene>>();
+	geneSet.isView = false;
+	simulatedGeneSet.storage = std::make_shared<std::vector<Gene>>();
+	simulatedGeneSet.isView = false;
 }
 
 
 Genome& Genome::operator=(const Genome& rhs)
 {
 	if (this == &rhs) return *this; // handle self assignment
-	genes = rhs.genes;
-	simulatedGenes = rhs.simulatedGenes;
+	geneSet = rhs.geneSet; //shares the genes, see getOwnGenes
+	simulatedGeneSet = rhs.simulatedGeneSet;
 	numGenesWithPhi = rhs.numGenesWithPhi;
 	//assignment operator
 	return *this;
@@ -41,9 +59,20 @@ bool Genome::operator==(const Genome& other) const
 {
 	bool match = true;
 
-	if (!(this->genes == other.genes)) { match = false; } //Do a ! operation because only the gene comparison is implemented,
-	//not the != operator.
-	if (!(this->simulatedGenes == other.simulatedGenes)) { match = false; }
+	for (unsigned set = 0u; set < 2u && match; set++)
+	{
+		bool simulated = set == 1u;
+		const GeneSet &ours = simulated ? simulatedGeneSet : geneSet;
+		const GeneSet &theirs = simulated ? other.simulatedGeneSet : other.geneSet;
+		unsigned size = (unsigned)(ours.isView ? ours.view.size() : ours.storage->size());
+		unsigned otherSize = (unsigned)(theirs.isView ? theirs.view.size() : theirs.storage->size());
+		if (size != otherSize) { match = false; }
+		for (unsigned i = 0u; i < size && match; i++)
+		{
+			//Do a ! operation because only the gene comparison is implemented, not the != operator.
+			if (!(geneAt(i, simulated) == other.geneAt(i, simulated))) { match = false; }
+		}
+	}
 	if (this->numGenesWithPhi != other.numGenesWithPhi) { match = false; }
 
 	return match;
@@ -58,6 +87,86 @@ bool Genome::operator==(const Genome& other) const
 //----------------------------------------//
 
 
+// CSV tokenizer used by the count file readers. The whole file is read into one buffer, the lines are found with
+// memchr and fields are parsed in place, without creating a string per field.
+
+
+/* readFileToBuffer (NOT EXPOSED)
+ * Arguments: file name, string to store the content in
+ * Returns false if the file can not be opened.
+*/
+static bool readFileToBuffer(const std::string &filename, std::string &buffer)
+{
+	std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+	if (input.fail()) return false;
+	input.seekg(0, std::ios::end);
+	std::streamoff size = input.tellg();
+	input.seekg(0, std::ios::beg);
+	buffer.resize(size > 0 ? (std::size_t)size : 0u);
+	if (!buffer.empty()) input.read(&buffer[0], buffer.size());
+	return true;
+}
+
+
+/* findCSVLines (NOT EXPOSED)
+ * Arguments: file content, vectors to store the begin and end offset of every line in
+ * Finds all lines after the header line, without line breaks (\n or \r\n). Empty lines are skipped.
+*/
+static void findCSVLines(const std::string &buffer, std::vector<std::size_t> &lineBegin, std::vector<std::size_t> &lineEnd)
+{
+	const char *data = buffer.data();
+	std::size_t size = buffer.size();
+	const char *newLine = (const char *)std::memchr(data, '\n', size);
+	std::size_t begin = newLine == NULL ? size : (std::size_t)(newLine - data) + 1u; // skip the header
+	while (begin < size)
+	{
+		newLine = (const char *)std::memchr(data + begin, '\n', size - begin);
+		std::size_t next = newLine == NULL ? size : (std::size_t)(newLine - data);
+		std::size_t end = next;
+		if (end > begin && data[end - 1] == '\r') end--;
+		if (end > begin)
+		{
+			lineBegin.push_back(begin);
+			lineEnd.push_back(end);
+		}
+		begin = next + 1u;
+	}
+}
+
+
+/* nextCSVField (NOT EXPOSED)
+ * Arguments: current position (moved past the field and its comma), end of the line, begin and end of the field
+ * Returns false if there is no field left in the line.
+*/
+static inline bool nextCSVField(const char *&position, const char *lineEnd, const char *&fieldBegin, const char *&fieldEnd)
+{
+	if (position > lineEnd) return false;
+	fieldBegin = position;
+	const char *comma = (const char *)std::memchr(position, ',', lineEnd - position);
+	fieldEnd = comma == NULL ? lineEnd : comma;
+	position = fieldEnd + 1;
+	return true;
+}
+
+
+/* parseCSVUnsigned (NOT EXPOSED)
+ * Arguments: begin and end of a field
+ * Parses the leading digits of a field after optional blanks, like std::atoi does for non-negative numbers. Returns 0
+ * if there are no digits.
+*/
+static inline unsigned parseCSVUnsigned(const char *begin, const char *end)
+{
+	while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '"')) begin++;
+	unsigned value = 0u;
+	for (; begin < end && *begin >= '0' && *begin <= '9'; begin++)
+	{
+		value = value * 10u + (unsigned)(*begin - '0');
+	}
+	return value;
+}
+
+
+
 void Genome::readFasta(std::string filename, bool Append) // read Fasta format sequences
 {
 	try
@@ -158,11 +267,11 @@ void Genome::writeFasta (std::string filename, bool simulated)
 		}
 		else
 		{
-			unsigned sized = simulated ? simulatedGenes.size() : genes.size();
+			unsigned sized = getGenomeSize(simulated);
 
 			for (unsigned i = 0u; i < sized; i++)
 			{
-				Gene *currentGene = simulated ? &simulatedGenes[i] : &genes[i];
+				Gene *currentGene = &getGene(i, simulated);
 
 				Fout << ">" << currentGene->getDescription() << "\n";
 				for (unsigned j = 0u; j < currentGene->length(); j++)
@@ -182,64 +291,75 @@ void Genome::writeFasta (std::string filename, bool simulated)
 }
 
 
+/* readRFPFile (RCPP EXPOSED)
+ * Arguments: file name
+ * Reads an RFP count file (ORF,RFP_Counts,Codon_Counts,Codon; one line per gene and codon, the lines of a gene
+ * consecutive) and appends its genes. The codon and RFP counts are stored directly in the sequence summaries, the
+ * genes have no sequence and no codon positions. The lines are parsed in parallel, the genes are then created in file
+ * order.
+*/
 void Genome::readRFPFile(std::string filename)
 {
-	std::ifstream Fin;
-	Fin.open(filename.c_str());
-	if (Fin.fail())
+	std::string buffer;
+	if (!readFileToBuffer(filename, buffer))
 	{
-			("Error in Genome::readRFPFile: Can not open RFP file %\n", filename);
+		my_printError("Error in Genome::readRFPFile: Can not open RFP file %\n", filename);
+		return;
 	}
 
-	std::string tmp;
-	std::getline(Fin, tmp); //trash the first line
-	std::string prevID = "";
-	Gene tmpGene;
-	bool first = true;
-	std::string seq = "";
-
-	while (std::getline(Fin,tmp))
+	std::vector<std::size_t> lineBegin, lineEnd;
+	findCSVLines(buffer, lineBegin, lineEnd);
+	int numLines = (int)lineBegin.size();
+
+	// per line: end of the gene id, RFP count, codon count, codon index
+	std::vector<std::size_t> idEnd(numLines);
+	std::vector<unsigned> rfpCounts(numLines), codonCounts(numLines), codonIndices(numLines);
+	const GeneticCode &code = CodonEncoding::activeCode();
+	const char *data = buffer.data();
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static) if (numLines > 100000)
+#endif
+	for (int i = 0; i < numLines; i++)
 	{
-		std::size_t pos = tmp.find(",");
-		std::string ID = tmp.substr(0, pos);
+		const char *position = data + lineBegin[i];
+		const char *end = data + lineEnd[i];
+		const char *fieldBegin = position, *fieldEnd = end;
+		nextCSVField(position, end, fieldBegin, fieldEnd);
+		idEnd[i] = fieldEnd - data;
+		rfpCounts[i] = nextCSVField(position, end, fieldBegin, fieldEnd) ? parseCSVUnsigned(fieldBegin, fieldEnd) : 0u;
+		codonCounts[i] = nextCSVField(position, end, fieldBegin, fieldEnd) ? parseCSVUnsigned(fieldBegin, fieldEnd) : 0u;
+		codonIndices[i] = nextCSVField(position, end, fieldBegin, fieldEnd) && fieldEnd - fieldBegin >= 3 ?
+			code.codonIndex(fieldBegin) : GeneticCode::invalidCodon;
+	}
 
-		if (first)
-		{
-			prevID = ID;
-			first = false;
-		}
-		if (ID != prevID)
+	unsigned numInvalid = 0u;
+	Gene tmpGene;
+	for (int i = 0; i < numLines; i++)
+	{
+		std::size_t idLength = idEnd[i] - lineBegin[i];
+		bool newGene = i == 0 || idLength != idEnd[i - 1] - lineBegin[i - 1]
+			|| std::memcmp(data + lineBegin[i], data + lineBegin[i - 1], idLength) != 0;
+		if (newGene)
 		{
-			tmpGene.setId(prevID);
-			tmpGene.setDescription("No description for RFP Model");
-			tmpGene.setSequence(seq);
-			addGene(tmpGene); //add to genome
+			if (i != 0) addGene(tmpGene);
 			tmpGene.clear();
-			seq = "";
+			tmpGene.setId(buffer.substr(lineBegin[i], idLength));
+			tmpGene.setDescription("No description for RFP Model");
 		}
-		std::size_t pos2 = tmp.find(",", pos + 1);
-		std::string value = tmp.substr(pos + 1, pos2 - (pos + 1));
-		unsigned tmpRFP = (unsigned)std::atoi(value.c_str());
-		pos = tmp.find(",", pos2 + 1);
-		value = tmp.substr(pos2 + 1, pos - (pos2 + 1));
-		unsigned counts = (unsigned)std::atoi(value.c_str());
 
-		std::string codon = tmp.substr(pos + 1, 3);
-		for (unsigned i = 0; i < counts; i++)
-			seq += codon;
-
-		prevID = ID;
-		unsigned index = SequenceSummary::codonToIndex(codon);
-		tmpGene.geneData.setRFPObserved(index, tmpRFP);
+		unsigned index = codonIndices[i];
+		if (index == GeneticCode::invalidCodon)
+		{
+			numInvalid++;
+			continue;
+		}
+		tmpGene.geneData.setRFPObserved(index, rfpCounts[i]);
+		tmpGene.geneData.setCodonCount(index, tmpGene.geneData.getCodonCountForCodon(index) + codonCounts[i]);
 	}
+	if (numLines != 0) addGene(tmpGene);
 
-	tmpGene.setId(prevID);
-	tmpGene.setDescription("No description for RFP Model");
-	tmpGene.setSequence(seq);
-
-	addGene(tmpGene); //add to genome
-
-	Fin.close();
+	if (numInvalid != 0u)
+		my_printError("WARNING: Genome::readRFPFile: % lines with an unrecognized codon were ignored\n", numInvalid);
 }
 
 
@@ -253,11 +373,11 @@ void Genome::writeRFPFile(std::string filename, bool simulated)
 	}
 
 	Fout << "ORF,RFP_Counts,Codon_Counts,Codon\n";
-	unsigned sized = simulated ? simulatedGenes.size() : genes.size();
+	unsigned sized = getGenomeSize(simulated);
 
 	for (unsigned geneIndex = 0; geneIndex < sized; geneIndex++)
 	{
-		Gene *currentGene = simulated ? &simulatedGenes[geneIndex] : &genes[geneIndex];
+		Gene *currentGene = &getGene(geneIndex, simulated);
 
 		for (unsigned codonIndex = 0; codonIndex < 64; codonIndex++) {
 			std::string codon = SequenceSummary::codonArray[codonIndex];
@@ -271,125 +391,499 @@ void Genome::writeRFPFile(std::string filename, bool simulated)
 }
 
 
-/* readPANSEFile
- * Arguments: string filename
+/* readPANSEFile (RCPP EXPOSED)
+ * Arguments: string filename, bool Append
  *
  * Read in a PANSE-formatted file: GeneID,Codon,Position (1-indexed),rfp_count
- * The positions are not necessarily in the right order.
+ * The lines of a gene have to be consecutive, its positions are not necessarily in the right order. The file is read
+ * once and its lines are parsed in parallel. Positions missing in the file become NNN in the sequence, only positions
+ * with a count > 0 are stored (see SequenceSummary::setSparseRFP_count).
 */
 void Genome::readPANSEFile(std::string filename, bool Append)
 {
-	try {
-		if (!Append)
+	if (!Append)
+	{
+		clear();
+	}
+	std::string buffer;
+	if (!readFileToBuffer(filename, buffer))
+	{
+		my_printError("Error in Genome::readPANSEFile: Can not open PANSE file %\n", filename);
+		return;
+	}
+
+	std::vector<std::size_t> lineBegin, lineEnd;
+	findCSVLines(buffer, lineBegin, lineEnd);
+	int numLines = (int)lineBegin.size();
+
+	// per line: end of the gene id, begin of the codon, position (0-indexed), RFP count
+	std::vector<std::size_t> idEnd(numLines), codonBegin(numLines);
+	std::vector<unsigned> positions(numLines), counts(numLines);
+	std::vector<char> valid(numLines);
+	const char *data = buffer.data();
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static) if (numLines > 100000)
+#endif
+	for (int i = 0; i < numLines; i++)
+	{
+		const char *position = data + lineBegin[i];
+		const char *end = data + lineEnd[i];
+		const char *fieldBegin = position, *fieldEnd = end;
+		nextCSVField(position, end, fieldBegin, fieldEnd);
+		idEnd[i] = fieldEnd - data;
+		valid[i] = nextCSVField(position, end, fieldBegin, fieldEnd) && fieldEnd - fieldBegin >= 3;
+		codonBegin[i] = fieldBegin - data;
+		unsigned oneIndexed = nextCSVField(position, end, fieldBegin, fieldEnd) ? parseCSVUnsigned(fieldBegin, fieldEnd) : 0u;
+		valid[i] = valid[i] && oneIndexed != 0u;
+		positions[i] = oneIndexed - 1u;
+		counts[i] = nextCSVField(position, end, fieldBegin, fieldEnd) ? parseCSVUnsigned(fieldBegin, fieldEnd) : 0u;
+	}
+
+	unsigned numInvalid = 0u;
+	Gene tmpGene;
+	std::string seq;
+	std::vector<std::pair<unsigned, unsigned>> nonZero; // position, count
+	std::vector<unsigned> nonZeroPositions, nonZeroCounts;
+	for (int first = 0, last; first < numLines; first = last)
+	{
+		std::size_t idLength = idEnd[first] - lineBegin[first];
+		unsigned numPositions = 0u;
+		for (last = first; last < numLines; last++)
 		{
-			clear();
+			if (idEnd[last] - lineBegin[last] != idLength
+				|| std::memcmp(data + lineBegin[last], data + lineBegin[first], idLength) != 0) break;
+			if (valid[last] && positions[last] + 1u > numPositions) numPositions = positions[last] + 1u;
 		}
-		std::ifstream Fin;
-		Fin.open(filename.c_str());
-		if (Fin.fail()) {
-			my_printError("Error in Genome::readPANSEFile: Can not open PANSE file %\n", filename);
+
+		seq.assign(3u * numPositions, 'N');
+		nonZero.clear();
+		for (int i = first; i < last; i++)
+		{
+			if (!valid[i])
+			{
+				numInvalid++;
+				continue;
+			}
+			seq.replace(3u * positions[i], 3u, data + codonBegin[i], 3u);
+			if (counts[i] != 0u) nonZero.push_back(std::make_pair(positions[i], counts[i]));
 		}
-		else
+		std::sort(nonZero.begin(), nonZero.end());
+		nonZeroPositions.clear();
+		nonZeroCounts.clear();
+		for (unsigned j = 0u; j < nonZero.size(); j++)
 		{
-			std::string tmp;
-			std::getline(Fin, tmp); //trash the first line
-			std::string prevID = "";
-			Gene tmpGene;
-			bool first = true;
-			std::string seq = "";
+			// a position listed twice gets the sum of its counts
+			if (!nonZeroPositions.empty() && nonZeroPositions.back() == nonZero[j].first)
+				nonZeroCounts.back() += nonZero[j].second;
+			else
+			{
+				nonZeroPositions.push_back(nonZero[j].first);
+				nonZeroCounts.push_back(nonZero[j].second);
+			}
+		}
 
-			std::map<std::string, unsigned> genes;
-			std::map<std::string, unsigned>::iterator git;
+		tmpGene.clear();
+		tmpGene.setId(buffer.substr(lineBegin[first], idLength));
+		tmpGene.setDescription("No description for PANSE Model");
+		tmpGene.setSequence(seq);
+		tmpGene.geneData.setSparseRFP_count(nonZeroPositions, nonZeroCounts, numPositions);
+		addGene(tmpGene); //add to genome
+	}
 
-			//First pass: For each gene name, count its size.
-			while (std::getline(Fin, tmp)) {
-				std::size_t pos = tmp.find(",");
-				std::string ID = tmp.substr(0, pos);
+	if (numInvalid != 0u)
+		my_printError("WARNING: Genome::readPANSEFile: % lines without a codon or position were ignored\n", numInvalid);
+}
 
-				if (first) {
-					prevID = ID;
-					first = false;
-					genes[ID] = 0;
-				}
-				if (ID != prevID) {
-					genes[prevID] *= 3; //multiply by three since codons
-					genes[ID] = 0; //initialize the new genes[ID]
-				}
-				prevID = ID;
-				genes[ID]++;
-			}
-			genes[prevID] *= 3; //multiply by three since codons
-			Fin.close();
-
-			Fin.open(filename.c_str());
-			std::getline(Fin, tmp); //retrash first line
-			prevID = "";
-			first = true;
-			std::vector<unsigned> RFP_counts;
-
-			//Now for each line associated with a gene ID, set the string appropriately
-			while (std::getline(Fin, tmp)) {
-				std::size_t pos = tmp.find(",");
-				std::string ID = tmp.substr(0, pos);
-
-				if (first) {
-					prevID = ID;
-					first = false;
-					git = genes.find(ID);
-					seq.resize(git->second);
-				}
-				if (ID != prevID) {
-					tmpGene.setId(prevID);
-					tmpGene.setDescription("No description for PANSE Model");
-					tmpGene.setSequence(seq);
-					tmpGene.addRFP_count(RFP_counts);
-					addGene(tmpGene); //add to genome
-					tmpGene.clear();
-					seq = "";
-
-					git = genes.find(ID);
-					seq.resize(git->second);
-					RFP_counts.clear();
-				}
-				// PANSE file format: GeneID,Codon,Position (1-indexed),rfp_count
-				std::size_t pos2 = tmp.find(",", pos + 1);
 
-				// Each codon is guaranteed to be of size 3
-				std::string codon = tmp.substr(pos + 1, 3);
+/* writePANSEFile (RCPP EXPOSED)
+ * Arguments: string filename, bool simulated
+ *
+ * Writes the genes in the PANSE format read by readPANSEFile: GeneID,Codon,Position (1-indexed),rfp_count
+ * One line per codon of the sequence, positions without counts get 0.
+*/
+void Genome::writePANSEFile(std::string filename, bool simulated)
+{
+	std::ofstream Fout;
+	Fout.open(filename.c_str());
+	if (Fout.fail())
+	{
+		my_printError("Error in Genome::writePANSEFile: Can not open output PANSE file %\n", filename);
+		return;
+	}
+
+	Fout << "GeneID,Codon,Position,rfp_count\n";
+	std::string line;
+	for (unsigned geneIndex = 0u; geneIndex < getGenomeSize(simulated); geneIndex++)
+	{
+		Gene &gene = getGene(geneIndex, simulated);
+		const std::string &id = gene.getId();
+		std::string seq = gene.getSequence();
+		const std::vector<unsigned> &countPositions = gene.geneData.getRFP_countPositions();
+		const std::vector<unsigned> &countValues = gene.geneData.getRFP_countValues();
+		unsigned next = 0u; // next position with a count
+		for (unsigned position = 0u; 3u * position + 2u < seq.size(); position++)
+		{
+			unsigned count = 0u;
+			if (next < countPositions.size() && countPositions[next] == position)
+				count = countValues[next++];
+			line = id;
+			line += ',';
+			line.append(seq, 3u * position, 3u);
+			line += ',';
+			line += std::to_string(position + 1u);
+			line += ',';
+			line += std::to_string(count);
+			line += '\n';
+			Fout << line;
+		}
+	}
+	Fout.close();
+}
+
+
+// Genome cache (.ribgenome): the summaries of a genome in binary form, so repeated runs skip parsing and counting.
+// All values are stored in the byte order of the machine that wrote the file.
+// header:  "RIBGENOM", u32 version, u32 byte order mark, u32 codon table, u32 split amino acids, u32 flags,
+//          u64 source hash, u64 payload size, u64 payload hash
+// payload: u32 number of phi sets, u32 genes with phi per set, u32 genes, u32 simulated genes, then per gene:
+//          u32 id length, id, u32 description length, description, u32 codon counts[64], u32 RFP observed[64],
+//          u32 number of observed phi values, f64 values, u32 number of positions, u8 codon index per position,
+//          u32 RFP count length, u32 number of positions with an RFP count, u32 positions, u32 counts
+static const char genomeCacheMagic[8] = {'R', 'I', 'B', 'G', 'E', 'N', 'O', 'M'};
+static const uint32_t genomeCacheVersion = 1u;
+static const uint32_t genomeCacheByteOrderMark = 0x01020304u;
+static const uint32_t genomeCacheWithPositions = 1u;
+static const std::size_t genomeCacheHeaderSize = 8u + 5u * sizeof(uint32_t) + 3u * sizeof(uint64_t);
+
+
+/* hashBytes (NOT EXPOSED)
+ * Arguments: data, size, hash to continue from
+ * 64 bit FNV-1a hash. Start with 14695981039346656037 (see hashGenomeSources).
+*/
+static uint64_t hashBytes(const char *data, std::size_t size, uint64_t hash)
+{
+	for (std::size_t i = 0u; i < size; i++)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
 
-				// Make pos find next comma to find position integer
-				pos = tmp.find(",", pos2 + 1);
-				unsigned position = (unsigned) std::atoi(tmp.substr(pos2 + 1, pos - (pos2 + 1)).c_str()) - 1;
+/* hashGenomeSources (NOT EXPOSED)
+ * Arguments: files the genome was read from, variable to store the hash in
+ * Hashes the content of all files in order. Returns false if a file can not be read.
+*/
+static bool hashGenomeSources(const std::vector<std::string> &sourceFiles, uint64_t &hash)
+{
+	hash = 14695981039346656037ull;
+	std::string buffer;
+	for (unsigned i = 0u; i < sourceFiles.size(); i++)
+	{
+		if (!readFileToBuffer(sourceFiles[i], buffer)) return false;
+		uint64_t size = buffer.size();
+		hash = hashBytes((const char *)&size, sizeof(size), hash);
+		hash = hashBytes(buffer.data(), buffer.size(), hash);
+	}
+	return true;
+}
 
-				// Get rfp_count from last comma-separated value
-				unsigned RFP_count = (unsigned) std::atoi(tmp.substr(pos + 1).c_str());
-				RFP_counts.push_back(RFP_count);
 
-				// Now add codon to appropriate place in sequence
-				seq[position * 3] = codon[0];
-				seq[position * 3 + 1] = codon[1];
-				seq[position * 3 + 2] = codon[2];
+template <typename T>
+static void appendToCache(std::string &buffer, T value)
+{
+	buffer.append((const char *)&value, sizeof(T));
+}
 
-				prevID = ID;
-			}
 
-			tmpGene.setId(prevID);
-			tmpGene.setDescription("No description for PANSE Model");
-			tmpGene.setSequence(seq);
-			tmpGene.addRFP_count(RFP_counts);
+/* appendGeneToCache (NOT EXPOSED)
+ * Arguments: cache payload, gene, whether the codon positions are stored
+ * Appends the record of one gene, see the layout above.
+*/
+static void appendGeneToCache(std::string &payload, Gene &gene, bool withPositions, std::vector<unsigned> &codonIndices)
+{
+	std::string id = gene.getId();
+	std::string description = gene.getDescription();
+	SequenceSummary &geneData = gene.geneData;
+
+	appendToCache<uint32_t>(payload, id.size());
+	payload.append(id);
+	appendToCache<uint32_t>(payload, description.size());
+	payload.append(description);
+	for (unsigned codonIndex = 0u; codonIndex < 64u; codonIndex++)
+		appendToCache<uint32_t>(payload, geneData.getCodonCountForCodon(codonIndex));
+	for (unsigned codonIndex = 0u; codonIndex < 64u; codonIndex++)
+		appendToCache<uint32_t>(payload, geneData.getRFPObserved(codonIndex));
+	appendToCache<uint32_t>(payload, gene.observedSynthesisRateValues.size());
+	for (unsigned i = 0u; i < gene.observedSynthesisRateValues.size(); i++)
+		appendToCache<double>(payload, gene.observedSynthesisRateValues[i]);
+
+	codonIndices.clear();
+	if (withPositions) geneData.getCodonIndexSequence(codonIndices);
+	appendToCache<uint32_t>(payload, codonIndices.size());
+	for (unsigned i = 0u; i < codonIndices.size(); i++)
+		payload.push_back((char)codonIndices[i]);
+
+	const std::vector<unsigned> &countPositions = geneData.getRFP_countPositions();
+	const std::vector<unsigned> &countValues = geneData.getRFP_countValues();
+	appendToCache<uint32_t>(payload, geneData.getRFP_countLength());
+	appendToCache<uint32_t>(payload, countPositions.size());
+	for (unsigned i = 0u; i < countPositions.size(); i++)
+		appendToCache<uint32_t>(payload, countPositions[i]);
+	for (unsigned i = 0u; i < countValues.size(); i++)
+		appendToCache<uint32_t>(payload, countValues[i]);
+}
 
-			addGene(tmpGene); //add to genome
-		} // end else
-		Fin.close();
-	} // end try
-	catch(char* pMsg)
+
+// Bounds checked reading from a cache. Once a read runs past the end, all further reads return zero and ok is false.
+struct GenomeCacheReader
+{
+	const char *position;
+	const char *end;
+	bool ok;
+
+	GenomeCacheReader(const char *begin, const char *_end) : position(begin), end(_end), ok(true) {}
+
+	const char *take(std::size_t size)
 	{
-		my_printError("\nException: %\n", pMsg);
+		if (!ok || (std::size_t)(end - position) < size)
+		{
+			ok = false;
+			return NULL;
+		}
+		const char *data = position;
+		position += size;
+		return data;
+	}
+
+	template <typename T>
+	T read()
+	{
+		T value = T();
+		const char *data = take(sizeof(T));
+		if (data != NULL) std::memcpy(&value, data, sizeof(T));
+		return value;
+	}
+};
+
+
+/* readGeneFromCache (NOT EXPOSED)
+ * Arguments: cache reader positioned at a gene record, gene to fill
+ * Fills the gene from its record without parsing a sequence: the counts are set directly, the codon positions are
+ * restored from the stored codon indices and the sequence is spelled out from them (unrecognized codons as NNN).
+ * Returns false if the record is truncated or malformed.
+*/
+static bool readGeneFromCache(GenomeCacheReader &reader, Gene &gene, std::vector<unsigned> &positions,
+	std::vector<unsigned> &counts)
+{
+	const GeneticCode &code = CodonEncoding::activeCode();
+	uint32_t size = reader.read<uint32_t>();
+	const char *data = reader.take(size);
+	if (data == NULL) return false;
+	gene.setId(std::string(data, size));
+	size = reader.read<uint32_t>();
+	data = reader.take(size);
+	if (data == NULL) return false;
+	gene.setDescription(std::string(data, size));
+
+	SequenceSummary &geneData = gene.geneData;
+	for (unsigned codonIndex = 0u; codonIndex < 64u; codonIndex++)
+		geneData.setCodonCount(codonIndex, reader.read<uint32_t>());
+	for (unsigned codonIndex = 0u; codonIndex < 64u; codonIndex++)
+		geneData.setRFPObserved(codonIndex, reader.read<uint32_t>());
+	size = reader.read<uint32_t>();
+	if (!reader.ok || size > (std::size_t)(reader.end - reader.position) / sizeof(double)) return false;
+	gene.observedSynthesisRateValues.resize(size);
+	for (unsigned i = 0u; i < size; i++)
+		gene.observedSynthesisRateValues[i] = reader.read<double>();
+
+	size = reader.read<uint32_t>();
+	const unsigned char *codonIndices = (const unsigned char *)reader.take(size);
+	if (!reader.ok) return false;
+	if (size != 0u)
+	{
+		geneData.setCodonPositions(codonIndices, size);
+		std::string seq(3u * size, 'N');
+		for (unsigned i = 0u; i < size; i++)
+		{
+			if (codonIndices[i] < GeneticCode::numCodons) std::memcpy(&seq[3u * i], code.codonNames[codonIndices[i]], 3u);
+		}
+		gene.setSummarizedSequence(seq);
+	}
+
+	uint32_t length = reader.read<uint32_t>();
+	size = reader.read<uint32_t>();
+	if (!reader.ok || size > (std::size_t)(reader.end - reader.position) / (2u * sizeof(uint32_t))) return false;
+	positions.resize(size);
+	counts.resize(size);
+	for (unsigned i = 0u; i < size; i++)
+		positions[i] = reader.read<uint32_t>();
+	for (unsigned i = 0u; i < size; i++)
+		counts[i] = reader.read<uint32_t>();
+	if (size != 0u || length != 0u) geneData.setSparseRFP_count(positions, counts, length);
+	return reader.ok;
+}
+
+
+/* writeGenomeCache (RCPP EXPOSED)
+ * Arguments: cache file name, files the genome was read from, whether codon positions (and the sequence) are stored
+ *
+ * Writes genes, simulated genes and observed phi values to a .ribgenome cache (layout above). The content of the
+ * source files is hashed into the cache, so readGenomeCache can tell when they changed. Without positions the cache
+ * is smaller, but the genes have no sequence, which models using codon positions (FONSE) need.
+*/
+void Genome::writeGenomeCache(std::string filename, std::vector<std::string> sourceFiles, bool withPositions)
+{
+	uint64_t sourceHash;
+	if (!hashGenomeSources(sourceFiles, sourceHash))
+	{
+		my_printError("Error in Genome::writeGenomeCache: Can not read the source files of the genome\n");
+		return;
+	}
+
+	std::string payload;
+	std::vector<unsigned> codonIndices;
+	appendToCache<uint32_t>(payload, numGenesWithPhi.size());
+	for (unsigned i = 0u; i < numGenesWithPhi.size(); i++)
+		appendToCache<uint32_t>(payload, numGenesWithPhi[i]);
+	appendToCache<uint32_t>(payload, getGenomeSize(false));
+	appendToCache<uint32_t>(payload, getGenomeSize(true));
+	for (unsigned i = 0u; i < getGenomeSize(false); i++)
+		appendGeneToCache(payload, getGene(i, false), withPositions, codonIndices);
+	for (unsigned i = 0u; i < getGenomeSize(true); i++)
+		appendGeneToCache(payload, getGene(i, true), withPositions, codonIndices);
+
+	std::string header(genomeCacheMagic, 8u);
+	appendToCache<uint32_t>(header, genomeCacheVersion);
+	appendToCache<uint32_t>(header, genomeCacheByteOrderMark);
+	appendToCache<uint32_t>(header, CodonEncoding::activeCode().tableId);
+	appendToCache<uint32_t>(header, CodonEncoding::activeCode().splitAA ? 1u : 0u);
+	appendToCache<uint32_t>(header, withPositions ? genomeCacheWithPositions : 0u);
+	appendToCache<uint64_t>(header, sourceHash);
+	appendToCache<uint64_t>(header, payload.size());
+	appendToCache<uint64_t>(header, hashBytes(payload.data(), payload.size(), 14695981039346656037ull));
+
+	std::ofstream Fout(filename.c_str(), std::ios::out | std::ios::binary);
+	if (Fout.fail())
+	{
+		my_printError("Error in Genome::writeGenomeCache: Can not open output file %\n", filename);
+		return;
 	}
+	Fout.write(header.data(), header.size());
+	Fout.write(payload.data(), payload.size());
+	Fout.close();
 }
 
 
-//TODO: Add writePANSEFile function here
+/* readGenomeCache (RCPP EXPOSED)
+ * Arguments: cache file name, files the genome is read from, bool Append
+ *
+ * Reads a cache written by writeGenomeCache. The file is memory mapped where possible and the genes are filled
+ * straight from the mapped records, no file content is copied into an intermediate buffer. Returns false and leaves the genome untouched if the cache does not exist, was
+ * written for another genetic code or byte order, is corrupt (payload hash) or is stale, i.e. the source files
+ * changed since it was written. Callers then read the source files and write a new cache.
+*/
+bool Genome::readGenomeCache(std::string filename, std::vector<std::string> sourceFiles, bool Append)
+{
+	const char *data = NULL;
+	std::size_t size = 0u;
+	std::string buffer;
+#ifndef _WIN32
+	void *mapping = MAP_FAILED;
+	int fileDescriptor = open(filename.c_str(), O_RDONLY);
+	if (fileDescriptor < 0) return false;
+	struct stat fileStatus;
+	if (fstat(fileDescriptor, &fileStatus) == 0 && fileStatus.st_size > 0)
+	{
+		size = (std::size_t)fileStatus.st_size;
+		mapping = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+	}
+	close(fileDescriptor);
+	if (mapping != MAP_FAILED)
+		data = (const char *)mapping;
+	else
+		size = 0u;
+#else
+	if (!readFileToBuffer(filename, buffer)) return false;
+	data = buffer.data();
+	size = buffer.size();
+#endif
+
+	std::string problem;
+	std::vector<Gene> cachedGenes, cachedSimulatedGenes;
+	std::vector<unsigned> cachedNumGenesWithPhi;
+	GenomeCacheReader reader(data, data + size);
+	const char *magic = reader.take(8u);
+	uint32_t version = reader.read<uint32_t>();
+	uint32_t byteOrderMark = reader.read<uint32_t>();
+	uint32_t tableId = reader.read<uint32_t>();
+	uint32_t splitAA = reader.read<uint32_t>();
+	reader.read<uint32_t>(); // flags, the record of every gene tells if it has positions
+	uint64_t sourceHash = reader.read<uint64_t>();
+	uint64_t payloadSize = reader.read<uint64_t>();
+	uint64_t payloadHash = reader.read<uint64_t>();
+	uint64_t currentSourceHash = 0u;
+
+	if (!reader.ok || std::memcmp(magic, genomeCacheMagic, 8u) != 0 || version != genomeCacheVersion ||
+		byteOrderMark != genomeCacheByteOrderMark)
+		problem = "it is not a genome cache of this version";
+	else if (tableId != CodonEncoding::activeCode().tableId || (splitAA != 0u) != CodonEncoding::activeCode().splitAA)
+		problem = "it was written for another codon table";
+	else if (payloadSize != size - genomeCacheHeaderSize ||
+		hashBytes(reader.position, payloadSize, 14695981039346656037ull) != payloadHash)
+		problem = "it is corrupt";
+	else if (!hashGenomeSources(sourceFiles, currentSourceHash) || currentSourceHash != sourceHash)
+		problem = "the genome files changed since it was written";
+	else
+	{
+		uint32_t numPhiSets = reader.read<uint32_t>();
+		for (unsigned i = 0u; i < numPhiSets && reader.ok; i++)
+			cachedNumGenesWithPhi.push_back(reader.read<uint32_t>());
+		uint32_t numGenes = reader.read<uint32_t>();
+		uint32_t numSimulatedGenes = reader.read<uint32_t>();
+		std::vector<unsigned> positions, counts;
+		if (numGenes + (uint64_t)numSimulatedGenes <= payloadSize)
+		{
+			cachedGenes.reserve(numGenes);
+			cachedSimulatedGenes.reserve(numSimulatedGenes);
+		}
+		for (unsigned i = 0u; i < numGenes + numSimulatedGenes && reader.ok; i++)
+		{
+			std::vector<Gene> &target = i < numGenes ? cachedGenes : cachedSimulatedGenes;
+			target.push_back(Gene());
+			if (!readGeneFromCache(reader, target.back(), positions, counts)) break;
+		}
+		if (!reader.ok || cachedGenes.size() != numGenes || cachedSimulatedGenes.size() != numSimulatedGenes)
+			problem = "it is corrupt";
+	}
+
+#ifndef _WIN32
+	if (data != NULL) munmap((void *)data, size);
+#endif
+	if (!problem.empty())
+	{
+		my_printError("WARNING: Genome::readGenomeCache: Not using %, %\n", filename, problem);
+		return false;
+	}
+
+	if (!Append)
+	{
+		clear();
+		getOwnGenes(false).swap(cachedGenes);
+		getOwnGenes(true).swap(cachedSimulatedGenes);
+		numGenesWithPhi.swap(cachedNumGenesWithPhi);
+	}
+	else
+	{
+		std::vector<Gene> &genes = getOwnGenes(false);
+		std::vector<Gene> &simulatedGenes = getOwnGenes(true);
+		genes.insert(genes.end(), cachedGenes.begin(), cachedGenes.end());
+		simulatedGenes.insert(simulatedGenes.end(), cachedSimulatedGenes.begin(), cachedSimulatedGenes.end());
+		if (numGenesWithPhi.empty()) numGenesWithPhi.swap(cachedNumGenesWithPhi);
+	}
+	return true;
+}
 
 
 /* readObservedPhiValues
@@ -416,6 +910,7 @@ void Genome::readObservedPhiValues(std::string filename, bool byId)
 	else
 	{
 		std::getline(input, tmp); //Trash the header line
+		std::vector<Gene> &genes = getOwnGenes(false);
 
 		if (genes.size() == 0)
 		{
@@ -629,16 +1124,21 @@ void Genome::readObservedPhiValues(std::string filename, bool byId)
 
 void Genome::addGene(const Gene& gene, bool simulated)
 {
-	if (!simulated)
-		genes.push_back(gene);
-	else
-		simulatedGenes.push_back(gene);
+	getOwnGenes(simulated).push_back(gene);
 }
 
 
 std::vector <Gene> Genome::getGenes(bool simulated)
 {
-	return  !simulated ? genes : simulatedGenes;
+	const GeneSet &set = simulated ? simulatedGeneSet : geneSet;
+	if (!set.isView)
+		return *set.storage;
+
+	std::vector<Gene> selected;
+	selected.reserve(set.view.size());
+	for (unsigned i = 0u; i < set.view.size(); i++)
+		selected.push_back((*set.storage)[set.view[i]]);
+	return selected;
 }
 
 
@@ -650,21 +1150,62 @@ unsigned Genome::getNumGenesWithPhiForIndex(unsigned index)
 
 Gene& Genome::getGene(unsigned index, bool simulated)
 {
-	return simulated ? simulatedGenes[index] : genes[index];
+	GeneSet &set = simulated ? simulatedGeneSet : geneSet;
+	return set.isView ? (*set.storage)[set.view[index]] : (*set.storage)[index];
 }
 
 
 Gene& Genome::getGene(std::string id, bool simulated)
 {
-	Gene tempGene;
 	unsigned geneIndex;
-	for (geneIndex = 0; geneIndex < getGenomeSize(); geneIndex++)
+	for (geneIndex = 0; geneIndex < getGenomeSize(simulated); geneIndex++)
+	{
+		if (getGene(geneIndex, simulated).getId().compare(id) == 0) break;
+	}
+	return getGene(geneIndex, simulated);
+}
+
+
+/* isGeneStorageShared (NOT EXPOSED)
+ * Arguments: whether to check the simulated genes
+ * Returns true if the genes are shared with another genome (a copy or a subset made by getGenomeForGeneIndicies).
+ * Shared genes must only be read.
+*/
+bool Genome::isGeneStorageShared(bool simulated)
+{
+	GeneSet &set = simulated ? simulatedGeneSet : geneSet;
+	return set.isView || set.storage.use_count() > 1;
+}
+
+
+/* getOwnGenes (NOT EXPOSED)
+ * Arguments: whether to return the simulated genes
+ * Returns the genes for changing them. Genes shared with another genome are copied first, a subset keeps only
+ * its selected genes.
+*/
+std::vector<Gene>& Genome::getOwnGenes(bool simulated)
+{
+	GeneSet &set = simulated ? simulatedGeneSet : geneSet;
+	if (set.isView)
 	{
-		if (!simulated) tempGene = genes[geneIndex];
-		else tempGene = simulatedGenes[geneIndex];
-		if (tempGene.getId().compare(id) == 0) break;
+		std::shared_ptr<std::vector<Gene>> storage = std::make_shared<std::vector<Gene>>();
+		storage->reserve(set.view.size());
+		for (unsigned i = 0u; i < set.view.size(); i++)
+			storage->push_back((*set.storage)[set.view[i]]);
+		set.storage = storage;
+		set.view.clear();
+		set.isView = false;
 	}
-	return simulated ? simulatedGenes[geneIndex] : genes[geneIndex];
+	else if (set.storage.use_count() > 1)
+		set.storage = std::make_shared<std::vector<Gene>>(*set.storage);
+	return *set.storage;
+}
+
+
+const Gene& Genome::geneAt(unsigned index, bool simulated) const
+{
+	const GeneSet &set = simulated ? simulatedGeneSet : geneSet;
+	return set.isView ? (*set.storage)[set.view[index]] : (*set.storage)[index];
 }
 
 
@@ -678,26 +1219,55 @@ Gene& Genome::getGene(std::string id, bool simulated)
 
 unsigned Genome::getGenomeSize(bool simulated)
 {
-	return simulated ? (unsigned)simulatedGenes.size() : (unsigned)genes.size();
+	GeneSet &set = simulated ? simulatedGeneSet : geneSet;
+	return (unsigned)(set.isView ? set.view.size() : set.storage->size());
+}
+
+
+/* setGenomeSize (NOT EXPOSED)
+ * Arguments: number of genes, whether to resize the simulated genes
+ * Adds empty genes to or removes genes from the end of the genome. Used to allocate all genes at once before they
+ * are filled in parallel.
+*/
+void Genome::setGenomeSize(unsigned size, bool simulated)
+{
+	getOwnGenes(simulated).resize(size);
 }
 
 
 void Genome::clear()
 {
-	genes.clear();
-	simulatedGenes.clear();
+	geneSet.storage = std::make_shared<std::vector<Gene>>();
+	geneSet.view.clear();
+	geneSet.isView = false;
+	simulatedGeneSet.storage = std::make_shared<std::vector<Gene>>();
+	simulatedGeneSet.view.clear();
+	simulatedGeneSet.isView = false;
 	numGenesWithPhi.clear();
 }
 
 
+/* getGenomeForGeneIndicies (NOT EXPOSED)
+ * Arguments: indices of the genes to select, whether to select simulated genes
+ * Returns a genome of the selected genes (as simulated genes if simulated is true) in the given order. The genes
+ * are not copied, the returned genome refers to them in the storage of this genome, see getOwnGenes.
+*/
 Genome Genome::getGenomeForGeneIndicies(std::vector <unsigned> indicies, bool simulated)
 {
 	Genome genome;
+	const GeneSet &source = simulated ? simulatedGeneSet : geneSet;
+	GeneSet &subset = simulated ? genome.simulatedGeneSet : genome.geneSet;
 
-	for (unsigned i = 0; i < indicies.size(); i++)
+	subset.storage = source.storage;
+	subset.isView = true;
+	if (source.isView)
 	{
-		simulated ? genome.addGene(simulatedGenes[indicies[i]], true) : genome.addGene(genes[indicies[i]], false);
+		subset.view.resize(indicies.size());
+		for (unsigned i = 0; i < indicies.size(); i++)
+			subset.view[i] = source.view[indicies[i]];
 	}
+	else
+		subset.view.swap(indicies);
 
 	return genome;
 }
@@ -705,12 +1275,11 @@ Genome Genome::getGenomeForGeneIndicies(std::vector <unsigned> indicies, bool si
 
 std::vector<unsigned> Genome::getCodonCountsPerGene(std::string codon)
 {
-	std::vector<unsigned> codonCounts(genes.size());
+	std::vector<unsigned> codonCounts(getGenomeSize());
 	unsigned codonIndex = SequenceSummary::codonToIndex(codon);
-	for(unsigned i = 0u; i < genes.size(); i++)
+	for(unsigned i = 0u; i < codonCounts.size(); i++)
 	{
-		Gene gene = genes[i];
-		SequenceSummary *seqsum = gene.getSequenceSummary();
+		SequenceSummary *seqsum = getGene(i).getSequenceSummary();
 		codonCounts[i] = seqsum -> getCodonCountForCodon(codonIndex);
 	}
 	return codonCounts;
@@ -762,7 +1331,7 @@ bool Genome::checkIndex(unsigned index, unsigned lowerbound, unsigned upperbound
 
 Gene& Genome::getGeneByIndex(unsigned index, bool simulated) //NOTE: This function does the check and performs the function itself because of memory issues.
 {
-	bool checker = checkIndex(index, 1, (unsigned)genes.size());
+	bool checker = checkIndex(index, 1, getGenomeSize(simulated));
 	if (!checker)
 	{
 #ifndef STANDALONE
@@ -771,7 +1340,7 @@ Gene& Genome::getGeneByIndex(unsigned index, bool simulated) //NOTE: This functi
 		std::cerr << "Invalid index given, returning gene 1, not simulated\n";
 #endif
 	}
-	return checker ? simulated ? simulatedGenes[index - 1] : genes[index - 1] : genes[0];
+	return checker ? getGene(index - 1, simulated) : getGene(0u, false);
 }
 
 
@@ -787,7 +1356,7 @@ Genome Genome::getGenomeForGeneIndiciesR(std::vector <unsigned> indicies, bool s
 	bool check = true;
 	for (unsigned i = 0; i < indicies.size(); i++)
 	{
-		if (indicies[i] < 1 || indicies[i] > getGenomeSize())
+		if (indicies[i] < 1 || indicies[i] > getGenomeSize(simulated))
 		{
 			check = false;
 			break;
@@ -823,6 +1392,9 @@ RCPP_MODULE(Genome_mod)
 		.method("writeFasta", &Genome::writeFasta, "writes the genome to a fasta file")
 		.method("readRFPFile", &Genome::readRFPFile, "reads RFP data in for the RFP model")
 		.method("writeRFPFile", &Genome::writeRFPFile)
+		.method("writePANSEFile", &Genome::writePANSEFile)
+		.method("writeGenomeCache", &Genome::writeGenomeCache)
+		.method("readGenomeCache", &Genome::readGenomeCache)
 		.method("readObservedPhiValues", &Genome::readObservedPhiValues)
 
 
@@ -0,0 +1,303 @@
+#include "include/HamiltonianSampler.h"
+
+
+
+//--------------------------------------------------//
+// ---------- Constructors & Destructors ---------- //
+//--------------------------------------------------//
+
+
+HamiltonianSampler::HamiltonianSampler()
+{
+	numSteps = 10u;
+	targetAcceptance = 0.8;
+	initialized = false;
+	adapting = false;
+	numGroupings = 0u;
+	adaptationCount = 0u;
+	windowSize = 50u;
+	windowCount = 0u;
+}
+
+
+HamiltonianSampler::~HamiltonianSampler()
+{
+	//dtor
+}
+
+
+
+
+
+//----------------------------------------//
+//---------- Sampling Functions ----------//
+//----------------------------------------//
+
+
+/* reset (NOT EXPOSED)
+ * Arguments: None
+ * Forgets the metric and step sizes, they are initialized again at the next proposal. Called at the start of a run.
+*/
+void HamiltonianSampler::reset()
+{
+	initialized = false;
+}
+
+
+/* proposeCodonSpecificParameter (NOT EXPOSED)
+ * Arguments: reference to a genome and a model, whether to adapt the step sizes and metric, vector to store one log
+ * acceptance ratio per grouping in
+ * Proposes new codon specific parameters for all groupings by simulating Hamiltonian dynamics with numSteps leapfrog
+ * steps from the current parameters. Groupings are independent given the synthesis rates, so every grouping follows
+ * its own trajectory with its own step size, but all of them are advanced together and share one pass over the genes
+ * per step. The end points are left as the proposed parameters of the model and the returned ratios are the change in
+ * total energy, to be accepted or rejected per grouping like a random walk proposal. Step sizes are jittered by +-10%.
+*/
+void HamiltonianSampler::proposeCodonSpecificParameter(Genome& genome, Model& model, bool adapt,
+		std::vector<double> &logAcceptanceRatios)
+{
+	model.getCodonSpecificParameterVector(initialPosition, groupingOffsets);
+	if (!initialized || inverseMetric.size() != initialPosition.size())
+	{
+		initialize(genome, model);
+	}
+	unsigned numValues = initialPosition.size();
+
+	if (adapt)
+	{
+		accumulateWindow();
+	}
+	else if (adapting)
+	{
+		// adaptation is over, keep the averaged step sizes from now on
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			stepSize[g] = std::exp(logStepSizeAverage[g]);
+		}
+		adapting = false;
+	}
+
+	Parameter::drawUniformVector(numGroupings, &trajectoryStepSize[0]);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		trajectoryStepSize[g] = stepSize[g] * (0.9 + 0.2 * trajectoryStepSize[g]);
+	}
+	Parameter::drawIidNormalVector(numValues, &momentum[0]);
+	for (unsigned j = 0u; j < numValues; j++)
+	{
+		momentum[j] /= std::sqrt(inverseMetric[j]);
+	}
+	logAcceptanceRatios.resize(numGroupings);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		logAcceptanceRatios[g] = calculateKineticEnergy(g);
+	}
+
+	position = initialPosition;
+	model.setProposedCodonSpecificParameterVector(position);
+	model.calculateLogPosteriorGradientForAllGroupings(genome, initialLogPosterior, gradient, NULL);
+	for (unsigned step = 0u; step <= numSteps; step++)
+	{
+		// half a step for the momentum at both ends of the trajectory, full steps in between
+		double momentumStep = (step == 0u || step == numSteps) ? 0.5 : 1.0;
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			double epsilon = momentumStep * trajectoryStepSize[g];
+			for (unsigned j = groupingOffsets[g]; j < groupingOffsets[g + 1]; j++)
+			{
+				momentum[j] += epsilon * gradient[j];
+			}
+		}
+		if (step == numSteps) break;
+
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			double epsilon = trajectoryStepSize[g];
+			for (unsigned j = groupingOffsets[g]; j < groupingOffsets[g + 1]; j++)
+			{
+				position[j] += epsilon * inverseMetric[j] * momentum[j];
+			}
+		}
+		model.setProposedCodonSpecificParameterVector(position);
+		model.calculateLogPosteriorGradientForAllGroupings(genome, logPosterior, gradient, NULL);
+	}
+
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		double ratio = (logPosterior[g] - calculateKineticEnergy(g)) - (initialLogPosterior[g] - logAcceptanceRatios[g]);
+		// a diverging trajectory is rejected
+		logAcceptanceRatios[g] = std::isnan(ratio) ? -std::numeric_limits<double>::infinity() : ratio;
+	}
+
+	if (adapt)
+	{
+		adaptStepSize(logAcceptanceRatios);
+	}
+}
+
+
+/* initialize (NOT EXPOSED)
+ * Arguments: reference to a genome and a model
+ * Sets the inverse metric to the inverse of the negative second derivatives of the log posterior at the current
+ * parameters, which is close to the posterior variance for a peaked posterior. Parameters without information keep a
+ * unit metric. Step sizes start at 0.5 and the first metric window is 50 proposals long.
+*/
+void HamiltonianSampler::initialize(Genome& genome, Model& model)
+{
+	unsigned numValues = initialPosition.size();
+	numGroupings = groupingOffsets.size() - 1;
+
+	model.setProposedCodonSpecificParameterVector(initialPosition);
+	model.calculateLogPosteriorGradientForAllGroupings(genome, logPosterior, gradient, &curvature);
+	inverseMetric.resize(numValues);
+	for (unsigned j = 0u; j < numValues; j++)
+	{
+		inverseMetric[j] = (curvature[j] > 0.0 && std::isfinite(curvature[j])) ? 1.0 / curvature[j] : 1.0;
+	}
+
+	position.resize(numValues);
+	momentum.resize(numValues);
+	windowMean.assign(numValues, 0.0);
+	windowSquares.assign(numValues, 0.0);
+	stepSize.assign(numGroupings, 0.5);
+	trajectoryStepSize.resize(numGroupings);
+	logStepSizeTarget.resize(numGroupings);
+	logStepSizeAverage.resize(numGroupings);
+	acceptanceStatistic.resize(numGroupings);
+	restartStepSizeAdaptation();
+
+	windowSize = 50u;
+	windowCount = 0u;
+	adapting = false;
+	initialized = true;
+}
+
+
+/* restartStepSizeAdaptation (NOT EXPOSED)
+ * Arguments: None
+ * Starts dual averaging again from the current step sizes, aiming at ten times the current step size.
+*/
+void HamiltonianSampler::restartStepSizeAdaptation()
+{
+	adaptationCount = 0u;
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		logStepSizeTarget[g] = std::log(10.0 * stepSize[g]);
+		logStepSizeAverage[g] = std::log(stepSize[g]);
+		acceptanceStatistic[g] = 0.0;
+	}
+}
+
+
+/* adaptStepSize (NOT EXPOSED)
+ * Arguments: log acceptance ratio of every grouping
+ * One dual averaging update of the step size of every grouping towards targetAcceptance, with the constants
+ * recommended by Hoffman & Gelman (2014).
+*/
+void HamiltonianSampler::adaptStepSize(std::vector<double> &logAcceptanceRatios)
+{
+	const double gamma = 0.05;
+	const double t0 = 10.0;
+	const double kappa = 0.75;
+
+	adaptationCount++;
+	double t = adaptationCount;
+	double weight = 1.0 / (t + t0);
+	double averageWeight = std::pow(t, -kappa);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		double acceptance = logAcceptanceRatios[g] >= 0.0 ? 1.0 : std::exp(logAcceptanceRatios[g]);
+		acceptanceStatistic[g] = (1.0 - weight) * acceptanceStatistic[g] + weight * (targetAcceptance - acceptance);
+		double logStepSize = logStepSizeTarget[g] - std::sqrt(t) / gamma * acceptanceStatistic[g];
+		logStepSizeAverage[g] = averageWeight * logStepSize + (1.0 - averageWeight) * logStepSizeAverage[g];
+		stepSize[g] = std::exp(logStepSize);
+	}
+	adapting = true;
+}
+
+
+/* accumulateWindow (NOT EXPOSED)
+ * Arguments: None
+ * Adds the current parameters to the running mean and variance of the metric window (Welford's algorithm) and updates
+ * the metric at the end of the window.
+*/
+void HamiltonianSampler::accumulateWindow()
+{
+	windowCount++;
+	for (unsigned j = 0u; j < initialPosition.size(); j++)
+	{
+		double delta = initialPosition[j] - windowMean[j];
+		windowMean[j] += delta / windowCount;
+		windowSquares[j] += delta * (initialPosition[j] - windowMean[j]);
+	}
+	if (windowCount == windowSize)
+	{
+		updateMetric();
+	}
+}
+
+
+/* updateMetric (NOT EXPOSED)
+ * Arguments: None
+ * Sets the inverse metric to the variance of the parameters over the window, shrunk towards the previous metric
+ * with the weight of five proposals. The next window is twice as long and step size adaptation starts over, as the
+ * step sizes fit the old metric.
+*/
+void HamiltonianSampler::updateMetric()
+{
+	double n = windowCount;
+	for (unsigned j = 0u; j < inverseMetric.size(); j++)
+	{
+		double variance = windowSquares[j] / (n - 1.0);
+		if (variance > 0.0)
+			inverseMetric[j] = (n / (n + 5.0)) * variance + (5.0 / (n + 5.0)) * inverseMetric[j];
+		windowMean[j] = 0.0;
+		windowSquares[j] = 0.0;
+	}
+	windowCount = 0u;
+	windowSize *= 2u;
+	restartStepSizeAdaptation();
+}
+
+
+double HamiltonianSampler::calculateKineticEnergy(unsigned grouping)
+{
+	double energy = 0.0;
+	for (unsigned j = groupingOffsets[grouping]; j < groupingOffsets[grouping + 1]; j++)
+	{
+		energy += inverseMetric[j] * momentum[j] * momentum[j];
+	}
+	return 0.5 * energy;
+}
+
+
+
+
+
+//-----------------------------------------------//
+//---------- Getter & Setter Functions ----------//
+//-----------------------------------------------//
+
+
+unsigned HamiltonianSampler::getNumSteps()
+{
+	return numSteps;
+}
+
+
+void HamiltonianSampler::setNumSteps(unsigned steps)
+{
+	numSteps = steps;
+}
+
+
+double HamiltonianSampler::getStepSize(unsigned grouping)
+{
+	return stepSize[grouping];
+}
+
+
+double HamiltonianSampler::getInverseMetric(unsigned index)
+{
+	return inverseMetric[index];
+}
@@ -0,0 +1,534 @@
+#include "include/JobConfig.h"
+
+
+
+//--------------------------------------------------//
+// ---------- Constructors & Destructors ---------- //
+//--------------------------------------------------//
+
+
+JobConfig::JobConfig()
+{
+	//ctor
+}
+
+
+JobConfig::~JobConfig()
+{
+	//dtor
+}
+
+
+
+
+
+//---------------------------------------//
+//---------- Reading Functions ----------//
+//---------------------------------------//
+
+
+/* readFile (NOT EXPOSED)
+ * Arguments: name of the file to read
+ * Reads a job file, see read. Returns false if the file can not be opened or has errors.
+*/
+bool JobConfig::readFile(std::string filename)
+{
+	std::ifstream input(filename.c_str());
+	if (!input)
+	{
+		errors.push_back("Could not open file " + filename);
+		return false;
+	}
+	return read(input);
+}
+
+
+bool JobConfig::readString(std::string text)
+{
+	std::istringstream input(text);
+	return read(input);
+}
+
+
+/* read (NOT EXPOSED)
+ * Arguments: stream to read from
+ * Adds all key value pairs of the stream to the configuration. Keys in a [table] are prefixed with the table name
+ * and a dot. Every malformed line is recorded with its line number and reading goes on with the next line, so all
+ * errors of a job file are reported at once. Returns false if any error was found.
+*/
+bool JobConfig::read(std::istream &input)
+{
+	std::string table = "";
+	std::string line;
+	unsigned lineNumber = 0u;
+	while (std::getline(input, line))
+	{
+		lineNumber++;
+		size_t pos = line.find_first_not_of(" \t\r");
+		if (pos == std::string::npos || line[pos] == '#') continue;
+
+		if (line[pos] == '[')
+		{
+			if (pos + 1 < line.size() && line[pos + 1] == '[')
+			{
+				addError(lineNumber, "arrays of tables are not supported");
+				continue;
+			}
+			pos++;
+			std::string name;
+			if (!parseKey(line, pos, lineNumber, name)) continue;
+			pos = line.find_first_not_of(" \t\r", pos);
+			if (pos == std::string::npos || line[pos] != ']')
+			{
+				addError(lineNumber, "expected ] after table name");
+				continue;
+			}
+			pos = line.find_first_not_of(" \t\r", pos + 1);
+			if (pos != std::string::npos && line[pos] != '#')
+			{
+				addError(lineNumber, "unexpected text after table name");
+				continue;
+			}
+			table = name + ".";
+			continue;
+		}
+
+		std::string key;
+		if (!parseKey(line, pos, lineNumber, key)) continue;
+		pos = line.find_first_not_of(" \t\r", pos);
+		if (pos == std::string::npos || line[pos] != '=')
+		{
+			addError(lineNumber, "expected = after key " + key);
+			continue;
+		}
+		pos = line.find_first_not_of(" \t\r", pos + 1);
+		if (pos == std::string::npos)
+		{
+			addError(lineNumber, "missing value for key " + key);
+			continue;
+		}
+
+		Value value;
+		unsigned lastLine = lineNumber;
+		bool ok = parseValue(line, pos, lineNumber, value, input, lastLine);
+		unsigned keyLine = lineNumber;
+		lineNumber = lastLine;
+		if (!ok) continue;
+
+		pos = line.find_first_not_of(" \t\r", pos);
+		if (pos != std::string::npos && line[pos] != '#')
+		{
+			addError(lineNumber, "unexpected text after value of key " + key);
+			continue;
+		}
+		key = table + key;
+		if (values.count(key) != 0)
+		{
+			addError(keyLine, "duplicate key " + key);
+			continue;
+		}
+		value.line = keyLine;
+		values[key] = value;
+	}
+	return errors.empty();
+}
+
+
+/* parseKey (NOT EXPOSED)
+ * Arguments: line, position to start at (moved past the key), line number for errors, string to store the key in
+ * Reads a bare ([A-Za-z0-9_-]+) or quoted key. Dotted keys are joined with dots.
+*/
+bool JobConfig::parseKey(const std::string &line, size_t &pos, unsigned lineNumber, std::string &key)
+{
+	key = "";
+	while (true)
+	{
+		pos = line.find_first_not_of(" \t\r", pos);
+		if (pos == std::string::npos)
+		{
+			addError(lineNumber, "missing key");
+			return false;
+		}
+		std::string part;
+		if (line[pos] == '"' || line[pos] == '\'')
+		{
+			if (!parseString(line, pos, lineNumber, part)) return false;
+		}
+		else
+		{
+			size_t start = pos;
+			while (pos < line.size() && (std::isalnum((unsigned char)line[pos]) || line[pos] == '_' || line[pos] == '-'))
+				pos++;
+			if (pos == start)
+			{
+				addError(lineNumber, "invalid key");
+				return false;
+			}
+			part = line.substr(start, pos - start);
+		}
+		key += part;
+
+		size_t next = line.find_first_not_of(" \t\r", pos);
+		if (next == std::string::npos || line[next] != '.') break;
+		key += ".";
+		pos = next + 1;
+	}
+	return true;
+}
+
+
+/* parseString (NOT EXPOSED)
+ * Arguments: line, position of the opening quote (moved past the closing quote), line number for errors, string to
+ * store the text in
+ * Reads a basic ("...", with \\ escapes) or literal ('...') string on a single line.
+*/
+bool JobConfig::parseString(const std::string &line, size_t &pos, unsigned lineNumber, std::string &text)
+{
+	char quote = line[pos++];
+	text = "";
+	while (pos < line.size() && line[pos] != quote)
+	{
+		char c = line[pos++];
+		if (c == '\\' && quote == '"')
+		{
+			if (pos == line.size()) break;
+			c = line[pos++];
+			switch (c)
+			{
+				case 'n': text += '\n'; break;
+				case 't': text += '\t'; break;
+				case 'r': text += '\r'; break;
+				case '"': text += '"'; break;
+				case '\\': text += '\\'; break;
+				default:
+					addError(lineNumber, std::string("unsupported escape sequence \\") + c);
+					return false;
+			}
+		}
+		else
+		{
+			text += c;
+		}
+	}
+	if (pos == line.size())
+	{
+		addError(lineNumber, "unterminated string");
+		return false;
+	}
+	pos++;
+	return true;
+}
+
+
+/* parseValue (NOT EXPOSED)
+ * Arguments: line (replaced by the following lines of the input if an array continues there), position of the value
+ * (moved past it), line number of the value, Value to fill, input stream, line number of the last line read
+ * Numbers are kept as written and converted when they are requested. Arrays may span several lines and may have a
+ * trailing comma.
+*/
+bool JobConfig::parseValue(std::string &line, size_t &pos, unsigned lineNumber, Value &value, std::istream &input,
+		unsigned &lastLine)
+{
+	value.line = lineNumber;
+	char c = line[pos];
+	if (c == '"' || c == '\'')
+	{
+		value.type = stringValue;
+		return parseString(line, pos, lineNumber, value.text);
+	}
+
+	if (c == '[')
+	{
+		value.type = arrayValue;
+		pos++;
+		bool expectItem = true;
+		while (true)
+		{
+			pos = line.find_first_not_of(" \t\r", pos);
+			if (pos == std::string::npos || line[pos] == '#')
+			{
+				// the array continues on the next line
+				if (!std::getline(input, line))
+				{
+					addError(lineNumber, "unterminated array");
+					return false;
+				}
+				lastLine++;
+				pos = 0;
+				continue;
+			}
+			if (line[pos] == ']')
+			{
+				pos++;
+				return true;
+			}
+			if (line[pos] == ',')
+			{
+				if (expectItem)
+				{
+					addError(lastLine, "missing array element");
+					return false;
+				}
+				expectItem = true;
+				pos++;
+				continue;
+			}
+			if (!expectItem)
+			{
+				addError(lastLine, "expected , between array elements");
+				return false;
+			}
+			Value item;
+			if (!parseValue(line, pos, lastLine, item, input, lastLine)) return false;
+			value.items.push_back(item);
+			expectItem = false;
+		}
+	}
+
+	size_t end = line.find_first_of(" \t\r,]#", pos);
+	if (end == std::string::npos) end = line.size();
+	value.text = line.substr(pos, end - pos);
+	pos = end;
+	if (value.text.empty())
+	{
+		addError(lineNumber, "missing value");
+		return false;
+	}
+	if (value.text == "true" || value.text == "false")
+	{
+		value.type = booleanValue;
+		return true;
+	}
+
+	std::string number;
+	for (unsigned i = 0u; i < value.text.size(); i++)
+	{
+		if (value.text[i] != '_') number += value.text[i];
+	}
+	size_t digits = (number[0] == '+' || number[0] == '-') ? 1 : 0;
+	if (digits < number.size() && number.find_first_not_of("0123456789", digits) == std::string::npos)
+	{
+		value.type = integerValue;
+		value.text = number;
+		return true;
+	}
+	char *numberEnd;
+	std::strtod(number.c_str(), &numberEnd);
+	if (!number.empty() && *numberEnd == '\0')
+	{
+		value.type = floatValue;
+		value.text = number;
+		return true;
+	}
+	addError(lineNumber, "invalid value " + value.text);
+	return false;
+}
+
+
+void JobConfig::addError(unsigned lineNumber, std::string message)
+{
+	std::ostringstream oss;
+	oss << "line " << lineNumber << ": " << message;
+	errors.push_back(oss.str());
+}
+
+
+
+
+
+//--------------------------------------//
+//---------- Getter Functions ----------//
+//--------------------------------------//
+
+
+bool JobConfig::hasKey(std::string key)
+{
+	return values.count(key) != 0;
+}
+
+
+std::vector<std::string> JobConfig::getKeys()
+{
+	std::vector<std::string> keys;
+	for (std::map<std::string, Value>::iterator it = values.begin(); it != values.end(); it++)
+	{
+		keys.push_back(it->first);
+	}
+	return keys;
+}
+
+
+/* findValue (NOT EXPOSED)
+ * Arguments: key, type the value must have, name of the type for the error message
+ * Returns the value of the key, or NULL if the key is not set. A value of another type is recorded as an error and
+ * NULL is returned, so the caller falls back to its default. Integers are accepted where floats are expected.
+*/
+const JobConfig::Value* JobConfig::findValue(std::string key, ValueType type, std::string typeName)
+{
+	std::map<std::string, Value>::iterator it = values.find(key);
+	if (it == values.end()) return NULL;
+	if (it->second.type != type && !(type == floatValue && it->second.type == integerValue))
+	{
+		addError(it->second.line, key + " must be " + typeName);
+		return NULL;
+	}
+	return &it->second;
+}
+
+
+std::string JobConfig::getString(std::string key, std::string defaultValue)
+{
+	const Value *value = findValue(key, stringValue, "a string");
+	return value == NULL ? defaultValue : value->text;
+}
+
+
+long JobConfig::getInteger(std::string key, long defaultValue)
+{
+	const Value *value = findValue(key, integerValue, "an integer");
+	if (value == NULL) return defaultValue;
+
+	errno = 0;
+	long rv = std::strtol(value->text.c_str(), NULL, 10);
+	if (errno == ERANGE)
+	{
+		addError(value->line, key + " is out of range");
+		return defaultValue;
+	}
+	return rv;
+}
+
+
+unsigned JobConfig::getUnsigned(std::string key, unsigned defaultValue)
+{
+	if (!hasKey(key)) return defaultValue;
+	long rv = getInteger(key, (long)defaultValue);
+	if (rv < 0 || rv > 4294967295L)
+	{
+		addError(values[key].line, key + " must be a non-negative integer");
+		return defaultValue;
+	}
+	return (unsigned)rv;
+}
+
+
+bool JobConfig::convertToDouble(const Value &value, double &out)
+{
+	if (value.type != floatValue && value.type != integerValue) return false;
+	out = std::strtod(value.text.c_str(), NULL);
+	return true;
+}
+
+
+double JobConfig::getDouble(std::string key, double defaultValue)
+{
+	const Value *value = findValue(key, floatValue, "a number");
+	double rv = defaultValue;
+	if (value != NULL) convertToDouble(*value, rv);
+	return rv;
+}
+
+
+bool JobConfig::getBool(std::string key, bool defaultValue)
+{
+	const Value *value = findValue(key, booleanValue, "true or false");
+	return value == NULL ? defaultValue : value->text == "true";
+}
+
+
+/* getStringArray (NOT EXPOSED)
+ * Arguments: key
+ * Returns the strings of an array of strings. A single string is returned as an array of one element, so lists of
+ * files can be given either way.
+*/
+std::vector<std::string> JobConfig::getStringArray(std::string key)
+{
+	std::vector<std::string> rv;
+	std::map<std::string, Value>::iterator it = values.find(key);
+	if (it == values.end()) return rv;
+	if (it->second.type == stringValue)
+	{
+		rv.push_back(it->second.text);
+		return rv;
+	}
+	const Value *value = findValue(key, arrayValue, "a string or an array of strings");
+	if (value == NULL) return rv;
+	for (unsigned i = 0u; i < value->items.size(); i++)
+	{
+		if (value->items[i].type != stringValue)
+		{
+			addError(value->line, key + " must be an array of strings");
+			return std::vector<std::string>();
+		}
+		rv.push_back(value->items[i].text);
+	}
+	return rv;
+}
+
+
+std::vector<double> JobConfig::getDoubleArray(std::string key)
+{
+	std::vector<double> rv;
+	std::map<std::string, Value>::iterator it = values.find(key);
+	if (it == values.end()) return rv;
+	double number;
+	if (convertToDouble(it->second, number))
+	{
+		rv.push_back(number);
+		return rv;
+	}
+	const Value *value = findValue(key, arrayValue, "a number or an array of numbers");
+	if (value == NULL) return rv;
+	for (unsigned i = 0u; i < value->items.size(); i++)
+	{
+		if (!convertToDouble(value->items[i], number))
+		{
+			addError(value->line, key + " must be an array of numbers");
+			return std::vector<double>();
+		}
+		rv.push_back(number);
+	}
+	return rv;
+}
+
+
+/* getUnsignedMatrix (NOT EXPOSED)
+ * Arguments: key
+ * Returns an array of arrays of non-negative integers, such as a mixture definition matrix [[1, 1], [2, 1]].
+*/
+std::vector<std::vector<unsigned>> JobConfig::getUnsignedMatrix(std::string key)
+{
+	std::vector<std::vector<unsigned>> rv;
+	const Value *value = findValue(key, arrayValue, "an array of arrays of integers");
+	if (value == NULL) return rv;
+	for (unsigned i = 0u; i < value->items.size(); i++)
+	{
+		const Value &row = value->items[i];
+		bool valid = row.type == arrayValue;
+		std::vector<unsigned> entries;
+		for (unsigned j = 0u; valid && j < row.items.size(); j++)
+		{
+			valid = row.items[j].type == integerValue && row.items[j].text[0] != '-';
+			if (valid) entries.push_back((unsigned)std::strtoul(row.items[j].text.c_str(), NULL, 10));
+		}
+		if (!valid)
+		{
+			addError(value->line, key + " must be an array of arrays of non-negative integers");
+			return std::vector<std::vector<unsigned>>();
+		}
+		rv.push_back(entries);
+	}
+	return rv;
+}
+
+
+bool JobConfig::hasError()
+{
+	return !errors.empty();
+}
+
+
+std::vector<std::string> JobConfig::getErrors()
+{
+	return errors;
+}
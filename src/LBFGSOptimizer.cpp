@@ -0,0 +1,203 @@
+#include "include/LBFGSOptimizer.h"
+
+
+
+//--------------------------------------------------//
+// ---------- Constructors & Destructors ---------- //
+//--------------------------------------------------//
+
+
+LBFGSOptimizer::LBFGSOptimizer(unsigned _historySize)
+{
+	historySize = _historySize;
+	numStored = 0u;
+	newest = 0u;
+	positionChanges.resize(historySize);
+	gradientChanges.resize(historySize);
+	curvatures.resize(historySize, 0.0);
+	weights.resize(historySize, 0.0);
+	value = 0.0;
+}
+
+
+LBFGSOptimizer::~LBFGSOptimizer()
+{
+	//dtor
+}
+
+
+
+
+
+//--------------------------------------------//
+//---------- Optimization Functions ----------//
+//--------------------------------------------//
+
+
+/* minimize (NOT EXPOSED)
+ * Arguments: function to minimize, starting point (overwritten with the minimum), maximum number of iterations,
+ * relative tolerance
+ * Limited memory BFGS (Nocedal & Wright 2006, algorithm 7.5) with a backtracking line search. Stops when an iteration
+ * decreases the value by less than tolerance * |value|, when no step along the search direction decreases the value,
+ * or after maxIterations iterations. Correction pairs without positive curvature are not stored. Returns the number of
+ * iterations done. All parallelism is in the objective.
+*/
+unsigned LBFGSOptimizer::minimize(LBFGSObjective &objective, std::vector<double> &x, unsigned maxIterations,
+		double tolerance)
+{
+	unsigned n = x.size();
+	for (unsigned k = 0u; k < historySize; k++)
+	{
+		positionChanges[k].resize(n);
+		gradientChanges[k].resize(n);
+	}
+	direction.resize(n);
+	trialPosition.resize(n);
+	positionChange.resize(n);
+	gradientChange.resize(n);
+	numStored = 0u;
+	newest = 0u;
+
+	value = objective.evaluate(x, gradient);
+	unsigned iteration = 0u;
+	for (; iteration < maxIterations; iteration++)
+	{
+		double gradientNorm = 0.0;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			gradientNorm = std::max(gradientNorm, std::fabs(gradient[j]));
+		}
+		if (gradientNorm == 0.0) break;
+
+		calculateDirection();
+		double slope = 0.0;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			slope += direction[j] * gradient[j];
+		}
+		if (!(slope < 0.0))
+		{
+			// not a descent direction, start over with steepest descent
+			numStored = 0u;
+			slope = 0.0;
+			for (unsigned j = 0u; j < n; j++)
+			{
+				direction[j] = -gradient[j];
+				slope -= gradient[j] * gradient[j];
+			}
+		}
+
+		// without curvature information the first step is kept small
+		double step = numStored == 0u ? std::min(1.0, 1.0 / gradientNorm) : 1.0;
+		double trialValue = std::numeric_limits<double>::infinity();
+		bool decreased = false;
+		for (unsigned tries = 0u; tries < 40u; tries++, step *= 0.5)
+		{
+			for (unsigned j = 0u; j < n; j++)
+			{
+				trialPosition[j] = x[j] + step * direction[j];
+			}
+			trialValue = objective.evaluate(trialPosition, trialGradient);
+			if (std::isfinite(trialValue) && trialValue <= value + 1e-4 * step * slope)
+			{
+				decreased = true;
+				break;
+			}
+		}
+		if (!decreased) break;
+
+		// the pair only replaces the oldest stored pair once it is accepted
+		double curvature = 0.0;
+		double gradientChangeNorm = 0.0;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			positionChange[j] = trialPosition[j] - x[j];
+			gradientChange[j] = trialGradient[j] - gradient[j];
+			curvature += positionChange[j] * gradientChange[j];
+			gradientChangeNorm += gradientChange[j] * gradientChange[j];
+		}
+		if (curvature > 1e-12 * gradientChangeNorm)
+		{
+			unsigned next = numStored == 0u ? 0u : (newest + 1u) % historySize;
+			positionChanges[next].swap(positionChange);
+			gradientChanges[next].swap(gradientChange);
+			curvatures[next] = 1.0 / curvature;
+			newest = next;
+			if (numStored < historySize) numStored++;
+		}
+
+		double decrease = value - trialValue;
+		x = trialPosition;
+		gradient = trialGradient;
+		value = trialValue;
+		if (decrease <= tolerance * std::max(1.0, std::fabs(value)))
+		{
+			iteration++;
+			break;
+		}
+	}
+	return iteration;
+}
+
+
+double LBFGSOptimizer::getValue()
+{
+	return value;
+}
+
+
+/* calculateDirection (NOT EXPOSED)
+ * Arguments: None
+ * Two loop recursion: direction = -H * gradient, with H the inverse Hessian approximation from the stored
+ * correction pairs, scaled by the newest pair.
+*/
+void LBFGSOptimizer::calculateDirection()
+{
+	unsigned n = gradient.size();
+	for (unsigned j = 0u; j < n; j++)
+	{
+		direction[j] = -gradient[j];
+	}
+	if (numStored == 0u) return;
+
+	unsigned k = newest;
+	for (unsigned m = 0u; m < numStored; m++, k = (k + historySize - 1u) % historySize)
+	{
+		double dot = 0.0;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			dot += positionChanges[k][j] * direction[j];
+		}
+		weights[k] = curvatures[k] * dot;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			direction[j] -= weights[k] * gradientChanges[k][j];
+		}
+	}
+
+	double gradientChangeNorm = 0.0;
+	for (unsigned j = 0u; j < n; j++)
+	{
+		gradientChangeNorm += gradientChanges[newest][j] * gradientChanges[newest][j];
+	}
+	double scale = 1.0 / (curvatures[newest] * gradientChangeNorm);
+	for (unsigned j = 0u; j < n; j++)
+	{
+		direction[j] *= scale;
+	}
+
+	k = (newest + historySize - numStored + 1u) % historySize;
+	for (unsigned m = 0u; m < numStored; m++, k = (k + 1u) % historySize)
+	{
+		double dot = 0.0;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			dot += gradientChanges[k][j] * direction[j];
+		}
+		double correction = weights[k] - curvatures[k] * dot;
+		for (unsigned j = 0u; j < n; j++)
+		{
+			direction[j] += correction * positionChanges[k][j];
+		}
+	}
+}
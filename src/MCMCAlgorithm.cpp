@@ -20,6 +20,12 @@ using namespace Rcpp;
 #include <thread>
 #endif
 
+//Thread pinning
+#if defined(__linux__) && !defined(__APPLE__)
+#include <sched.h>
+#include <pthread.h>
+#endif
+
 
 
 
@@ -44,6 +50,19 @@ MCMCAlgorithm::MCMCAlgorithm() : samples(1000), thining(1), adaptiveWidth(100 *
 
 	estimateMixtureAssignment = true;
 	stepsToAdapt = -1;
+	threadAffinity = "none";
+	parallelWallTime = 0.0;
+	profiling = false;
+	profileFile = "";
+	delayedAcceptance = false;
+	delayedAcceptanceFraction = 0.1;
+	delayedAcceptanceActive = false;
+	firstStageProposals = 0ul;
+	firstStagePassed = 0ul;
+	hamiltonian = false;
+	hamiltonianActive = false;
+	posteriorModeStart = false;
+	posteriorModeRounds = 50u;
 }
 
 /* MCMCAlgorithm constructor (RCPP EXPOSED)
@@ -66,6 +85,19 @@ MCMCAlgorithm::MCMCAlgorithm(unsigned _samples, unsigned _thining, unsigned _ada
 	lastConvergenceTest = 0u;
 	estimateMixtureAssignment = true;
 	stepsToAdapt = -1;
+	threadAffinity = "none";
+	parallelWallTime = 0.0;
+	profiling = false;
+	profileFile = "";
+	delayedAcceptance = false;
+	delayedAcceptanceFraction = 0.1;
+	delayedAcceptanceActive = false;
+	firstStageProposals = 0ul;
+	firstStagePassed = 0ul;
+	hamiltonian = false;
+	hamiltonianActive = false;
+	posteriorModeStart = false;
+	posteriorModeRounds = 50u;
 }
 
 
@@ -99,55 +131,50 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 	// TODO move the likelihood calculation out off here. make it a void function again.
 
 	double logLikelihood = 0.0;
-    double logLikelihood2 = 0.0;
 	int numGenes = genome.getGenomeSize();
 
 	unsigned numSynthesisRateCategories = model.getNumSynthesisRateCategories();
 	unsigned numMixtures = model.getNumMixtureElements();
-	double* dirichletParameters = new double[numMixtures]();
-	//TODO: why is this not just a vector?
-
 
-	for (unsigned i = 0u; i < numMixtures; i++) {
-		dirichletParameters[i] = 0.0;
+	// all per gene arrays live in synthesisRateScratch (see initIterationScratch), so the loop below does not allocate
+	double* unscaledLogProb_curr = &synthesisRateScratch[0];
+	double* unscaledLogProb_prop = unscaledLogProb_curr + numSynthesisRateCategories;
+	double* unscaledLogPost_curr = unscaledLogProb_prop + numSynthesisRateCategories;
+	double* unscaledLogPost_prop = unscaledLogPost_curr + numSynthesisRateCategories;
+	double* mixtureProbabilities = unscaledLogPost_prop + numSynthesisRateCategories;
+	double* newMixtureProbabilities = mixtureProbabilities + numMixtures;
+
+	// mixtureElements holds the mixture elements of all categories in the order they are visited below, which is
+	// also the layout of geneLogProbabilityRatios.
+	unsigned numMixtureTerms = mixtureElements.size();
+
+	// Genes only depend on their own phi and mixture assignment, so the likelihood ratios of all genes are calculated
+	// up front in parallel. This also fills the genes x mixtures matrix of log posteriors of mixtureSampler.
+	// Accepting/rejecting stays sequential below to keep the random number stream in gene order.
+	calculateLogProbabilityRatiosForAllGenes(genome, model, mixtureElements);
+
+	/*
+		 The mixture probabilities of a gene do not depend on whether its new phi is accepted, so they are calculated
+		 for all genes at once. Since some values returned by calculateLogLikelihoodRatioPerGene are very small (~ -1100),
+		 exponentiation leads to 0. To solve this problem, we adjust the value by a constant c, the maximum across all
+		 mixtures. We justify this by
+		 P = Sum(p_i*f(...))
+		 => f' = c*f
+		 => ln(f') = ln(c) + ln(f)
+		 => ln(P) = ln( Sum(p_i*f'(...)) )
+		 => ln(P) = ln(P') - ln(c)
+	 */
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		mixtureProbabilities[k] = model.getCategoryProbability(k);
 	}
+	mixtureSampler.calculateProbabilities(mixtureProbabilities);
 
-	//initialize parameter's size
 	for(int i = 0; i < numGenes; i++)
 	{
-		Gene *gene = &genome.getGene(i);
-
-		/*
-			 Since some values returned by calculateLogLikelihoodRatioPerGene are veyr small (~ -1100), exponentiation leads to 0.
-			 To solve this problem, we adjust the value by a constant c. I choose to use the average value across all mixtures.
-			 We justify this by
-			 P = Sum(p_i*f(...))
-			 => f' = c*f
-			 => ln(f') = ln(c) + ln(f)
-			 => ln(P) = ln( Sum(p_i*f'(...)) )
-			 => ln(P) = ln(P') - ln(c)
-			 Note that we use the inverse sign because our values of ln(f) and ln(f') are negative.
-		 */
-
-		double maxValue = -1000000.0;
+		double *probabilities = mixtureSampler.getProbabilities(i);
 		unsigned mixtureIndex = 0u;
 
-		double* unscaledLogProb_curr = new double[numSynthesisRateCategories]();
-		double* unscaledLogProb_prop = new double[numSynthesisRateCategories]();
-
-		double* unscaledLogPost_curr = new double[numSynthesisRateCategories]();
-		double* unscaledLogPost_prop = new double[numSynthesisRateCategories]();
-
-
-		double* unscaledLogProb_curr_singleMixture = new double[numMixtures]();
-		double* probabilities = new double[numMixtures]();
-
-		for (unsigned j = 0u; j < numMixtures; j++)
-		{
-			probabilities[j] = 0.0;
-			unscaledLogProb_curr_singleMixture[j] = 0.0;
-		}
-
 		for (unsigned j = 0u; j < numSynthesisRateCategories; j++)
 		{
 			unscaledLogProb_curr[j] = 0.0;
@@ -160,43 +187,19 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 		{
 			// logProbabilityRatio contains the logProbabilityRatio in element 0,
 			// the current unscaled probability in element 1 and the proposed unscaled probability in element 2
-			std::vector<unsigned> mixtureElements = model.getMixtureElementsOfSelectionCategory(k);
-			for(unsigned n = 0u; n < mixtureElements.size(); n++)
+			for(unsigned n = 0u; n < mixtureElementsOfCategory[k].size(); n++)
 			{
-				unsigned mixtureElement = mixtureElements[n];
-				double logProbabilityRatio[5];
-				model.calculateLogLikelihoodRatioPerGene(*gene, i, mixtureElement, logProbabilityRatio);
+				double *logProbabilityRatio = &geneLogProbabilityRatios[(i * numMixtureTerms + mixtureIndex) * 5];
 
 				// log posterior with and without rev. jump probability
 				unscaledLogProb_curr[k] += logProbabilityRatio[1]; // with rev. jump prob.
 				unscaledLogProb_prop[k] += logProbabilityRatio[2]; // with rev. jump prob.
 				unscaledLogPost_curr[k] += logProbabilityRatio[3]; // without rev. jump prob.
 				unscaledLogPost_prop[k] += logProbabilityRatio[4]; // without rev. jump prob.
-
-				unscaledLogProb_curr_singleMixture[mixtureIndex] = logProbabilityRatio[3];
-				maxValue = unscaledLogProb_curr_singleMixture[mixtureIndex] > maxValue ? unscaledLogProb_curr_singleMixture[mixtureIndex] : maxValue;
 				mixtureIndex++;
 			}
 		}
 
-
-		// adjust the the unscaled probabilities by the constant c
-		// ln(f') = ln(c) + ln(f)
-		// calculate ln(P) = ln( Sum(p_i*f'(...)) ) and obtain normalizing constant for new p_i
-		double normalizingProbabilityConstant = 0.0;
-
-		for(unsigned k = 0u; k < numMixtures; k++)
-		{
-			unscaledLogProb_curr_singleMixture[k] -= maxValue;
-			probabilities[k] = model.getCategoryProbability(k) * std::exp(unscaledLogProb_curr_singleMixture[k]);
-			normalizingProbabilityConstant += probabilities[k];
-		}
-		// normalize probabilities
-		for (unsigned k = 0u; k < numMixtures; k++)
-		{
-			probabilities[k] = probabilities[k] / normalizingProbabilityConstant;
-		}
-
 		for(unsigned k = 0u; k < numSynthesisRateCategories; k++)
 		{
 			// We do not need to add std::log(model.getCategoryProbability(k)) since it will cancel in the ratio!
@@ -224,43 +227,44 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
 			std::cout << "\tInfinity reached (Gene: " << i << ")\n";
 #endif
 		}
+	}
 
-		// Get category in which the gene is placed in.
-		// If we use multiple sequence observation (like different mutants) randMultinom needs a parameter N to place N observations in numMixture buckets
-		unsigned categoryOfGene = Parameter::randMultinom(probabilities, numMixtures);
+	// Get category in which the gene is placed in. All genes are assigned with one batch of uniform numbers, and the
+	// number of genes per mixture element gives the parameters of the Dirichlet distribution of the mixture probabilities.
+	// If we use multiple sequence observation (like different mutants) this needs to place N observations in numMixture buckets
+	mixtureSampler.drawAssignments();
+	mixtureSampler.countAssignments();
+	for(int i = 0; i < numGenes; i++)
+	{
 		if(estimateMixtureAssignment)
 		{
-			model.setMixtureAssignment(i, categoryOfGene);
+			model.setMixtureAssignment(i, mixtureSampler.getAssignment(i));
 		}
-
-		dirichletParameters[categoryOfGene] += 1;
-		if((iteration % thining) == 0)
+	}
+	if((iteration % thining) == 0)
+	{
+		std::chrono::steady_clock::time_point traceStart = startPhase();
+		for(int i = 0; i < numGenes; i++)
 		{
 			model.updateSynthesisRateTrace(iteration/thining, i);
 			model.updateMixtureAssignmentTrace(iteration/thining, i);
 		}
-		delete[] probabilities;
-		delete[] unscaledLogProb_curr_singleMixture;
-		delete[] unscaledLogProb_prop;
-		delete[] unscaledLogProb_curr;
-		delete[] unscaledLogPost_prop;
-		delete[] unscaledLogPost_curr;
+		stopPhase(TRACE_PHASE, traceStart, PHI_PHASE);
 	}
 
 	// take all priors into account
 	logLikelihood += model.calculateAllPriors();
-	double *newMixtureProbabilities = new double[numMixtures]();
-	Parameter::randDirichlet(dirichletParameters, numMixtures, newMixtureProbabilities);
+	Parameter::randDirichlet(mixtureSampler.getCounts(), numMixtures, newMixtureProbabilities);
 	for(unsigned k = 0u; k < numMixtures; k++)
 	{
 		model.setCategoryProbability(k, newMixtureProbabilities[k]);
 	}
 	if((iteration % thining) == 0)
 	{
+		std::chrono::steady_clock::time_point traceStart = startPhase();
 		model.updateMixtureProbabilitiesTrace(iteration/thining);
+		stopPhase(TRACE_PHASE, traceStart, PHI_PHASE);
 	}
-	delete[] dirichletParameters;
-	delete[] newMixtureProbabilities;
 	return logLikelihood;
 }
 
@@ -269,26 +273,65 @@ double MCMCAlgorithm::acceptRejectSynthesisRateLevelForAllGenes(Genome& genome,
  * Calculates the logLikelihood for each grouping based on codon specific parameters. If this is greater
  * than a random number from the exponential distribution we update the parameters from proposed to
  * current. Update the trace when applicable.
+ * With delayed acceptance, proposals are first screened with the likelihood of a systematic sample of the genes with
+ * a random start, scaled up to the whole genome. Only proposals passing this stage are evaluated on all genes, and are
+ * then accepted with the ratio of the exact and the estimated acceptance probabilities. The proposals are symmetric and
+ * the sample does not depend on the state, so the chain keeps the exact posterior (Christen & Fox 2005).
+ * Delayed acceptance is only used for models whose first stage really uses the gene sample (see
+ * Model::hasSubsampleSurrogate). With Hamiltonian Monte Carlo the proposals are made here as well, see
+ * HamiltonianSampler. Delayed acceptance is not used for them.
 */
 void MCMCAlgorithm::acceptRejectCodonSpecificParameter(Genome& genome, Model& model, int iteration)
 {
-	double acceptanceRatioForAllMixtures = 0.0;
 	unsigned size = model.getGroupListSize();
+	bool delayed = delayedAcceptanceActive;
+
+	// groupings are independent given phi, so the likelihood ratios of all of them are calculated in one pass over
+	// the genes before any of them is accepted or rejected
+	if (hamiltonianActive)
+	{
+		hamiltonianSampler.proposeCodonSpecificParameter(genome, model, iteration <= stepsToAdapt, logAcceptanceRatios);
+	}
+	else if (delayed)
+	{
+		unsigned geneStride = (unsigned)std::ceil(1.0 / delayedAcceptanceFraction);
+		unsigned firstGene = (unsigned)Parameter::randUnif(0.0, geneStride);
+		if (firstGene >= geneStride) firstGene = geneStride - 1;
+		model.calculateLogLikelihoodRatioForGroupings(genome, firstGene, geneStride, NULL, surrogateLogAcceptanceRatios);
+
+		delayedAcceptanceMask.resize(size);
+		for (unsigned i = 0; i < size; i++)
+		{
+			delayedAcceptanceMask[i] = -Parameter::randExp(1) < surrogateLogAcceptanceRatios[i];
+			firstStagePassed += delayedAcceptanceMask[i];
+		}
+		firstStageProposals += size;
+		model.calculateLogLikelihoodRatioForGroupings(genome, 0u, 1u, &delayedAcceptanceMask[0], logAcceptanceRatios);
+	}
+	else
+	{
+		model.calculateLogLikelihoodRatioForAllGroupings(genome, logAcceptanceRatios);
+	}
 
 	for(unsigned i = 0; i < size; i++)
 	{
 		std::string grouping = model.getGrouping(i);
 
-		// calculate likelihood ratio for every Category for current AA
-		model.calculateLogLikelihoodRatioPerGroupingPerCategory(grouping, genome, acceptanceRatioForAllMixtures);
-		if( -Parameter::randExp(1) < acceptanceRatioForAllMixtures )
+		bool accept;
+		if (delayed)
+			accept = delayedAcceptanceMask[i] && -Parameter::randExp(1) < logAcceptanceRatios[i] - surrogateLogAcceptanceRatios[i];
+		else
+			accept = -Parameter::randExp(1) < logAcceptanceRatios[i];
+		if (accept)
 		{
 			// moves proposed codon specific parameters to current codon specific parameters
 			model.updateCodonSpecificParameter(grouping);
 		}
 		if((iteration % thining) == 0)
 		{
+			std::chrono::steady_clock::time_point traceStart = startPhase();
 			model.updateCodonSpecificParameterTrace(iteration/thining, grouping);
+			stopPhase(TRACE_PHASE, traceStart, CSP_PHASE);
 		}
 	}
 }
@@ -300,7 +343,7 @@ void MCMCAlgorithm::acceptRejectCodonSpecificParameter(Genome& genome, Model& mo
 */
 void MCMCAlgorithm::acceptRejectHyperParameter(Genome &genome, Model& model, int iteration)
 {
-	std::vector <double> logProbabilityRatios;
+	std::vector <double> &logProbabilityRatios = hyperParameterLogProbabilityRatios;
 
 	model.calculateLogLikelihoodRatioForHyperParameters(genome, iteration, logProbabilityRatios);
 
@@ -323,14 +366,105 @@ void MCMCAlgorithm::acceptRejectHyperParameter(Genome &genome, Model& model, int
 
 	if((iteration % thining) == 0)
 	{
+		std::chrono::steady_clock::time_point traceStart = startPhase();
 		model.updateHyperParameterTraces(iteration/thining);
+		stopPhase(TRACE_PHASE, traceStart, HYPER_PHASE);
+	}
+}
+
+
+/* calculateLogProbabilityRatiosForAllGenes (NOT EXPOSED)
+ * Arguments: reference to a genome and a model, mixture elements to evaluate every gene for
+ * Calls calculateLogLikelihoodRatiosPerGene for every gene in a single parallel region and stores the results for all
+ * mixture elements in geneLogProbabilityRatios. The model evaluates all mixture elements of a gene at once, so terms
+ * shared by elements with the same mutation or selection category are calculated once. The current log posteriors are
+ * also copied into the log posterior matrix of mixtureSampler. Genes are handed out dynamically since their lengths
+ * differ. The time each thread spends on its genes is added to threadComputeTime, the wall time of the region to
+ * parallelWallTime. The difference is time spent waiting at the barrier closing the region.
+*/
+void MCMCAlgorithm::calculateLogProbabilityRatiosForAllGenes(Genome& genome, Model& model, std::vector<unsigned> &mixtureElements)
+{
+	int numGenes = genome.getGenomeSize();
+	unsigned numMixtureTerms = mixtureElements.size();
+	geneLogProbabilityRatios.resize(numGenes * numMixtureTerms * 5);
+	mixtureSampler.resize(numGenes, model.getNumMixtureElements());
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	if (threadComputeTime.size() < numThreads) threadComputeTime.resize(numThreads, 0.0);
+	model.prepareLogLikelihoodRatiosPerGene(mixtureElements, numThreads);
+
+	std::chrono::steady_clock::time_point regionStart = std::chrono::steady_clock::now();
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+		std::chrono::steady_clock::time_point threadStart = std::chrono::steady_clock::now();
+#ifndef __APPLE__
+#pragma omp for schedule(dynamic, 8) nowait
+#endif
+		for (int i = 0; i < numGenes; i++)
+		{
+			double *logProbabilityRatios = &geneLogProbabilityRatios[i * numMixtureTerms * 5];
+			model.calculateLogLikelihoodRatiosPerGene(genome.getGene(i), i, mixtureElements, logProbabilityRatios);
+
+			// current log posterior without rev. jump probability of every mixture element
+			double *logPosterior = mixtureSampler.getLogPosterior(i);
+			for (unsigned n = 0u; n < numMixtureTerms; n++)
+			{
+				logPosterior[mixtureElements[n]] = logProbabilityRatios[n * 5 + 3];
+			}
+		}
+		std::chrono::duration<double> busy = std::chrono::steady_clock::now() - threadStart;
+#ifndef __APPLE__
+		threadComputeTime[omp_get_thread_num()] += busy.count();
+#else
+		threadComputeTime[0] += busy.count();
+#endif
+	}
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - regionStart;
+	parallelWallTime += wall.count();
+}
+
+
+
+
+
+
+/* initIterationScratch (NOT EXPOSED)
+ * Arguments: reference to a genome and a model
+ * Sizes everything the accept/reject functions need per iteration, so after the first iteration the MCMC loop does
+ * not allocate. The mixture elements of a category do not change during a run and are looked up here once.
+*/
+void MCMCAlgorithm::initIterationScratch(Genome& genome, Model& model)
+{
+	unsigned numSynthesisRateCategories = model.getNumSynthesisRateCategories();
+	unsigned numMixtures = model.getNumMixtureElements();
+
+	mixtureElementsOfCategory.resize(numSynthesisRateCategories);
+	mixtureElements.clear();
+	for (unsigned k = 0u; k < numSynthesisRateCategories; k++)
+	{
+		mixtureElementsOfCategory[k] = model.getMixtureElementsOfSelectionCategory(k);
+		mixtureElements.insert(mixtureElements.end(), mixtureElementsOfCategory[k].begin(), mixtureElementsOfCategory[k].end());
 	}
+
+	synthesisRateScratch.resize(4 * numSynthesisRateCategories + 2 * numMixtures);
+	mixtureSampler.resize(genome.getGenomeSize(), numMixtures);
+	geneLogProbabilityRatios.resize(genome.getGenomeSize() * mixtureElements.size() * 5);
+	logAcceptanceRatios.reserve(model.getGroupListSize());
+	surrogateLogAcceptanceRatios.reserve(model.getGroupListSize());
+	delayedAcceptanceMask.reserve(model.getGroupListSize());
+	hyperParameterLogProbabilityRatios.reserve(model.getNumPhiGroupings() + 1);
 }
 
 
 
 
 
+
 //------------------------------------//
 //---------- MCMC Functions ----------//
 //------------------------------------//
@@ -343,9 +477,39 @@ void MCMCAlgorithm::acceptRejectHyperParameter(Genome &genome, Model& model, int
 */
 void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigned divergenceIterations)
 {
+#ifndef STANDALONE
+	// one scope for the whole run, the scopes of the single draws in Parameter then no longer save the R random
+	// number state every time
+	RNGScope scope;
+#endif
 #ifndef __APPLE__
 	omp_set_num_threads(numCores);
 #endif
+	pinThreads(numCores);
+	parallelWallTime = 0.0;
+	threadComputeTime.assign(numCores, 0.0);
+	firstStageProposals = 0ul;
+	firstStagePassed = 0ul;
+	hamiltonianActive = hamiltonian && model.hasCodonSpecificParameterGradient();
+	if (hamiltonian && !hamiltonianActive)
+	{
+		std::cerr << "Hamiltonian Monte Carlo is not available for this model, using random walk proposals\n";
+	}
+	// the first stage only pays off if it is cheaper than the exact ratio, Hamiltonian proposals are not screened
+	delayedAcceptanceActive = delayedAcceptance && !hamiltonianActive && model.hasSubsampleSurrogate();
+	if (delayedAcceptance && !hamiltonianActive && !delayedAcceptanceActive)
+	{
+		std::cerr << "Delayed acceptance is not available for this model, using the standard update\n";
+	}
+	hamiltonianSampler.reset();
+	phaseTime.assign(NUM_PROFILE_PHASES, 0.0);
+	phaseCalls.assign(NUM_PROFILE_PHASES, 0u);
+	runStart = std::chrono::steady_clock::now();
+
+	if (posteriorModeStart)
+	{
+		findPosteriorMode(genome, model);
+	}
 
 	// Allows to diverge from initial conditions (divergenceIterations controls the divergence).
 	// This allows for varying initial conditions for better exploration of the parameter space.
@@ -356,6 +520,7 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 
 	model.setNumPhiGroupings(genome.getGene(0).getObservedSynthesisRateValues().size());
 	model.initTraces(samples + 1, genome.getGenomeSize()); //Samples + 2 so we can store the starting and ending values.
+	initIterationScratch(genome, model);
 	// starting the MCMC
 
 	model.updateTracesWithInitialValues(genome);
@@ -389,6 +554,7 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 		{
 			if ((iteration) % fileWriteInterval  == 0u)
 			{
+				std::chrono::steady_clock::time_point phaseStart = startPhase();
 #ifndef STANDALONE
 				Rprintf("Writing restart file!\n");
 #else
@@ -405,6 +571,7 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 				{
 					model.writeRestartFile(file);
 				}
+				stopPhase(RESTART_PHASE, phaseStart);
 			}
 		}
 		if( (iteration) % 100u == 0u)
@@ -433,51 +600,75 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 				std::cout << "\t current Mixture element probability for element " << i << ": " << model.getCategoryProbability(i) << std::endl;
 #endif
 			}
+			if (profiling)
+			{
+				printProfile();
+			}
 		}
 		if(estimateCodonSpecificParameter)
 		{
-			model.proposeCodonSpecificParameter();
+			std::chrono::steady_clock::time_point phaseStart = startPhase();
+			if (!hamiltonianActive) model.proposeCodonSpecificParameter();
 			acceptRejectCodonSpecificParameter(genome, model, iteration);
+			stopPhase(CSP_PHASE, phaseStart);
 			if(( (iteration) % adaptiveWidth) == 0u)
 			{
+				phaseStart = startPhase();
 				model.adaptCodonSpecificParameterProposalWidth(adaptiveWidth, iteration / thining, iteration <= stepsToAdapt);
+				stopPhase(ADAPTATION_PHASE, phaseStart);
 			}
 		}
 		// update hyper parameter
 		if(estimateHyperParameter)
 		{
+			std::chrono::steady_clock::time_point phaseStart = startPhase();
 			model.updateGibbsSampledHyperParameters(genome);
 			model.proposeHyperParameters();
 			acceptRejectHyperParameter(genome, model, iteration);
+			stopPhase(HYPER_PHASE, phaseStart);
 			if(( (iteration) % adaptiveWidth) == 0u)
 			{
+				phaseStart = startPhase();
 				model.adaptHyperParameterProposalWidths(adaptiveWidth, iteration <= stepsToAdapt);
+				stopPhase(ADAPTATION_PHASE, phaseStart);
 			}
 		}
 		// update expression level values
 		if(estimateSynthesisRate || estimateMixtureAssignment)
 		{
+			std::chrono::steady_clock::time_point phaseStart = startPhase();
 			model.proposeSynthesisRateLevels();
 			double logLike = acceptRejectSynthesisRateLevelForAllGenes(genome, model, iteration);
+			stopPhase(PHI_PHASE, phaseStart);
 			if((iteration % thining) == 0u)
 			{
 				likelihoodTrace[(iteration / thining)] = logLike;
 				if (std::isnan(logLike)) {
 					std::cerr << "Log likelihood is NaN, exiting at iteration " << iteration << std::endl;
 					model.setLastIteration(iteration / thining);
+					if (profiling)
+					{
+						printProfile();
+						writeProfile();
+					}
+					unpinThreads();
 					return;
 				}
 			}
 			if(( (iteration) % adaptiveWidth) == 0u)
 			{
+				phaseStart = startPhase();
 				model.adaptSynthesisRateProposalWidth(adaptiveWidth, iteration <= stepsToAdapt);
+				stopPhase(ADAPTATION_PHASE, phaseStart);
 			}
 		}
 
 
 		if( ( (iteration) % (50*adaptiveWidth)) == 0u)
 		{
+			std::chrono::steady_clock::time_point phaseStart = startPhase();
 			double gewekeScore = calculateGewekeScore(iteration/thining);
+			stopPhase(GEWEKE_PHASE, phaseStart);
 #ifndef STANDALONE
 			Rprintf("##################################################\n");
 			Rprintf("Geweke Score after %d iterations: %f\n", iteration, gewekeScore);
@@ -506,10 +697,66 @@ void MCMCAlgorithm::run(Genome& genome, Model& model, unsigned numCores, unsigne
 #else
 	std::cout << "leaving MCMC loop" << std::endl;
 #endif
+	if (profiling) printParallelTimes();
+	if (delayedAcceptanceActive && firstStageProposals > 0ul)
+	{
+#ifndef STANDALONE
+		Rprintf("Delayed acceptance: %lu of %lu codon specific parameter proposals passed the first stage\n",
+				firstStagePassed, firstStageProposals);
+#else
+		std::cout << "Delayed acceptance: " << firstStagePassed << " of " << firstStageProposals
+			<< " codon specific parameter proposals passed the first stage\n";
+#endif
+	}
+	if (hamiltonianActive && estimateCodonSpecificParameter)
+	{
+#ifndef STANDALONE
+		Rprintf("Hamiltonian Monte Carlo step sizes\n");
+		for (unsigned i = 0u; i < model.getGroupListSize(); i++)
+		{
+			Rprintf("\t%s:\t%f\n", model.getGrouping(i).c_str(), hamiltonianSampler.getStepSize(i));
+		}
+#else
+		std::cout << "Hamiltonian Monte Carlo step sizes\n";
+		for (unsigned i = 0u; i < model.getGroupListSize(); i++)
+		{
+			std::cout << "\t" << model.getGrouping(i) << ":\t" << hamiltonianSampler.getStepSize(i) << "\n";
+		}
+#endif
+	}
+	if (profiling)
+	{
+		printProfile();
+		writeProfile();
+	}
+	unpinThreads();
 }
 
 
 
+/* findPosteriorMode (NOT EXPOSED)
+ * Arguments: reference to a genome and a model
+ * Moves the parameters of the model to the posterior mode, see Model::findPosteriorMode. Only done if all parameters
+ * are estimated, as the search changes all of them.
+*/
+void MCMCAlgorithm::findPosteriorMode(Genome& genome, Model& model)
+{
+	if (!(estimateSynthesisRate && estimateCodonSpecificParameter && estimateHyperParameter))
+	{
+		std::cerr << "Posterior mode start needs all parameters to be estimated, starting from the initial values\n";
+		return;
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	bool converged = model.findPosteriorMode(genome, posteriorModeRounds);
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+#ifndef STANDALONE
+	Rprintf("Posterior mode search %s after %f seconds\n", converged ? "converged" : "stopped", seconds);
+#else
+	std::cout << "Posterior mode search " << (converged ? "converged" : "stopped") << " after " << seconds << " seconds\n";
+#endif
+}
+
+
 /* varyInitialConditions (NOT EXPOSED)
  * Arguments: reference to a genome and a model. Number of iterations that the model can diverge from initial
  * conditions.
@@ -753,6 +1000,145 @@ int MCMCAlgorithm::getStepsToAdapt()
 }
 
 
+/* setThreadAffinity (RCPP EXPOSED)
+ * Arguments: "none", "close" or "spread"
+ * Sets how the threads of a run are pinned to cpus. "none" leaves placement to the OS, "close" puts thread i on the
+ * i-th available cpu, "spread" distributes the threads evenly over all available cpus. Pinning is only supported
+ * on Linux and is undone at the end of the run.
+*/
+void MCMCAlgorithm::setThreadAffinity(std::string affinity)
+{
+	if (affinity == "none" || affinity == "close" || affinity == "spread")
+	{
+		threadAffinity = affinity;
+	}
+	else
+	{
+		std::cerr << "Cannot set thread affinity - value must be \"none\", \"close\" or \"spread\"\n";
+	}
+}
+
+
+/* setProfiling (RCPP EXPOSED)
+ * Arguments: boolean, file name (empty for none)
+ * Turns timing of the phases of a run on or off. When on, the time and number of calls of each phase are printed
+ * with the status lines and at the end of the run, and written to the given file as JSON.
+*/
+void MCMCAlgorithm::setProfiling(bool in, std::string filename)
+{
+	profiling = in;
+	profileFile = filename;
+}
+
+
+/* setDelayedAcceptance (RCPP EXPOSED)
+ * Arguments: boolean, fraction of genes used to screen proposals (0, 1]
+ * Turns delayed acceptance of codon specific parameters on or off. Proposals are first accepted or rejected based on
+ * the given fraction of the genes, and only the ones passing are evaluated on all genes.
+*/
+void MCMCAlgorithm::setDelayedAcceptance(bool in, double fraction)
+{
+	if (fraction > 0.0 && fraction <= 1.0)
+	{
+		delayedAcceptance = in;
+		delayedAcceptanceFraction = fraction;
+	}
+	else
+	{
+		std::cerr << "Cannot set delayed acceptance - fraction must be in (0, 1]\n";
+	}
+}
+
+
+/* isDelayedAcceptance (RCPP EXPOSED)
+ * Arguments: None
+ * Return whether codon specific parameters are updated with delayed acceptance.
+*/
+bool MCMCAlgorithm::isDelayedAcceptance()
+{
+	return delayedAcceptance;
+}
+
+
+/* setHamiltonianMonteCarlo (RCPP EXPOSED)
+ * Arguments: boolean, number of leapfrog steps per proposal
+ * Turns Hamiltonian Monte Carlo proposals of codon specific parameters on or off. Every proposal costs steps + 1
+ * passes over the genes. Models without gradient functions keep using random walk proposals.
+*/
+void MCMCAlgorithm::setHamiltonianMonteCarlo(bool in, unsigned steps)
+{
+	if (steps > 0u)
+	{
+		hamiltonian = in;
+		hamiltonianSampler.setNumSteps(steps);
+	}
+	else
+	{
+		std::cerr << "Cannot set Hamiltonian Monte Carlo - at least one leapfrog step is needed\n";
+	}
+}
+
+
+/* isHamiltonianMonteCarlo (RCPP EXPOSED)
+ * Arguments: None
+ * Return whether codon specific parameters are proposed with Hamiltonian Monte Carlo.
+*/
+bool MCMCAlgorithm::isHamiltonianMonteCarlo()
+{
+	return hamiltonian;
+}
+
+
+/* setPosteriorModeStart (RCPP EXPOSED)
+ * Arguments: boolean, maximum number of optimization rounds
+ * Turns on or off starting the chain from the posterior mode instead of the initial values. The search also sets the
+ * proposal covariance matrices of the codon specific parameters. Models without gradient functions start from the
+ * initial values.
+*/
+void MCMCAlgorithm::setPosteriorModeStart(bool in, unsigned rounds)
+{
+	if (rounds > 0u)
+	{
+		posteriorModeStart = in;
+		posteriorModeRounds = rounds;
+	}
+	else
+	{
+		std::cerr << "Cannot set posterior mode start - at least one optimization round is needed\n";
+	}
+}
+
+
+/* isPosteriorModeStart (RCPP EXPOSED)
+ * Arguments: None
+ * Return whether the chain starts from the posterior mode.
+*/
+bool MCMCAlgorithm::isPosteriorModeStart()
+{
+	return posteriorModeStart;
+}
+
+
+/* isProfiling (RCPP EXPOSED)
+ * Arguments: None
+ * Return whether the phases of a run are timed.
+*/
+bool MCMCAlgorithm::isProfiling()
+{
+	return profiling;
+}
+
+
+/* getThreadAffinity (RCPP EXPOSED)
+ * Arguments: None
+ * Return the thread affinity setting.
+*/
+std::string MCMCAlgorithm::getThreadAffinity()
+{
+	return threadAffinity;
+}
+
+
 /* getLogLikelihoodTrace (RCPP EXPOSED)
  * Arguments: None
  * Return the liklihood trace.
@@ -927,6 +1313,215 @@ std::vector<std::vector<double>> MCMCAlgorithm::solveToeplitzMatrix(int lr, std:
 
 
 
+//-----------------------------------------//
+//---------- Threading Functions ----------//
+//-----------------------------------------//
+
+
+/* pinThreads (NOT EXPOSED)
+ * Arguments: number of threads used in the run
+ * Pins each of the numCores OpenMP threads of the run to a single cpu as set by setThreadAffinity. The cpus the
+ * calling thread was allowed to run on are remembered so unpinThreads can restore them.
+*/
+void MCMCAlgorithm::pinThreads(unsigned numCores)
+{
+	if (threadAffinity == "none" || numCores == 0u) return;
+#if defined(__linux__) && !defined(__APPLE__)
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	if (sched_getaffinity(0, sizeof(cpu_set_t), &cpus) != 0) return;
+
+	unpinnedCpus.clear();
+	for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+	{
+		if (CPU_ISSET(cpu, &cpus)) unpinnedCpus.push_back(cpu);
+	}
+	unsigned numCpus = unpinnedCpus.size();
+	bool spread = (threadAffinity == "spread");
+
+#pragma omp parallel num_threads(numCores)
+	{
+		unsigned thread = omp_get_thread_num();
+		unsigned slot = spread ? (thread * numCpus) / numCores : thread;
+		cpu_set_t mask;
+		CPU_ZERO(&mask);
+		CPU_SET(unpinnedCpus[slot % numCpus], &mask);
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mask);
+	}
+#else
+#ifndef STANDALONE
+	Rprintf("Thread affinity \"%s\" is not supported on this platform, threads are not pinned.\n", threadAffinity.c_str());
+#else
+	std::cout << "Thread affinity \"" << threadAffinity << "\" is not supported on this platform, threads are not pinned.\n";
+#endif
+#endif
+}
+
+
+/* unpinThreads (NOT EXPOSED)
+ * Arguments: None
+ * Allows every OpenMP thread to run on all cpus it could run on before pinThreads again.
+*/
+void MCMCAlgorithm::unpinThreads()
+{
+#if defined(__linux__) && !defined(__APPLE__)
+	if (unpinnedCpus.empty()) return;
+	cpu_set_t mask;
+	CPU_ZERO(&mask);
+	for (unsigned i = 0u; i < unpinnedCpus.size(); i++)
+	{
+		CPU_SET(unpinnedCpus[i], &mask);
+	}
+#pragma omp parallel
+	{
+		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mask);
+	}
+	unpinnedCpus.clear();
+#endif
+}
+
+
+/* printParallelTimes (NOT EXPOSED)
+ * Arguments: None
+ * Reports how the time of the parallel synthesis rate sweep was split between computing and waiting at the
+ * barrier for the slowest thread. Only the synthesis rate sweep is timed per thread, the parallel regions of the
+ * codon specific and hyper parameter updates are opened by the model and not split up.
+*/
+void MCMCAlgorithm::printParallelTimes()
+{
+	double computeTime = 0.0;
+	for (unsigned i = 0u; i < threadComputeTime.size(); i++)
+	{
+		computeTime += threadComputeTime[i];
+	}
+	double barrierTime = (parallelWallTime * threadComputeTime.size()) - computeTime;
+	double barrierPercent = parallelWallTime > 0.0 ? 100.0 * barrierTime / (parallelWallTime * threadComputeTime.size()) : 0.0;
+#ifndef STANDALONE
+	Rprintf("Synthesis rate sweep only (not codon specific or hyper parameters): %f s wall time on %d threads (affinity: %s)\n",
+		parallelWallTime, (int)threadComputeTime.size(), threadAffinity.c_str());
+	Rprintf("\t %f s computing, %f s (%f%%) waiting at barriers\n", computeTime, barrierTime, barrierPercent);
+	for (unsigned i = 0u; i < threadComputeTime.size(); i++)
+	{
+		Rprintf("\t thread %d: %f s computing\n", i, threadComputeTime[i]);
+	}
+#else
+	std::cout << "Synthesis rate sweep only (not codon specific or hyper parameters): " << parallelWallTime << " s wall time on "
+		<< threadComputeTime.size() << " threads (affinity: " << threadAffinity << ")\n";
+	std::cout << "\t " << computeTime << " s computing, " << barrierTime << " s (" << barrierPercent << "%) waiting at barriers\n";
+	for (unsigned i = 0u; i < threadComputeTime.size(); i++)
+	{
+		std::cout << "\t thread " << i << ": " << threadComputeTime[i] << " s computing\n";
+	}
+#endif
+}
+
+
+
+
+
+
+
+
+//-----------------------------------------//
+//---------- Profiling Functions ----------//
+//-----------------------------------------//
+
+
+static const char *profilePhaseNames[] = {"csp", "hyper", "phi", "trace", "adaptation", "restart", "geweke"};
+
+
+/* startPhase (NOT EXPOSED)
+ * Arguments: None
+ * Returns the time a profiled phase starts at. Does not read the clock if profiling is turned off.
+*/
+std::chrono::steady_clock::time_point MCMCAlgorithm::startPhase()
+{
+	return profiling ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point();
+}
+
+
+/* stopPhase (NOT EXPOSED)
+ * Arguments: phase that ended, time it started (from startPhase), phase it is nested in (if any)
+ * Adds the time since start to the phase and counts the call. The time is removed from the enclosing phase, so
+ * that trace updates done while accepting/rejecting are only counted once.
+*/
+void MCMCAlgorithm::stopPhase(ProfilePhase phase, std::chrono::steady_clock::time_point start, ProfilePhase enclosingPhase)
+{
+	if (!profiling) return;
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	phaseTime[phase] += elapsed.count();
+	phaseCalls[phase]++;
+	if (enclosingPhase != NUM_PROFILE_PHASES)
+	{
+		phaseTime[enclosingPhase] -= elapsed.count();
+	}
+}
+
+
+/* printProfile (NOT EXPOSED)
+ * Arguments: None
+ * Prints the time spent in each phase of the run so far.
+*/
+void MCMCAlgorithm::printProfile()
+{
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - runStart;
+#ifndef STANDALONE
+	Rprintf("\t profile after %f s:\n", wall.count());
+	for (unsigned i = 0u; i < NUM_PROFILE_PHASES; i++)
+	{
+		Rprintf("\t\t %s: %f s in %u calls\n", profilePhaseNames[i], phaseTime[i], phaseCalls[i]);
+	}
+#else
+	std::cout << "\t profile after " << wall.count() << " s:\n";
+	for (unsigned i = 0u; i < NUM_PROFILE_PHASES; i++)
+	{
+		std::cout << "\t\t " << profilePhaseNames[i] << ": " << phaseTime[i] << " s in " << phaseCalls[i] << " calls\n";
+	}
+#endif
+}
+
+
+/* writeProfile (NOT EXPOSED)
+ * Arguments: None
+ * Writes the phase times, the busy time of each thread in the synthesis rate sweep and the run settings to
+ * profileFile as JSON. Nothing is written if no file is set. The per thread times only cover the synthesis rate sweep
+ * (see printParallelTimes), the field is named phiSweepOnly so they are not read as busy times of the whole run.
+*/
+void MCMCAlgorithm::writeProfile()
+{
+	if (profileFile.empty()) return;
+	std::ofstream out(profileFile.c_str());
+	if (out.fail())
+	{
+		std::cerr << "Could not open profile file " << profileFile << " for writing\n";
+		return;
+	}
+	std::chrono::duration<double> wall = std::chrono::steady_clock::now() - runStart;
+	out.precision(9);
+	out << "{\n";
+	out << "  \"wallTime\": " << wall.count() << ",\n";
+	out << "  \"threads\": " << threadComputeTime.size() << ",\n";
+	out << "  \"threadAffinity\": \"" << threadAffinity << "\",\n";
+	out << "  \"phases\": {\n";
+	for (unsigned i = 0u; i < NUM_PROFILE_PHASES; i++)
+	{
+		out << "    \"" << profilePhaseNames[i] << "\": {\"time\": " << phaseTime[i] << ", \"calls\": " << phaseCalls[i] << "}"
+			<< (i + 1 < NUM_PROFILE_PHASES ? ",\n" : "\n");
+	}
+	out << "  },\n";
+	out << "  \"phiSweepOnly\": {\"wallTime\": " << parallelWallTime << ", \"threadBusyTime\": [";
+	for (unsigned i = 0u; i < threadComputeTime.size(); i++)
+	{
+		out << (i > 0u ? ", " : "") << threadComputeTime[i];
+	}
+	out << "]}\n";
+	out << "}\n";
+}
+
+
+
+
+
 
 
 
@@ -1026,6 +1621,16 @@ RCPP_MODULE(MCMCAlgorithm_mod)
         .method("setLogLikelihoodTrace", &MCMCAlgorithm::setLogLikelihoodTrace)
         .method("setStepsToAdapt", &MCMCAlgorithm::setStepsToAdapt)
         .method("getStepsToAdapt", &MCMCAlgorithm::getStepsToAdapt)
+        .method("setThreadAffinity", &MCMCAlgorithm::setThreadAffinity)
+        .method("getThreadAffinity", &MCMCAlgorithm::getThreadAffinity)
+        .method("setProfiling", &MCMCAlgorithm::setProfiling)
+        .method("isProfiling", &MCMCAlgorithm::isProfiling)
+        .method("setDelayedAcceptance", &MCMCAlgorithm::setDelayedAcceptance)
+        .method("isDelayedAcceptance", &MCMCAlgorithm::isDelayedAcceptance)
+        .method("setHamiltonianMonteCarlo", &MCMCAlgorithm::setHamiltonianMonteCarlo)
+        .method("isHamiltonianMonteCarlo", &MCMCAlgorithm::isHamiltonianMonteCarlo)
+        .method("setPosteriorModeStart", &MCMCAlgorithm::setPosteriorModeStart)
+        .method("isPosteriorModeStart", &MCMCAlgorithm::isPosteriorModeStart)
 		;
 
 
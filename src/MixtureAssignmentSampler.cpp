@@ -0,0 +1,255 @@
+#include "include/MixtureAssignmentSampler.h"
+
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
+
+//--------------------------------------------------//
+// ---------- Constructors & Destructors ---------- //
+//--------------------------------------------------//
+
+
+MixtureAssignmentSampler::MixtureAssignmentSampler()
+{
+	numGenes = 0u;
+	numMixtures = 0u;
+}
+
+
+MixtureAssignmentSampler::~MixtureAssignmentSampler()
+{
+	//dtor
+}
+
+
+
+
+
+//----------------------------------------//
+//---------- Sampling Functions ----------//
+//----------------------------------------//
+
+
+/* resize (NOT EXPOSED)
+ * Arguments: number of genes, number of mixture elements
+ * Sizes the genes x mixtures matrices. Memory is kept if the sizes do not change, so the sampler can be
+ * resized every iteration without allocating.
+*/
+void MixtureAssignmentSampler::resize(unsigned _numGenes, unsigned _numMixtures)
+{
+	numGenes = _numGenes;
+	numMixtures = _numMixtures;
+	logPosterior.resize(numGenes * numMixtures, 0.0);
+	probabilities.resize(numGenes * numMixtures, 0.0);
+	logNormalizingConstant.resize(numGenes, 0.0);
+	referenceValues.resize(numGenes, 0.0);
+	assignments.resize(numGenes, 0u);
+	counts.resize(numMixtures, 0.0);
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	if (partialCounts.size() < numThreads * numMixtures) partialCounts.resize(numThreads * numMixtures);
+}
+
+
+/* calculateProbabilities (NOT EXPOSED)
+ * Arguments: probability of every mixture element
+ * Calculates the posterior probability of every mixture element for every gene from the unnormalized log posteriors
+ * in getLogPosterior. Log posteriors are around -1000, so they are shifted by their maximum before exponentiating:
+ * p_k = w_k * exp(l_k - max(l)) / sum(w_j * exp(l_j - max(l))). The log of the normalizing constant,
+ * max(l) + log(sum(w_j * exp(l_j - max(l)))), is kept per gene. Rows are independent and processed in parallel, the
+ * loops over mixture elements are written to be vectorized.
+*/
+void MixtureAssignmentSampler::calculateProbabilities(const double *mixtureProbabilities)
+{
+	int n = numGenes;
+	unsigned m = numMixtures;
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static)
+#endif
+	for (int i = 0; i < n; i++)
+	{
+		const double *logPost = &logPosterior[i * m];
+		double *prob = &probabilities[i * m];
+
+		double maxValue = logPost[0];
+#ifndef __APPLE__
+#pragma omp simd reduction(max:maxValue)
+#endif
+		for (unsigned k = 1u; k < m; k++)
+		{
+			maxValue = logPost[k] > maxValue ? logPost[k] : maxValue;
+		}
+
+		double normalizingConstant = 0.0;
+#ifndef __APPLE__
+#pragma omp simd reduction(+:normalizingConstant)
+#endif
+		for (unsigned k = 0u; k < m; k++)
+		{
+			prob[k] = mixtureProbabilities[k] * std::exp(logPost[k] - maxValue);
+			normalizingConstant += prob[k];
+		}
+
+#ifndef __APPLE__
+#pragma omp simd
+#endif
+		for (unsigned k = 0u; k < m; k++)
+		{
+			prob[k] = prob[k] / normalizingConstant;
+		}
+		logNormalizingConstant[i] = maxValue + std::log(normalizingConstant);
+	}
+}
+
+
+/* drawAssignments (NOT EXPOSED)
+ * Arguments: None
+ * Draws one U(0,1) number per gene in a single batch and assigns every gene to a mixture element, see assign.
+*/
+void MixtureAssignmentSampler::drawAssignments()
+{
+	if (numGenes == 0u) return;
+	Parameter::drawUniformVector(numGenes, &referenceValues[0]);
+	assign(&referenceValues[0]);
+}
+
+
+/* assign (NOT EXPOSED)
+ * Arguments: one U(0,1) number per gene
+ * Assigns every gene to the first mixture element at which the cumulative sum of its probabilities reaches the
+ * uniform number, the same inversion Parameter::randMultinom uses. If rounding keeps the sum below the number the gene
+ * is assigned to the first mixture element, as in randMultinom.
+*/
+void MixtureAssignmentSampler::assign(const double *uniformNumbers)
+{
+	int n = numGenes;
+	unsigned m = numMixtures;
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static)
+#endif
+	for (int i = 0; i < n; i++)
+	{
+		const double *prob = &probabilities[i * m];
+		unsigned category = 0u;
+		double cumsum = 0.0;
+		for (unsigned k = 0u; k < m; k++)
+		{
+			cumsum += prob[k];
+			if (uniformNumbers[i] <= cumsum)
+			{
+				category = k;
+				break;
+			}
+		}
+		assignments[i] = category;
+	}
+}
+
+
+/* countAssignments (NOT EXPOSED)
+ * Arguments: None
+ * Counts the genes assigned to every mixture element. Every thread counts its genes into its own row of partialCounts,
+ * the rows are added up afterwards. The counts are the parameters of the Dirichlet draw of the mixture probabilities,
+ * so they are stored as doubles.
+*/
+void MixtureAssignmentSampler::countAssignments()
+{
+	int n = numGenes;
+	unsigned m = numMixtures;
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	if (partialCounts.size() < numThreads * m) partialCounts.resize(numThreads * m);
+	for (unsigned k = 0u; k < numThreads * m; k++)
+	{
+		partialCounts[k] = 0.0;
+	}
+
+#ifndef __APPLE__
+#pragma omp parallel num_threads(numThreads)
+#endif
+	{
+#ifndef __APPLE__
+		double *count = &partialCounts[omp_get_thread_num() * m];
+#pragma omp for schedule(static)
+#else
+		double *count = &partialCounts[0];
+#endif
+		for (int i = 0; i < n; i++)
+		{
+			count[assignments[i]] += 1;
+		}
+	}
+
+	for (unsigned k = 0u; k < m; k++)
+	{
+		counts[k] = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			counts[k] += partialCounts[t * m + k];
+		}
+	}
+}
+
+
+
+
+
+//--------------------------------------//
+//---------- Getter Functions ----------//
+//--------------------------------------//
+
+
+unsigned MixtureAssignmentSampler::getNumGenes()
+{
+	return numGenes;
+}
+
+
+unsigned MixtureAssignmentSampler::getNumMixtures()
+{
+	return numMixtures;
+}
+
+
+/* getLogPosterior (NOT EXPOSED)
+ * Arguments: index of a gene
+ * Returns the row of the gene in the genes x mixtures matrix of unnormalized log posteriors, to be filled before
+ * calculateProbabilities is called.
+*/
+double* MixtureAssignmentSampler::getLogPosterior(unsigned gene)
+{
+	return &logPosterior[gene * numMixtures];
+}
+
+
+double* MixtureAssignmentSampler::getProbabilities(unsigned gene)
+{
+	return &probabilities[gene * numMixtures];
+}
+
+
+double MixtureAssignmentSampler::getLogNormalizingConstant(unsigned gene)
+{
+	return logNormalizingConstant[gene];
+}
+
+
+unsigned MixtureAssignmentSampler::getAssignment(unsigned gene)
+{
+	return assignments[gene];
+}
+
+
+double* MixtureAssignmentSampler::getCounts()
+{
+	return &counts[0];
+}
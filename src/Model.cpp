@@ -1,5 +1,12 @@
 #include "include/base/Model.h"
 
+
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
 Model::Model()
 {
 //ctor
@@ -10,6 +17,249 @@ Model::~Model()
 //dtor
 }
 
+
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, vector to store one log acceptance ratio per grouping in
+ * Calculates the log acceptance ratio of the proposed codon specific parameters for every grouping. The groupings are
+ * conditionally independent given phi, so all ratios can be calculated before any of them is accepted.
+ * This default calls calculateLogLikelihoodRatioPerGroupingPerCategory once per grouping. Models override it to do a
+ * single pass over the genes instead.
+*/
+void Model::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios)
+{
+	unsigned numGroupings = getGroupListSize();
+	logAcceptanceRatios.resize(numGroupings);
+	for (unsigned i = 0u; i < numGroupings; i++)
+	{
+		calculateLogLikelihoodRatioPerGroupingPerCategory(getGrouping(i), genome, logAcceptanceRatios[i]);
+	}
+}
+
+
+/* calculateLogLikelihoodRatioForGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, first gene and stride of the genes to use, one flag per grouping (NULL for all
+ * groupings), vector to store one log acceptance ratio per grouping in
+ * Like calculateLogLikelihoodRatioForAllGroupings, but only for the flagged groupings and only using every
+ * geneStride-th gene starting at firstGene. The likelihood of the used genes is scaled up to the whole genome, so
+ * with a stride above one the result is an estimate. This is the cheap first stage of delayed acceptance.
+ * This default uses all genes regardless of the stride. Models override it to use the gene subsample, and say so with
+ * hasSubsampleSurrogate.
+*/
+void Model::calculateLogLikelihoodRatioForGroupings(Genome& genome, unsigned /*firstGene*/, unsigned /*geneStride*/,
+		const char* groupingMask, std::vector<double> &logAcceptanceRatios)
+{
+	unsigned numGroupings = getGroupListSize();
+	logAcceptanceRatios.resize(numGroupings);
+	for (unsigned i = 0u; i < numGroupings; i++)
+	{
+		if (groupingMask != NULL && !groupingMask[i]) continue;
+		calculateLogLikelihoodRatioPerGroupingPerCategory(getGrouping(i), genome, logAcceptanceRatios[i]);
+	}
+}
+
+
+/* prepareLogLikelihoodRatiosPerGene (NOT EXPOSED)
+ * Arguments: mixture elements every gene will be evaluated for, number of threads calling
+ * calculateLogLikelihoodRatiosPerGene
+ * Called once before every synthesis rate sweep, outside of the parallel region. Models that share work between mixture
+ * elements gather their gene independent terms and size their per thread scratch space here. The default does nothing.
+*/
+void Model::prepareLogLikelihoodRatiosPerGene(std::vector<unsigned> &/*mixtureElements*/, unsigned /*numThreads*/)
+{
+}
+
+
+/* calculateLogLikelihoodRatiosPerGene (NOT EXPOSED)
+ * Arguments: gene, index of the gene, mixture elements to evaluate the gene for, array to store five values per mixture
+ * element in (see calculateLogLikelihoodRatioPerGene)
+ * Same as calling calculateLogLikelihoodRatioPerGene for every mixture element. Mixture elements sharing a mutation or
+ * selection category share most of their likelihood, so models override this to calculate those terms once per
+ * category instead of once per mixture element.
+*/
+void Model::calculateLogLikelihoodRatiosPerGene(Gene& gene, unsigned geneIndex, std::vector<unsigned> &mixtureElements,
+		double* logProbabilityRatios)
+{
+	for (unsigned n = 0u; n < mixtureElements.size(); n++)
+	{
+		calculateLogLikelihoodRatioPerGene(gene, geneIndex, mixtureElements[n], &logProbabilityRatios[n * 5]);
+	}
+}
+
+/* hasSubsampleSurrogate (NOT EXPOSED)
+ * Arguments: None
+ * Returns whether calculateLogLikelihoodRatioForGroupings only uses the requested gene subsample. Without it the first
+ * stage of delayed acceptance would cost as much as the exact ratio. The default does not.
+*/
+bool Model::hasSubsampleSurrogate()
+{
+	return false;
+}
+
+
+/* hasCodonSpecificParameterGradient (NOT EXPOSED)
+ * Arguments: None
+ * Returns whether the model implements the gradient functions below, which gradient based samplers of the codon
+ * specific parameters need. The default does not.
+*/
+bool Model::hasCodonSpecificParameterGradient()
+{
+	return false;
+}
+
+
+/* getCodonSpecificParameterVector (NOT EXPOSED)
+ * Arguments: vector to store the current codon specific parameters in, vector to store where the parameters of every
+ * grouping start in (one more entry than groupings, the last one is the number of parameters)
+ * Flattens the current codon specific parameters of all groupings into one vector. Only implemented by models with a
+ * gradient, the default stores nothing.
+*/
+void Model::getCodonSpecificParameterVector(std::vector<double> &values, std::vector<unsigned> &groupingOffsets)
+{
+	values.clear();
+	groupingOffsets.assign(1, 0u);
+}
+
+
+/* setProposedCodonSpecificParameterVector (NOT EXPOSED)
+ * Arguments: codon specific parameters of all groupings, in the layout of getCodonSpecificParameterVector
+ * Sets the proposed codon specific parameters. Only implemented by models with a gradient.
+*/
+void Model::setProposedCodonSpecificParameterVector(std::vector<double> &/*values*/)
+{
+	std::cerr << "Model::setProposedCodonSpecificParameterVector not implemented for this model\n";
+}
+
+
+/* calculateLogPosteriorGradientForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, vector to store the log posterior of every grouping in, vector to store the
+ * gradient in (layout of getCodonSpecificParameterVector), vector to store the negative second derivatives in (NULL
+ * if not needed)
+ * Calculates the log posterior of the proposed codon specific parameters of every grouping and its gradient, given
+ * the current synthesis rates and mixture assignments. Only implemented by models with a gradient.
+*/
+void Model::calculateLogPosteriorGradientForAllGroupings(Genome& /*genome*/, std::vector<double> &/*logPosterior*/,
+		std::vector<double> &/*gradient*/, std::vector<double> * /*curvature*/)
+{
+	std::cerr << "Model::calculateLogPosteriorGradientForAllGroupings not implemented for this model\n";
+}
+
+
+/* findPosteriorMode (NOT EXPOSED)
+ * Arguments: reference to a genome, maximum number of optimization rounds
+ * Moves the parameters of the model to the mode of the posterior before sampling starts. Returns whether the search
+ * converged. Only implemented by models with a gradient, the default leaves the parameters as they are.
+*/
+bool Model::findPosteriorMode(Genome& /*genome*/, unsigned /*maxIterations*/)
+{
+	std::cerr << "Model::findPosteriorMode not implemented for this model, starting from the initial values\n";
+	return false;
+}
+
+
+/* calculateLogLikelihoodPerGene (NOT EXPOSED)
+ * Arguments: reference to a gene, mixture element, synthesis rates, vector to store the log likelihoods in
+ * Calculates the log likelihood of the data of the gene under the current codon specific parameters of the mixture
+ * element for each of the given synthesis rates, without the prior of the synthesis rate. Used to evaluate genes the
+ * model was not fit to (see CrossValidation). Only implemented by models that can do that.
+*/
+void Model::calculateLogLikelihoodPerGene(Gene& /*gene*/, unsigned /*mixtureElement*/, std::vector<double> &phiValues,
+		std::vector<double> &logLikelihoods)
+{
+	std::cerr << "Model::calculateLogLikelihoodPerGene not implemented for this model\n";
+	logLikelihoods.assign(phiValues.size(), 0.0);
+}
+
+
+/* simulateGenomeToFile (RCPP EXPOSED)
+ * Arguments: reference to a genome, name of the output file
+ * Simulates a new sequence for every gene of the genome from the current parameters and writes them to a FASTA file
+ * under the ids of the original genes, without storing them in the genome. The default is for models that simulate
+ * codon sequences, models that simulate other data override it.
+*/
+void Model::simulateGenomeToFile(Genome &genome, std::string filename)
+{
+	simulateGenomeInBlocks(genome, filename);
+}
+
+
+/* simulateCodonSequences (NOT EXPOSED)
+ * Arguments: reference to a genome, first gene and number of genes to simulate, seed of the random number streams,
+ * vector to store the simulated sequences in
+ * Simulates a new sequence for the given genes from the current parameters, keeping the amino acid sequence. Gene
+ * i uses the random number stream (seed, i), so the result does not depend on the number of threads or on how the
+ * genes are split into calls. Only implemented by models that simulate codon sequences.
+*/
+void Model::simulateCodonSequences(Genome &/*genome*/, unsigned /*firstGene*/, unsigned numGenes, unsigned /*seed*/,
+		std::vector<std::string> &sequences)
+{
+	std::cerr << "Model::simulateCodonSequences not implemented for this model\n";
+	sequences.assign(numGenes, "");
+}
+
+
+/* simulateGenomeInBlocks (NOT EXPOSED)
+ * Arguments: reference to a genome, name of a FASTA file (empty to store the simulated genes in the genome)
+ * Simulates all genes of the genome with simulateCodonSequences, one block of genes at a time so only one block of
+ * sequences is held in memory. Without a file name the simulated genes are added to the simulated genes of the
+ * genome with the id "Simulated Gene" and the id of the original gene as description. With a file name they are
+ * written to the file as writeFasta would write them.
+*/
+void Model::simulateGenomeInBlocks(Genome &genome, std::string filename)
+{
+	const unsigned blockSize = 1024u;
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned firstSimulated = genome.getGenomeSize(true);
+	unsigned seed = (unsigned)Parameter::randUnif(0.0, 4294967295.0);
+
+	std::ofstream Fout;
+	if (filename.empty())
+	{
+		genome.setGenomeSize(firstSimulated + numGenes, true);
+	}
+	else
+	{
+		Fout.open(filename.c_str());
+		if (Fout.fail())
+		{
+			my_printError("Error in Model::simulateGenomeInBlocks: Can not open output Fasta file %\n", filename);
+			return;
+		}
+	}
+
+	std::vector<std::string> sequences;
+	for (unsigned block = 0u; block < numGenes; block += blockSize)
+	{
+		unsigned numBlockGenes = std::min(blockSize, numGenes - block);
+		simulateCodonSequences(genome, block, numBlockGenes, seed, sequences);
+		if (filename.empty())
+		{
+#ifndef __APPLE__
+#pragma omp parallel for schedule(dynamic, 16)
+#endif
+			for (unsigned i = 0u; i < numBlockGenes; i++)
+			{
+				Gene &simulatedGene = genome.getGene(firstSimulated + block + i, true);
+				simulatedGene.setId("Simulated Gene");
+				simulatedGene.setDescription(genome.getGene(block + i).getId());
+				simulatedGene.setSequence(sequences[i]);
+			}
+		}
+		else
+		{
+			for (unsigned i = 0u; i < numBlockGenes; i++)
+			{
+				const std::string &sequence = sequences[i];
+				Fout << ">" << genome.getGene(block + i).getId() << "\n";
+				for (size_t j = 0u; j < sequence.size(); j += 60u)
+				{
+					Fout.write(sequence.data() + j, std::min<size_t>(60u, sequence.size() - j));
+					Fout << "\n";
+				}
+			}
+		}
+	}
+}
+
 //Cedric: This functions will repalce calculateMutationPrior in ROC/FONSE model and allows us to more generally use priors on codon specific parameters.
 //			We have to first change how current and proposed csp values are stored to move the function getParameterForCategory up into the base parameter class.
 
@@ -0,0 +1,911 @@
+#include "include/PANSE/PANSEModel.h"
+
+//R runs only
+#ifndef STANDALONE
+#include <Rcpp.h>
+using namespace Rcpp;
+#endif
+
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+//--------------------------------------------------//
+//----------- Constructors & Destructors ---------- //
+//--------------------------------------------------//
+
+PANSEModel::PANSEModel() : Model()
+{
+	parameter = 0;
+	numCodons = 0u;
+	//ctor
+}
+
+PANSEModel::~PANSEModel()
+{
+	//dtor
+	//TODO: call Parent's deconstructor
+}
+
+
+
+
+/* calculateLogLikelihoodPerCodonPerGene (NOT EXPOSED)
+ * Arguments: alpha with its log and log gamma, lambda prime and its log, RFP counts at the positions of the codon that
+ * have one, number of those counts, number of positions of the codon in the gene, phi and its log
+ * Calculates the log likelihood of the RFP counts at all positions of one codon in one gene. Every position is a
+ * gamma-poisson (negative binomial) draw with shape alpha, so positions without footprints all contribute
+ * alpha * (log(lambdaPrime) - log(lambdaPrime + phi)) and are accounted for by the codon count. Only the positions with
+ * a count are visited.
+*/
+double PANSEModel::calculateLogLikelihoodPerCodonPerGene(double alpha, double logAlpha, double logGammaAlpha,
+		double lambdaPrime, double logLambdaPrime, const unsigned* rfpCounts, unsigned numRFPCounts,
+		unsigned numCodonsInMRNA, double phiValue, double logPhiValue)
+{
+	unsigned rfpSum = 0u;
+	double logGammaRatioSum = calculateLogGammaRatioSum(alpha, logAlpha, logGammaAlpha, rfpCounts, numRFPCounts, rfpSum);
+	double logLambdaPrimePlusPhi = std::log(lambdaPrime + phiValue);
+
+	return logGammaRatioSum + (rfpSum * (logPhiValue - logLambdaPrimePlusPhi))
+		   + ((numCodonsInMRNA * alpha) * (logLambdaPrime - logLambdaPrimePlusPhi));
+}
+
+
+/* calculateLogGammaRatioSum (NOT EXPOSED)
+ * Arguments: alpha with its log and log gamma, RFP counts, number of counts, variable to store the sum of the counts in
+ * Returns the sum of lgamma(alpha + count) - lgamma(alpha) over the counts. This part of the likelihood does not
+ * depend on phi. A count of one, the most common one, is log(alpha) and needs no lgamma call.
+*/
+double PANSEModel::calculateLogGammaRatioSum(double alpha, double logAlpha, double logGammaAlpha, const unsigned* rfpCounts,
+		unsigned numRFPCounts, unsigned &rfpSum)
+{
+	double logGammaRatioSum = 0.0;
+	rfpSum = 0u;
+	for (unsigned j = 0u; j < numRFPCounts; j++)
+	{
+		unsigned count = rfpCounts[j];
+		rfpSum += count;
+		logGammaRatioSum += (count == 1u) ? logAlpha : std::lgamma(alpha + count) - logGammaAlpha;
+	}
+	return logGammaRatioSum;
+}
+
+
+/* refreshCodonTerms (NOT EXPOSED)
+ * Arguments: None
+ * Recomputes the logs of the current alpha and lambda prime values of every category and codon that changed since
+ * they were last computed. Must not be called from inside a parallel region, the likelihood functions only read the
+ * terms and compute them on the fly if they are outdated.
+*/
+void PANSEModel::refreshCodonTerms()
+{
+	numCodons = getGroupListSize();
+	unsigned numAlphaCategories = parameter->getNumMutationCategories();
+	unsigned numLambdaPrimeCategories = parameter->getNumSelectionCategories();
+	double invalid = std::numeric_limits<double>::quiet_NaN();
+
+	if (termAlpha.size() != numAlphaCategories || (numAlphaCategories != 0u && termAlpha[0].size() != numCodons))
+	{
+		termAlpha.assign(numAlphaCategories, std::vector<double>(numCodons, invalid));
+		termLogAlpha.assign(numAlphaCategories, std::vector<double>(numCodons, 0.0));
+		termLogGammaAlpha.assign(numAlphaCategories, std::vector<double>(numCodons, 0.0));
+	}
+	if (termLambdaPrime.size() != numLambdaPrimeCategories ||
+		(numLambdaPrimeCategories != 0u && termLambdaPrime[0].size() != numCodons))
+	{
+		termLambdaPrime.assign(numLambdaPrimeCategories, std::vector<double>(numCodons, invalid));
+		termLogLambdaPrime.assign(numLambdaPrimeCategories, std::vector<double>(numCodons, 0.0));
+	}
+
+	for (unsigned k = 0u; k < numAlphaCategories; k++)
+	{
+		for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+		{
+			double alpha = parameter->getParameterForCategory(k, PANSEParameter::alp, codonIndex, false);
+			if (termAlpha[k][codonIndex] == alpha) continue;
+			termAlpha[k][codonIndex] = alpha;
+			termLogAlpha[k][codonIndex] = std::log(alpha);
+			termLogGammaAlpha[k][codonIndex] = std::lgamma(alpha);
+		}
+	}
+	for (unsigned k = 0u; k < numLambdaPrimeCategories; k++)
+	{
+		for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+		{
+			double lambdaPrime = parameter->getParameterForCategory(k, PANSEParameter::lmPri, codonIndex, false);
+			if (termLambdaPrime[k][codonIndex] == lambdaPrime) continue;
+			termLambdaPrime[k][codonIndex] = lambdaPrime;
+			termLogLambdaPrime[k][codonIndex] = std::log(lambdaPrime);
+		}
+	}
+}
+
+
+/* calculateProposedCodonTerms (NOT EXPOSED)
+ * Arguments: codon index, vectors to store the proposed alpha, log(alpha), lgamma(alpha) per mutation category and the
+ * proposed lambda prime and its log per selection category in
+ * Computes the terms of the proposed parameters of one codon once, instead of once per gene.
+*/
+void PANSEModel::calculateProposedCodonTerms(unsigned codonIndex, std::vector<double> &alpha, std::vector<double> &logAlpha,
+		std::vector<double> &logGammaAlpha, std::vector<double> &lambdaPrime, std::vector<double> &logLambdaPrime)
+{
+	unsigned numAlphaCategories = parameter->getNumMutationCategories();
+	unsigned numLambdaPrimeCategories = parameter->getNumSelectionCategories();
+	alpha.resize(numAlphaCategories);
+	logAlpha.resize(numAlphaCategories);
+	logGammaAlpha.resize(numAlphaCategories);
+	lambdaPrime.resize(numLambdaPrimeCategories);
+	logLambdaPrime.resize(numLambdaPrimeCategories);
+	for (unsigned k = 0u; k < numAlphaCategories; k++)
+	{
+		alpha[k] = parameter->getParameterForCategory(k, PANSEParameter::alp, codonIndex, true);
+		logAlpha[k] = std::log(alpha[k]);
+		logGammaAlpha[k] = std::lgamma(alpha[k]);
+	}
+	for (unsigned k = 0u; k < numLambdaPrimeCategories; k++)
+	{
+		lambdaPrime[k] = parameter->getParameterForCategory(k, PANSEParameter::lmPri, codonIndex, true);
+		logLambdaPrime[k] = std::log(lambdaPrime[k]);
+	}
+}
+
+
+
+
+
+//------------------------------------------------//
+//---------- Likelihood Ratio Functions ----------//
+//------------------------------------------------//
+
+
+/* calculateLogLikelihoodRatioPerGene (NOT EXPOSED)
+ * Arguments: gene, gene index, mixture element, array to store the five log probability ratios in
+ * Calculates the log likelihood ratio of the proposed synthesis rate of a gene over its per position RFP counts. The
+ * lgamma part of the likelihood does not depend on phi, so it is computed once for both phi values.
+*/
+void PANSEModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex, unsigned k, double* logProbabilityRatio)
+{
+	double logLikelihood = 0.0;
+	double logLikelihood_proposed = 0.0;
+
+	unsigned alphaCategory = parameter->getMutationCategory(k);
+	unsigned lambdaPrimeCategory = parameter->getSelectionCategory(k);
+	unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(k);
+
+	double phiValue = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, false);
+	double phiValue_proposed = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, true);
+	double logPhi = std::log(phiValue);
+	double logPhi_proposed = std::log(phiValue_proposed);
+
+	const std::vector<unsigned> &codonStart = gene.geneData.getRFP_countCodonStart();
+	const std::vector<unsigned> &rfpCounts = gene.geneData.getRFP_countByCodon();
+	bool hasCounts = !codonStart.empty();
+	bool cached = termAlpha.size() > alphaCategory && termLambdaPrime.size() > lambdaPrimeCategory &&
+		termAlpha[alphaCategory].size() == getGroupListSize();
+
+	for (unsigned codonIndex = 0u; codonIndex < getGroupListSize(); codonIndex++) //number of codons, without the stop codons
+	{
+		unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(codonIndex);
+		if (currNumCodonsInMRNA == 0) continue;
+
+		double alpha = parameter->getParameterForCategory(alphaCategory, PANSEParameter::alp, codonIndex, false);
+		double lambdaPrime = parameter->getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, codonIndex, false);
+		double logAlpha, logGammaAlpha, logLambdaPrime;
+		if (cached && termAlpha[alphaCategory][codonIndex] == alpha)
+		{
+			logAlpha = termLogAlpha[alphaCategory][codonIndex];
+			logGammaAlpha = termLogGammaAlpha[alphaCategory][codonIndex];
+		}
+		else
+		{
+			logAlpha = std::log(alpha);
+			logGammaAlpha = std::lgamma(alpha);
+		}
+		if (cached && termLambdaPrime[lambdaPrimeCategory][codonIndex] == lambdaPrime)
+			logLambdaPrime = termLogLambdaPrime[lambdaPrimeCategory][codonIndex];
+		else
+			logLambdaPrime = std::log(lambdaPrime);
+
+		unsigned rfpSum = 0u;
+		double logGammaRatioSum = 0.0;
+		if (hasCounts)
+		{
+			logGammaRatioSum = calculateLogGammaRatioSum(alpha, logAlpha, logGammaAlpha, &rfpCounts[0] + codonStart[codonIndex],
+				codonStart[codonIndex + 1] - codonStart[codonIndex], rfpSum);
+		}
+		double logLambdaPrimePlusPhi = std::log(lambdaPrime + phiValue);
+		double logLambdaPrimePlusPhi_proposed = std::log(lambdaPrime + phiValue_proposed);
+		double alphaTimesNumCodons = currNumCodonsInMRNA * alpha;
+
+		logLikelihood += logGammaRatioSum + (rfpSum * (logPhi - logLambdaPrimePlusPhi))
+			+ (alphaTimesNumCodons * (logLambdaPrime - logLambdaPrimePlusPhi));
+		logLikelihood_proposed += logGammaRatioSum + (rfpSum * (logPhi_proposed - logLambdaPrimePlusPhi_proposed))
+			+ (alphaTimesNumCodons * (logLambdaPrime - logLambdaPrimePlusPhi_proposed));
+	}
+
+	double stdDevSynthesisRate = parameter->getStdDevSynthesisRate(false);
+	double logPhiProbability = Parameter::densityLogNorm(phiValue, (-(stdDevSynthesisRate * stdDevSynthesisRate) / 2), stdDevSynthesisRate, true);
+	double logPhiProbability_proposed = Parameter::densityLogNorm(phiValue_proposed, (-(stdDevSynthesisRate * stdDevSynthesisRate) / 2), stdDevSynthesisRate, true);
+	double currentLogLikelihood = (logLikelihood + logPhiProbability);
+	double proposedLogLikelihood = (logLikelihood_proposed + logPhiProbability_proposed);
+
+	logProbabilityRatio[0] = (proposedLogLikelihood - currentLogLikelihood) - (logPhi - logPhi_proposed);
+	logProbabilityRatio[1] = currentLogLikelihood - logPhi_proposed;
+	logProbabilityRatio[2] = proposedLogLikelihood - logPhi;
+	logProbabilityRatio[3] = currentLogLikelihood;
+	logProbabilityRatio[4] = proposedLogLikelihood;
+}
+
+
+/* calculateLogLikelihoodRatioPerGroupingPerCategory (NOT EXPOSED)
+ * Arguments: codon, genome, variable to store the log acceptance ratio in
+ * Calculates the log acceptance ratio of the proposed alpha and lambda prime of one codon over the per position RFP
+ * counts of all genes. Genes are processed in parallel, each thread sums a contiguous block of genes and the blocks
+ * are added up in order, so the result does not depend on the number of threads.
+*/
+void PANSEModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, double& logAcceptanceRatioForAllMixtures)
+{
+	unsigned codonIndex = SequenceSummary::codonToIndex(grouping);
+	refreshCodonTerms();
+	std::vector<double> propAlpha, propLogAlpha, propLogGammaAlpha, propLambdaPrime, propLogLambdaPrime;
+	calculateProposedCodonTerms(codonIndex, propAlpha, propLogAlpha, propLogGammaAlpha, propLambdaPrime, propLogLambdaPrime);
+
+	int numGenes = genome.getGenomeSize();
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	std::vector<double> threadLogLikelihood(numThreads, 0.0);
+	std::vector<double> threadLogLikelihood_proposed(numThreads, 0.0);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		unsigned thread = omp_get_thread_num();
+#else
+		unsigned thread = 0u;
+#endif
+		double logLikelihood = 0.0;
+		double logLikelihood_proposed = 0.0;
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int i = 0; i < numGenes; i++)
+		{
+			SequenceSummary &geneData = genome.getGene(i).geneData;
+			unsigned currNumCodonsInMRNA = geneData.getCodonCountForCodon(codonIndex);
+			if (currNumCodonsInMRNA == 0) continue;
+
+			// which mixture element does this gene belong to
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			// how is the mixture element defined. Which categories make it up
+			unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
+			unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+			unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			// get non codon specific values, calculate likelihood conditional on these
+			double phiValue = parameter->getSynthesisRate(i, synthesisRateCategory, false);
+			double logPhi = parameter->getLogSynthesisRate(i, synthesisRateCategory);
+
+			const std::vector<unsigned> &codonStart = geneData.getRFP_countCodonStart();
+			const unsigned *rfpCounts = NULL;
+			unsigned numRFPCounts = 0u;
+			if (!codonStart.empty() && codonStart[codonIndex + 1] != codonStart[codonIndex])
+			{
+				rfpCounts = &geneData.getRFP_countByCodon()[codonStart[codonIndex]];
+				numRFPCounts = codonStart[codonIndex + 1] - codonStart[codonIndex];
+			}
+
+			logLikelihood += calculateLogLikelihoodPerCodonPerGene(termAlpha[alphaCategory][codonIndex],
+				termLogAlpha[alphaCategory][codonIndex], termLogGammaAlpha[alphaCategory][codonIndex],
+				termLambdaPrime[lambdaPrimeCategory][codonIndex], termLogLambdaPrime[lambdaPrimeCategory][codonIndex],
+				rfpCounts, numRFPCounts, currNumCodonsInMRNA, phiValue, logPhi);
+			logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(propAlpha[alphaCategory],
+				propLogAlpha[alphaCategory], propLogGammaAlpha[alphaCategory], propLambdaPrime[lambdaPrimeCategory],
+				propLogLambdaPrime[lambdaPrimeCategory], rfpCounts, numRFPCounts, currNumCodonsInMRNA, phiValue, logPhi);
+		}
+		threadLogLikelihood[thread] = logLikelihood;
+		threadLogLikelihood_proposed[thread] = logLikelihood_proposed;
+	}
+
+	double logLikelihood = 0.0;
+	double logLikelihood_proposed = 0.0;
+	for (unsigned thread = 0u; thread < numThreads; thread++)
+	{
+		logLikelihood += threadLogLikelihood[thread];
+		logLikelihood_proposed += threadLogLikelihood_proposed[thread];
+	}
+	logAcceptanceRatioForAllMixtures = logLikelihood_proposed - logLikelihood;
+}
+
+
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: genome, vector to store one log acceptance ratio per codon in
+ * Same as calling calculateLogLikelihoodRatioPerGroupingPerCategory for every codon, but every gene is visited once:
+ * its codon grouped counts are walked front to back while they are in cache, instead of once per codon. Each thread
+ * keeps one row of partial sums per codon over a contiguous block of genes, the rows are added up in thread order.
+*/
+void PANSEModel::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios)
+{
+	refreshCodonTerms();
+	unsigned numAlphaCategories = parameter->getNumMutationCategories();
+	unsigned numLambdaPrimeCategories = parameter->getNumSelectionCategories();
+	// proposed terms, indexed by [category * numCodons + codon]
+	std::vector<double> propAlpha(numAlphaCategories * numCodons), propLogAlpha(numAlphaCategories * numCodons);
+	std::vector<double> propLogGammaAlpha(numAlphaCategories * numCodons);
+	std::vector<double> propLambdaPrime(numLambdaPrimeCategories * numCodons);
+	std::vector<double> propLogLambdaPrime(numLambdaPrimeCategories * numCodons);
+	std::vector<double> alpha, logAlpha, logGammaAlpha, lambdaPrime, logLambdaPrime;
+	for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+	{
+		calculateProposedCodonTerms(codonIndex, alpha, logAlpha, logGammaAlpha, lambdaPrime, logLambdaPrime);
+		for (unsigned k = 0u; k < numAlphaCategories; k++)
+		{
+			propAlpha[k * numCodons + codonIndex] = alpha[k];
+			propLogAlpha[k * numCodons + codonIndex] = logAlpha[k];
+			propLogGammaAlpha[k * numCodons + codonIndex] = logGammaAlpha[k];
+		}
+		for (unsigned k = 0u; k < numLambdaPrimeCategories; k++)
+		{
+			propLambdaPrime[k * numCodons + codonIndex] = lambdaPrime[k];
+			propLogLambdaPrime[k * numCodons + codonIndex] = logLambdaPrime[k];
+		}
+	}
+
+	int numGenes = genome.getGenomeSize();
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	// per thread [thread * numCodons + codon] sums of proposed minus current log likelihood
+	std::vector<double> threadLogRatio(numThreads * numCodons, 0.0);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		unsigned thread = omp_get_thread_num();
+#else
+		unsigned thread = 0u;
+#endif
+		double *logRatio = &threadLogRatio[thread * numCodons];
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int i = 0; i < numGenes; i++)
+		{
+			SequenceSummary &geneData = genome.getGene(i).geneData;
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
+			unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+			unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			double phiValue = parameter->getSynthesisRate(i, synthesisRateCategory, false);
+			double logPhi = parameter->getLogSynthesisRate(i, synthesisRateCategory);
+
+			const std::vector<unsigned> &codonStart = geneData.getRFP_countCodonStart();
+			const std::vector<unsigned> &rfpCounts = geneData.getRFP_countByCodon();
+			bool hasCounts = !codonStart.empty();
+			unsigned alphaOffset = alphaCategory * numCodons;
+			unsigned lambdaPrimeOffset = lambdaPrimeCategory * numCodons;
+
+			for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+			{
+				unsigned currNumCodonsInMRNA = geneData.getCodonCountForCodon(codonIndex);
+				if (currNumCodonsInMRNA == 0) continue;
+
+				const unsigned *counts = NULL;
+				unsigned numRFPCounts = 0u;
+				if (hasCounts && codonStart[codonIndex + 1] != codonStart[codonIndex])
+				{
+					counts = &rfpCounts[codonStart[codonIndex]];
+					numRFPCounts = codonStart[codonIndex + 1] - codonStart[codonIndex];
+				}
+
+				logRatio[codonIndex] += calculateLogLikelihoodPerCodonPerGene(propAlpha[alphaOffset + codonIndex],
+					propLogAlpha[alphaOffset + codonIndex], propLogGammaAlpha[alphaOffset + codonIndex],
+					propLambdaPrime[lambdaPrimeOffset + codonIndex], propLogLambdaPrime[lambdaPrimeOffset + codonIndex],
+					counts, numRFPCounts, currNumCodonsInMRNA, phiValue, logPhi)
+					- calculateLogLikelihoodPerCodonPerGene(termAlpha[alphaCategory][codonIndex],
+					termLogAlpha[alphaCategory][codonIndex], termLogGammaAlpha[alphaCategory][codonIndex],
+					termLambdaPrime[lambdaPrimeCategory][codonIndex], termLogLambdaPrime[lambdaPrimeCategory][codonIndex],
+					counts, numRFPCounts, currNumCodonsInMRNA, phiValue, logPhi);
+			}
+		}
+	}
+
+	logAcceptanceRatios.assign(numCodons, 0.0);
+	for (unsigned thread = 0u; thread < numThreads; thread++)
+	{
+		for (unsigned codonIndex = 0u; codonIndex < numCodons; codonIndex++)
+		{
+			logAcceptanceRatios[codonIndex] += threadLogRatio[thread * numCodons + codonIndex];
+		}
+	}
+}
+
+
+/* prepareLogLikelihoodRatiosPerGene (NOT EXPOSED)
+ * Arguments: mixture elements, number of threads
+ * Refreshes the codon terms of the current parameters before a synthesis rate sweep, so
+ * calculateLogLikelihoodRatioPerGene finds them cached.
+*/
+void PANSEModel::prepareLogLikelihoodRatiosPerGene(std::vector<unsigned> &/*mixtureElements*/, unsigned /*numThreads*/)
+{
+	refreshCodonTerms();
+}
+
+
+void PANSEModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned /*iteration*/, std::vector <double> & logProbabilityRatio)
+{
+
+	double lpr = 0.0; // this variable is only needed because OpenMP doesn't allow variables in reduction clause to be reference
+
+	unsigned selectionCategory = getNumSynthesisRateCategories();
+	std::vector<double> currentStdDevSynthesisRate(selectionCategory, 0.0);
+	std::vector<double> currentMphi(selectionCategory, 0.0);
+	std::vector<double> proposedStdDevSynthesisRate(selectionCategory, 0.0);
+	std::vector<double> proposedMphi(selectionCategory, 0.0);
+	for(unsigned i = 0u; i < selectionCategory; i++)
+	{
+		currentStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, false);
+		currentMphi[i] = -((currentStdDevSynthesisRate[i] * currentStdDevSynthesisRate[i]) / 2);
+		proposedStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, true);
+		proposedMphi[i] = -((proposedStdDevSynthesisRate[i] * proposedStdDevSynthesisRate[i]) / 2);
+		// take the jacobian into account for the non-linear transformation from logN to N distribution
+		lpr -= (std::log(currentStdDevSynthesisRate[i]) - std::log(proposedStdDevSynthesisRate[i]));
+		// take prior into account
+		//TODO(Cedric): make sure you can control that prior from R
+		lpr -= Parameter::densityNorm(currentStdDevSynthesisRate[i], 1.0, 0.1, true) - Parameter::densityNorm(proposedStdDevSynthesisRate[i], 1.0, 0.1, true);
+	}
+
+
+
+
+	logProbabilityRatio.resize(1);
+	int numGenes = genome.getGenomeSize();
+#ifndef __APPLE__
+#pragma omp parallel for reduction(+:lpr)
+#endif
+	for (int i = 0; i < numGenes; i++)
+	{
+		unsigned mixture = getMixtureAssignment(i);
+		mixture = getSynthesisRateCategory(mixture);
+		double phi = getSynthesisRate(i, mixture, false);
+		if (i == 0) {
+	//	std::cout <<"proposed: " << Parameter::densityLogNorm(phi, proposedMPhi[mixture], proposedStdDevSynthesisRate[mixture], false) <<"\n";
+		//std::cout <<"current: " << Parameter::densityLogNorm(phi, currentMPhi, currentStdDevSynthesisRate, false) <<"\n";
+		}
+		lpr += Parameter::densityLogNorm(phi, proposedMphi[mixture], proposedStdDevSynthesisRate[mixture], true) -
+				Parameter::densityLogNorm(phi, currentMphi[mixture], currentStdDevSynthesisRate[mixture], true);
+		//std::cout <<"LPR: " << lpr <<"\n";
+	}
+
+	logProbabilityRatio[0] = lpr;
+}
+
+
+
+
+
+//----------------------------------------------------------//
+//---------- Initialization and Restart Functions ----------//
+//----------------------------------------------------------//
+
+
+void PANSEModel::initTraces(unsigned samples, unsigned num_genes)
+{
+	parameter->initAllTraces(samples, num_genes);
+}
+
+
+void PANSEModel::writeRestartFile(std::string filename)
+{
+	return parameter->writeEntireRestartFile(filename);
+}
+
+
+
+
+
+
+//----------------------------------------//
+//---------- Category Functions ----------//
+//----------------------------------------//
+
+
+double PANSEModel::getCategoryProbability(unsigned i)
+{
+	return parameter->getCategoryProbability(i);
+}
+
+
+unsigned PANSEModel::getMutationCategory(unsigned mixture)
+{
+	return parameter->getMutationCategory(mixture);
+}
+
+
+unsigned PANSEModel::getSelectionCategory(unsigned mixture)
+{
+	return parameter->getSelectionCategory(mixture);
+}
+
+
+unsigned PANSEModel::getSynthesisRateCategory(unsigned mixture)
+{
+	return parameter->getSynthesisRateCategory(mixture);
+}
+
+
+std::vector<unsigned> PANSEModel::getMixtureElementsOfSelectionCategory(unsigned k)
+{
+	return parameter->getMixtureElementsOfSelectionCategory(k);
+}
+
+
+
+
+
+//------------------------------------------//
+//---------- Group List Functions ----------//
+//------------------------------------------//
+
+
+unsigned PANSEModel::getGroupListSize()
+{
+	return parameter->getGroupListSize();
+}
+
+
+std::string PANSEModel::getGrouping(unsigned index)
+{
+	return parameter->getGrouping(index);
+}
+
+
+
+
+
+//---------------------------------------------------//
+//---------- stdDevSynthesisRate Functions ----------//
+//---------------------------------------------------//
+
+
+double PANSEModel::getStdDevSynthesisRate(unsigned selectionCategory, bool proposed)
+{
+	return parameter->getStdDevSynthesisRate(selectionCategory, proposed);
+}
+
+
+double PANSEModel::getCurrentStdDevSynthesisRateProposalWidth()
+{
+	return parameter->getCurrentStdDevSynthesisRateProposalWidth();
+}
+
+
+void PANSEModel::updateStdDevSynthesisRate()
+{
+	parameter->updateStdDevSynthesisRate();
+}
+
+
+
+
+
+//----------------------------------------------//
+//---------- Synthesis Rate Functions ----------//
+//----------------------------------------------//
+
+
+double PANSEModel::getSynthesisRate(unsigned index, unsigned mixture, bool proposed)
+{
+	return parameter->getSynthesisRate(index, mixture, proposed);
+}
+
+
+void PANSEModel::updateSynthesisRate(unsigned i, unsigned k)
+{
+	parameter->updateSynthesisRate(i, k);
+}
+
+
+
+
+
+//-----------------------------------------//
+//---------- Iteration Functions ----------//
+//-----------------------------------------//
+
+
+unsigned PANSEModel::getLastIteration()
+{
+	return parameter->getLastIteration();
+}
+
+
+void PANSEModel::setLastIteration(unsigned iteration)
+{
+	parameter->setLastIteration(iteration);
+}
+
+
+
+
+
+//-------------------------------------//
+//---------- Trace Functions ----------//
+//-------------------------------------//
+
+
+void PANSEModel::updateStdDevSynthesisRateTrace(unsigned sample)
+{
+	parameter->updateStdDevSynthesisRateTrace(sample);
+}
+
+
+void PANSEModel::updateSynthesisRateTrace(unsigned sample, unsigned i)
+{
+	parameter->updateSynthesisRateTrace(sample, i);
+}
+
+
+void PANSEModel::updateMixtureAssignmentTrace(unsigned sample, unsigned i)
+{
+	parameter->updateMixtureAssignmentTrace(sample, i);
+}
+
+
+void PANSEModel::updateMixtureProbabilitiesTrace(unsigned sample)
+{
+	parameter->updateMixtureProbabilitiesTrace(sample);
+}
+
+
+void PANSEModel::updateCodonSpecificParameterTrace(unsigned sample, std::string codon)
+{
+	parameter->updateCodonSpecificParameterTrace(sample, codon);
+}
+
+
+void PANSEModel::updateHyperParameterTraces(unsigned sample)
+{
+	updateStdDevSynthesisRateTrace(sample);
+}
+
+
+void PANSEModel::updateTracesWithInitialValues(Genome & genome)
+{
+	std::vector <std::string> groupList = parameter->getGroupList();
+
+	for (unsigned i = 0; i < genome.getGenomeSize(); i++)
+	{
+		parameter->updateSynthesisRateTrace(0, i);
+		parameter->updateMixtureAssignmentTrace(0, i);
+	}
+
+	for (unsigned i = 0; i < groupList.size(); i++)
+	{
+		parameter->updateCodonSpecificParameterTrace(0, getGrouping(i));
+	}
+}
+
+
+
+
+
+//----------------------------------------------//
+//---------- Adaptive Width Functions ----------//
+//----------------------------------------------//
+
+
+void PANSEModel::adaptStdDevSynthesisRateProposalWidth(unsigned adaptiveWidth, bool adapt)
+{
+	parameter->adaptStdDevSynthesisRateProposalWidth(adaptiveWidth, adapt);
+}
+
+
+void PANSEModel::adaptSynthesisRateProposalWidth(unsigned adaptiveWidth, bool adapt)
+{
+	parameter->adaptSynthesisRateProposalWidth(adaptiveWidth, adapt);
+}
+
+
+void PANSEModel::adaptCodonSpecificParameterProposalWidth(unsigned adaptiveWidth, unsigned lastIteration, bool adapt)
+{
+	parameter->adaptCodonSpecificParameterProposalWidth(adaptiveWidth, lastIteration, adapt);
+}
+
+
+void PANSEModel::adaptHyperParameterProposalWidths(unsigned adaptiveWidth, bool adapt)
+{
+	adaptStdDevSynthesisRateProposalWidth(adaptiveWidth, adapt);
+}
+
+
+
+
+
+//-------------------------------------//
+//---------- Other Functions ----------//
+//-------------------------------------//
+
+
+void PANSEModel::proposeCodonSpecificParameter()
+{
+	parameter->proposeCodonSpecificParameter();
+}
+
+
+void PANSEModel::proposeHyperParameters()
+{
+	parameter->proposeStdDevSynthesisRate();
+}
+
+
+void PANSEModel::proposeSynthesisRateLevels()
+{
+	parameter->proposeSynthesisRateLevels();
+}
+
+
+unsigned PANSEModel::getNumPhiGroupings()
+{
+	return parameter->getNumObservedPhiSets();
+}
+
+
+unsigned PANSEModel::getMixtureAssignment(unsigned index)
+{
+	return parameter->getMixtureAssignment(index);
+}
+
+
+unsigned PANSEModel::getNumMixtureElements()
+{
+	return parameter->getNumMixtureElements();
+}
+
+
+unsigned PANSEModel::getNumSynthesisRateCategories()
+{
+	return parameter->getNumSynthesisRateCategories();
+}
+
+
+void PANSEModel::setNumPhiGroupings(unsigned value)
+{
+	parameter->setNumObservedPhiSets(value);
+}
+
+
+void PANSEModel::setMixtureAssignment(unsigned i, unsigned catOfGene)
+{
+	parameter->setMixtureAssignment(i, catOfGene);
+}
+
+
+void PANSEModel::setCategoryProbability(unsigned mixture, double value)
+{
+	parameter->setCategoryProbability(mixture, value);
+}
+
+
+void PANSEModel::updateCodonSpecificParameter(std::string aa)
+{
+	parameter->updateCodonSpecificParameter(aa);
+}
+
+
+void PANSEModel::updateGibbsSampledHyperParameters(Genome &/*genome*/)
+{
+	//TODO: fill in
+}
+
+
+void PANSEModel::updateAllHyperParameter()
+{
+	updateStdDevSynthesisRate();
+}
+
+
+void PANSEModel::updateHyperParameter(unsigned hp)
+{
+	// NOTE: when adding additional hyper parameter, also add to updateAllHyperParameter()
+	switch (hp) {
+		case 0:
+			updateStdDevSynthesisRate();
+			break;
+	}
+}
+
+
+/* simulateGenome (NOT EXPOSED)
+ * Arguments: genome
+ * Simulates an RFP count for every position of every gene: a gamma distributed pausing time with the alpha and lambda
+ * prime of the codon at the position, scaled by phi, drawn from a poisson distribution. The counts are stored
+ * sparse in the simulated genes.
+*/
+void PANSEModel::simulateGenome(Genome &genome)
+{
+	std::vector<unsigned> codonIndices, positions, counts;
+	for (unsigned geneIndex = 0; geneIndex < genome.getGenomeSize(); geneIndex++)
+	{
+		unsigned mixtureElement = getMixtureAssignment(geneIndex);
+		Gene gene = genome.getGene(geneIndex);
+		double phi = parameter -> getSynthesisRate(geneIndex, mixtureElement, false);
+		unsigned alphaCat = parameter -> getMutationCategory(mixtureElement);
+		unsigned lambdaPrimeCat = parameter -> getSelectionCategory(mixtureElement);
+		Gene tmpGene = gene;
+
+		gene.geneData.getCodonIndexSequence(codonIndices);
+		positions.clear();
+		counts.clear();
+		for (unsigned position = 0u; position < codonIndices.size(); position++)
+		{
+			unsigned codonIndex = codonIndices[position];
+			if (codonIndex >= getGroupListSize()) continue; // stop codons and unknown codons are never read
+
+			double alpha = parameter->getParameterForCategory(alphaCat, PANSEParameter::alp, codonIndex, false);
+			double lambdaPrime = parameter->getParameterForCategory(lambdaPrimeCat, PANSEParameter::lmPri, codonIndex, false);
+			unsigned simulatedValue;
+#ifndef STANDALONE
+			RNGScope scope;
+			NumericVector xx(1);
+			xx = rgamma(1, alpha, 1.0/lambdaPrime);
+			xx = rpois(1, xx[0] * phi);
+			simulatedValue = xx[0];
+#else
+			std::gamma_distribution<double> GDistribution(alpha, 1.0/lambdaPrime);
+			double tmp = GDistribution(Parameter::generator);
+			std::poisson_distribution<unsigned> PDistribution(phi * tmp);
+			simulatedValue = PDistribution(Parameter::generator);
+#endif
+			if (simulatedValue == 0u) continue;
+			positions.push_back(position);
+			counts.push_back(simulatedValue);
+		}
+		tmpGene.geneData.setSparseRFP_count(positions, counts, codonIndices.size());
+		genome.addGene(tmpGene, true);
+	}
+}
+
+
+void PANSEModel::printHyperParameters()
+{
+	for(unsigned i = 0u; i < getNumSynthesisRateCategories(); i++)
+	{
+		std::cout << "stdDevSynthesisRate posterior estimate for selection category " << i << ": " << parameter -> getStdDevSynthesisRate(i) << std::endl;
+	}
+	std::cout << "\t current stdDevSynthesisRate proposal width: " << getCurrentStdDevSynthesisRateProposalWidth() << std::endl;
+}
+
+
+void PANSEModel::setParameter(PANSEParameter &_parameter)
+{
+	parameter = &_parameter;
+}
+
+
+double PANSEModel::calculateAllPriors()
+{
+	return 0.0; //TODO(Cedric): implement me, see ROCModel
+}
+
+
+double PANSEModel::getParameterForCategory(unsigned category, unsigned param, std::string codon, bool proposal)
+{
+	return parameter->getParameterForCategory(category, param, codon, proposal);
+}
+
+
+
+
+
+
+
+
@@ -447,7 +447,7 @@ void PANSEParameter::updateCodonSpecificParameter(std::string grouping)
 // ---------- Adaptive Width Functions ----------//
 // ----------------------------------------------//
 
-void PANSEParameter::adaptCodonSpecificParameterProposalWidth(unsigned adaptationWidth, unsigned lastIteration, bool adapt)
+void PANSEParameter::adaptCodonSpecificParameterProposalWidth(unsigned adaptationWidth, unsigned /*lastIteration*/, bool adapt)
 {
 	std::cout << "acceptance rate for codon:\n";
 	for (unsigned i = 0; i < groupList.size(); i++)
@@ -487,45 +487,63 @@ double PANSEParameter::getParameterForCategory(unsigned category, unsigned param
 }
 
 
+/* getParameterForCategory (NOT EXPOSED)
+ * Arguments: category, parameter type, codon index, where or not proposed or current
+ * Same as above but skips the codon string lookup. Used by the likelihood loops in PANSEModel.
+*/
+double PANSEParameter::getParameterForCategory(unsigned category, unsigned paramType, unsigned codonIndex, bool proposal)
+{
+	return (proposal ? proposedCodonSpecificParameter[paramType][category][codonIndex] : currentCodonSpecificParameter[paramType][category][codonIndex]);
+}
+
+
+/* calculatePANSEMean (NOT EXPOSED)
+ * Arguments: genome
+ * Prints mean and variance over genes of the RFP counts summed over the positions of each codon. The sums come from
+ * the codon grouped sparse counts, positions without counts are never visited.
+*/
 void PANSEParameter::calculatePANSEMean(Genome& genome)
 {
-	std::vector<unsigned> PANSESums(61,0);
-	std::vector <unsigned> Means(61, 0);
-	for(unsigned geneIndex = 0; geneIndex < genome.getGenomeSize(); geneIndex++)
+	unsigned numGenes = genome.getGenomeSize();
+	std::vector <unsigned> codonSums(numGenes * 61, 0u);
+	std::vector <double> means(61, 0.0);
+	for (unsigned geneIndex = 0; geneIndex < numGenes; geneIndex++)
 	{
-		Gene *gene = &genome.getGene(geneIndex);
+		SequenceSummary &geneData = genome.getGene(geneIndex).geneData;
+		const std::vector <unsigned> &codonStart = geneData.getRFP_countCodonStart();
+		const std::vector <unsigned> &counts = geneData.getRFP_countByCodon();
+		if (codonStart.empty()) continue;
 		for (unsigned codonIndex = 0; codonIndex < 61; codonIndex++)
 		{
-			PANSESums[codonIndex] += gene -> geneData.getPANSEObserved(codonIndex);
+			unsigned sum = 0u;
+			for (unsigned j = codonStart[codonIndex]; j < codonStart[codonIndex + 1]; j++)
+				sum += counts[j];
+			codonSums[geneIndex * 61 + codonIndex] = sum;
+			means[codonIndex] += sum;
 		}
 	}
 
 	std::cout <<"Means calculated\n";
 	for (unsigned codonIndex = 0; codonIndex < 61; codonIndex++)
 	{
-		Means[codonIndex] = PANSESums[codonIndex] / genome.getGenomeSize();
+		means[codonIndex] /= numGenes;
 	}
 
-	std::vector <unsigned> variance(61, 0);
-	for (unsigned codonIndex = 0; codonIndex < 61; codonIndex++)
+	std::vector <double> variance(61, 0.0);
+	for (unsigned geneIndex = 0; geneIndex < numGenes; geneIndex++)
 	{
-		long long squareSum = 0;
-		for (unsigned geneIndex = 0; geneIndex < genome.getGenomeSize(); geneIndex++)
+		for (unsigned codonIndex = 0; codonIndex < 61; codonIndex++)
 		{
-			Gene *gene = &genome.getGene(geneIndex);
-			long long count = gene -> geneData.getPANSEObserved(codonIndex);
-			count -= Means[codonIndex];
-			count *= count;
-			squareSum += count;
+			double difference = codonSums[geneIndex * 61 + codonIndex] - means[codonIndex];
+			variance[codonIndex] += difference * difference;
 		}
-		variance[codonIndex] = squareSum / genome.getGenomeSize();
 	}
 
 	std::cout <<"Variance calculated\n";
 	for (unsigned codonIndex = 0; codonIndex < 61; codonIndex++)
 	{
-		std::cout << SequenceSummary::indexToCodon(codonIndex) <<" Mean:" << Means[codonIndex];
-		std::cout <<"\tVariance:" << variance[codonIndex] <<"\n";
+		std::cout << SequenceSummary::indexToCodon(codonIndex) <<" Mean:" << means[codonIndex];
+		std::cout <<"\tVariance:" << variance[codonIndex] / numGenes <<"\n";
 	}
 }
 
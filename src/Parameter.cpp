@@ -8,9 +8,31 @@ using namespace Rcpp;
 #endif
 
 
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
 //C++ runs only
 #ifdef STANDALONE
-std::default_random_engine Parameter::generator( (unsigned) std::time(NULL));
+#include <thread>
+#include <functional>
+
+/* seedThreadGenerator (NOT EXPOSED)
+ * Arguments: None
+ * Returns the generator of a new thread, seeded from the time, the thread id and std::random_device. Threads started
+ * in the same second would draw the same numbers if seeded from the time alone.
+*/
+static std::default_random_engine seedThreadGenerator()
+{
+	std::random_device device;
+	std::seed_seq seedSequence{(unsigned) std::time(NULL),
+		(unsigned) std::hash<std::thread::id>()(std::this_thread::get_id()), (unsigned) device()};
+	return std::default_random_engine(seedSequence);
+}
+
+thread_local std::default_random_engine Parameter::generator(seedThreadGenerator());
 #endif
 
 
@@ -48,7 +70,7 @@ Parameter::Parameter()
 	numSelectionCategories = 0u;
 	numMixtures = 0u;
 	std_stdDevSynthesisRate = 0.1;
-	maxGrouping = 22;
+	maxGrouping = SequenceSummary::numAminoAcids();
 }
 
 
@@ -97,6 +119,7 @@ Parameter& Parameter::operator=(const Parameter& rhs)
   	std_phi = rhs.std_phi;
 
   	currentSynthesisRateLevel = rhs.currentSynthesisRateLevel;
+  	currentLogSynthesisRateLevel = rhs.currentLogSynthesisRateLevel;
   	proposedSynthesisRateLevel = rhs.proposedSynthesisRateLevel;
   	numAcceptForSynthesisRate = rhs.numAcceptForSynthesisRate;
 
@@ -157,7 +180,7 @@ void Parameter::initParameterSet(std::vector<double> _stdDevSynthesisRate, unsig
 #endif
 
 	mutationSelectionState = _mutationSelectionState;
-	numParam = ((splitSer) ? 40 : 41);
+	numParam = SequenceSummary::numParameterCodons() + ((splitSer) ? 0u : 1u);
 	numMixtures = _numMixtures;
 	stdDevSynthesisRate.resize(_stdDevSynthesisRate.size());
 	stdDevSynthesisRate_proposed.resize(_stdDevSynthesisRate.size());
@@ -202,6 +225,7 @@ void Parameter::initParameterSet(std::vector<double> _stdDevSynthesisRate, unsig
 		std::vector<double> tempStdPhi(numGenes, 0.1);
 		std_phi[i] = tempStdPhi;
 	}
+	updateLogSynthesisRateLevels();
 }
 
 
@@ -263,6 +287,25 @@ void Parameter::initBaseValuesFromFile(std::string filename)
 						stdDevSynthesisRate.push_back(val);
 					}
 				}
+				else if (variableName == "codonTable")
+				{
+					// written for codon tables other than the standard code, which has to be selected before reading
+					unsigned tableId;
+					std::string splitAA;
+					iss.str(tmp);
+					iss >> tableId >> splitAA;
+					const GeneticCode& code = CodonEncoding::activeCode();
+					if (tableId != code.tableId || (splitAA == "TRUE") != code.splitAA)
+					{
+#ifndef STANDALONE
+						Rf_error("Restart file %s was written for codon table %u (splitAA = %s), select it with useCodonTable first\n",
+							filename.c_str(), tableId, splitAA.c_str());
+#else
+						std::cerr << "Restart file " << filename << " was written for codon table " << tableId
+							<< " (splitAA = " << splitAA << "), select it with useCodonTable first\n";
+#endif
+					}
+				}
 				else if (variableName == "numParam") {iss.str(tmp); iss >> numParam;}
 				else if (variableName == "numMutationCategories") {iss.str(tmp); iss >> numMutationCategories;}
 				else if (variableName == "numSelectionCategories") {iss.str(tmp); iss >> numSelectionCategories;}
@@ -385,6 +428,7 @@ void Parameter::initBaseValuesFromFile(std::string filename)
 			std::vector <unsigned> tmp2(currentSynthesisRateLevel[i].size(), 0u);
 			numAcceptForSynthesisRate[i] = tmp2;
 		}
+		updateLogSynthesisRateLevels();
 	}
 }
 
@@ -411,6 +455,11 @@ void Parameter::writeBasicRestartFile(std::string filename)
 	}
 	else
 	{
+		if (!CodonEncoding::isStandardCode())
+		{
+			const GeneticCode& code = CodonEncoding::activeCode();
+			oss << ">codonTable:\n" << code.tableId << " " << (code.splitAA ? "TRUE" : "FALSE") << "\n";
+		}
 		oss << ">groupList:\n";
 		for (i = 0; i < groupList.size(); i++) {
 			oss << groupList[i];
@@ -570,7 +619,7 @@ void Parameter::InitializeSynthesisRate(Genome& genome, double sd_phi)
 	for(unsigned i = 0u; i < genomeSize; i++)
 	{
 		index[i] = i;
-		scuoValues[i] = calculateSCUO( genome.getGene(i), 22 ); //This used to be maxGrouping, but RFP model will not work that way
+		scuoValues[i] = calculateSCUO( genome.getGene(i), SequenceSummary::numAminoAcids() ); //This used to be maxGrouping, but RFP model will not work that way
 		expression[i] = Parameter::randLogNorm(-(sd_phi * sd_phi) / 2, sd_phi);
 	}
 	quickSortPair(scuoValues, index, 0, genomeSize);
@@ -586,6 +635,7 @@ void Parameter::InitializeSynthesisRate(Genome& genome, double sd_phi)
 			numAcceptForSynthesisRate[category][j] = 0u;
 		}
 	}
+	updateLogSynthesisRateLevels();
 
 	delete [] scuoValues;
 	delete [] expression;
@@ -605,6 +655,7 @@ void Parameter::InitializeSynthesisRate(double sd_phi)
 			numAcceptForSynthesisRate[category][i] = 0u;
 		}
 	}
+	updateLogSynthesisRateLevels();
 }
 
 
@@ -620,6 +671,7 @@ void Parameter::InitializeSynthesisRate(std::vector<double> expression)
 			numAcceptForSynthesisRate[category][i] = 0u;
 		}
 	}
+	updateLogSynthesisRateLevels();
 }
 
 
@@ -799,7 +851,7 @@ void Parameter::setGroupList(std::vector <std::string> gl)
 	groupList.clear();
 	for (unsigned i = 0; i < gl.size(); i++)
 	{
-		if (gl[i] == "M" || gl[i] == "W" || gl[i] == "X")
+		if (SequenceSummary::GetNumCodonsForAA(gl[i], true) == 0u) // M, W, X and unknown amino acids have no parameters
 		{
 #ifndef STANDALONE
 			Rf_error("Warning: Amino Acid %s not recognized in ROC model\n", gl[i].c_str());
@@ -890,6 +942,18 @@ double Parameter::getSynthesisRate(unsigned geneIndex, unsigned mixtureElement,
 }
 
 
+/* getLogSynthesisRate (NOT EXPOSED)
+ * Arguments: gene index, mixture element
+ * Returns log(getSynthesisRate(geneIndex, mixtureElement, false)) without calling std::log. The logs are updated
+ * whenever a synthesis rate is set or a proposal is accepted.
+*/
+double Parameter::getLogSynthesisRate(unsigned geneIndex, unsigned mixtureElement)
+{
+	unsigned category = getSelectionCategory(mixtureElement);
+	return currentLogSynthesisRateLevel[category][geneIndex];
+}
+
+
 double Parameter::getCurrentSynthesisRateProposalWidth(unsigned expressionCategory, unsigned geneIndex)
 {
 	return std_phi[expressionCategory][geneIndex];
@@ -911,7 +975,7 @@ void Parameter::proposeSynthesisRateLevels()
 		for(unsigned i = 0u; i < numSynthesisRateLevels; i++)
 		{
 			// avoid adjusting probabilities for asymmetry of distribution
-			proposedSynthesisRateLevel[category][i] = std::exp( randNorm( std::log(currentSynthesisRateLevel[category][i]) , std_phi[category][i]) );
+			proposedSynthesisRateLevel[category][i] = std::exp( randNorm( currentLogSynthesisRateLevel[category][i] , std_phi[category][i]) );
 		}
 	}
 }
@@ -921,6 +985,7 @@ void Parameter::setSynthesisRate(double phi, unsigned geneIndex, unsigned mixtur
 {
 	unsigned category = getSelectionCategory(mixtureElement);
 	currentSynthesisRateLevel[category][geneIndex] = phi;
+	currentLogSynthesisRateLevel[category][geneIndex] = std::log(phi);
 }
 
 
@@ -930,6 +995,7 @@ void Parameter::updateSynthesisRate(unsigned geneIndex)
 	{
 		numAcceptForSynthesisRate[category][geneIndex]++;
 		currentSynthesisRateLevel[category][geneIndex] = proposedSynthesisRateLevel[category][geneIndex];
+		currentLogSynthesisRateLevel[category][geneIndex] = std::log(currentSynthesisRateLevel[category][geneIndex]);
 	}
 }
 
@@ -939,6 +1005,26 @@ void Parameter::updateSynthesisRate(unsigned geneIndex, unsigned mixtureElement)
 	unsigned category = getSelectionCategory(mixtureElement);
 	numAcceptForSynthesisRate[category][geneIndex]++;
 	currentSynthesisRateLevel[category][geneIndex] = proposedSynthesisRateLevel[category][geneIndex];
+	currentLogSynthesisRateLevel[category][geneIndex] = std::log(currentSynthesisRateLevel[category][geneIndex]);
+}
+
+
+/* updateLogSynthesisRateLevels (NOT EXPOSED)
+ * Arguments: None
+ * Recalculates the log synthesis rates after all synthesis rates were set at once.
+*/
+void Parameter::updateLogSynthesisRateLevels()
+{
+	currentLogSynthesisRateLevel.resize(currentSynthesisRateLevel.size());
+	for (unsigned category = 0u; category < currentSynthesisRateLevel.size(); category++)
+	{
+		std::vector<double> &phi = currentSynthesisRateLevel[category];
+		currentLogSynthesisRateLevel[category].resize(phi.size());
+		for (unsigned i = 0u; i < phi.size(); i++)
+		{
+			currentLogSynthesisRateLevel[category][i] = std::log(phi[i]);
+		}
+	}
 }
 
 
@@ -1010,41 +1096,161 @@ unsigned Parameter::getMixtureAssignment(unsigned gene)
 	return mixtureAssignment[gene];
 }
 
+/* proposeCovaryingCodonSpecificParameters (NOT EXPOSED)
+ * Arguments: index of the mutation and of the selection parameter type
+ * Proposes new mutation and selection parameters for all groupings. The standard normals of all groupings are drawn
+ * in one batch (in the order the groupings are proposed), each grouping's block is correlated with the packed
+ * Choleski factor of its covariance matrix and added to the current values in proposedCodonSpecificParameter.
+ * Used by ROC and FONSE.
+*/
+void Parameter::proposeCovaryingCodonSpecificParameters(unsigned mutationType, unsigned selectionType)
+{
+	unsigned numGroupings = getGroupListSize();
+	unsigned numCategories = numMutationCategories + numSelectionCategories;
+
+	proposalOffset.resize(numGroupings + 1);
+	proposalCodonStart.resize(numGroupings);
+	proposalAAIndex.resize(numGroupings);
+	unsigned maxDraws = 0u;
+	proposalOffset[0] = 0u;
+	for (unsigned k = 0u; k < numGroupings; k++)
+	{
+		unsigned aaEnd;
+		SequenceSummary::AAToCodonRange(groupList[k], proposalCodonStart[k], aaEnd, true);
+		proposalAAIndex[k] = SequenceSummary::AAToAAIndex(groupList[k]);
+		unsigned draws = (aaEnd - proposalCodonStart[k]) * numCategories;
+		proposalOffset[k + 1] = proposalOffset[k] + draws;
+		if (draws > maxDraws) maxDraws = draws;
+	}
+	proposalIidNumbers.resize(proposalOffset[numGroupings]);
+	proposalCovaryingNumbers.resize(maxDraws);
+	drawIidNormalVector(proposalOffset[numGroupings], &proposalIidNumbers[0]);
+
+	for (unsigned k = 0u; k < numGroupings; k++)
+	{
+		unsigned aaStart = proposalCodonStart[k];
+		unsigned numCodons = (proposalOffset[k + 1] - proposalOffset[k]) / numCategories;
+		double *covaryingNums = &proposalCovaryingNumbers[0];
+		covarianceMatrix[proposalAAIndex[k]].transformIidNumersIntoCovaryingNumbers(&proposalIidNumbers[proposalOffset[k]], covaryingNums);
+
+		for (unsigned i = 0u; i < numMutationCategories; i++)
+		{
+			double *current = &currentCodonSpecificParameter[mutationType][i][aaStart];
+			double *proposed = &proposedCodonSpecificParameter[mutationType][i][aaStart];
+			for (unsigned j = 0u; j < numCodons; j++)
+			{
+				proposed[j] = current[j] + covaryingNums[i * numCodons + j];
+			}
+		}
+		covaryingNums += numMutationCategories * numCodons;
+		for (unsigned i = 0u; i < numSelectionCategories; i++)
+		{
+			double *current = &currentCodonSpecificParameter[selectionType][i][aaStart];
+			double *proposed = &proposedCodonSpecificParameter[selectionType][i][aaStart];
+			for (unsigned j = 0u; j < numCodons; j++)
+			{
+				proposed[j] = current[j] + covaryingNums[i * numCodons + j];
+			}
+		}
+	}
+}
+
+
+/* calculateSelectionCoefficients (NOT EXPOSED)
+ * Arguments: number of samples used for the posterior means, mixture element
+ * Returns the selection coefficients of every gene as one vector per gene, see the overload below.
+*/
 std::vector <std::vector <double> > Parameter::calculateSelectionCoefficients(unsigned sample, unsigned mixture)
 {
 	unsigned numGenes = mixtureAssignment.size();
-	std::vector<std::vector<double>> selectionCoefficients;
-	selectionCoefficients.resize(numGenes);
-	for (unsigned i = 0; i < numGenes; i++)
+	unsigned numCodons = 0u;
+	for (unsigned j = 0u; j < getGroupListSize(); j++)
 	{
-		for (unsigned j = 0; j < getGroupListSize(); j++)
-		{
+		std::string aa = getGrouping(j);
+		numCodons += SequenceSummary::GetNumCodonsForAA(aa);
+	}
 
-			std::string aa = getGrouping(j);
-			unsigned aaStart;
-			unsigned aaEnd;
-			SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, true);
-				std::vector<double> tmp;
-			double minValue = 0.0;
-			for (unsigned k = aaStart; k < aaEnd; k++)
-			{
-				std::string codon = SequenceSummary::codonArrayParameter[k];
-				tmp.push_back(getCodonSpecificPosteriorMean(sample, mixture, codon, 1));
-				if (tmp[k] < minValue)
-				{
-					minValue = tmp[k];
-				}
-			}
-			tmp.push_back(0.0);
-			double phi = getSynthesisRatePosteriorMean(sample, i, mixture);
-			for (unsigned k = 0; k < tmp.size(); k++)
+	std::vector<double> coefficients(numGenes * numCodons);
+	calculateSelectionCoefficients(sample, mixture, coefficients.data(), numCodons, 1u);
+	std::vector<std::vector<double>> selectionCoefficients(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		selectionCoefficients[i].assign(coefficients.begin() + i * numCodons, coefficients.begin() + (i + 1) * numCodons);
+	}
+	return selectionCoefficients;
+}
+
+
+/* calculateSelectionCoefficients (NOT EXPOSED)
+ * Arguments: number of samples used for the posterior means, mixture element, array to store the coefficients in,
+ * distance in the array between the coefficients of consecutive genes and of consecutive codons
+ * Calculates phi * (selection - minimal selection of the grouping) for every codon of every grouping and every gene,
+ * using posterior means. Codons are ordered by grouping, with the reference codon (selection 0) last in each grouping.
+ * The codon specific posterior means do not depend on the gene and are calculated once. A row major array uses
+ * (number of codons, 1) as strides, a column major matrix like R's uses (1, number of genes).
+*/
+void Parameter::calculateSelectionCoefficients(unsigned samples, unsigned mixture, double *selectionCoefficients,
+		unsigned geneStride, unsigned codonStride)
+{
+	unsigned numGenes = mixtureAssignment.size();
+	unsigned traceLength = lastIteration + 1;
+	if (samples > traceLength)
+	{
+#ifndef STANDALONE
+		Rf_warning("Warning in Parameter::calculateSelectionCoefficients throws: Number of anticipated samples (%d) is greater than the length of the available trace (%d). Whole trace is used for posterior estimate! \n",
+			samples, traceLength);
+#else
+		std::cerr << "Warning in Parameter::calculateSelectionCoefficients throws: Number of anticipated samples ("
+			<< samples << ") is greater than the length of the available trace (" << traceLength << ")."
+			<< "Whole trace is used for posterior estimate! \n";
+#endif
+		samples = traceLength;
+	}
+	unsigned start = traceLength - samples;
+
+	std::vector<std::vector<double>> &selectionTrace =
+		(*traces.getCodonSpecificParameterTrace())[dEta][getSelectionCategory(mixture)];
+	std::vector<double> relativeSelection;
+	for (unsigned j = 0u; j < getGroupListSize(); j++)
+	{
+		std::string aa = getGrouping(j);
+		unsigned aaStart;
+		unsigned aaEnd;
+		SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, true);
+		unsigned first = relativeSelection.size();
+		double minValue = 0.0; // selection of the reference codon
+		for (unsigned k = aaStart; k < aaEnd; k++)
+		{
+			double posteriorMean = 0.0;
+			for (unsigned i = start; i < traceLength; i++)
 			{
-				tmp[k] -= minValue;
-				selectionCoefficients[i].push_back(phi * tmp[k]);
+				posteriorMean += selectionTrace[k][i];
 			}
+			posteriorMean /= (double)samples;
+			relativeSelection.push_back(posteriorMean);
+			if (posteriorMean < minValue) minValue = posteriorMean;
+		}
+		relativeSelection.push_back(0.0);
+		for (unsigned k = first; k < relativeSelection.size(); k++)
+		{
+			relativeSelection[k] -= minValue;
+		}
+	}
+
+	std::vector<double> synthesisRates(numGenes);
+	getSynthesisRatePosteriorMeans(samples, mixture, synthesisRates.data());
+	unsigned numCodons = relativeSelection.size();
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static)
+#endif
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		double *geneCoefficients = selectionCoefficients + (size_t)i * geneStride;
+		for (unsigned k = 0u; k < numCodons; k++)
+		{
+			geneCoefficients[(size_t)k * codonStride] = synthesisRates[i] * relativeSelection[k];
 		}
 	}
-	return selectionCoefficients;
 }
 
 // --------------------------------------//
@@ -1090,6 +1296,43 @@ void Parameter::updateMixtureProbabilitiesTrace(unsigned samples)
 }
 
 
+/* setToTraceSample (NOT EXPOSED)
+ * Arguments: index of a sample in the traces
+ * Sets the current and proposed codon specific parameters, stdDevSynthesisRate and mixture probabilities to their
+ * values in the given sample, e.g. to evaluate genes under every posterior sample after a run. Synthesis rates are
+ * left as they are.
+*/
+void Parameter::setToTraceSample(unsigned sample)
+{
+	std::vector<std::vector<std::vector<std::vector<double>>>> *codonSpecificParameterTrace =
+		traces.getCodonSpecificParameterTrace();
+	for (unsigned paramType = 0u; paramType < codonSpecificParameterTrace->size()
+		&& paramType < currentCodonSpecificParameter.size(); paramType++)
+	{
+		std::vector<std::vector<std::vector<double>>> &trace = (*codonSpecificParameterTrace)[paramType];
+		for (unsigned category = 0u; category < trace.size()
+			&& category < currentCodonSpecificParameter[paramType].size(); category++)
+		{
+			std::vector<double> &current = currentCodonSpecificParameter[paramType][category];
+			for (unsigned i = 0u; i < trace[category].size() && i < current.size(); i++)
+			{
+				current[i] = trace[category][i][sample];
+			}
+			proposedCodonSpecificParameter[paramType][category] = current;
+		}
+	}
+	for (unsigned k = 0u; k < stdDevSynthesisRate.size(); k++)
+	{
+		stdDevSynthesisRate[k] = traces.getStdDevSynthesisRateTrace(k)[sample];
+		stdDevSynthesisRate_proposed[k] = stdDevSynthesisRate[k];
+	}
+	for (unsigned mixture = 0u; mixture < numMixtures; mixture++)
+	{
+		categoryProbabilities[mixture] = traces.getMixtureProbabilitiesTraceForMixture(mixture)[sample];
+	}
+}
+
+
 // ----------------------------------------------//
 // ---------- Adaptive Width Functions ----------//
 // ----------------------------------------------//
@@ -1283,6 +1526,60 @@ double Parameter::getSynthesisRatePosteriorMean(unsigned samples, unsigned geneI
 	return posteriorMean / (double)usedSamples;
 }
 
+/* getSynthesisRatePosteriorMeans (NOT EXPOSED)
+ * Arguments: number of samples, mixture element, array to store one posterior mean per gene in
+ * getSynthesisRatePosteriorMean for all genes at once, reading the traces without copying them. Genes that were never
+ * in the synthesis rate category of the mixture element during the samples get NaN.
+*/
+void Parameter::getSynthesisRatePosteriorMeans(unsigned samples, unsigned mixtureElement, double *posteriorMeans)
+{
+	unsigned expressionCategory = getSynthesisRateCategory(mixtureElement);
+	std::vector<std::vector<double>> &synthesisRateTrace = *traces.getSynthesisRateTraceForCategory(expressionCategory);
+	std::vector<std::vector<unsigned>> &mixtureAssignmentTrace = *traces.getMixtureAssignmentTraceForGenes();
+	unsigned numGenes = mixtureAssignment.size();
+	unsigned traceLength = lastIteration + 1;
+	if (samples > traceLength)
+	{
+#ifndef STANDALONE
+		Rf_warning("Warning in Parameter::getSynthesisRatePosteriorMeans throws: Number of anticipated samples (%d) is greater than the length of the available trace (%d). Whole trace is used for posterior estimate! \n",
+			samples, traceLength);
+#else
+		std::cerr << "Warning in Parameter::getSynthesisRatePosteriorMeans throws: Number of anticipated samples ("
+			<< samples << ") is greater than the length of the available trace (" << traceLength << ")."
+			<< "Whole trace is used for posterior estimate! \n";
+#endif
+		samples = traceLength;
+	}
+	unsigned start = traceLength - samples;
+
+	std::vector<unsigned> categoryOfMixture(numMixtures);
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		categoryOfMixture[k] = getSynthesisRateCategory(k);
+	}
+
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static)
+#endif
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		std::vector<double> &geneTrace = synthesisRateTrace[i];
+		std::vector<unsigned> &assignmentTrace = mixtureAssignmentTrace[i];
+		double posteriorMean = 0.0;
+		unsigned usedSamples = 0u;
+		for (unsigned j = start; j < traceLength; j++)
+		{
+			if (categoryOfMixture[assignmentTrace[j]] == expressionCategory)
+			{
+				posteriorMean += geneTrace[j];
+				usedSamples++;
+			}
+		}
+		posteriorMeans[i] = posteriorMean / (double)usedSamples;
+	}
+}
+
+
 double Parameter::getCodonSpecificPosteriorMean(unsigned mixtureElement, unsigned samples, std::string &codon, unsigned paramType,
 	bool withoutReference)
 {
@@ -1401,7 +1698,7 @@ double Parameter::getCodonSpecificVariance(unsigned mixtureElement, unsigned sam
 		samples = traceLength;
 	}
 
-	double posteriorMean = getCodonSpecificPosteriorMean(mixtureElement, samples, codon, paramType);
+	double posteriorMean = getCodonSpecificPosteriorMean(mixtureElement, samples, codon, paramType, withoutReference);
 
 	double posteriorVariance = 0.0;
 
@@ -1611,7 +1908,7 @@ double Parameter::calculateSCUO(Gene& gene, unsigned maxAA)
 	{
 		std::string curAA = SequenceSummary::AminoAcidArray[i];
 		// skip amino acids with only one codon or stop codons
-		if(curAA == "X" || curAA == "M" || curAA == "W") continue;
+		if(curAA == "X" || SequenceSummary::GetNumCodonsForAA(curAA) < 2u) continue;
 		totalDegenerateAACount += (double)seqsum->getAACountForAA(i);
 	}
 
@@ -1620,7 +1917,7 @@ double Parameter::calculateSCUO(Gene& gene, unsigned maxAA)
 	{
 		std::string curAA = SequenceSummary::AminoAcidArray[i];
 		// skip amino acids with only one codon or stop codons
-		if(curAA == "X" || curAA == "M" || curAA == "W") continue;
+		if(curAA == "X" || SequenceSummary::GetNumCodonsForAA(curAA) < 2u) continue;
 		double numDegenerateCodons = SequenceSummary::GetNumCodonsForAA(curAA);
 
 		double aaCount = (double)seqsum->getAACountForAA(i);
@@ -1672,14 +1969,51 @@ void Parameter::drawIidRandomVector(unsigned draws, double r, double (*proposal)
 }
 
 
+// Draws standard normals in one go. The C++ version keeps one distribution for all draws, so both numbers of each
+// generated pair are used.
+void Parameter::drawIidNormalVector(unsigned draws, double* randomNumbers)
+{
+#ifndef STANDALONE
+	RNGScope scope;
+	for(unsigned i = 0u; i < draws; i++)
+	{
+		randomNumbers[i] = R::norm_rand();
+	}
+#else
+	std::normal_distribution<double> distribution(0.0, 1.0);
+	for(unsigned i = 0u; i < draws; i++)
+	{
+		randomNumbers[i] = distribution(generator);
+	}
+#endif
+}
+
+
+// Draws U(0,1) numbers in one go, with one distribution for all draws.
+void Parameter::drawUniformVector(unsigned draws, double* randomNumbers)
+{
+#ifndef STANDALONE
+	RNGScope scope;
+	for(unsigned i = 0u; i < draws; i++)
+	{
+		randomNumbers[i] = R::unif_rand();
+	}
+#else
+	std::uniform_real_distribution<double> distribution(0.0, 1.0);
+	for(unsigned i = 0u; i < draws; i++)
+	{
+		randomNumbers[i] = distribution(generator);
+	}
+#endif
+}
+
+
 double Parameter::randNorm(double mean, double sd)
 {
 	double rv;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
-	xx = rnorm(1, mean, sd);
-	rv = xx[0];
+	rv = R::rnorm(mean, sd);
 #else
 	std::normal_distribution<double> distribution(mean, sd);
 	rv = distribution(generator);
@@ -1693,9 +2027,7 @@ double Parameter::randLogNorm(double m, double s)
 	double rv;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
-	xx = rlnorm(1, m, s);
-	rv = xx[0];
+	rv = R::rlnorm(m, s);
 #else
 	std::lognormal_distribution<double> distribution(m, s);
 	rv = distribution(generator);
@@ -1709,9 +2041,7 @@ double Parameter::randExp(double r)
 	double rv;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
-	xx = rexp(1, r);
-	rv = xx[0];
+	rv = R::rexp(1.0 / r); // R::rexp takes the scale
 #else
 	std::exponential_distribution<double> distribution(r);
 	rv = distribution(generator);
@@ -1728,9 +2058,7 @@ double Parameter::randGamma(double shape, double rate)
 	double rv;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
-	xx = rgamma(1, shape, 1.0 / rate);
-	rv = xx[0];
+	rv = R::rgamma(shape, 1.0 / rate);
 #else
 	std::gamma_distribution<double> distribution(shape, 1.0 / rate);
 	rv = distribution(generator);
@@ -1747,12 +2075,10 @@ void Parameter::randDirichlet(double *input, unsigned numElements, double *outpu
 	double sumTotal = 0.0;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
 	for(unsigned i = 0; i < numElements; i++)
 	{
-		xx = rgamma(1, input[i], 1);
-		output[i] = xx[0];
-		sumTotal += xx[0];
+		output[i] = R::rgamma(input[i], 1);
+		sumTotal += output[i];
 	}
 #else
 	for(unsigned i = 0; i < numElements; i++)
@@ -1774,9 +2100,7 @@ double Parameter::randUnif(double minVal, double maxVal)
 	double rv;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
-	xx = runif(1, minVal, maxVal);
-	rv = xx[0];
+	rv = R::runif(minVal, maxVal);
 #else
 	std::uniform_real_distribution<double> distribution(minVal, maxVal);
 	rv = distribution(generator);
@@ -1787,37 +2111,27 @@ double Parameter::randUnif(double minVal, double maxVal)
 
 unsigned Parameter::randMultinom(double* probabilities, unsigned mixtureElements)
 {
-	// calculate cummulative sum to determine group boundaries
-	double* cumsum = new double[mixtureElements]();
-	//std::vector<double> cumsum(groups);
-	cumsum[0] = probabilities[0];
-
-	for(unsigned i = 1u; i < mixtureElements; i++)
-	{
-		cumsum[i] = cumsum[i-1u] + probabilities[i];
-	}
 	// draw random number from U(0,1)
 	double referenceValue;
 #ifndef STANDALONE
 	RNGScope scope;
-	NumericVector xx(1);
-	xx = runif(1, 0, 1);
-	referenceValue = xx[0];
+	referenceValue = R::runif(0, 1);
 #else
 	std::uniform_real_distribution<double> distribution(0, 1);
 	referenceValue = distribution(generator);
 #endif
-	// check in which category the element falls
+	// check in which category the element falls, the cummulative sum gives the group boundaries
 	unsigned returnValue = 0u;
+	double cumsum = 0.0;
 	for (unsigned i = 0u; i < mixtureElements; i++)
 	{
-		if (referenceValue <= cumsum[i])
+		cumsum += probabilities[i];
+		if (referenceValue <= cumsum)
 		{
 			returnValue = i;
 			break;
 		}
 	}
-	delete [] cumsum;
 	return returnValue;
 }
 
@@ -2114,20 +2428,13 @@ std::vector<double> Parameter::getEstimatedMixtureAssignmentProbabilitiesForGene
 
 SEXP Parameter::calculateSelectionCoefficientsR(unsigned sample, unsigned mixture)
 {
-	NumericMatrix RSelectionCoefficents(mixtureAssignment.size(), 62); //62 due to stop codons
-	std::vector<std::vector<double>> selectionCoefficients;
+	unsigned numGenes = mixtureAssignment.size();
+	NumericMatrix RSelectionCoefficents(numGenes, 62); //62 due to stop codons
 	bool checkMixture = checkIndex(mixture, 1, numMixtures);
 	if (checkMixture)
 	{
-		selectionCoefficients = calculateSelectionCoefficients(sample, mixture - 1);
-		unsigned index = 0;
-		for (unsigned i = 0; i < selectionCoefficients.size(); i++)
-		{
-			for (unsigned j = 0; j < selectionCoefficients[i].size(); j++, index++)
-			{
-				RSelectionCoefficents[index] = selectionCoefficients[i][j];
-			}
-		}
+		// column major, gene i and codon k go to row i and column k
+		calculateSelectionCoefficients(sample, mixture - 1, RSelectionCoefficents.begin(), 1u, numGenes);
 	}
 	return RSelectionCoefficents;
 }
@@ -12,6 +12,7 @@ RCPP_EXPOSED_CLASS(Genome)
 RCPP_MODULE(Model_mod)
 {
 	class_<Model>("Model")
+		.method("simulateGenomeToFile", &Model::simulateGenomeToFile)
 		;
 
 	class_<ROCModel>( "ROCModel" )
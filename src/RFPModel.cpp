@@ -6,6 +6,11 @@
 using namespace Rcpp;
 #endif
 
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
 //--------------------------------------------------//
 //----------- Constructors & Destructors ---------- //
 //--------------------------------------------------//
@@ -13,6 +18,7 @@ using namespace Rcpp;
 RFPModel::RFPModel() : Model()
 {
 	parameter = 0;
+	numCodons = 0u;
 	//ctor
 }
 
@@ -26,14 +32,167 @@ RFPModel::~RFPModel()
 
 
 
-double RFPModel::calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime,
-													   unsigned currRFPObserved, unsigned currNumCodonsInMRNA, double phiValue)
+/* calculateLogLikelihoodPerCodonPerGene (NOT EXPOSED)
+ * Arguments: alpha times the codon count, log gamma ratio (see calculateLogGammaRatio), lambda prime and its log,
+ * observed RFP count, phi and its log
+ * Calculates the gamma-poisson log likelihood of the RFP count of one codon in one gene. The logs that stay fixed
+ * across genes or proposals are taken from the caller, only log(lambdaPrime + phi) is computed here.
+*/
+double RFPModel::calculateLogLikelihoodPerCodonPerGene(double alphaTimesNumCodons, double logGammaRatio, double lambdaPrime,
+		double logLambdaPrime, unsigned rfpObserved, double phiValue, double logPhiValue)
 {
-	double logLikelihood = ((std::lgamma((currNumCodonsInMRNA * currAlpha) + currRFPObserved)) - (std::lgamma(currNumCodonsInMRNA * currAlpha)))
-						   + (currRFPObserved * (std::log(phiValue) - std::log(currLambdaPrime + phiValue)))
-						   + ((currNumCodonsInMRNA * currAlpha) * (std::log(currLambdaPrime) - std::log(currLambdaPrime + phiValue)));
+	double logLambdaPrimePlusPhi = std::log(lambdaPrime + phiValue);
 
-	return logLikelihood;
+	return logGammaRatio + (rfpObserved * (logPhiValue - logLambdaPrimePlusPhi))
+		   + (alphaTimesNumCodons * (logLambdaPrime - logLambdaPrimePlusPhi));
+}
+
+
+/* calculateLogGammaRatio (NOT EXPOSED)
+ * Arguments: alpha times the codon count, observed RFP count
+ * Returns lgamma(alpha * n + rfp) - lgamma(alpha * n). The ratio is exactly zero when no footprints were observed,
+ * which is the common case, so both lgamma calls are skipped there.
+*/
+double RFPModel::calculateLogGammaRatio(double alphaTimesNumCodons, unsigned rfpObserved)
+{
+	if (rfpObserved == 0u) return 0.0;
+	return std::lgamma(alphaTimesNumCodons + rfpObserved) - std::lgamma(alphaTimesNumCodons);
+}
+
+
+/* resizeLikelihoodCache (NOT EXPOSED)
+ * Arguments: number of genes
+ * (Re)allocates the per gene, per codon likelihood cache. All cells are invalidated by setting their phi key to NaN,
+ * which never compares equal to a phi value.
+*/
+void RFPModel::resizeLikelihoodCache(unsigned numGenes)
+{
+	numCodons = getGroupListSize();
+	unsigned numCells = numGenes * numCodons;
+	double invalid = std::numeric_limits<double>::quiet_NaN();
+
+	currentCodonLogLikelihood.assign(numCells, 0.0);
+	proposedCodonLogLikelihood.assign(numCells, 0.0);
+	cellSynthesisRate.assign(numCells, invalid);
+	cellMixtureElement.assign(numCells, 0u);
+	logSynthesisRate.assign(numGenes, 0.0);
+	cachedSynthesisRate.assign(numGenes, invalid);
+
+	unsigned numCategories = std::max(parameter->getNumMutationCategories(), parameter->getNumSelectionCategories());
+	cellAlpha.assign(numCategories, std::vector<double>(numCodons, invalid));
+	cellLambdaPrime.assign(numCategories, std::vector<double>(numCodons, invalid));
+	cellLogLambdaPrime.assign(numCategories, std::vector<double>(numCodons, 0.0));
+	proposedAlpha.assign(numCategories, std::vector<double>(numCodons, 0.0));
+	proposedLambdaPrime.assign(numCategories, std::vector<double>(numCodons, 0.0));
+	proposedLogLambdaPrime.assign(numCategories, std::vector<double>(numCodons, 0.0));
+}
+
+
+/* isCodonColumnCurrent (NOT EXPOSED)
+ * Arguments: codon index
+ * Checks if the current alpha and lambda prime values of a codon still match what the cached column was computed
+ * with. If not, the column is rekeyed and false is returned so the caller recomputes every cell of the column.
+ * This catches parameter changes made outside of updateCodonSpecificParameter (initialization, restart files).
+*/
+bool RFPModel::isCodonColumnCurrent(unsigned codonIndex)
+{
+	bool current = true;
+	for (unsigned k = 0u; k < parameter->getNumMutationCategories(); k++)
+	{
+		double alpha = parameter->getParameterForCategory(k, RFPParameter::alp, codonIndex, false);
+		if (cellAlpha[k][codonIndex] != alpha)
+		{
+			cellAlpha[k][codonIndex] = alpha;
+			current = false;
+		}
+	}
+	for (unsigned k = 0u; k < parameter->getNumSelectionCategories(); k++)
+	{
+		double lambdaPrime = parameter->getParameterForCategory(k, RFPParameter::lmPri, codonIndex, false);
+		if (cellLambdaPrime[k][codonIndex] != lambdaPrime)
+		{
+			cellLambdaPrime[k][codonIndex] = lambdaPrime;
+			cellLogLambdaPrime[k][codonIndex] = std::log(lambdaPrime);
+			current = false;
+		}
+	}
+	return current;
+}
+
+
+/* prepareProposedCodonColumn (NOT EXPOSED)
+ * Arguments: codon index
+ * Copies the proposed alpha and lambda prime values of a codon for every category and takes the log of lambda prime
+ * once, so updateCodonLogLikelihoodCell does not have to do it per gene.
+*/
+void RFPModel::prepareProposedCodonColumn(unsigned codonIndex)
+{
+	for (unsigned k = 0u; k < parameter->getNumMutationCategories(); k++)
+	{
+		proposedAlpha[k][codonIndex] = parameter->getParameterForCategory(k, RFPParameter::alp, codonIndex, true);
+	}
+	for (unsigned k = 0u; k < parameter->getNumSelectionCategories(); k++)
+	{
+		proposedLambdaPrime[k][codonIndex] = parameter->getParameterForCategory(k, RFPParameter::lmPri, codonIndex, true);
+		proposedLogLambdaPrime[k][codonIndex] = std::log(proposedLambdaPrime[k][codonIndex]);
+	}
+}
+
+
+/* updateCodonLogLikelihoodCell (NOT EXPOSED)
+ * Arguments: gene, gene index, codon index, whether the cached column of the codon is still current
+ * Fills the proposed likelihood cell of the gene and codon and refreshes the current one if phi, the mixture
+ * assignment or the current parameters of the codon changed since it was last filled. Returns false if the codon
+ * does not occur in the gene, in which case the cells are left alone and contribute nothing.
+ * Requires isCodonColumnCurrent and prepareProposedCodonColumn to have been called for the codon.
+*/
+bool RFPModel::updateCodonLogLikelihoodCell(Gene& gene, unsigned geneIndex, unsigned codonIndex, bool columnCurrent)
+{
+	unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(codonIndex);
+	if (currNumCodonsInMRNA == 0) return false;
+
+	// which mixture element does this gene belong to
+	unsigned mixtureElement = parameter->getMixtureAssignment(geneIndex);
+	// how is the mixture element defined. Which categories make it up
+	unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
+	unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+	unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(mixtureElement);
+	// get non codon specific values, calculate likelihood conditional on these
+	double phiValue = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, false);
+	double logPhi = getLogSynthesisRate(geneIndex, phiValue);
+	unsigned currRFPObserved = gene.geneData.getRFPObserved(codonIndex);
+	unsigned cell = geneIndex * numCodons + codonIndex;
+
+	if (!columnCurrent || cellSynthesisRate[cell] != phiValue || cellMixtureElement[cell] != mixtureElement)
+	{
+		double alphaTimesNumCodons = currNumCodonsInMRNA * cellAlpha[alphaCategory][codonIndex];
+		currentCodonLogLikelihood[cell] = calculateLogLikelihoodPerCodonPerGene(alphaTimesNumCodons,
+				calculateLogGammaRatio(alphaTimesNumCodons, currRFPObserved), cellLambdaPrime[lambdaPrimeCategory][codonIndex],
+				cellLogLambdaPrime[lambdaPrimeCategory][codonIndex], currRFPObserved, phiValue, logPhi);
+		cellSynthesisRate[cell] = phiValue;
+		cellMixtureElement[cell] = mixtureElement;
+	}
+
+	double propAlphaTimesNumCodons = currNumCodonsInMRNA * proposedAlpha[alphaCategory][codonIndex];
+	proposedCodonLogLikelihood[cell] = calculateLogLikelihoodPerCodonPerGene(propAlphaTimesNumCodons,
+			calculateLogGammaRatio(propAlphaTimesNumCodons, currRFPObserved), proposedLambdaPrime[lambdaPrimeCategory][codonIndex],
+			proposedLogLambdaPrime[lambdaPrimeCategory][codonIndex], currRFPObserved, phiValue, logPhi);
+	return true;
+}
+
+
+/* getLogSynthesisRate (NOT EXPOSED)
+ * Arguments: gene index, current phi value of the gene
+ * Returns log(phi), only recomputing it when phi changed since the last call for this gene.
+*/
+double RFPModel::getLogSynthesisRate(unsigned geneIndex, double phiValue)
+{
+	if (cachedSynthesisRate[geneIndex] != phiValue)
+	{
+		cachedSynthesisRate[geneIndex] = phiValue;
+		logSynthesisRate[geneIndex] = std::log(phiValue);
+	}
+	return logSynthesisRate[geneIndex];
 }
 
 
@@ -59,22 +218,28 @@ void RFPModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex
 	double phiValue = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, false);
 	double phiValue_proposed = parameter->getSynthesisRate(geneIndex, synthesisRateCategory, true);
 
-#ifndef __APPLE__
-#pragma omp parallel for reduction(+:logLikelihood,logLikelihood_proposed)
-#endif
-	for (int index = 0; index < getGroupListSize(); index++) //number of codons, without the stop codons
+	double logPhi = std::log(phiValue);
+	double logPhi_proposed = std::log(phiValue_proposed);
+
+	// no parallel region here, this is called from within the parallel gene loop of the MCMC
+	for (unsigned index = 0u; index < getGroupListSize(); index++) //number of codons, without the stop codons
 	{
-		std::string codon = getGrouping(index);
+		unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(index);
+		if (currNumCodonsInMRNA == 0) continue;
 
-		double currAlpha = getParameterForCategory(alphaCategory, RFPParameter::alp, codon, false);
-		double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, RFPParameter::lmPri, codon, false);
+		double currAlpha = parameter->getParameterForCategory(alphaCategory, RFPParameter::alp, (unsigned)index, false);
+		double currLambdaPrime = parameter->getParameterForCategory(lambdaPrimeCategory, RFPParameter::lmPri, (unsigned)index, false);
 		unsigned currRFPObserved = gene.geneData.getRFPObserved(index);
 
-		unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(index);
-		if (currNumCodonsInMRNA == 0) continue;
+		// everything but log(lambdaPrime + phi) is shared between the current and proposed phi
+		double alphaTimesNumCodons = currNumCodonsInMRNA * currAlpha;
+		double logGammaRatio = calculateLogGammaRatio(alphaTimesNumCodons, currRFPObserved);
+		double logLambdaPrime = std::log(currLambdaPrime);
 
-		logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPObserved, currNumCodonsInMRNA, phiValue);
-		logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPObserved, currNumCodonsInMRNA, phiValue_proposed);
+		logLikelihood += calculateLogLikelihoodPerCodonPerGene(alphaTimesNumCodons, logGammaRatio, currLambdaPrime,
+				logLambdaPrime, currRFPObserved, phiValue, logPhi);
+		logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(alphaTimesNumCodons, logGammaRatio, currLambdaPrime,
+				logLambdaPrime, currRFPObserved, phiValue_proposed, logPhi_proposed);
 	}
 
 	double stdDevSynthesisRate = parameter->getStdDevSynthesisRate(false);
@@ -91,44 +256,131 @@ void RFPModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex
 }
 
 
+/* calculateLogLikelihoodPerGene (NOT EXPOSED)
+ * Arguments: reference to a gene, mixture element, synthesis rates, vector to store the log likelihoods in
+ * Log likelihood of the RFP counts of the gene for each synthesis rate, see Model::calculateLogLikelihoodPerGene. The
+ * terms not depending on the synthesis rate are calculated once per codon.
+*/
+void RFPModel::calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+		std::vector<double> &logLikelihoods)
+{
+	unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
+	unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
+
+	logLikelihoods.assign(phiValues.size(), 0.0);
+	for (unsigned index = 0u; index < getGroupListSize(); index++)
+	{
+		unsigned currNumCodonsInMRNA = gene.geneData.getCodonCountForCodon(index);
+		if (currNumCodonsInMRNA == 0) continue;
+
+		double currAlpha = parameter->getParameterForCategory(alphaCategory, RFPParameter::alp, (unsigned)index, false);
+		double currLambdaPrime = parameter->getParameterForCategory(lambdaPrimeCategory, RFPParameter::lmPri, (unsigned)index, false);
+		unsigned currRFPObserved = gene.geneData.getRFPObserved(index);
+		double alphaTimesNumCodons = currNumCodonsInMRNA * currAlpha;
+		double logGammaRatio = calculateLogGammaRatio(alphaTimesNumCodons, currRFPObserved);
+		double logLambdaPrime = std::log(currLambdaPrime);
+		for (unsigned j = 0u; j < phiValues.size(); j++)
+		{
+			logLikelihoods[j] += calculateLogLikelihoodPerCodonPerGene(alphaTimesNumCodons, logGammaRatio, currLambdaPrime,
+					logLambdaPrime, currRFPObserved, phiValues[j], std::log(phiValues[j]));
+		}
+	}
+}
+
+
 void RFPModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, double& logAcceptanceRatioForAllMixtures)
 {
 	double logLikelihood = 0.0;
 	double logLikelihood_proposed = 0.0;
-	Gene *gene;
 	unsigned index = SequenceSummary::codonToIndex(grouping);
+	unsigned numGenes = genome.getGenomeSize();
 
+	if (currentCodonLogLikelihood.size() != numGenes * getGroupListSize()) resizeLikelihoodCache(numGenes);
+	bool columnCurrent = isCodonColumnCurrent(index);
+	prepareProposedCodonColumn(index);
 
 #ifndef __APPLE__
-#pragma omp parallel for private(gene) reduction(+:logLikelihood,logLikelihood_proposed)
+#pragma omp parallel for reduction(+:logLikelihood,logLikelihood_proposed)
 #endif
-	for (int i = 0u; i < genome.getGenomeSize(); i++)
+	for (int i = 0u; i < numGenes; i++)
 	{
-		gene = &genome.getGene(i);
-		// which mixture element does this gene belong to
-		unsigned mixtureElement = parameter->getMixtureAssignment(i);
-		// how is the mixture element defined. Which categories make it up
-		unsigned alphaCategory = parameter->getMutationCategory(mixtureElement);
-		unsigned lambdaPrimeCategory = parameter->getSelectionCategory(mixtureElement);
-		unsigned synthesisRateCategory = parameter->getSynthesisRateCategory(mixtureElement);
-		// get non codon specific values, calculate likelihood conditional on these
-		double phiValue = parameter->getSynthesisRate(i, synthesisRateCategory, false);
-		unsigned currRFPObserved = gene->geneData.getRFPObserved(index);
-		unsigned currNumCodonsInMRNA = gene->geneData.getCodonCountForCodon(index);
-		if (currNumCodonsInMRNA == 0) continue;
+		if (!updateCodonLogLikelihoodCell(genome.getGene(i), i, index, columnCurrent)) continue;
+
+		unsigned cell = i * numCodons + index;
+		logLikelihood += currentCodonLogLikelihood[cell];
+		logLikelihood_proposed += proposedCodonLogLikelihood[cell];
+	}
+	logAcceptanceRatioForAllMixtures = logLikelihood_proposed - logLikelihood;
+}
+
+
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, vector to store one log acceptance ratio per codon in
+ * Same as calling calculateLogLikelihoodRatioPerGroupingPerCategory for every codon, but done in a single parallel
+ * pass over the genes. Each thread sums its genes into its own row of partial sums, which are added up in thread
+ * order afterwards so results do not depend on thread timing.
+*/
+void RFPModel::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios)
+{
+	int numGenes = genome.getGenomeSize();
+	unsigned numGroupings = getGroupListSize();
 
+	if (currentCodonLogLikelihood.size() != numGenes * numGroupings) resizeLikelihoodCache(numGenes);
+	codonColumnCurrent.resize(numGroupings);
+	for (unsigned index = 0u; index < numGroupings; index++)
+	{
+		codonColumnCurrent[index] = isCodonColumnCurrent(index);
+		prepareProposedCodonColumn(index);
+	}
 
-		double currAlpha = getParameterForCategory(alphaCategory, RFPParameter::alp, grouping, false);
-		double currLambdaPrime = getParameterForCategory(lambdaPrimeCategory, RFPParameter::lmPri, grouping, false);
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	// per thread: current likelihood of every codon followed by the proposed ones
+	partialLikelihood.assign(numThreads * numGroupings * 2, 0.0);
 
-		double propAlpha = getParameterForCategory(alphaCategory, RFPParameter::alp, grouping, true);
-		double propLambdaPrime = getParameterForCategory(lambdaPrimeCategory, RFPParameter::lmPri, grouping, true);
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		double *logLikelihood = &partialLikelihood[omp_get_thread_num() * numGroupings * 2];
+#else
+		double *logLikelihood = &partialLikelihood[0];
+#endif
+		double *logLikelihood_proposed = logLikelihood + numGroupings;
 
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int i = 0; i < numGenes; i++)
+		{
+			Gene &gene = genome.getGene(i);
+			for (unsigned index = 0u; index < numGroupings; index++)
+			{
+				if (!updateCodonLogLikelihoodCell(gene, i, index, codonColumnCurrent[index])) continue;
+
+				unsigned cell = i * numCodons + index;
+				logLikelihood[index] += currentCodonLogLikelihood[cell];
+				logLikelihood_proposed[index] += proposedCodonLogLikelihood[cell];
+			}
+		}
+	}
 
-		logLikelihood += calculateLogLikelihoodPerCodonPerGene(currAlpha, currLambdaPrime, currRFPObserved, currNumCodonsInMRNA, phiValue);
-		logLikelihood_proposed += calculateLogLikelihoodPerCodonPerGene(propAlpha, propLambdaPrime, currRFPObserved, currNumCodonsInMRNA, phiValue);
+	logAcceptanceRatios.resize(numGroupings);
+	for (unsigned index = 0u; index < numGroupings; index++)
+	{
+		double logLikelihood = 0.0;
+		double logLikelihood_proposed = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			logLikelihood += partialLikelihood[(t * 2) * numGroupings + index];
+			logLikelihood_proposed += partialLikelihood[(t * 2 + 1) * numGroupings + index];
+		}
+		logAcceptanceRatios[index] = logLikelihood_proposed - logLikelihood;
 	}
-	logAcceptanceRatioForAllMixtures = logLikelihood_proposed - logLikelihood;
 }
 
 
@@ -138,10 +390,10 @@ void RFPModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, uns
 	double lpr = 0.0; // this variable is only needed because OpenMP doesn't allow variables in reduction clause to be reference
 
 	unsigned selectionCategory = getNumSynthesisRateCategories();
-	std::vector<double> currentStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> currentMphi(selectionCategory, 0.0);
-	std::vector<double> proposedStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> proposedMphi(selectionCategory, 0.0);
+	currentStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	currentMphi.assign(selectionCategory, 0.0);
+	proposedStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	proposedMphi.assign(selectionCategory, 0.0);
 	for(unsigned i = 0u; i < selectionCategory; i++)
 	{
 		currentStdDevSynthesisRate[i] = getStdDevSynthesisRate(i, false);
@@ -191,6 +443,7 @@ void RFPModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, uns
 void RFPModel::initTraces(unsigned samples, unsigned num_genes)
 {
 	parameter->initAllTraces(samples, num_genes);
+	currentCodonLogLikelihood.clear(); // a new run may use a different genome
 }
 
 
@@ -489,6 +742,16 @@ void RFPModel::setCategoryProbability(unsigned mixture, double value)
 void RFPModel::updateCodonSpecificParameter(std::string aa)
 {
 	parameter->updateCodonSpecificParameter(aa);
+
+	// The proposed terms computed for this codon become the current ones. Cells of genes without this codon are
+	// never read, so copying them along is harmless.
+	unsigned index = SequenceSummary::codonToIndex(aa);
+	if (index < numCodons && !cellAlpha.empty())
+	{
+		for (unsigned i = index; i < currentCodonLogLikelihood.size(); i += numCodons)
+			currentCodonLogLikelihood[i] = proposedCodonLogLikelihood[i];
+		isCodonColumnCurrent(index);
+	}
 }
 
 
@@ -523,7 +786,7 @@ void RFPModel::simulateGenome(Genome &genome)
 		Gene gene = genome.getGene(geneIndex);
 		double phi = parameter -> getSynthesisRate(geneIndex, mixtureElement, false);
 		Gene tmpGene = gene;
-		for (unsigned codonIndex = 0; codonIndex < 61; codonIndex++)
+		for (unsigned codonIndex = 0; codonIndex < SequenceSummary::numSenseCodons(); codonIndex++)
 		{
 			std::string codon = SequenceSummary::codonArray[codonIndex];
 			unsigned alphaCat = parameter -> getMutationCategory(mixtureElement);
@@ -553,6 +816,18 @@ void RFPModel::simulateGenome(Genome &genome)
 }
 
 
+/* simulateGenomeToFile (RCPP EXPOSED)
+ * Arguments: reference to a genome, name of the output file
+ * Simulates RFP counts for every gene and writes them as an RFP file. The simulated genes are also added to the
+ * genome.
+*/
+void RFPModel::simulateGenomeToFile(Genome &genome, std::string filename)
+{
+	simulateGenome(genome);
+	genome.writeRFPFile(filename, true);
+}
+
+
 void RFPModel::printHyperParameters()
 {
 	for(unsigned i = 0u; i < getNumSynthesisRateCategories(); i++)
@@ -566,6 +841,7 @@ void RFPModel::printHyperParameters()
 void RFPModel::setParameter(RFPParameter &_parameter)
 {
 	parameter = &_parameter;
+	currentCodonLogLikelihood.clear();
 }
 
 
@@ -31,7 +31,7 @@ RFPParameter::RFPParameter(std::string filename) : Parameter(64)
 	currentCodonSpecificParameter.resize(2);
 	proposedCodonSpecificParameter.resize(2);
 	initFromRestartFile(filename);
-	numParam = 61;
+	numParam = SequenceSummary::numSenseCodons();
 }
 
 
@@ -105,7 +105,7 @@ void RFPParameter::initRFPParameterSet()
 	currentCodonSpecificParameter[lmPri].resize(lambdaPrimeCategories);
 	proposedCodonSpecificParameter[lmPri].resize(lambdaPrimeCategories);
 	lambdaValues.resize(lambdaPrimeCategories);
-	numParam = 61;
+	numParam = SequenceSummary::numSenseCodons();
 
 	for (unsigned i = 0; i < alphaCategories; i++)
 	{
@@ -124,13 +124,8 @@ void RFPParameter::initRFPParameterSet()
 	bias_csp = 0;
 	std_csp.resize(numParam, 0.1);
 
-	groupList = {"GCA", "GCC", "GCG", "GCT", "TGC", "TGT", "GAC", "GAT", "GAA", "GAG",
-		"TTC", "TTT", "GGA", "GGC", "GGG", "GGT", "CAC", "CAT", "ATA", "ATC",
-		"ATT", "AAA", "AAG", "CTA", "CTC", "CTG", "CTT", "TTA", "TTG", "ATG",
-		"AAC", "AAT", "CCA", "CCC", "CCG", "CCT", "CAA", "CAG", "AGA", "AGG",
-		"CGA", "CGC", "CGG", "CGT", "TCA", "TCC", "TCG", "TCT", "ACA", "ACC",
-		"ACG", "ACT", "GTA", "GTC", "GTG", "GTT", "TGG", "TAC", "TAT", "AGC",
-		"AGT"};
+	// the sense codons of the active genetic code
+	groupList.assign(SequenceSummary::codonArray.begin(), SequenceSummary::codonArray.begin() + numParam);
 }
 
 
@@ -483,11 +478,16 @@ void RFPParameter::proposeCodonSpecificParameter()
 	unsigned numAlpha = (unsigned)currentCodonSpecificParameter[alp][0].size();
 	unsigned numLambdaPrime = (unsigned)currentCodonSpecificParameter[lmPri][0].size();
 
+	// all standard normals are drawn in one batch, in the order the parameters are proposed
+	proposalIidNumbers.resize(numMutationCategories * numAlpha + numSelectionCategories * numLambdaPrime);
+	drawIidNormalVector(proposalIidNumbers.size(), &proposalIidNumbers[0]);
+	double *iidNumbers = &proposalIidNumbers[0];
+
 	for (unsigned i = 0; i < numMutationCategories; i++)
 	{
 		for (unsigned j = 0; j < numAlpha; j++)
 		{
-			proposedCodonSpecificParameter[alp][i][j] = std::exp( randNorm( std::log(currentCodonSpecificParameter[alp][i][j]) , std_csp[j]) );
+			proposedCodonSpecificParameter[alp][i][j] = std::exp( std::log(currentCodonSpecificParameter[alp][i][j]) + std_csp[j] * *iidNumbers++ );
 		}
 	}
 
@@ -495,7 +495,7 @@ void RFPParameter::proposeCodonSpecificParameter()
 	{
 		for (unsigned j = 0; j < numLambdaPrime; j++)
 		{
-			proposedCodonSpecificParameter[lmPri][i][j] = std::exp( randNorm( std::log(currentCodonSpecificParameter[lmPri][i][j]) , std_csp[j]) );
+			proposedCodonSpecificParameter[lmPri][i][j] = std::exp( std::log(currentCodonSpecificParameter[lmPri][i][j]) + std_csp[j] * *iidNumbers++ );
 		}
 	}
 }
@@ -578,6 +578,16 @@ double RFPParameter::getParameterForCategory(unsigned category, unsigned paramTy
 }
 
 
+/* getParameterForCategory (NOT EXPOSED)
+ * Arguments: category, parameter type, codon index, where or not proposed or current
+ * Same as above but skips the codon string lookup. Used by the likelihood loops in RFPModel.
+*/
+double RFPParameter::getParameterForCategory(unsigned category, unsigned paramType, unsigned codonIndex, bool proposal)
+{
+	return (proposal ? proposedCodonSpecificParameter[paramType][category][codonIndex] : currentCodonSpecificParameter[paramType][category][codonIndex]);
+}
+
+
 
 
 
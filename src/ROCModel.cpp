@@ -1,6 +1,12 @@
 #include "include/ROC/ROCModel.h"
 
 
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
 //--------------------------------------------------//
 //----------- Constructors & Destructors ---------- //
 //--------------------------------------------------//
@@ -10,6 +16,8 @@ ROCModel::ROCModel(bool _withPhi) : Model()
 {
 	parameter = 0;
 	withPhi = _withPhi;
+	sweepScratchStride = 0u;
+	observedSynthesisRatesCached = false;
 }
 
 
@@ -70,6 +78,29 @@ void ROCModel::obtainCodonCount(SequenceSummary *seqsum, std::string curAA, int
 }
 
 
+/* initGroupings (NOT EXPOSED)
+ * Arguments: None
+ * Fills groupingNames, groupingAAIndex, groupingAAStart and groupingNumCodons, so functions looping over all genes
+ * do not have to look up the codon range of every amino acid per gene.
+*/
+void ROCModel::initGroupings()
+{
+	unsigned numGroupings = getGroupListSize();
+	groupingNames.resize(numGroupings);
+	groupingAAIndex.resize(numGroupings);
+	groupingAAStart.resize(numGroupings);
+	groupingNumCodons.resize(numGroupings);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		unsigned aaEnd;
+		groupingNames[g] = getGrouping(g);
+		groupingAAIndex[g] = SequenceSummary::AAToAAIndex(groupingNames[g]);
+		groupingNumCodons[g] = SequenceSummary::GetNumCodonsForAA(groupingNames[g]);
+		SequenceSummary::AAToCodonRange(groupingNames[g], groupingAAStart[g], aaEnd, false);
+	}
+}
+
+
 
 
 
@@ -96,15 +127,13 @@ void ROCModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex
 	double mutation[5];
 	double selection[5];
 	int codonCount[6];
-#ifndef __APPLE__
-#pragma omp parallel for private(mutation, selection, codonCount) reduction(+:logLikelihood,logLikelihood_proposed)
-#endif
-	for(int i = 0; i < getGroupListSize(); i++)
+	// no parallel region here, this is called from within the parallel gene loop of the MCMC
+	for(unsigned i = 0u; i < getGroupListSize(); i++)
 	{
 		std::string curAA = getGrouping(i);
 
 		// skip amino acids which do not occur in current gene. Avoid useless calculations and multiplying by 0
-		if(seqsum->getAACountForAA(i) == 0) continue;
+		if(seqsum->getAACountForAA(SequenceSummary::AAToAAIndex(curAA)) == 0) continue;
 
 		// get number of codons for AA (total number not parameter->count)
 		unsigned numCodons = seqsum->GetNumCodonsForAA(curAA);
@@ -147,6 +176,40 @@ void ROCModel::calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex
 }
 
 
+/* calculateLogLikelihoodPerGene (NOT EXPOSED)
+ * Arguments: reference to a gene, mixture element, synthesis rates, vector to store the log likelihoods in
+ * Calculates the log likelihood of the codon counts of the gene under the current codon specific parameters of the mixture
+ * element for each of the given synthesis rates, without the prior of the synthesis rate. The gene does not need to
+ * be part of the genome the model is fit to.
+*/
+void ROCModel::calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+		std::vector<double> &logLikelihoods)
+{
+	SequenceSummary *seqsum = gene.getSequenceSummary();
+	unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+	unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+
+	double mutation[5];
+	double selection[5];
+	int codonCount[6];
+	logLikelihoods.assign(phiValues.size(), 0.0);
+	for (unsigned i = 0u; i < getGroupListSize(); i++)
+	{
+		std::string curAA = getGrouping(i);
+		if (seqsum->getAACountForAA(SequenceSummary::AAToAAIndex(curAA)) == 0) continue;
+
+		unsigned numCodons = seqsum->GetNumCodonsForAA(curAA);
+		parameter->getParameterForCategory(mutationCategory, ROCParameter::dM, curAA, false, mutation);
+		parameter->getParameterForCategory(selectionCategory, ROCParameter::dEta, curAA, false, selection);
+		obtainCodonCount(seqsum, curAA, codonCount);
+		for (unsigned j = 0u; j < phiValues.size(); j++)
+		{
+			logLikelihoods[j] += calculateLogLikelihoodPerAAPerGene(numCodons, codonCount, mutation, selection, phiValues[j]);
+		}
+	}
+}
+
+
 void ROCModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, double& logAcceptanceRatioForAllMixtures)
 {
 	int numGenes = genome.getGenomeSize();
@@ -200,14 +263,67 @@ void ROCModel::calculateLogLikelihoodRatioPerGroupingPerCategory(std::string gro
 }
 
 
+/* cacheObservedSynthesisRates (NOT EXPOSED)
+ * Arguments: reference to a genome
+ * Gathers the log observed synthesis rates of all genes into a dense [observed phi set][gene] matrix with a mask of the
+ * genes that have a value in that set. The observed values do not change during a run, so this is only done once per
+ * run (initTraces clears the cache).
+*/
+void ROCModel::cacheObservedSynthesisRates(Genome& genome)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numSets = parameter->getNumObservedPhiSets();
+	if (observedSynthesisRatesCached && observedLogSynthesisRate.size() == numSets * numGenes)
+		return;
+
+	observedSynthesisRatesCached = true;
+	observedLogSynthesisRate.assign(numSets * numGenes, 0.0);
+	observedSynthesisRateMask.assign(numSets * numGenes, 0.0);
+	for (unsigned j = 0u; j < numGenes; j++)
+	{
+		Gene &gene = genome.getGene(j);
+		for (unsigned i = 0u; i < numSets; i++)
+		{
+			double obsPhi = gene.getObservedSynthesisRate(i);
+			if (obsPhi > -1.0)
+			{
+				observedLogSynthesisRate[i * numGenes + j] = std::log(obsPhi);
+				observedSynthesisRateMask[i * numGenes + j] = 1.0;
+			}
+		}
+	}
+}
+
+
+/* gatherLogSynthesisRates (NOT EXPOSED)
+ * Arguments: number of genes
+ * Copies the current log(phi) of every gene in its mixture into hyperLogSynthesisRate, so the hyper parameter sums
+ * run over contiguous memory.
+*/
+void ROCModel::gatherLogSynthesisRates(unsigned numGenes)
+{
+	hyperLogSynthesisRate.resize(numGenes);
+	for (unsigned j = 0u; j < numGenes; j++)
+	{
+		hyperLogSynthesisRate[j] = parameter->getLogSynthesisRate(j, getMixtureAssignment(j));
+	}
+}
+
+
+/* calculateLogLikelihoodRatioForHyperParameters (NOT EXPOSED)
+ * Arguments: reference to a genome, iteration, vector to store the log acceptance ratios in
+ * Log acceptance ratio of stdDevSynthesisRate followed by one per noise offset. The sums over the genes work on the
+ * cached log synthesis rates and log observed synthesis rates. Each thread sums its genes into its own row, the rows
+ * are added up in thread order.
+*/
 void ROCModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> &logProbabilityRatio)
 {
 	double lpr = 0.0;
 	unsigned selectionCategory = getNumSynthesisRateCategories();
-	std::vector<double> currentStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> currentMphi(selectionCategory, 0.0);
-	std::vector<double> proposedStdDevSynthesisRate(selectionCategory, 0.0);
-	std::vector<double> proposedMphi(selectionCategory, 0.0);
+	currentStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	currentMphi.assign(selectionCategory, 0.0);
+	proposedStdDevSynthesisRate.assign(selectionCategory, 0.0);
+	proposedMphi.assign(selectionCategory, 0.0);
 
 
 	for(unsigned i = 0u; i < selectionCategory; i++)
@@ -220,67 +336,1195 @@ void ROCModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, uns
 		lpr -= (std::log(currentStdDevSynthesisRate[i]) - std::log(proposedStdDevSynthesisRate[i]));
 	}
 
+	unsigned numSets = withPhi ? parameter->getNumObservedPhiSets() : 0u;
 	if (withPhi) {
 		// one for each noiseOffset, and one for stdDevSynthesisRate
 		logProbabilityRatio.resize(getNumPhiGroupings()+1);
+		cacheObservedSynthesisRates(genome);
 	}
 	else {
 		logProbabilityRatio.resize(1);
 	}
-#ifndef __APPLE__
-//#pragma omp parallel for reduction(+:lpr)
-#endif
-	for (int i = 0; i < genome.getGenomeSize(); i++)
+
+	int numGenes = genome.getGenomeSize();
+	gatherLogSynthesisRates(numGenes);
+	const double *logPhi = hyperLogSynthesisRate.data();
+	for (int j = 0; j < numGenes; j++)
 	{
-		unsigned mixture = getMixtureAssignment(i);
-		mixture = getSynthesisRateCategory(mixture);
-		double phi = getSynthesisRate(i, mixture, false);
-		if (!std::isfinite(phi))
+		if (!std::isfinite(logPhi[j]))
 		{
+			double phi = std::exp(logPhi[j]);
 #ifndef STANDALONE
-			Rf_error("Phi value for gene %d is not finite (%f)!", i, phi);
+			Rf_error("Phi value for gene %d is not finite (%f)!", j, phi);
+#else
+			std::cerr << "phi " << j << " not finite! " << phi << "\n";
+#endif
+		}
+	}
+
+	// log density of log normal phi without the -log(phi) term, which cancels in the ratio
+	hyperStdDevOffset.assign(selectionCategory, 0.0);
+	for (unsigned k = 0u; k < selectionCategory; k++)
+	{
+		hyperStdDevOffset[k] = std::log(proposedStdDevSynthesisRate[k]) - std::log(currentStdDevSynthesisRate[k]);
+	}
+	hyperNoiseOffset.assign(numSets, 0.0);
+	hyperNoiseOffsetProposed.assign(numSets, 0.0);
+	hyperNoiseScale.assign(numSets, 0.0);
+	for (unsigned i = 0u; i < numSets; i++)
+	{
+		hyperNoiseOffset[i] = getNoiseOffset(i, false);
+		hyperNoiseOffsetProposed[i] = getNoiseOffset(i, true);
+		hyperNoiseScale[i] = 0.5 / (getObservedSynthesisNoise(i) * getObservedSynthesisNoise(i));
+	}
+	const double *offset = hyperStdDevOffset.data();
+	const double *noiseOffset = hyperNoiseOffset.data();
+	const double *noiseOffset_proposed = hyperNoiseOffsetProposed.data();
+	const double *noiseScale = hyperNoiseScale.data();
+
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
 #else
-			std::cerr << "phi " << i << " not finite! " << phi << "\n";
+	unsigned numThreads = 1u;
 #endif
+	unsigned stride = numSets + 1u;
+	partialHyperParameter.assign(numThreads * stride, 0.0);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		double *sum = &partialHyperParameter[omp_get_thread_num() * stride];
+#else
+		double *sum = &partialHyperParameter[0];
+#endif
+		if (selectionCategory == 1u)
+		{
+			// a single category: a plain reduction the compiler can vectorize
+			double currentMean = currentMphi[0], proposedMean = proposedMphi[0];
+			double currentScale = 0.5 / (currentStdDevSynthesisRate[0] * currentStdDevSynthesisRate[0]);
+			double proposedScale = 0.5 / (proposedStdDevSynthesisRate[0] * proposedStdDevSynthesisRate[0]);
+			double value = 0.0;
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+			for (int j = 0; j < numGenes; j++)
+			{
+				double current = logPhi[j] - currentMean;
+				double proposed = logPhi[j] - proposedMean;
+				value += currentScale * current * current - proposedScale * proposed * proposed;
+			}
+			sum[0] += value;
+		}
+		else
+		{
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+			for (int j = 0; j < numGenes; j++)
+			{
+				unsigned k = getSynthesisRateCategory(getMixtureAssignment(j));
+				double current = (logPhi[j] - currentMphi[k]) / currentStdDevSynthesisRate[k];
+				double proposed = (logPhi[j] - proposedMphi[k]) / proposedStdDevSynthesisRate[k];
+				sum[0] += 0.5 * (current * current - proposed * proposed) - offset[k];
+			}
+		}
+
+		for (unsigned i = 0u; i < numSets; i++)
+		{
+			const double *logObsPhi = &observedLogSynthesisRate[i * numGenes];
+			const double *observed = &observedSynthesisRateMask[i * numGenes];
+			double current = noiseOffset[i], proposed = noiseOffset_proposed[i];
+			double value = 0.0;
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+			for (int j = 0; j < numGenes; j++)
+			{
+				double residual = logObsPhi[j] - logPhi[j];
+				double currentResidual = residual - current;
+				double proposedResidual = residual - proposed;
+				value += observed[j] * (currentResidual * currentResidual - proposedResidual * proposedResidual);
+			}
+			sum[i + 1u] += value * noiseScale[i];
 		}
-		lpr += Parameter::densityLogNorm(phi, proposedMphi[mixture], proposedStdDevSynthesisRate[mixture], true)
-			   - Parameter::densityLogNorm(phi, currentMphi[mixture], currentStdDevSynthesisRate[mixture], true);
 	}
 
-	// TODO: USE CONSTANTS INSTEAD OF 0
+	if (selectionCategory == 1u) lpr -= numGenes * offset[0];
+	for (unsigned t = 0u; t < numThreads; t++)
+	{
+		lpr += partialHyperParameter[t * stride];
+	}
 	logProbabilityRatio[0] = lpr;
+	for (unsigned i = 0u; i < numSets; i++)
+	{
+		lpr = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			lpr += partialHyperParameter[t * stride + i + 1u];
+		}
+		logProbabilityRatio[i + 1] = lpr;
+	}
+}
 
-	if (withPhi)
+
+/* calculateLogLikelihoodRatioForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, vector to store one log acceptance ratio per amino acid in
+ * Same as calling calculateLogLikelihoodRatioPerGroupingPerCategory for every amino acid, but done in a single
+ * parallel pass over the genes.
+*/
+void ROCModel::calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios)
+{
+	calculateLogLikelihoodRatioForGroupings(genome, 0u, 1u, NULL, logAcceptanceRatios);
+}
+
+
+/* calculateLogLikelihoodRatioForGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, first gene and stride of the genes to use, one flag per amino acid (NULL for all),
+ * vector to store one log acceptance ratio per amino acid in
+ * Calculates the log acceptance ratio of the flagged amino acids in a single parallel pass over every geneStride-th
+ * gene. The likelihood ratio of these genes is scaled by numGenes / number of genes used, the mutation prior is not.
+ * Each thread accumulates its genes into its own row of partial sums, which are added up in thread order afterwards
+ * so results do not depend on thread timing.
+*/
+void ROCModel::calculateLogLikelihoodRatioForGroupings(Genome& genome, unsigned firstGene, unsigned geneStride,
+		const char* groupingMask, std::vector<double> &logAcceptanceRatios)
+{
+	int numGenes = genome.getGenomeSize();
+	int numSampledGenes = (numGenes > (int)firstGene) ? (numGenes - firstGene + geneStride - 1) / geneStride : 0;
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+
+	// gather everything that does not depend on the gene once, instead of once per gene
+	std::vector<std::string> &groupings = groupingNames;
+	std::vector<unsigned> &aaIndex = groupingAAIndex, &aaStart = groupingAAStart, &numCodons = groupingNumCodons;
+	std::vector<double> &mutation = groupingMutation, &mutation_proposed = groupingMutationProposed;
+	std::vector<double> &selection = groupingSelection, &selection_proposed = groupingSelectionProposed;
+	initGroupings();
+	mutation.resize(numGroupings * numMutationCategories * 5);
+	mutation_proposed.resize(numGroupings * numMutationCategories * 5);
+	selection.resize(numGroupings * numSelectionCategories * 5);
+	selection_proposed.resize(numGroupings * numSelectionCategories * 5);
+	for (unsigned g = 0u; g < numGroupings; g++)
 	{
-		for (unsigned i = 0; i < parameter->getNumObservedPhiSets(); i++) {
-			lpr = 0.0;
-			double noiseOffset = getNoiseOffset(i, false);
-			double noiseOffset_proposed = getNoiseOffset(i, true);
-			double observedSynthesisNoise = getObservedSynthesisNoise(i);
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupings[g], false, &mutation[(g * numMutationCategories + k) * 5]);
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupings[g], true, &mutation_proposed[(g * numMutationCategories + k) * 5]);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupings[g], false, &selection[(g * numSelectionCategories + k) * 5]);
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupings[g], true, &selection_proposed[(g * numSelectionCategories + k) * 5]);
+		}
+	}
+
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	// per thread: current likelihood of every grouping followed by the proposed ones
+	partialLikelihood.assign(numThreads * numGroupings * 2, 0.0);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		double *likelihood = &partialLikelihood[omp_get_thread_num() * numGroupings * 2];
+#else
+		double *likelihood = &partialLikelihood[0];
+#endif
+		double *likelihood_proposed = likelihood + numGroupings;
+		int codonCount[6];
+
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int n = 0; n < numSampledGenes; n++)
+		{
+			int i = firstGene + n * geneStride;
+			SequenceSummary *seqsum = genome.getGene(i).getSequenceSummary();
+
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+			unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+			unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			double phiValue = parameter->getSynthesisRate(i, expressionCategory, false);
+
+			for (unsigned g = 0u; g < numGroupings; g++)
+			{
+				if (groupingMask != NULL && !groupingMask[g]) continue;
+				if (seqsum->getAACountForAA(aaIndex[g]) == 0) continue;
+
+				for (unsigned j = 0u; j < numCodons[g]; j++)
+				{
+					codonCount[j] = seqsum->getCodonCountForCodon(aaStart[g] + j);
+				}
+				unsigned mutationIndex = (g * numMutationCategories + mutationCategory) * 5;
+				unsigned selectionIndex = (g * numSelectionCategories + selectionCategory) * 5;
+				likelihood[g] += calculateLogLikelihoodPerAAPerGene(numCodons[g], codonCount, &mutation[mutationIndex],
+						&selection[selectionIndex], phiValue);
+				likelihood_proposed[g] += calculateLogLikelihoodPerAAPerGene(numCodons[g], codonCount, &mutation_proposed[mutationIndex],
+						&selection_proposed[selectionIndex], phiValue);
+			}
+		}
+	}
+
+	// estimate the likelihood of the whole genome from the genes used
+	double scale = numSampledGenes > 0 ? (double)numGenes / numSampledGenes : 1.0;
+	logAcceptanceRatios.resize(numGroupings);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		if (groupingMask != NULL && !groupingMask[g]) continue;
+		double likelihood = 0.0;
+		double likelihood_proposed = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			likelihood += partialLikelihood[(t * 2) * numGroupings + g];
+			likelihood_proposed += partialLikelihood[(t * 2 + 1) * numGroupings + g];
+		}
+		likelihood_proposed = scale * likelihood_proposed + calculateMutationPrior(groupings[g], true);
+		likelihood = scale * likelihood + calculateMutationPrior(groupings[g], false);
+
+		logAcceptanceRatios[g] = (likelihood_proposed - likelihood);
+	}
+}
+
+
+bool ROCModel::hasSubsampleSurrogate()
+{
+	return true;
+}
+
+
+
+
+
+
+/* prepareLogLikelihoodRatiosPerGene (NOT EXPOSED)
+ * Arguments: mixture elements every gene will be evaluated for, number of threads
+ * Gathers the current mutation and selection parameters of every category once per synthesis rate sweep, together with
+ * everything calculateLogLikelihoodRatiosPerGene needs that does not depend on the gene:
+ * exp(-mutation) per mutation category and the selection parameters shifted by min(0, min(selection)) per selection
+ * category. The shift is the one calculateCodonProbabilityVector uses to avoid overflow for large phi values.
+*/
+void ROCModel::prepareLogLikelihoodRatiosPerGene(std::vector<unsigned> &mixtureElements, unsigned numThreads)
+{
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	unsigned numMixtureTerms = mixtureElements.size();
+
+	termMutationCategory.resize(numMixtureTerms);
+	termSelectionCategory.resize(numMixtureTerms);
+	for (unsigned n = 0u; n < numMixtureTerms; n++)
+	{
+		termMutationCategory[n] = parameter->getMutationCategory(mixtureElements[n]);
+		termSelectionCategory[n] = parameter->getSelectionCategory(mixtureElements[n]);
+	}
+
+	initGroupings();
+	sweepMutation.resize(numGroupings * numMutationCategories * 5);
+	sweepExpMutation.resize(numGroupings * numMutationCategories * 5);
+	sweepSelection.resize(numGroupings * numSelectionCategories * 5);
+	sweepSelectionShift.resize(numGroupings * numSelectionCategories);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		unsigned numParameters = groupingNumCodons[g] - 1;
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			double *mutation = &sweepMutation[(g * numMutationCategories + k) * 5];
+			double *expMutation = &sweepExpMutation[(g * numMutationCategories + k) * 5];
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupingNames[g], false, mutation);
+			for (unsigned j = 0u; j < numParameters; j++)
+			{
+				expMutation[j] = std::exp(-mutation[j]);
+			}
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			double *selection = &sweepSelection[(g * numSelectionCategories + k) * 5];
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupingNames[g], false, selection);
+			double shift = 0.0;
+			for (unsigned j = 0u; j < numParameters; j++)
+			{
+				if (selection[j] < shift) shift = selection[j];
+			}
+			for (unsigned j = 0u; j < numParameters; j++)
+			{
+				selection[j] -= shift;
+			}
+			sweepSelectionShift[g * numSelectionCategories + k] = shift;
+		}
+	}
+
+	// per thread: mutation terms, selection terms, 2 x (phi, phi prior, 6 selection factors) per selection category
+	// and 2 x the log normalizing constants per mixture term
+	sweepScratchStride = numMutationCategories + 17 * numSelectionCategories + 2 * numMixtureTerms;
+	if (sweepScratch.size() < numThreads * sweepScratchStride) sweepScratch.resize(numThreads * sweepScratchStride);
+}
+
+
+/* calculateLogLikelihoodRatiosPerGene (NOT EXPOSED)
+ * Arguments: gene, index of the gene, mixture elements to evaluate the gene for, array to store five values per mixture
+ * element in (see calculateLogLikelihoodRatioPerGene)
+ * With codon counts c, amino acid count n and reference codon r, the log likelihood of an amino acid is
+ *   sum(c * log(p)) = -sum(c * dM) - phi * sum(c * (dEta - shift)) - n * log(Z)
+ * where Z = sum(exp(-dM) * exp(-(dEta - shift) * phi)) and dM = dEta = 0 for r. The first sum only depends on the
+ * mutation category, the second only on the selection category and the factors exp(-(dEta - shift) * phi) only on the
+ * selection category and phi. They are calculated once per category. Only Z is calculated per mixture element, as a
+ * dot product followed by a single log. Requires prepareLogLikelihoodRatiosPerGene to be called for the same mixture
+ * elements first, otherwise every mixture element is evaluated on its own.
+*/
+void ROCModel::calculateLogLikelihoodRatiosPerGene(Gene& gene, unsigned geneIndex, std::vector<unsigned> &mixtureElements,
+		double* logProbabilityRatios)
+{
 #ifndef __APPLE__
-//#pragma omp parallel for reduction(+:lpr)
+	unsigned thread = omp_get_thread_num();
+#else
+	unsigned thread = 0u;
 #endif
-			for (int j = 0; j < genome.getGenomeSize(); j++) {
-				unsigned mixtureAssignment = getMixtureAssignment(j);
-				mixtureAssignment = getSynthesisRateCategory(mixtureAssignment);
-				double logphi = std::log(getSynthesisRate(j, mixtureAssignment, false));
-				double obsPhi = genome.getGene(j).getObservedSynthesisRate(i);
+	unsigned numMixtureTerms = mixtureElements.size();
+	if (numMixtureTerms != termMutationCategory.size() || (thread + 1) * sweepScratchStride > sweepScratch.size())
+	{
+		Model::calculateLogLikelihoodRatiosPerGene(gene, geneIndex, mixtureElements, logProbabilityRatios);
+		return;
+	}
+
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	SequenceSummary *seqsum = gene.getSequenceSummary();
+
+	double *mutationTerm = &sweepScratch[thread * sweepScratchStride];
+	double *selectionTerm = mutationTerm + numMutationCategories;
+	double *phiValue = selectionTerm + numSelectionCategories;
+	double *phiValue_proposed = phiValue + numSelectionCategories;
+	double *logPhiProbability = phiValue_proposed + numSelectionCategories;
+	double *logPhiProbability_proposed = logPhiProbability + numSelectionCategories;
+	double *selectionFactor = logPhiProbability_proposed + numSelectionCategories;
+	double *selectionFactor_proposed = selectionFactor + 6 * numSelectionCategories;
+	double *logNormalizer = selectionFactor_proposed + 6 * numSelectionCategories;
+	double *logNormalizer_proposed = logNormalizer + numMixtureTerms;
+
+	for (unsigned k = 0u; k < numMutationCategories; k++)
+	{
+		mutationTerm[k] = 0.0;
+	}
+	for (unsigned k = 0u; k < numSelectionCategories; k++)
+	{
+		selectionTerm[k] = 0.0;
+		phiValue[k] = parameter->getSynthesisRate(geneIndex, k, false);
+		phiValue_proposed[k] = parameter->getSynthesisRate(geneIndex, k, true);
+	}
+	for (unsigned n = 0u; n < numMixtureTerms; n++)
+	{
+		logNormalizer[n] = 0.0;
+		logNormalizer_proposed[n] = 0.0;
+	}
+
+	int codonCount[6];
+	// no parallel region here, this is called from within the parallel gene loop of the MCMC
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		// skip amino acids which do not occur in current gene. Avoid useless calculations and multiplying by 0
+		if (seqsum->getAACountForAA(groupingAAIndex[g]) == 0) continue;
+
+		unsigned numCodons = groupingNumCodons[g];
+		unsigned reference = numCodons - 1;
+		double aaCount = 0.0;
+		for (unsigned j = 0u; j < numCodons; j++)
+		{
+			codonCount[j] = seqsum->getCodonCountForCodon(groupingAAStart[g] + j);
+			aaCount += codonCount[j];
+		}
+
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			double *mutation = &sweepMutation[(g * numMutationCategories + k) * 5];
+			for (unsigned j = 0u; j < reference; j++)
+			{
+				mutationTerm[k] -= codonCount[j] * mutation[j];
+			}
+		}
+
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			double *selection = &sweepSelection[(g * numSelectionCategories + k) * 5];
+			double shift = sweepSelectionShift[g * numSelectionCategories + k];
+			double *factor = &selectionFactor[k * 6];
+			double *factor_proposed = &selectionFactor_proposed[k * 6];
+
+			selectionTerm[k] -= codonCount[reference] * shift;
+			for (unsigned j = 0u; j < reference; j++)
+			{
+				selectionTerm[k] += codonCount[j] * selection[j];
+				factor[j] = std::exp(-selection[j] * phiValue[k]);
+				factor_proposed[j] = std::exp(-selection[j] * phiValue_proposed[k]);
+			}
+			factor[reference] = std::exp(shift * phiValue[k]);
+			factor_proposed[reference] = std::exp(shift * phiValue_proposed[k]);
+		}
+
+		for (unsigned n = 0u; n < numMixtureTerms; n++)
+		{
+			double *expMutation = &sweepExpMutation[(g * numMutationCategories + termMutationCategory[n]) * 5];
+			double *factor = &selectionFactor[termSelectionCategory[n] * 6];
+			double *factor_proposed = &selectionFactor_proposed[termSelectionCategory[n] * 6];
+			double normalizer = factor[reference];
+			double normalizer_proposed = factor_proposed[reference];
+			for (unsigned j = 0u; j < reference; j++)
+			{
+				normalizer += expMutation[j] * factor[j];
+				normalizer_proposed += expMutation[j] * factor_proposed[j];
+			}
+			logNormalizer[n] += aaCount * std::log(normalizer);
+			logNormalizer_proposed[n] += aaCount * std::log(normalizer_proposed);
+		}
+	}
+
+	// the prior on phi only depends on the phi value, so it is shared by all mixture elements of a selection category
+	unsigned mixture = getMixtureAssignment(geneIndex);
+	mixture = getSynthesisRateCategory(mixture);
+	double stdDevSynthesisRate = parameter->getStdDevSynthesisRate(mixture, false);
+	double mPhi = (-(stdDevSynthesisRate * stdDevSynthesisRate) * 0.5); // X * 0.5 = X / 2
+	for (unsigned k = 0u; k < numSelectionCategories; k++)
+	{
+		logPhiProbability[k] = Parameter::densityLogNorm(phiValue[k], mPhi, stdDevSynthesisRate, true);
+		logPhiProbability_proposed[k] = Parameter::densityLogNorm(phiValue_proposed[k], mPhi, stdDevSynthesisRate, true);
+		if (withPhi) {
+			for (unsigned i = 0; i < parameter->getNumObservedPhiSets(); i++) {
+				double obsPhi = gene.getObservedSynthesisRate(i);
 				if (obsPhi > -1.0) {
-					double logobsPhi = std::log(obsPhi);
-					double proposed = Parameter::densityNorm(logobsPhi, logphi + noiseOffset_proposed, observedSynthesisNoise, true);
-					double current = Parameter::densityNorm(logobsPhi, logphi + noiseOffset, observedSynthesisNoise, true);
-					lpr += proposed - current;
+					logPhiProbability[k] += Parameter::densityLogNorm(obsPhi, std::log(phiValue[k]) + getNoiseOffset(i), getObservedSynthesisNoise(i), true);
+					logPhiProbability_proposed[k] += Parameter::densityLogNorm(obsPhi, std::log(phiValue_proposed[k]) + getNoiseOffset(i), getObservedSynthesisNoise(i), true);
 				}
 			}
-			logProbabilityRatio[i+1] = lpr;
 		}
 	}
+
+	for (unsigned n = 0u; n < numMixtureTerms; n++)
+	{
+		unsigned k = termSelectionCategory[n];
+		double logLikelihood = mutationTerm[termMutationCategory[n]] - phiValue[k] * selectionTerm[k] - logNormalizer[n];
+		double logLikelihood_proposed = mutationTerm[termMutationCategory[n]] - phiValue_proposed[k] * selectionTerm[k]
+				- logNormalizer_proposed[n];
+
+		double currentLogLikelihood = (logLikelihood + logPhiProbability[k]);
+		double proposedLogLikelihood = (logLikelihood_proposed + logPhiProbability_proposed[k]);
+
+		double *logProbabilityRatio = &logProbabilityRatios[n * 5];
+		logProbabilityRatio[0] = (proposedLogLikelihood - currentLogLikelihood) - (std::log(phiValue[k]) - std::log(phiValue_proposed[k]));
+		logProbabilityRatio[1] = currentLogLikelihood - std::log(phiValue_proposed[k]);
+		logProbabilityRatio[2] = proposedLogLikelihood - std::log(phiValue[k]);
+		logProbabilityRatio[3] = currentLogLikelihood;
+		logProbabilityRatio[4] = proposedLogLikelihood;
+	}
 }
 
 
 
 
 
+
+//----------------------------------------//
+//---------- Gradient Functions ----------//
+//----------------------------------------//
+
+
+bool ROCModel::hasCodonSpecificParameterGradient()
+{
+	return true;
+}
+
+
+/* getCodonSpecificParameterVector (NOT EXPOSED)
+ * Arguments: vector to store the current codon specific parameters in, vector to store where every amino acid starts in
+ * The parameters of an amino acid are its delta M values of every mutation category followed by its delta eta values
+ * of every selection category, the same order as the rows of its covariance matrix.
+*/
+void ROCModel::getCodonSpecificParameterVector(std::vector<double> &values, std::vector<unsigned> &groupingOffsets)
+{
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	initGroupings();
+
+	groupingParameterOffset.resize(numGroupings + 1);
+	groupingParameterOffset[0] = 0u;
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		groupingParameterOffset[g + 1] = groupingParameterOffset[g] +
+			(numMutationCategories + numSelectionCategories) * (groupingNumCodons[g] - 1);
+	}
+
+	values.resize(groupingParameterOffset[numGroupings]);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		unsigned numParameters = groupingNumCodons[g] - 1;
+		double *value = &values[groupingParameterOffset[g]];
+		for (unsigned k = 0u; k < numMutationCategories; k++, value += numParameters)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupingNames[g], false, value);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++, value += numParameters)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupingNames[g], false, value);
+		}
+	}
+	groupingOffsets = groupingParameterOffset;
+}
+
+
+void ROCModel::setProposedCodonSpecificParameterVector(std::vector<double> &values)
+{
+	setCodonSpecificParameterVector(values, true);
+}
+
+
+/* setCodonSpecificParameterVector (NOT EXPOSED)
+ * Arguments: codon specific parameters in the layout of getCodonSpecificParameterVector, whether to set the proposed
+ * or the current parameters
+*/
+void ROCModel::setCodonSpecificParameterVector(std::vector<double> &values, bool proposed)
+{
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		unsigned numParameters = groupingNumCodons[g] - 1;
+		double *value = &values[groupingParameterOffset[g]];
+		for (unsigned k = 0u; k < numMutationCategories; k++, value += numParameters)
+		{
+			parameter->setParameterForCategory(k, ROCParameter::dM, groupingNames[g], proposed, value);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++, value += numParameters)
+		{
+			parameter->setParameterForCategory(k, ROCParameter::dEta, groupingNames[g], proposed, value);
+		}
+	}
+}
+
+
+/* calculateLogPosteriorGradientForAllGroupings (NOT EXPOSED)
+ * Arguments: reference to a genome, vector to store the log posterior of every amino acid in, vector to store the
+ * gradient in, vector to store the negative second derivatives in (NULL if not needed)
+ * Evaluated at the proposed codon specific parameters, in one parallel pass over the genes. With codon probabilities p
+ * and counts c (n in total) of a gene, the derivative of its log likelihood is -(c_j - n * p_j) for delta M_j and
+ * -phi * (c_j - n * p_j) for delta eta_j, and the negative second derivatives are n * p_j * (1 - p_j) and
+ * phi^2 * n * p_j * (1 - p_j). Only delta M has a prior. getCodonSpecificParameterVector has to be called first to
+ * set up the layout.
+*/
+void ROCModel::calculateLogPosteriorGradientForAllGroupings(Genome& genome, std::vector<double> &logPosterior,
+		std::vector<double> &gradient, std::vector<double> *curvature)
+{
+	calculateLogPosteriorGradient(genome, NULL, logPosterior, gradient, curvature, NULL);
+}
+
+
+/* calculateLogPosteriorGradient (NOT EXPOSED)
+ * Arguments: reference to a genome, log(phi) of every gene (NULL to use the current synthesis rates), vectors to
+ * store the log posterior of every amino acid, the gradient and the negative second derivatives (NULL if not needed)
+ * in, vector to store the derivative of the log likelihood of every gene with respect to phi in (NULL if not needed)
+ * See calculateLogPosteriorGradientForAllGroupings. The derivative with respect to phi is -sum(eta_j * (c_j - n * p_j))
+ * over the amino acids of a gene.
+*/
+void ROCModel::calculateLogPosteriorGradient(Genome& genome, std::vector<double> *logSynthesisRate,
+		std::vector<double> &logPosterior, std::vector<double> &gradient, std::vector<double> *curvature,
+		std::vector<double> *synthesisRateDerivative)
+{
+	int numGenes = genome.getGenomeSize();
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	unsigned numValues = groupingParameterOffset[numGroupings];
+
+	std::vector<unsigned> &aaIndex = groupingAAIndex, &aaStart = groupingAAStart, &numCodons = groupingNumCodons;
+	std::vector<unsigned> &offset = groupingParameterOffset;
+	std::vector<double> &mutation = groupingMutationProposed, &selection = groupingSelectionProposed;
+	mutation.resize(numGroupings * numMutationCategories * 5);
+	selection.resize(numGroupings * numSelectionCategories * 5);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupingNames[g], true, &mutation[(g * numMutationCategories + k) * 5]);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupingNames[g], true, &selection[(g * numSelectionCategories + k) * 5]);
+		}
+	}
+
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	// per thread: gradient, curvature and log likelihood of every amino acid
+	unsigned stride = 2 * numValues + numGroupings;
+	partialGradient.assign(numThreads * stride, 0.0);
+	bool withCurvature = curvature != NULL;
+	if (synthesisRateDerivative != NULL) synthesisRateDerivative->resize(numGenes);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		double *threadGradient = &partialGradient[omp_get_thread_num() * stride];
+#else
+		double *threadGradient = &partialGradient[0];
+#endif
+		double *threadCurvature = threadGradient + numValues;
+		double *threadLikelihood = threadCurvature + numValues;
+		double codonProbabilities[6];
+
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int i = 0; i < numGenes; i++)
+		{
+			SequenceSummary *seqsum = genome.getGene(i).getSequenceSummary();
+
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+			unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+			unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			double phiValue = logSynthesisRate != NULL ? std::exp((*logSynthesisRate)[i]) :
+				parameter->getSynthesisRate(i, expressionCategory, false);
+			double phiDerivative = 0.0;
+
+			for (unsigned g = 0u; g < numGroupings; g++)
+			{
+				unsigned numAACodons = seqsum->getAACountForAA(aaIndex[g]);
+				if (numAACodons == 0) continue;
+
+				unsigned numParameters = numCodons[g] - 1;
+				double *selectionValues = &selection[(g * numSelectionCategories + selectionCategory) * 5];
+				calculateCodonProbabilityVector(numCodons[g], &mutation[(g * numMutationCategories + mutationCategory) * 5],
+						selectionValues, phiValue, codonProbabilities);
+
+				unsigned mutationIndex = offset[g] + mutationCategory * numParameters;
+				unsigned selectionIndex = offset[g] + (numMutationCategories + selectionCategory) * numParameters;
+				for (unsigned j = 0u; j < numCodons[g]; j++)
+				{
+					int codonCount = seqsum->getCodonCountForCodon(aaStart[g] + j);
+					if (codonCount != 0) threadLikelihood[g] += std::log(codonProbabilities[j]) * codonCount;
+					if (j == numParameters) break; // reference codon has no parameters
+
+					double residual = codonCount - numAACodons * codonProbabilities[j];
+					threadGradient[mutationIndex + j] -= residual;
+					threadGradient[selectionIndex + j] -= phiValue * residual;
+					phiDerivative -= selectionValues[j] * residual;
+					if (withCurvature)
+					{
+						double information = numAACodons * codonProbabilities[j] * (1.0 - codonProbabilities[j]);
+						threadCurvature[mutationIndex + j] += information;
+						threadCurvature[selectionIndex + j] += phiValue * phiValue * information;
+					}
+				}
+			}
+			if (synthesisRateDerivative != NULL) (*synthesisRateDerivative)[i] = phiDerivative;
+		}
+	}
+
+	logPosterior.resize(numGroupings);
+	gradient.resize(numValues);
+	if (withCurvature) curvature->resize(numValues);
+	for (unsigned j = 0u; j < numValues; j++)
+	{
+		double sum = 0.0;
+		double curvatureSum = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			sum += partialGradient[t * stride + j];
+			curvatureSum += partialGradient[t * stride + numValues + j];
+		}
+		gradient[j] = sum;
+		if (withCurvature) (*curvature)[j] = curvatureSum;
+	}
+
+	double mutationPriorVariance = parameter->getMutationPriorStandardDeviation();
+	mutationPriorVariance *= mutationPriorVariance;
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		double likelihood = 0.0;
+		for (unsigned t = 0u; t < numThreads; t++)
+		{
+			likelihood += partialGradient[t * stride + 2 * numValues + g];
+		}
+		logPosterior[g] = likelihood + calculateMutationPrior(groupingNames[g], true);
+
+		unsigned numParameters = numCodons[g] - 1;
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			for (unsigned j = 0u; j < numParameters; j++)
+			{
+				unsigned index = offset[g] + k * numParameters + j;
+				gradient[index] -= mutation[(g * numMutationCategories + k) * 5 + j] / mutationPriorVariance;
+				if (withCurvature) (*curvature)[index] += 1.0 / mutationPriorVariance;
+			}
+		}
+	}
+}
+
+
+
+
+
+
+//----------------------------------------------//
+//---------- Posterior Mode Functions ----------//
+//----------------------------------------------//
+
+
+/* findPosteriorMode (NOT EXPOSED)
+ * Arguments: reference to a genome, maximum number of optimization rounds
+ * Every round moves the codon specific parameters of all amino acids and log(phi) of all genes jointly to their mode
+ * with L-BFGS (one parallel pass over the genes per evaluation), then sets stdDevSynthesisRate to the mode of its
+ * Laplace approximated marginal (the joint mode of the hierarchical prior is at stdDevSynthesisRate = 0) and, with
+ * observed phi values, the noise offsets to the mean residual. Mixture assignments and observedSynthesisNoise are
+ * kept. Stops once a round changes the log posterior by less than 1e-8 relative to its value. The proposal covariance
+ * matrix of every amino acid is then set to the scaled inverse Hessian at the mode. Returns whether the search
+ * converged.
+*/
+bool ROCModel::findPosteriorMode(Genome& genome, unsigned maxIterations)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	std::vector<double> values;
+	std::vector<unsigned> groupingOffsets;
+	getCodonSpecificParameterVector(values, groupingOffsets);
+	unsigned numValues = values.size();
+	values.resize(numValues + numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		unsigned expressionCategory = parameter->getSynthesisRateCategory(parameter->getMixtureAssignment(i));
+		values[numValues + i] = std::log(parameter->getSynthesisRate(i, expressionCategory, false));
+	}
+
+	ROCPosteriorModeObjective objective(*this, genome);
+	LBFGSOptimizer optimizer;
+	std::vector<double> logSynthesisRate(numGenes);
+	std::vector<double> synthesisRateCurvature(numGenes);
+	double logPosterior = -std::numeric_limits<double>::infinity();
+	bool converged = false;
+	for (unsigned round = 0u; round < maxIterations && !converged; round++)
+	{
+		unsigned iterations = optimizer.minimize(objective, values, 1000u, 1e-12);
+		setCodonSpecificParameterVector(values, false);
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			logSynthesisRate[i] = values[numValues + i];
+			parameter->setSynthesisRate(std::exp(logSynthesisRate[i]), i, parameter->getMixtureAssignment(i));
+		}
+
+		calculateSynthesisRateCurvature(genome, logSynthesisRate, synthesisRateCurvature);
+		findStdDevSynthesisRateMode(genome, logSynthesisRate, synthesisRateCurvature);
+		if (withPhi) findNoiseOffsetMode(genome, logSynthesisRate);
+
+		double newLogPosterior = -optimizer.getValue();
+		converged = std::fabs(newLogPosterior - logPosterior) <= 1e-8 * std::fabs(newLogPosterior);
+		logPosterior = newLogPosterior;
+#ifndef STANDALONE
+		Rprintf("Posterior mode round %d: log posterior %f (%d L-BFGS iterations)\n", round + 1, logPosterior, iterations);
+#else
+		std::cout << "Posterior mode round " << round + 1 << ": log posterior " << logPosterior << " (" << iterations
+			<< " L-BFGS iterations)\n";
+#endif
+	}
+	setProposalCovarianceToInverseHessian(genome);
+	return converged;
+}
+
+
+/* calculateLogPosteriorForPosteriorMode (NOT EXPOSED)
+ * Arguments: reference to a genome, codon specific parameters in the layout of getCodonSpecificParameterVector
+ * followed by log(phi) of every gene, vector to store the gradient in
+ * Log posterior of the codon specific parameters and the synthesis rates up to a constant, with the synthesis rates
+ * on the log scale they are proposed on. Leaves the codon specific parameters as the proposed ones.
+ * getCodonSpecificParameterVector has to be called first to set up the layout.
+*/
+double ROCModel::calculateLogPosteriorForPosteriorMode(Genome& genome, std::vector<double> &values,
+		std::vector<double> &gradient)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numValues = groupingParameterOffset[getGroupListSize()];
+	setCodonSpecificParameterVector(values, true);
+	modeLogSynthesisRate.assign(values.begin() + numValues, values.end());
+	calculateLogPosteriorGradient(genome, &modeLogSynthesisRate, modeLogPosterior, gradient, NULL,
+			&modeSynthesisRateDerivative);
+
+	double logPosterior = 0.0;
+	for (unsigned g = 0u; g < modeLogPosterior.size(); g++)
+	{
+		logPosterior += modeLogPosterior[g];
+	}
+	gradient.resize(numValues + numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		Gene &gene = genome.getGene(i);
+		unsigned expressionCategory = parameter->getSynthesisRateCategory(parameter->getMixtureAssignment(i));
+		double logPhi = modeLogSynthesisRate[i];
+		double stdDevSynthesisRate = parameter->getStdDevSynthesisRate(expressionCategory, false);
+		double variance = stdDevSynthesisRate * stdDevSynthesisRate;
+		double deviation = logPhi + variance * 0.5;
+		logPosterior -= deviation * deviation / (2.0 * variance);
+		double derivative = std::exp(logPhi) * modeSynthesisRateDerivative[i] - deviation / variance;
+
+		if (withPhi)
+		{
+			for (unsigned k = 0u; k < parameter->getNumObservedPhiSets(); k++)
+			{
+				double obsPhi = gene.getObservedSynthesisRate(k);
+				if (obsPhi > -1.0)
+				{
+					double noise = getObservedSynthesisNoise(k);
+					double residual = std::log(obsPhi) - logPhi - getNoiseOffset(k);
+					logPosterior -= residual * residual / (2.0 * noise * noise);
+					derivative += residual / (noise * noise);
+				}
+			}
+		}
+		gradient[numValues + i] = derivative;
+	}
+	return logPosterior;
+}
+
+
+ROCPosteriorModeObjective::ROCPosteriorModeObjective(ROCModel &_model, Genome &_genome)
+{
+	model = &_model;
+	genome = &_genome;
+}
+
+
+ROCPosteriorModeObjective::~ROCPosteriorModeObjective()
+{
+	//dtor
+}
+
+
+double ROCPosteriorModeObjective::evaluate(std::vector<double> &x, std::vector<double> &gradient)
+{
+	double logPosterior = model->calculateLogPosteriorForPosteriorMode(*genome, x, gradient);
+	for (unsigned j = 0u; j < gradient.size(); j++)
+	{
+		gradient[j] = -gradient[j];
+	}
+	return -logPosterior;
+}
+
+
+/* calculateSynthesisRateCurvature (NOT EXPOSED)
+ * Arguments: reference to a genome, log(phi) of every gene, vector to store the negative second derivatives in
+ * Negative second derivative of the log posterior of log(phi) of every gene, given the current codon specific
+ * parameters. With codon probabilities p (n codons in total) the second derivative of the log likelihood with
+ * respect to phi is -n * Var_p[eta] and the first one -sum(c_j * eta_j) + n * E_p[eta].
+*/
+void ROCModel::calculateSynthesisRateCurvature(Genome& genome, std::vector<double> &logSynthesisRate,
+		std::vector<double> &curvature)
+{
+	int numGenes = genome.getGenomeSize();
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	groupingMutation.resize(numGroupings * numMutationCategories * 5);
+	groupingSelection.resize(numGroupings * numSelectionCategories * 5);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupingNames[g], false, &groupingMutation[(g * numMutationCategories + k) * 5]);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupingNames[g], false, &groupingSelection[(g * numSelectionCategories + k) * 5]);
+		}
+	}
+
+#ifndef __APPLE__
+#pragma omp parallel for schedule(static)
+#endif
+	for (int i = 0; i < numGenes; i++)
+	{
+		Gene &gene = genome.getGene(i);
+		SequenceSummary *seqsum = gene.getSequenceSummary();
+		unsigned mixtureElement = parameter->getMixtureAssignment(i);
+		unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+		unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+		unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
+		double phiValue = std::exp(logSynthesisRate[i]);
+
+		double derivative = 0.0;
+		double secondDerivative = 0.0;
+		double codonProbabilities[6];
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			unsigned numAACodons = seqsum->getAACountForAA(groupingAAIndex[g]);
+			if (numAACodons == 0) continue;
+
+			unsigned numCodons = groupingNumCodons[g];
+			double *selection = &groupingSelection[(g * numSelectionCategories + selectionCategory) * 5];
+			calculateCodonProbabilityVector(numCodons, &groupingMutation[(g * numMutationCategories + mutationCategory) * 5],
+					selection, phiValue, codonProbabilities);
+
+			double meanSelection = 0.0;
+			double meanSquaredSelection = 0.0;
+			for (unsigned j = 0u; j < numCodons - 1; j++) // reference codon has no parameters
+			{
+				derivative -= seqsum->getCodonCountForCodon(groupingAAStart[g] + j) * selection[j];
+				meanSelection += codonProbabilities[j] * selection[j];
+				meanSquaredSelection += codonProbabilities[j] * selection[j] * selection[j];
+			}
+			derivative += numAACodons * meanSelection;
+			secondDerivative -= numAACodons * (meanSquaredSelection - meanSelection * meanSelection);
+		}
+
+		double stdDevSynthesisRate = parameter->getStdDevSynthesisRate(expressionCategory, false);
+		curvature[i] = -(phiValue * derivative + phiValue * phiValue * secondDerivative) +
+			1.0 / (stdDevSynthesisRate * stdDevSynthesisRate);
+		if (withPhi)
+		{
+			for (unsigned k = 0u; k < parameter->getNumObservedPhiSets(); k++)
+			{
+				double noise = getObservedSynthesisNoise(k);
+				if (gene.getObservedSynthesisRate(k) > -1.0) curvature[i] += 1.0 / (noise * noise);
+			}
+		}
+	}
+}
+
+
+/* findStdDevSynthesisRateMode (NOT EXPOSED)
+ * Arguments: reference to a genome, log(phi) and the negative second derivative of its log posterior for every gene
+ * Sets stdDevSynthesisRate of every synthesis rate category to the maximum of the expected log prior of log(phi)
+ * under a normal approximation of every gene around its mode (the EM update of a Laplace approximation). Golden
+ * section search on log(stdDevSynthesisRate) between 1e-3 and 10.
+*/
+void ROCModel::findStdDevSynthesisRateMode(Genome& genome, std::vector<double> &logSynthesisRate,
+		std::vector<double> &curvature)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numCategories = getNumSynthesisRateCategories();
+	for (unsigned category = 0u; category < numCategories; category++)
+	{
+		std::vector<double> logPhi;
+		std::vector<double> logPhiVariance;
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			if (parameter->getSynthesisRateCategory(parameter->getMixtureAssignment(i)) != category) continue;
+			logPhi.push_back(logSynthesisRate[i]);
+			logPhiVariance.push_back(curvature[i] > 0.0 ? 1.0 / curvature[i] : 0.0);
+		}
+		if (logPhi.empty()) continue;
+
+		const double ratio = 0.5 * (std::sqrt(5.0) - 1.0);
+		double lower = std::log(1e-3);
+		double upper = std::log(10.0);
+		double first = upper - ratio * (upper - lower);
+		double second = lower + ratio * (upper - lower);
+		double firstValue = calculateExpectedLogSynthesisRatePrior(logPhi, logPhiVariance, std::exp(first));
+		double secondValue = calculateExpectedLogSynthesisRatePrior(logPhi, logPhiVariance, std::exp(second));
+		for (unsigned iteration = 0u; iteration < 60u; iteration++)
+		{
+			if (firstValue < secondValue)
+			{
+				lower = first;
+				first = second;
+				firstValue = secondValue;
+				second = lower + ratio * (upper - lower);
+				secondValue = calculateExpectedLogSynthesisRatePrior(logPhi, logPhiVariance, std::exp(second));
+			}
+			else
+			{
+				upper = second;
+				second = first;
+				secondValue = firstValue;
+				first = upper - ratio * (upper - lower);
+				firstValue = calculateExpectedLogSynthesisRatePrior(logPhi, logPhiVariance, std::exp(first));
+			}
+		}
+		parameter->setStdDevSynthesisRate(std::exp(0.5 * (lower + upper)), category);
+	}
+}
+
+
+/* calculateExpectedLogSynthesisRatePrior (NOT EXPOSED)
+ * Arguments: log(phi) and its approximate posterior variance for every gene of a category, stdDevSynthesisRate
+ * Expected log normal prior density of log(phi) (mean -stdDevSynthesisRate^2 / 2) over the normal approximations,
+ * up to a constant.
+*/
+double ROCModel::calculateExpectedLogSynthesisRatePrior(std::vector<double> &logPhi, std::vector<double> &logPhiVariance,
+		double stdDevSynthesisRate)
+{
+	double variance = stdDevSynthesisRate * stdDevSynthesisRate;
+	double value = 0.0;
+	for (unsigned i = 0u; i < logPhi.size(); i++)
+	{
+		double deviation = logPhi[i] + variance * 0.5;
+		value -= std::log(stdDevSynthesisRate) + (deviation * deviation + logPhiVariance[i]) / (2.0 * variance);
+	}
+	return value;
+}
+
+
+/* findNoiseOffsetMode (NOT EXPOSED)
+ * Arguments: reference to a genome, log(phi) of every gene
+ * Sets the noise offset of every set of observed phi values to the mean difference between log observed phi and
+ * log phi, its mode under a flat prior.
+*/
+void ROCModel::findNoiseOffsetMode(Genome& genome, std::vector<double> &logSynthesisRate)
+{
+	unsigned numGenes = genome.getGenomeSize();
+	for (unsigned i = 0u; i < parameter->getNumObservedPhiSets(); i++)
+	{
+		double sum = 0.0;
+		unsigned count = 0u;
+		for (unsigned j = 0u; j < numGenes; j++)
+		{
+			double obsPhi = genome.getGene(j).getObservedSynthesisRate(i);
+			if (obsPhi > -1.0)
+			{
+				sum += std::log(obsPhi) - logSynthesisRate[j];
+				count++;
+			}
+		}
+		if (count != 0u) parameter->setNoiseOffset(i, sum / count);
+	}
+}
+
+
+/* setProposalCovarianceToInverseHessian (NOT EXPOSED)
+ * Arguments: reference to a genome
+ * Sets the proposal covariance matrix of every amino acid to the inverse of the negative Hessian of its log posterior
+ * at the current codon specific parameters, scaled by 2.38^2 / dimension (Roberts & Rosenthal 2001). With
+ * W = n * (diag(p) - p * p^T) over the non reference codons of a gene, its delta M block gets W, its delta eta block
+ * phi^2 * W and the blocks between them phi * W. Amino acids whose Hessian is singular (e.g. without codons in a
+ * selection category) keep their covariance matrix.
+*/
+void ROCModel::setProposalCovarianceToInverseHessian(Genome& genome)
+{
+	int numGenes = genome.getGenomeSize();
+	unsigned numGroupings = getGroupListSize();
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	unsigned numCategories = numMutationCategories + numSelectionCategories;
+	groupingMutation.resize(numGroupings * numMutationCategories * 5);
+	groupingSelection.resize(numGroupings * numSelectionCategories * 5);
+	std::vector<unsigned> matrixOffset(numGroupings + 1, 0u);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dM, groupingNames[g], false, &groupingMutation[(g * numMutationCategories + k) * 5]);
+		}
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			parameter->getParameterForCategory(k, ROCParameter::dEta, groupingNames[g], false, &groupingSelection[(g * numSelectionCategories + k) * 5]);
+		}
+		unsigned numVariates = numCategories * (groupingNumCodons[g] - 1);
+		matrixOffset[g + 1] = matrixOffset[g] + numVariates * numVariates;
+	}
+
+#ifndef __APPLE__
+	unsigned numThreads = omp_get_max_threads();
+#else
+	unsigned numThreads = 1u;
+#endif
+	unsigned stride = matrixOffset[numGroupings];
+	std::vector<double> partialHessian(numThreads * stride, 0.0);
+
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+#ifndef __APPLE__
+		double *threadHessian = &partialHessian[omp_get_thread_num() * stride];
+#else
+		double *threadHessian = &partialHessian[0];
+#endif
+		double codonProbabilities[6];
+
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+		for (int i = 0; i < numGenes; i++)
+		{
+			SequenceSummary *seqsum = genome.getGene(i).getSequenceSummary();
+			unsigned mixtureElement = parameter->getMixtureAssignment(i);
+			unsigned mutationCategory = parameter->getMutationCategory(mixtureElement);
+			unsigned selectionCategory = parameter->getSelectionCategory(mixtureElement);
+			unsigned expressionCategory = parameter->getSynthesisRateCategory(mixtureElement);
+			double phiValue = parameter->getSynthesisRate(i, expressionCategory, false);
+
+			for (unsigned g = 0u; g < numGroupings; g++)
+			{
+				unsigned numAACodons = seqsum->getAACountForAA(groupingAAIndex[g]);
+				if (numAACodons == 0) continue;
+
+				unsigned numParameters = groupingNumCodons[g] - 1;
+				unsigned numVariates = numCategories * numParameters;
+				calculateCodonProbabilityVector(groupingNumCodons[g],
+						&groupingMutation[(g * numMutationCategories + mutationCategory) * 5],
+						&groupingSelection[(g * numSelectionCategories + selectionCategory) * 5], phiValue, codonProbabilities);
+
+				double *hessian = threadHessian + matrixOffset[g];
+				unsigned mutationIndex = mutationCategory * numParameters;
+				unsigned selectionIndex = (numMutationCategories + selectionCategory) * numParameters;
+				for (unsigned a = 0u; a < numParameters; a++)
+				{
+					for (unsigned b = 0u; b < numParameters; b++)
+					{
+						double w = numAACodons * ((a == b ? codonProbabilities[a] : 0.0) - codonProbabilities[a] * codonProbabilities[b]);
+						hessian[(mutationIndex + a) * numVariates + mutationIndex + b] += w;
+						hessian[(mutationIndex + a) * numVariates + selectionIndex + b] += phiValue * w;
+						hessian[(selectionIndex + a) * numVariates + mutationIndex + b] += phiValue * w;
+						hessian[(selectionIndex + a) * numVariates + selectionIndex + b] += phiValue * phiValue * w;
+					}
+				}
+			}
+		}
+	}
+
+	double mutationPriorVariance = parameter->getMutationPriorStandardDeviation();
+	mutationPriorVariance *= mutationPriorVariance;
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		unsigned numVariates = numCategories * (groupingNumCodons[g] - 1);
+		std::vector<double> hessian(numVariates * numVariates);
+		for (unsigned j = 0u; j < hessian.size(); j++)
+		{
+			double sum = 0.0;
+			for (unsigned t = 0u; t < numThreads; t++)
+			{
+				sum += partialHessian[t * stride + matrixOffset[g] + j];
+			}
+			hessian[j] = sum;
+		}
+		for (unsigned j = 0u; j < numMutationCategories * (groupingNumCodons[g] - 1); j++)
+		{
+			hessian[j * numVariates + j] += 1.0 / mutationPriorVariance;
+		}
+
+		CovarianceMatrix covarianceMatrix(hessian);
+		if (!covarianceMatrix.invert()) continue;
+		covarianceMatrix *= 2.38 * 2.38 / numVariates;
+		covarianceMatrix.choleskiDecomposition();
+		parameter->getCovarianceMatrixForAA(groupingNames[g]) = covarianceMatrix;
+	}
+}
+
+
+
+
+
+
 //----------------------------------------------------------//
 //---------- Initialization and Restart Functions ----------//
 //----------------------------------------------------------//
@@ -289,6 +1533,7 @@ void ROCModel::calculateLogLikelihoodRatioForHyperParameters(Genome &genome, uns
 void ROCModel::initTraces(unsigned samples, unsigned num_genes)
 {
 	parameter -> initAllTraces(samples, num_genes);
+	observedSynthesisRatesCached = false; // a new run may use a different genome or new observed values
 }
 
 
@@ -604,19 +1849,49 @@ void ROCModel::updateGibbsSampledHyperParameters(Genome &genome)
 {
 	// TODO: Fix this for any numbers of phi values
 	if (withPhi) {
-		double shape = ((double)genome.getGenomeSize() - 1.0) / 2.0;
-		for (unsigned i = 0; i < parameter->getNumObservedPhiSets(); i++) {
-			double rate = 0.0;
-			unsigned mixtureAssignment;
-			double noiseOffset = getNoiseOffset(i);
-			for (unsigned j = 0; j < genome.getGenomeSize(); j++) {
-				mixtureAssignment = getMixtureAssignment(j);
-				double obsPhi = genome.getGene(j).getObservedSynthesisRate(i);
-				if (obsPhi > -1.0) {
-					double sum = std::log(obsPhi) - noiseOffset - std::log(getSynthesisRate(j, mixtureAssignment, false));
-					//double sum = std::log(obsPhi) - std::log(getSynthesisRate(j, mixtureAssignment, false));
-					rate += sum * sum;
+		unsigned numGenes = genome.getGenomeSize();
+		unsigned numSets = parameter->getNumObservedPhiSets();
+		double shape = ((double)numGenes - 1.0) / 2.0;
+		cacheObservedSynthesisRates(genome);
+		gatherLogSynthesisRates(numGenes);
+		const double *logPhi = hyperLogSynthesisRate.data();
+
+#ifndef __APPLE__
+		unsigned numThreads = omp_get_max_threads();
+#else
+		unsigned numThreads = 1u;
+#endif
+		partialHyperParameter.assign(numThreads * numSets, 0.0);
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+		{
+#ifndef __APPLE__
+			double *rate = &partialHyperParameter[omp_get_thread_num() * numSets];
+#else
+			double *rate = &partialHyperParameter[0];
+#endif
+			for (unsigned i = 0; i < numSets; i++) {
+				const double *logObsPhi = &observedLogSynthesisRate[i * numGenes];
+				const double *observed = &observedSynthesisRateMask[i * numGenes];
+				double noiseOffset = getNoiseOffset(i);
+				double value = 0.0;
+#ifndef __APPLE__
+#pragma omp for schedule(static)
+#endif
+				for (int j = 0; j < (int)numGenes; j++) {
+					double sum = logObsPhi[j] - noiseOffset - logPhi[j];
+					value += observed[j] * sum * sum;
 				}
+				rate[i] += value;
+			}
+		}
+
+		for (unsigned i = 0; i < numSets; i++) {
+			double rate = 0.0;
+			for (unsigned t = 0u; t < numThreads; t++)
+			{
+				rate += partialHyperParameter[t * numSets + i];
 			}
 			rate /= 2;
 			double rand = parameter->randGamma(shape, rate);
@@ -648,61 +1923,108 @@ void ROCModel::updateHyperParameter(unsigned hp)
 
 void ROCModel::simulateGenome(Genome &genome)
 {
-	unsigned codonIndex;
+	simulateGenomeInBlocks(genome, "");
+}
 
-	std::string tmpDesc = "Simulated Gene";
 
-	for (unsigned geneIndex = 0; geneIndex < genome.getGenomeSize(); geneIndex++) //loop over all genes in the genome
+/* simulateCodonSequences (NOT EXPOSED)
+ * Arguments: see Model::simulateCodonSequences
+ * The codon probabilities of a gene only depend on its categories and phi, so they are tabulated once per gene as
+ * cumulative probabilities over the codons of every amino acid and each codon is drawn with a single uniform number.
+ * The first codon is always ATG, stop codons within the sequence are dropped and the last codon is a stop codon
+ * drawn uniformly.
+*/
+void ROCModel::simulateCodonSequences(Genome &genome, unsigned firstGene, unsigned numGenes, unsigned seed,
+		std::vector<std::string> &sequences)
+{
+	unsigned numMutationCategories = parameter->getNumMutationCategories();
+	unsigned numSelectionCategories = parameter->getNumSelectionCategories();
+	unsigned numAA = SequenceSummary::numAminoAcids();
+	unsigned numSenseCodons = SequenceSummary::numSenseCodons();
+	unsigned aaStart[GeneticCode::maxNumAA];
+	unsigned aaEnd[GeneticCode::maxNumAA];
+	unsigned codonAA[64];
+
+	// [category][amino acid][codon], read once instead of per codon
+	std::vector<double> mutation(numMutationCategories * numAA * 5, 0.0);
+	std::vector<double> selection(numSelectionCategories * numAA * 5, 0.0);
+	for (unsigned aaIndex = 0u; aaIndex < numAA; aaIndex++)
 	{
-		Gene gene = genome.getGene(geneIndex);
-		SequenceSummary seqSum = gene.geneData;
-		std::string tmpSeq = "ATG"; //Always will have the start amino acid
-
+		SequenceSummary::AAIndexToCodonRange(aaIndex, aaStart[aaIndex], aaEnd[aaIndex], false);
+		for (unsigned codonIndex = aaStart[aaIndex]; codonIndex < aaEnd[aaIndex]; codonIndex++)
+			codonAA[codonIndex] = aaIndex;
+
+		std::string aa = SequenceSummary::indexToAA(aaIndex);
+		if (SequenceSummary::GetNumCodonsForAA(aa, true) == 0u) continue; // no parameters, e.g. M, W and X
+		for (unsigned k = 0u; k < numMutationCategories; k++)
+			getParameterForCategory(k, ROCParameter::dM, aa, false, &mutation[(k * numAA + aaIndex) * 5]);
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+			getParameterForCategory(k, ROCParameter::dEta, aa, false, &selection[(k * numAA + aaIndex) * 5]);
+	}
 
-		unsigned mixtureElement = getMixtureAssignment(geneIndex);
-		unsigned mutationCategory = getMutationCategory(mixtureElement);
-		unsigned selectionCategory = getSelectionCategory(mixtureElement);
-		unsigned synthesisRateCategory = getSynthesisRateCategory(mixtureElement);
-		double phi = getSynthesisRate(geneIndex, synthesisRateCategory, false);
+	sequences.resize(numGenes);
+#ifndef __APPLE__
+#pragma omp parallel
+#endif
+	{
+		double cumulativeProb[64];
+		double codonProb[6];
+		std::vector<unsigned> codonIndices;
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
 
-		std::string geneSeq = gene.getSequence();
-		for (unsigned position = 1; position < (geneSeq.size() / 3); position++)
+#ifndef __APPLE__
+#pragma omp for schedule(dynamic, 16)
+#endif
+		for (unsigned i = 0u; i < numGenes; i++)
 		{
-			std::string codon = geneSeq.substr((position * 3), 3);
-			std::string aa = SequenceSummary::codonToAA(codon);
-
-			if (aa == "X") continue;
-
-			unsigned numCodons = SequenceSummary::GetNumCodonsForAA(aa);
-
-			double* codonProb = new double[numCodons](); //size the arrays to the proper size based on # of codons.
-			double* mutation = new double[numCodons - 1]();
-			double* selection = new double[numCodons - 1]();
-
-
-			if (aa == "M" || aa == "W")
+			unsigned geneIndex = firstGene + i;
+			unsigned mixtureElement = getMixtureAssignment(geneIndex);
+			unsigned mutationCategory = getMutationCategory(mixtureElement);
+			unsigned selectionCategory = getSelectionCategory(mixtureElement);
+			unsigned synthesisRateCategory = getSynthesisRateCategory(mixtureElement);
+			double phi = getSynthesisRate(geneIndex, synthesisRateCategory, false);
+
+			for (unsigned aaIndex = 0u; aaIndex + 1u < numAA; aaIndex++)
 			{
-				codonProb[0] = 1;
-			}
-			else
-			{
-				getParameterForCategory(mutationCategory, ROCParameter::dM, aa, false, mutation);
-				getParameterForCategory(selectionCategory, ROCParameter::dEta, aa, false, selection);
-				calculateCodonProbabilityVector(numCodons, mutation, selection, phi, codonProb);
+				unsigned numCodons = aaEnd[aaIndex] - aaStart[aaIndex];
+				if (numCodons == 1)
+				{
+					cumulativeProb[aaStart[aaIndex]] = 1.0;
+					continue;
+				}
+				calculateCodonProbabilityVector(numCodons, &mutation[(mutationCategory * numAA + aaIndex) * 5],
+						&selection[(selectionCategory * numAA + aaIndex) * 5], phi, codonProb);
+				double sum = 0.0;
+				for (unsigned k = 0u; k < numCodons; k++)
+				{
+					sum += codonProb[k];
+					cumulativeProb[aaStart[aaIndex] + k] = sum;
+				}
 			}
 
+			genome.getGene(geneIndex).geneData.getCodonIndexSequence(codonIndices);
+			std::seed_seq seedSequence{seed, geneIndex};
+			std::default_random_engine generator(seedSequence);
 
-			codonIndex = Parameter::randMultinom(codonProb, numCodons);
-			unsigned aaStart;
-			unsigned aaEnd;
-			SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, false); //need the first spot in the array where the codons for curAA are
-			codon = seqSum.indexToCodon(aaStart + codonIndex);//get the correct codon based off codonIndex
-			tmpSeq += codon;
+			std::string &sequence = sequences[i];
+			sequence.clear();
+			sequence.reserve(3 * codonIndices.size() + 6);
+			sequence.append("ATG"); //Always will have the start amino acid
+			for (unsigned position = 1u; position < codonIndices.size(); position++)
+			{
+				unsigned codonIndex = codonIndices[position];
+				if (codonIndex >= numSenseCodons) continue; // stop codon or not recognized
+
+				unsigned aaIndex = codonAA[codonIndex];
+				double draw = uniform(generator);
+				unsigned drawn = aaStart[aaIndex];
+				while (drawn < aaEnd[aaIndex] - 1 && draw >= cumulativeProb[drawn]) drawn++;
+				sequence.append(SequenceSummary::codonArray[drawn]);
+			}
+			unsigned numStopCodons = 64u - numSenseCodons;
+			unsigned stopCodon = std::min(numSenseCodons + (unsigned)(uniform(generator) * numStopCodons), 63u);
+			sequence.append(SequenceSummary::codonArray[stopCodon]);
 		}
-		std::string codon =	seqSum.indexToCodon((unsigned)Parameter::randUnif(61.0, 63.0)); //randomly choose a stop codon, from range 61-63
-		tmpSeq += codon;
-		Gene simulatedGene(tmpSeq, tmpDesc, gene.getId());
-		genome.addGene(simulatedGene, true);
 	}
 }
 
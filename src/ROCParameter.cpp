@@ -20,7 +20,7 @@ ROCParameter::ROCParameter() : Parameter()
 }
 
 
-ROCParameter::ROCParameter(std::string filename) : Parameter(22)
+ROCParameter::ROCParameter(std::string filename) : Parameter(SequenceSummary::numAminoAcids())
 {
 	currentCodonSpecificParameter.resize(2);
 	proposedCodonSpecificParameter.resize(2);
@@ -30,7 +30,7 @@ ROCParameter::ROCParameter(std::string filename) : Parameter(22)
 
 ROCParameter::ROCParameter(std::vector<double> stdDevSynthesisRate, unsigned _numMixtures, std::vector<unsigned> geneAssignment,
 		std::vector<std::vector<unsigned>> thetaKMatrix, bool splitSer, std::string _mutationSelectionState) :
-		Parameter(22)
+		Parameter(SequenceSummary::numAminoAcids())
 {
 	initParameterSet(stdDevSynthesisRate, _numMixtures, geneAssignment, thetaKMatrix, splitSer, _mutationSelectionState);
 	initROCParameterSet();
@@ -76,7 +76,7 @@ void ROCParameter::initROCParameterSet()
 {
 	mutation_prior_sd = 0.35;
 
-	groupList = {"A", "C", "D", "E", "F", "G", "H", "I", "K", "L", "N", "P", "Q", "R", "S", "T", "V", "Y", "Z"};
+	groupList = SequenceSummary::aminoAcidsWithParameters();
 	// proposal bias and std for codon specific parameter
 	bias_csp = 0;
 	
@@ -549,7 +549,7 @@ void ROCParameter::updateCodonSpecificParameterTrace(unsigned sample, std::strin
 CovarianceMatrix& ROCParameter::getCovarianceMatrixForAA(std::string aa)
 {
 	aa[0] = (char) std::toupper(aa[0]);
-	unsigned aaIndex = SequenceSummary::aaToIndex.find(aa) -> second;
+	unsigned aaIndex = SequenceSummary::AAToAAIndex(aa);
 	return covarianceMatrix[aaIndex];
 }
 
@@ -633,39 +633,7 @@ double ROCParameter::getCurrentCodonSpecificProposalWidth(unsigned aa)
 // 4. the adjusment of the likelihood by the jacobian that arises from this transformation is cheap and by grouping everything in one class it takes place more or less at the same place
 void ROCParameter::proposeCodonSpecificParameter()
 {
-
-	for (unsigned k = 0; k < getGroupListSize(); k++)
-	{
-		std::vector<double> iidProposed;
-		std::string aa = getGrouping(k);
-		unsigned aaStart;
-		unsigned aaEnd;
-		SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, true);
-		unsigned numCodons = aaEnd - aaStart;
-		for (unsigned i = 0u; i < (numCodons * (numMutationCategories + numSelectionCategories)); i++)
-		{
-			iidProposed.push_back(randNorm(0.0, 1.0));
-		}
-
-		std::vector<double> covaryingNums;
-		covaryingNums = covarianceMatrix[SequenceSummary::AAToAAIndex(aa)].transformIidNumersIntoCovaryingNumbers(
-				iidProposed);
-		for (unsigned i = 0; i < numMutationCategories; i++)
-		{
-			for (unsigned j = i * numCodons, l = aaStart; j < (i * numCodons) + numCodons; j++, l++)
-			{
-				proposedCodonSpecificParameter[dM][i][l] = currentCodonSpecificParameter[dM][i][l] + covaryingNums[j];
-			}
-		}
-		for (unsigned i = 0; i < numSelectionCategories; i++)
-		{
-			for (unsigned j = i * numCodons, l = aaStart; j < (i * numCodons) + numCodons; j++, l++)
-			{
-				proposedCodonSpecificParameter[dEta][i][l] = currentCodonSpecificParameter[dEta][i][l]
-												   + covaryingNums[(numMutationCategories * numCodons) + j];
-			}
-		}
-	}
+	proposeCovaryingCodonSpecificParameters(dM, dEta);
 }
 
 
@@ -674,7 +642,7 @@ void ROCParameter::updateCodonSpecificParameter(std::string grouping)
 	unsigned aaStart;
 	unsigned aaEnd;
 	SequenceSummary::AAToCodonRange(grouping, aaStart, aaEnd, true);
-	unsigned aaIndex = SequenceSummary::aaToIndex.find(grouping)->second;
+	unsigned aaIndex = SequenceSummary::AAToAAIndex(grouping);
 	numAcceptForCodonSpecificParameters[aaIndex]++;
 
 	for (unsigned k = 0u; k < numMutationCategories; k++)
@@ -835,6 +803,30 @@ void ROCParameter::getParameterForCategory(unsigned category, unsigned paramType
 	}
 }
 
+
+/* setParameterForCategory (NOT EXPOSED)
+ * Arguments: category, parameter type (dM or dEta), amino acid, whether to set the proposed or the current values,
+ * one value per codon of the amino acid (without the reference codon)
+ * Counterpart of getParameterForCategory. Used by samplers that move all parameters of an amino acid at once.
+*/
+void ROCParameter::setParameterForCategory(unsigned category, unsigned paramType, std::string aa, bool proposal,
+										   double *values)
+{
+	std::vector<double> *tempSet;
+	tempSet = (proposal ? &proposedCodonSpecificParameter[paramType][category] : &currentCodonSpecificParameter[paramType][category]);
+
+	unsigned aaStart;
+	unsigned aaEnd;
+	SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, true);
+
+	unsigned j = 0u;
+	for (unsigned i = aaStart; i < aaEnd; i++, j++)
+	{
+		tempSet->at(i) = values[j];
+	}
+}
+
+
 // -----------------------------------------------------------------------------------------------------//
 // ---------------------------------------- R SECTION --------------------------------------------------//
 // -----------------------------------------------------------------------------------------------------//
@@ -850,7 +842,7 @@ void ROCParameter::getParameterForCategory(unsigned category, unsigned paramType
 
 
 ROCParameter::ROCParameter(std::vector<double> stdDevSynthesisRate, std::vector<unsigned> geneAssignment,
-						std::vector<unsigned> _matrix, bool splitSer) : Parameter(22)
+						std::vector<unsigned> _matrix, bool splitSer) : Parameter(SequenceSummary::numAminoAcids())
 {
 	unsigned _numMixtures = _matrix.size() / 2;
 	std::vector<std::vector<unsigned>> thetaKMatrix;
@@ -870,7 +862,7 @@ ROCParameter::ROCParameter(std::vector<double> stdDevSynthesisRate, std::vector<
 }
 
 ROCParameter::ROCParameter(std::vector<double> stdDevSynthesisRate, unsigned _numMixtures, std::vector<unsigned> geneAssignment,
-							bool splitSer, std::string _mutationSelectionState) : Parameter(22)
+							bool splitSer, std::string _mutationSelectionState) : Parameter(SequenceSummary::numAminoAcids())
 {
 	std::vector<std::vector<unsigned>> thetaKMatrix;
 	initParameterSet(stdDevSynthesisRate, _numMixtures, geneAssignment, thetaKMatrix, splitSer, _mutationSelectionState);
@@ -893,7 +885,7 @@ void ROCParameter::initCovarianceMatrix(SEXP _matrix, std::string aa)
 
 	for(unsigned i = 0u; i < aa.length(); i++)	aa[i] = (char)std::toupper(aa[i]);
 
-	unsigned aaIndex = SequenceSummary::aaToIndex.find(aa) -> second;
+	unsigned aaIndex = SequenceSummary::AAToAAIndex(aa);
 	unsigned numRows = matrix.nrow();
 	std::vector<double> covMatrix(numRows * numRows);
 
@@ -7,10 +7,11 @@ using namespace Rcpp;
 
 const std::string SequenceSummary::Ser2 = "Z";
 
-const std::vector<std::string> SequenceSummary::AminoAcidArray = {"A", "C", "D", "E", "F", "G", "H", "I", "K", "L",
+// names of the active genetic code (CodonEncoding::activeCode()), set by setGeneticCode
+std::vector<std::string> SequenceSummary::AminoAcidArray = {"A", "C", "D", "E", "F", "G", "H", "I", "K", "L",
 	"M", "N", "P", "Q", "R", "S", "T", "V", "W", "Y", SequenceSummary::Ser2, "X"};
 
-const std::string SequenceSummary::codonArray[] =
+std::vector<std::string> SequenceSummary::codonArray =
 		{"GCA", "GCC", "GCG", "GCT", "TGC", "TGT", "GAC", "GAT", "GAA", "GAG",
 		 "TTC", "TTT", "GGA", "GGC", "GGG", "GGT", "CAC", "CAT", "ATA", "ATC",
 		 "ATT", "AAA", "AAG", "CTA", "CTC", "CTG", "CTT", "TTA", "TTG", "ATG",
@@ -19,7 +20,7 @@ const std::string SequenceSummary::codonArray[] =
 		 "ACG", "ACT", "GTA", "GTC", "GTG", "GTT", "TGG", "TAC", "TAT", "AGC",
 		 "AGT", "TAA", "TAG", "TGA"};
 
-const std::string SequenceSummary::codonArrayParameter[] =
+std::vector<std::string> SequenceSummary::codonArrayParameter =
 		{"GCA", "GCC", "GCG", "TGC", "GAC",
 		 "GAA", "TTC", "GGA", "GGC", "GGG",
 		 "CAC", "ATA", "ATC", "AAA", "CTA",
@@ -29,26 +30,6 @@ const std::string SequenceSummary::codonArrayParameter[] =
 		 "TCC", "TCG", "ACA", "ACC", "ACG",
 		 "GTA", "GTC", "GTG", "TAC", "AGC"};
 
-const std::map<std::string, unsigned> SequenceSummary::aaToIndex = {{"A", 0}, {"C", 1}, {"D", 2}, {"E", 3}, {"F", 4},
-	{"G", 5}, {"H", 6}, {"I", 7}, {"K", 8}, {"L", 9}, {"M", 10}, {"N", 11}, {"P", 12}, {"Q", 13}, {"R", 14}, {"S", 15},
-	{"T", 16}, {"V", 17}, {"W", 18}, {"Y", 19}, {SequenceSummary::Ser2, 20}, {"X", 21}};
-
-const std::map<std::string, unsigned> SequenceSummary::codonToIndexWithReference = {{"GCA", 0}, {"GCC", 1}, {"GCG", 2},
-	{"GCT", 3}, {"TGC", 4}, {"TGT", 5}, {"GAC", 6}, {"GAT", 7}, {"GAA", 8}, {"GAG", 9}, {"TTC", 10}, {"TTT", 11},
-	{"GGA", 12}, {"GGC", 13}, {"GGG", 14}, {"GGT", 15}, {"CAC", 16}, {"CAT", 17}, {"ATA", 18}, {"ATC", 19}, {"ATT", 20},
-	{"AAA", 21}, {"AAG", 22}, {"CTA", 23}, {"CTC", 24}, {"CTG", 25}, {"CTT", 26}, {"TTA", 27}, {"TTG", 28}, {"ATG", 29},
-	{"AAC", 30}, {"AAT", 31}, {"CCA", 32}, {"CCC", 33}, {"CCG", 34}, {"CCT", 35}, {"CAA", 36}, {"CAG", 37}, {"AGA", 38},
-	{"AGG", 39}, {"CGA", 40}, {"CGC", 41}, {"CGG", 42}, {"CGT", 43}, {"TCA", 44}, {"TCC", 45}, {"TCG", 46}, {"TCT", 47},
-	{"ACA", 48}, {"ACC", 49}, {"ACG", 50}, {"ACT", 51}, {"GTA", 52}, {"GTC", 53}, {"GTG", 54}, {"GTT", 55}, {"TGG", 56},
-	{"TAC", 57}, {"TAT", 58}, {"AGC", 59}, {"AGT", 60}, {"TAA", 61}, {"TAG", 62}, {"TGA", 63}};
-
-const std::map<std::string, unsigned> SequenceSummary::codonToIndexWithoutReference = {{"GCA", 0}, {"GCC", 1},
-	{"GCG", 2}, {"TGC", 3}, {"GAC", 4}, {"GAA", 5}, {"TTC", 6}, {"GGA", 7}, {"GGC", 8}, {"GGG", 9}, {"CAC", 10},
-	{"ATA", 11}, {"ATC", 12}, {"AAA", 13}, {"CTA", 14}, {"CTC", 15}, {"CTG", 16}, {"CTT", 17}, {"TTA", 18}, {"AAC", 19},
-	{"CCA", 20}, {"CCC", 21}, {"CCG", 22}, {"CAA", 23}, {"AGA", 24}, {"AGG", 25}, {"CGA", 26}, {"CGC", 27}, {"CGG", 28},
-	{"TCA", 29}, {"TCC", 30}, {"TCG", 31}, {"ACA", 32}, {"ACC", 33}, {"ACG", 34}, {"GTA", 35}, {"GTC", 36}, {"GTG", 37},
-	{"TAC", 38}, {"AGC", 39}};
-
 
 
 //------------------------------------------------//
@@ -80,13 +61,17 @@ SequenceSummary::SequenceSummary(const SequenceSummary& other)
 		ncodons[i] = other.ncodons[i];
 	}
 
-	for (unsigned i = 0u; i < 22; i++) {
-		naa[i] = other.naa[i];
-	}
+	naa = other.naa;
 
 	for (unsigned i = 0u; i < 64; i++) {
 		RFPObserved[i] = other.RFPObserved[i];
 	}
+
+	RFP_countPositions = other.RFP_countPositions;
+	RFP_countValues = other.RFP_countValues;
+	RFP_countLength = other.RFP_countLength;
+	RFP_countCodonStart = other.RFP_countCodonStart;
+	RFP_countByCodon = other.RFP_countByCodon;
 }
 
 
@@ -105,11 +90,13 @@ SequenceSummary& SequenceSummary::operator=(const SequenceSummary& rhs)
 		RFPObserved[i] = rhs.RFPObserved[i];
 	}
 
-	for (unsigned i = 0u; i < 22; i++) {
-		naa[i] = rhs.naa[i];
-	}
+	naa = rhs.naa;
 
-	RFP_count = rhs.RFP_count;
+	RFP_countPositions = rhs.RFP_countPositions;
+	RFP_countValues = rhs.RFP_countValues;
+	RFP_countLength = rhs.RFP_countLength;
+	RFP_countCodonStart = rhs.RFP_countCodonStart;
+	RFP_countByCodon = rhs.RFP_countByCodon;
 
 	return *this;
 }
@@ -123,7 +110,9 @@ bool SequenceSummary::operator==(const SequenceSummary& other) const
 	if (this->ncodons != other.ncodons) { match = false; }
 	if (this->codonPositions != other.codonPositions) { match = false; }
 	if (this->RFPObserved != other.RFPObserved) { match = false; }
-	if (this->RFP_count != other.RFP_count) {match = false; }
+	if (this->RFP_countPositions != other.RFP_countPositions) {match = false; }
+	if (this->RFP_countValues != other.RFP_countValues) {match = false; }
+	if (this->RFP_countLength != other.RFP_countLength) {match = false; }
 
 	return match;
 }
@@ -145,7 +134,7 @@ SequenceSummary::~SequenceSummary()
 
 unsigned SequenceSummary::getAACountForAA(std::string aa)
 {
-	return naa[aaToIndex.find(aa)->second];
+	return naa[AAToAAIndex(aa)];
 }
 
 
@@ -185,6 +174,18 @@ void SequenceSummary::setRFPObserved(unsigned codonIndex, unsigned value)
 }
 
 
+/* setCodonCount (NOT EXPOSED)
+ * Arguments: codon index, number of occurrences
+ * Sets the count of a codon and updates the count of its amino acid accordingly. Used to fill the summary from count
+ * data (RFP files), no codon positions are stored.
+*/
+void SequenceSummary::setCodonCount(unsigned codonIndex, unsigned count)
+{
+	naa[CodonEncoding::activeCode().codonToAAIndex(codonIndex)] += count - ncodons[codonIndex];
+	ncodons[codonIndex] = count;
+}
+
+
 std::vector <unsigned> *SequenceSummary::getCodonPositions(std::string codon)
 {
 	unsigned codonIndex = codonToIndex(codon);
@@ -194,17 +195,168 @@ std::vector <unsigned> *SequenceSummary::getCodonPositions(std::string codon)
 
 std::vector <unsigned> *SequenceSummary::getCodonPositions(unsigned index)
 {
+	// summaries filled from counts (setCodonCount) have no positions
+	if (codonPositions.size() < 64) codonPositions.resize(64);
 	return &codonPositions[index];
 }
 
+
+/* getCodonIndexSequence (NOT EXPOSED)
+ * Arguments: vector to store the codon indices in
+ * Rebuilds the sequence as one codon index per position from the codon positions, without parsing the sequence
+ * string. Positions of codons that were not recognized get index 64. Unrecognized codons at the end of the sequence
+ * are not stored.
+*/
+void SequenceSummary::getCodonIndexSequence(std::vector <unsigned> &codonIndices)
+{
+	unsigned length = 0u;
+	for (unsigned i = 0u; i < codonPositions.size(); i++)
+	{
+		if (!codonPositions[i].empty() && codonPositions[i].back() + 1u > length)
+			length = codonPositions[i].back() + 1u;
+	}
+	codonIndices.assign(length, 64u);
+	for (unsigned i = 0u; i < codonPositions.size(); i++)
+	{
+		for (unsigned j = 0u; j < codonPositions[i].size(); j++)
+		{
+			codonIndices[codonPositions[i][j]] = i;
+		}
+	}
+}
+
+/* setCodonPositions (NOT EXPOSED)
+ * Arguments: one codon index per position (as written by getCodonIndexSequence, 64 for unrecognized codons), number of
+ * positions
+ * Restores the codon positions without parsing a sequence. The codon and amino acid counts are not touched, they are
+ * set separately (setCodonCount). Used by Genome::readGenomeCache.
+*/
+void SequenceSummary::setCodonPositions(const unsigned char *codonIndices, unsigned length)
+{
+	std::array<unsigned, 65> numPositions;
+	numPositions.fill(0u);
+	for (unsigned position = 0u; position < length; position++)
+		numPositions[std::min(codonIndices[position], (unsigned char)64u)]++;
+
+	codonPositions.assign(64, std::vector <unsigned>());
+	for (unsigned codonIndex = 0u; codonIndex < 64u; codonIndex++)
+		codonPositions[codonIndex].reserve(numPositions[codonIndex]);
+	for (unsigned position = 0u; position < length; position++)
+	{
+		if (codonIndices[position] < 64u) codonPositions[codonIndices[position]].push_back(position);
+	}
+}
+
+/* getRFP_count (NOT EXPOSED)
+ * Arguments: None
+ * Returns the RFP count of every position, including the positions without counts.
+*/
 std::vector <unsigned> SequenceSummary::getRFP_count()
 {
+	std::vector <unsigned> RFP_count(RFP_countLength, 0u);
+	for (unsigned i = 0u; i < RFP_countPositions.size(); i++)
+	{
+		RFP_count[RFP_countPositions[i]] = RFP_countValues[i];
+	}
 	return RFP_count;
 }
 
+
+/* setRFP_count (NOT EXPOSED)
+ * Arguments: RFP count of every position
+ * Stores the positions with a count > 0.
+*/
 void SequenceSummary::setRFP_count(std::vector <unsigned> arg)
 {
-	RFP_count = arg;
+	RFP_countPositions.clear();
+	RFP_countValues.clear();
+	for (unsigned i = 0u; i < arg.size(); i++)
+	{
+		if (arg[i] == 0u) continue;
+		RFP_countPositions.push_back(i);
+		RFP_countValues.push_back(arg[i]);
+	}
+	RFP_countLength = arg.size();
+	groupRFP_countByCodon();
+}
+
+
+/* setSparseRFP_count (NOT EXPOSED)
+ * Arguments: positions with a count > 0 in increasing order, their counts, number of positions
+ * Takes over the content of both vectors, they are left empty.
+*/
+void SequenceSummary::setSparseRFP_count(std::vector <unsigned> &positions, std::vector <unsigned> &counts, unsigned length)
+{
+	RFP_countPositions.swap(positions);
+	RFP_countValues.swap(counts);
+	positions.clear();
+	counts.clear();
+	RFP_countLength = length;
+	groupRFP_countByCodon();
+}
+
+
+const std::vector <unsigned> &SequenceSummary::getRFP_countPositions() const
+{
+	return RFP_countPositions;
+}
+
+
+const std::vector <unsigned> &SequenceSummary::getRFP_countValues() const
+{
+	return RFP_countValues;
+}
+
+
+unsigned SequenceSummary::getRFP_countLength() const
+{
+	return RFP_countLength;
+}
+
+
+const std::vector <unsigned> &SequenceSummary::getRFP_countCodonStart() const
+{
+	return RFP_countCodonStart;
+}
+
+
+const std::vector <unsigned> &SequenceSummary::getRFP_countByCodon() const
+{
+	return RFP_countByCodon;
+}
+
+
+/* groupRFP_countByCodon (NOT EXPOSED)
+ * Arguments: None
+ * Sorts the per position RFP counts by the codon at their position (counting sort, positions stay in increasing
+ * order within a codon), so a likelihood over the positions of one codon only touches that codon's counts.
+ * Counts at positions without a recognized codon are dropped. Needs the sequence to be set before the counts.
+*/
+void SequenceSummary::groupRFP_countByCodon()
+{
+	RFP_countCodonStart.assign(65, 0u);
+	RFP_countByCodon.clear();
+	if (RFP_countPositions.empty()) return;
+
+	std::vector <unsigned> codonIndices;
+	getCodonIndexSequence(codonIndices);
+	for (unsigned i = 0u; i < RFP_countPositions.size(); i++)
+	{
+		unsigned position = RFP_countPositions[i];
+		if (position < codonIndices.size() && codonIndices[position] < 64u)
+			RFP_countCodonStart[codonIndices[position] + 1u]++;
+	}
+	for (unsigned i = 0u; i < 64u; i++)
+		RFP_countCodonStart[i + 1u] += RFP_countCodonStart[i];
+
+	std::vector <unsigned> next(RFP_countCodonStart.begin(), RFP_countCodonStart.end() - 1);
+	RFP_countByCodon.resize(RFP_countCodonStart[64]);
+	for (unsigned i = 0u; i < RFP_countPositions.size(); i++)
+	{
+		unsigned position = RFP_countPositions[i];
+		if (position < codonIndices.size() && codonIndices[position] < 64u)
+			RFP_countByCodon[next[codonIndices[position]]++] = RFP_countValues[i];
+	}
 }
 
 
@@ -216,13 +368,17 @@ void SequenceSummary::setRFP_count(std::vector <unsigned> arg)
 void SequenceSummary::clear()
 {
 	codonPositions.clear();
-	RFP_count.clear();
+	RFP_countPositions.clear();
+	RFP_countValues.clear();
+	RFP_countLength = 0u;
+	RFP_countCodonStart.clear();
+	RFP_countByCodon.clear();
 	for(unsigned k = 0; k < 64; k++)
 	{
 		ncodons[k] = 0;
 		RFPObserved[k] = 0;
 	}
-	for(unsigned k = 0; k < 22; k++) { naa[k] = 0; }
+	naa.fill(0u);
 }
 
 bool SequenceSummary::processSequence(const std::string& sequence)
@@ -231,31 +387,34 @@ bool SequenceSummary::processSequence(const std::string& sequence)
 	//RFP sets RFPObserved by codon, and not by setting the sequence. This causes
 	//the values to be zero during the MCMC.
 
+	// with the standard code the compiler can fold the lookup tables into the loop
+	if (CodonEncoding::isStandardCode())
+		return countCodons(sequence, CodonEncoding::standardCode);
+	return countCodons(sequence, CodonEncoding::activeCode());
+}
+
+
+inline bool SequenceSummary::countCodons(const std::string& sequence, const GeneticCode& code)
+{
 	bool check = true;
-	int codonID;
-	int aaID;
-	std::string codon;
+	const char *seq = sequence.c_str();
+	unsigned length = sequence.length();
 
-	codonPositions.resize(64);
+	if (length != 0u) codonPositions.resize(64);
 
-	for (unsigned i = 0u; i < sequence.length(); i += 3)
+	for (unsigned i = 0u; i < length; i += 3)
 	{
-		codon = sequence.substr(i, 3);
-		codon[0] = (char)std::toupper(codon[0]);
-		codon[1] = (char)std::toupper(codon[1]);
-		codon[2] = (char)std::toupper(codon[2]);
-
-		codonID = codonToIndex(codon);
-		if (codonID != 64) // if codon id == 64 => codon not found. Ignore, probably N 
+		// reading past the end of a trailing partial codon hits the terminating null, which is not a nucleotide
+		unsigned codonID = i + 2u < length ? code.codonIndex(seq + i) : GeneticCode::invalidCodon;
+		if (codonID != GeneticCode::invalidCodon) // if codon id == 64 => codon not found. Ignore, probably N
 		{
-			aaID = codonToAAIndex(codon);
 			ncodons[codonID]++;
-			naa[aaID]++;
+			naa[code.codonToAAIndex(codonID)]++;
 			codonPositions[codonID].push_back(i / 3);
 		}
 		else
 		{
-			my_printError("WARNING: Codon % not recognized!\n Codon will be ignored!\n", codon);
+			my_printError("WARNING: Codon % not recognized!\n Codon will be ignored!\n", sequence.substr(i, 3));
 			check = false;
 		}
 	}
@@ -271,123 +430,29 @@ bool SequenceSummary::processSequence(const std::string& sequence)
 //--------------------------------------//
 
 
-unsigned SequenceSummary::AAToAAIndex(std::string aa)
+unsigned SequenceSummary::AAToAAIndex(const std::string& aa)
 {
-	return SequenceSummary::aaToIndex.find(aa) -> second;
+	return CodonEncoding::activeCode().aaIndex(aa[0]);
 }
 
 
 void SequenceSummary::AAIndexToCodonRange(unsigned aaIndex, unsigned& startAAIndex, unsigned& endAAIndex, bool forParamVector)
 {
-	std::string aa = indexToAA(aaIndex);
-	AAToCodonRange(aa, startAAIndex, endAAIndex, forParamVector);
+	const GeneticCode& code = CodonEncoding::activeCode();
+	startAAIndex = forParamVector ? code.aaParameterBegin(aaIndex) : code.aaCodonBegin(aaIndex);
+	endAAIndex = forParamVector ? code.aaParameterEnd(aaIndex) : code.aaCodonEnd(aaIndex);
 }
 
-//std::array<unsigned, 2>
-void SequenceSummary::AAToCodonRange(std::string aa, unsigned& startAAIndex, unsigned& endAAIndex, bool forParamVector)
+
+void SequenceSummary::AAToCodonRange(const std::string& aa, unsigned& startAAIndex, unsigned& endAAIndex, bool forParamVector)
 {
 	//aa = (char)std::toupper(aa[0]); CEDRIC: commented out for performance. Put back in if necessary!
-	// switch statement is a lot faster than a chain of if else!
-	//unsigned startAAIndex = 0u;
-	//unsigned endAAIndex = 0u;
-	char AA = aa[0];
-	
-	switch (AA)
+	unsigned aaIndex = AAToAAIndex(aa);
+	AAIndexToCodonRange(aaIndex, startAAIndex, endAAIndex, forParamVector);
+	if (aaIndex == GeneticCode::invalidAA)
 	{
-	case 'A':
-		if (!forParamVector) { startAAIndex = 0; endAAIndex = 4; }
-		else { startAAIndex = 0; endAAIndex = 3; }
-		break;
-	case 'C':
-		if (!forParamVector) { startAAIndex = 4; endAAIndex = 6; }
-		else { startAAIndex = 3; endAAIndex = 4; }
-		break;
-	case 'D':
-		if (!forParamVector) { startAAIndex = 6; endAAIndex = 8; }
-		else { startAAIndex = 4; endAAIndex = 5; }
-		break;
-	case 'E':
-		if (!forParamVector) { startAAIndex = 8; endAAIndex = 10; }
-		else { startAAIndex = 5; endAAIndex = 6; }
-		break;
-	case 'F':
-		if (!forParamVector) { startAAIndex = 10; endAAIndex = 12; }
-		else { startAAIndex = 6; endAAIndex = 7; }
-		break;
-	case 'G':
-		if (!forParamVector) { startAAIndex = 12; endAAIndex = 16; }
-		else { startAAIndex = 7; endAAIndex = 10; }
-		break;
-	case 'H':
-		if (!forParamVector) { startAAIndex = 16; endAAIndex = 18; }
-		else { startAAIndex = 10; endAAIndex = 11; }
-		break;
-	case 'I':
-		if (!forParamVector) { startAAIndex = 18; endAAIndex = 21; }
-		else { startAAIndex = 11; endAAIndex = 13; }
-		break;
-	case 'K':
-		if (!forParamVector) { startAAIndex = 21; endAAIndex = 23; }
-		else { startAAIndex = 13; endAAIndex = 14; }
-		break;
-	case 'L':
-		if (!forParamVector) { startAAIndex = 23; endAAIndex = 29; }
-		else { startAAIndex = 14; endAAIndex = 19; }
-		break;
-	case 'M':
-		if (!forParamVector) { startAAIndex = 29; endAAIndex = 30; }
-		else { startAAIndex = 19; endAAIndex = 19; }
-		break;
-	case 'N':
-		if (!forParamVector) { startAAIndex = 30; endAAIndex = 32; }
-		else { startAAIndex = 19; endAAIndex = 20; }
-		break;
-	case 'P':
-		if (!forParamVector) { startAAIndex = 32; endAAIndex = 36; }
-		else { startAAIndex = 20; endAAIndex = 23; }
-		break;
-	case 'Q':
-		if (!forParamVector) { startAAIndex = 36; endAAIndex = 38; }
-		else { startAAIndex = 23; endAAIndex = 24; }
-		break;
-	case 'R':
-		if (!forParamVector) { startAAIndex = 38; endAAIndex = 44; }
-		else { startAAIndex = 24; endAAIndex = 29; }
-		break;
-	case 'S':
-		if (!forParamVector) { startAAIndex = 44; endAAIndex = 48; }
-		else { startAAIndex = 29; endAAIndex = 32; }
-		break;
-	case 'T':
-		if (!forParamVector) { startAAIndex = 48; endAAIndex = 52; }
-		else { startAAIndex = 32; endAAIndex = 35; }
-		break;
-	case 'V':
-		if (!forParamVector) { startAAIndex = 52; endAAIndex = 56; }
-		else { startAAIndex = 35; endAAIndex = 38; }
-		break;
-	case 'W':
-		if (!forParamVector) { startAAIndex = 56; endAAIndex = 57; }
-		else { startAAIndex = 38; endAAIndex = 38; }
-		break;
-	case 'Y':
-		if (!forParamVector) { startAAIndex = 57; endAAIndex = 59; }
-		else { startAAIndex = 38; endAAIndex = 39; }
-		break;
-	case 'Z':
-		if (!forParamVector) { startAAIndex = 59; endAAIndex = 61; }
-		else { startAAIndex = 39; endAAIndex = 40; }
-		break;
-	case 'X':
-		if (!forParamVector) { startAAIndex = 61; endAAIndex = 64; }
-		else { startAAIndex = 40; endAAIndex = 40; }
-		break;
-	default: // INVALID AA
-		startAAIndex = 0;
-		endAAIndex = 0;
-		my_print("%\n", AA);
+		my_print("%\n", aa[0]);
 		my_printError("Invalid AA given, returning 0,0\n");
-		break;
 	}
 }
 
@@ -415,102 +480,25 @@ std::vector<std::string> SequenceSummary::AAToCodon(std::string aa, bool forPara
 }
 
 
-std::string SequenceSummary::codonToAA(std::string& codon)
-{
-	codon[0] = (char) std::toupper(codon[0]);
-	codon[1] = (char) std::toupper(codon[1]);
-	codon[2] = (char) std::toupper(codon[2]);
-	//std::transform(codon.begin(), codon.end(), codon.begin(), ::toupper);
-	std::string aa = "#";
-	//Phenylalanine
-	if(!codon.compare("TTT") || !codon.compare("UUU") || !codon.compare("TTC") || !codon.compare("UUC")) aa = "F";
-		//Leucine
-	else if(!codon.compare("TTA") || !codon.compare("UUA") || !codon.compare("TTG") || !codon.compare("UUG") ||
-			!codon.compare("CTT") || !codon.compare("CUU") || !codon.compare("CTC") || !codon.compare("CUC") ||
-			!codon.compare("CTA") || !codon.compare("CUA") || !codon.compare("CTG") || !codon.compare("CUG")) aa = "L";
-		//Isoleucine
-	else if(!codon.compare("ATT") || !codon.compare("AUU") || !codon.compare("ATC") || !codon.compare("AUC") ||
-			!codon.compare("ATA") || !codon.compare("AUA")) aa = "I";
-		//Methionine
-	else if(!codon.compare("ATG") || !codon.compare("AUG")) aa = "M";
-		//Valine
-	else if(!codon.compare("GTT") || !codon.compare("GUU") || !codon.compare("GTC") || !codon.compare("GUC") ||
-			!codon.compare("GTA") || !codon.compare("GUA") || !codon.compare("GTG") || !codon.compare("GUG")) aa = "V";
-		//Serine4
-	else if(!codon.compare("TCT") || !codon.compare("UCU") || !codon.compare("TCC") || !codon.compare("UCC") ||
-			!codon.compare("TCA") || !codon.compare("UCA") || !codon.compare("TCG") || !codon.compare("UCG")) aa = "S";
-		//Proline
-	else if(!codon.compare("CCT") || !codon.compare("CCU") || !codon.compare("CCC") ||
-			!codon.compare("CCA") || !codon.compare("CCG")) aa = "P";
-		//Threonine
-	else if(!codon.compare("ACT") || !codon.compare("ACU") || !codon.compare("ACC") ||
-			!codon.compare("ACA") || !codon.compare("ACG")) aa = "T";
-		//Alanine
-	else if(!codon.compare("GCT") || !codon.compare("GCU") || !codon.compare("GCC") ||
-			!codon.compare("GCA") || !codon.compare("GCG")) aa = "A";
-		//Tyrosine
-	else if(!codon.compare("TAT") || !codon.compare("UAU") || !codon.compare("TAC") || !codon.compare("UAC")) aa = "Y";
-		//Histidine
-	else if(!codon.compare("CAT") || !codon.compare("CAU") || !codon.compare("CAC")) aa = "H";
-		//Glutamine
-	else if(!codon.compare("CAA") || !codon.compare("CAG")) aa = "Q";
-		//Asparagine
-	else if(!codon.compare("AAT") || !codon.compare("AAU") || !codon.compare("AAC")) aa = "N";
-		//Lysine
-	else if(!codon.compare("AAA") || !codon.compare("AAG")) aa = "K";
-		//Aspartic Acid
-	else if(!codon.compare("GAT") || !codon.compare("GAU") || !codon.compare("GAC")) aa = "D";
-		//Glutamic Acid
-	else if(!codon.compare("GAA") || !codon.compare("GAG")) aa = "E";
-		//Cysteine
-	else if(!codon.compare("TGT") || !codon.compare("TAT") || !codon.compare("TGC") || !codon.compare("UGC")) aa = "C";
-		//Tryptophan
-	else if(!codon.compare("TGG") || !codon.compare("UGG")) aa = "W";
-		//Arginine
-	else if(!codon.compare("CGT") || !codon.compare("CGU") || !codon.compare("CGC") || !codon.compare("CGA") ||
-			!codon.compare("CGG") || !codon.compare("AGA") || !codon.compare("AGG")) aa = "R";
-		//Serine2
-	else if(!codon.compare("AGT") || !codon.compare("AGU") || !codon.compare("AGC")) aa = SequenceSummary::Ser2;
-		//Glycine
-	else if(!codon.compare("GGT") || !codon.compare("GGU") || !codon.compare("GGC")  || !codon.compare("GGC") ||
-			!codon.compare("GGA")  || !codon.compare("GGG")) aa = "G";
-		//Stop
-	else if (!codon.compare("TAA") || !codon.compare("UAA") || !codon.compare("TAG") || !codon.compare("UAG") ||
-			 !codon.compare("TGA") || !codon.compare("UGA")) aa = "X";
-
-	return aa;
-}
-
-
-unsigned SequenceSummary::codonToIndex(std::string& codon, bool forParamVector)
-{
-	unsigned i = 0;
-	codon[0] = (char) std::toupper(codon[0]);
-	codon[1] = (char) std::toupper(codon[1]);
-	codon[2] = (char) std::toupper(codon[2]);
-	if (((codon[0] != 'A') && (codon[0] != 'C') && (codon[0] != 'G') && (codon[0] != 'T')) ||
-		((codon[1] != 'A') && (codon[1] != 'C') && (codon[1] != 'G') && (codon[1] != 'T')) ||
-		((codon[2] != 'A') && (codon[2] != 'C') && (codon[2] != 'G') && (codon[2] != 'T')))
-	{
-		i = 64;
-	}
-	else 
-	{
-		if(forParamVector)
-		{
-			i = SequenceSummary::codonToIndexWithoutReference.find(codon) -> second;
-		}else{
-			i = SequenceSummary::codonToIndexWithReference.find(codon) -> second;
-		}
-	}
-	return i;
+std::string SequenceSummary::codonToAA(const std::string& codon)
+{
+	unsigned aaIndex = codonToAAIndex(codon);
+	return aaIndex == GeneticCode::invalidAA ? "#" : AminoAcidArray[aaIndex];
 }
 
 
-unsigned SequenceSummary::codonToAAIndex(std::string& codon)
+unsigned SequenceSummary::codonToIndex(const std::string& codon, bool forParamVector)
 {
-	std::string aa = codonToAA(codon);
-	return SequenceSummary::aaToIndex.find(aa) -> second;
+	const GeneticCode& code = CodonEncoding::activeCode();
+	unsigned i = codon.length() < 3 ? GeneticCode::invalidCodon : code.codonIndex(codon.c_str());
+	// reference codons have no parameter, they are reported as not found like invalid codons
+	return forParamVector ? code.codonToParameterIndex(i) : i;
+}
+
+
+unsigned SequenceSummary::codonToAAIndex(const std::string& codon)
+{
+	return CodonEncoding::activeCode().codonToAAIndex(codonToIndex(codon));
 }
 
 
@@ -526,87 +514,57 @@ std::string SequenceSummary::indexToCodon(unsigned index, bool forParamVector)
 }
 
 
-unsigned SequenceSummary::GetNumCodonsForAA(std::string& aa, bool forParamVector)
+unsigned SequenceSummary::GetNumCodonsForAA(const std::string& aa, bool forParamVector)
 {
-	unsigned ncodon = 0;
-	char AA = aa[0];
-	switch (AA)
-	{
-	case 'A':
-		ncodon = 4;
-		break;
-	case 'C':
-		ncodon = 2;
-		break;
-	case 'D':
-		ncodon = 2;
-		break;
-	case 'E':
-		ncodon = 2;
-		break;
-	case 'F':
-		ncodon = 2;
-		break;
-	case 'G':
-		ncodon = 4;
-		break;
-	case 'H':
-		ncodon = 2;
-		break;
-	case 'I':
-		ncodon = 3;
-		break;
-	case 'K':
-		ncodon = 2;
-		break;
-	case 'L':
-		ncodon = 6;
-		break;
-	case 'M':
-		ncodon = 1;
-		break;
-	case 'N':
-		ncodon = 2;
-		break;
-	case 'P':
-		ncodon = 4;
-		break;
-	case 'Q':
-		ncodon = 2;
-		break;
-	case 'R':
-		ncodon = 6;
-		break;
-	case 'S':
-		ncodon = 4;
-		break;
-	case 'T':
-		ncodon = 4;
-		break;
-	case 'V':
-		ncodon = 4;
-		break;
-	case 'W':
-		ncodon = 1;
-		break;
-	case 'Y':
-		ncodon = 2;
-		break;
-	case 'Z':
-		ncodon = 2;
-		break;
-	case 'X':
-		ncodon = 3;
-		break;
-		default: // INVALID AA
+	unsigned aaIndex = AAToAAIndex(aa);
+	if (aaIndex == GeneticCode::invalidAA)
+		my_printError("WARNING: Invalid Amino Acid given (%), returning 0,0\n", aa);
+	return CodonEncoding::activeCode().numCodonsForAA(aaIndex, forParamVector);
+}
 
 
-		my_printError("WARNING: Invalid Amino Acid given (%), returning 0,0\n", aa);
+unsigned SequenceSummary::numAminoAcids()
+{
+	return CodonEncoding::activeCode().numAA;
+}
+
+
+unsigned SequenceSummary::numParameterCodons()
+{
+	return CodonEncoding::activeCode().numParameterCodons;
+}
 
 
-		break;
+unsigned SequenceSummary::numSenseCodons()
+{
+	return CodonEncoding::activeCode().numSenseCodons();
+}
+
+
+/* setGeneticCode (NOT EXPOSED)
+ * Arguments: genetic code
+ * Selects the genetic code used by all lookups and updates the amino acid and codon names to its order. Genomes have
+ * to be read after this, parameters and models set up after this.
+*/
+void SequenceSummary::setGeneticCode(const GeneticCode& code)
+{
+	CodonEncoding::setActiveCode(code);
+	const GeneticCode& active = CodonEncoding::activeCode();
+	AminoAcidArray.resize(active.numAA);
+	for (unsigned a = 0u; a < active.numAA; a++)
+	{
+		AminoAcidArray[a] = std::string(1, active.aaLetters[a]);
+	}
+	codonArray.resize(GeneticCode::numCodons);
+	for (unsigned i = 0u; i < GeneticCode::numCodons; i++)
+	{
+		codonArray[i] = active.codonNames[i];
+	}
+	codonArrayParameter.resize(active.numParameterCodons);
+	for (unsigned i = 0u; i < active.numParameterCodons; i++)
+	{
+		codonArrayParameter[i] = active.codonNames[active.parameterToCodon[i]];
 	}
-	return (forParamVector ? (ncodon - 1) : ncodon);
 }
 
 
@@ -625,6 +583,22 @@ std::vector<std::string> SequenceSummary::aminoAcids()
 }
 
 
+/* aminoAcidsWithParameters (NOT EXPOSED)
+ * Arguments: None
+ * Amino acids of the active genetic code that have codon specific parameters, the default group list of the models.
+*/
+std::vector<std::string> SequenceSummary::aminoAcidsWithParameters()
+{
+	const GeneticCode& code = CodonEncoding::activeCode();
+	std::vector<std::string> RV;
+	for (unsigned a = 0u; a < code.numAA; a++)
+	{
+		if (code.numCodonsForAA(a, true) > 0u) RV.push_back(AminoAcidArray[a]);
+	}
+	return RV;
+}
+
+
 std::vector<std::string> SequenceSummary::codons()
 {
 	std::vector<std::string> RV;
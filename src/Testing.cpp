@@ -1,10 +1,44 @@
 #include "include/Testing.h"
+#include <cstring>
+#include <cstdio>
 
 #ifndef STANDALONE
 #include <Rcpp.h>
 using namespace Rcpp;
 #endif
 
+
+//Allocation counting for testMCMCAllocations. Replacing the global allocation functions affects the whole
+//program, so it is only compiled in when COUNT_ALLOCATIONS is defined.
+#ifdef COUNT_ALLOCATIONS
+#include <new>
+static bool countAllocations = false;
+static unsigned long allocationCount = 0ul;
+
+void* operator new(std::size_t size)
+{
+	if (countAllocations) allocationCount++;
+	void *ptr = std::malloc(size == 0 ? 1 : size);
+	if (ptr == NULL) throw std::bad_alloc();
+	return ptr;
+}
+
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+#endif
+
 int testSequenceSummary()
 {
     SequenceSummary SS("ATGCTCATTCTCACTGCTGCCTCGTAG");
@@ -1368,6 +1402,9 @@ int testGenome(std::string testFileDir)
      * getGenomeForGeneIndicies
      * readFasta
      * readPANSEFile
+     * writePANSEFile
+     * writeGenomeCache
+     * readGenomeCache
      * readObservedPhiValues
     */
 
@@ -1407,6 +1444,34 @@ int testGenome(std::string testFileDir)
         globalError = 1;
     }
 
+    // subsets share the genes of the genome, changing a subset copies its genes first
+    uVector = {3, 1};
+    Genome subset = genome.getGenomeForGeneIndicies(uVector, true);
+    if (!genome.isGeneStorageShared(true) || !subset.isGeneStorageShared(true)
+        || subset.getGenomeSize(true) != 2 || subset.getGenomeSize(false) != 0
+        || &subset.getGene(0, true) != &genome.getGene(3, true)) {
+        std::cerr << "Error in getGenomeForGeneIndicies: subset does not share the genes of the genome.\n";
+        error = 1;
+        globalError = 1;
+    }
+
+    uVector = {1};
+    Genome subsetOfSubset = subset.getGenomeForGeneIndicies(uVector, true);
+    if (&subsetOfSubset.getGene(0, true) != &genome.getGene(1, true)) {
+        std::cerr << "Error in getGenomeForGeneIndicies: subset of a subset does not refer to the genome.\n";
+        error = 1;
+        globalError = 1;
+    }
+
+    subset.addGene(g1, true);
+    if (subset.isGeneStorageShared(true) || subset.getGenomeSize(true) != 3 || genome.getGenomeSize(true) != 4
+        || !(subset.getGene(0, true) == s4) || !(subset.getGene(1, true) == s2) || !(subset.getGene(2, true) == g1)
+        || !(genome.getGene(3, true) == s4)) {
+        std::cerr << "Error in getGenomeForGeneIndicies: changing a subset changed the genome.\n";
+        error = 1;
+        globalError = 1;
+    }
+
     if (!error)
         std::cout << "Genome getGenomeForGeneIndicies --- Pass\n";
     else
@@ -1496,9 +1561,10 @@ int testGenome(std::string testFileDir)
     file = testFileDir + "/" + "testReadRFP.csv";
     genome.readRFPFile(file);
 
-    Gene rfp1("GCAGCC", "TEST001", "No description for RFP Model");
-    Gene rfp2("GCGTTTTTT", "TEST002", "No description for RFP Model");
-    Gene rfp3("GCTATGATGATGATGATG", "TEST003", "No description for RFP Model");
+    // RFP genes only have codon and RFP counts, no sequence or codon positions
+    Gene rfp1("", "TEST001", "No description for RFP Model");
+    Gene rfp2("", "TEST002", "No description for RFP Model");
+    Gene rfp3("", "TEST003", "No description for RFP Model");
 
     // need to access the public SequenceSummary of a gene to access codonIndex
     // in order to use then modify setRFPObserved
@@ -1506,26 +1572,32 @@ int testGenome(std::string testFileDir)
     std::string codon = "GCA";
     unsigned index = SequenceSummary::codonToIndex(codon);
     rfp1.geneData.setRFPObserved(index, 0);
+    rfp1.geneData.setCodonCount(index, 1);
 
     codon = "GCC";
     index = SequenceSummary::codonToIndex(codon);
     rfp1.geneData.setRFPObserved(index, 5);
+    rfp1.geneData.setCodonCount(index, 1);
 
     codon = "GCG";
     index = SequenceSummary::codonToIndex(codon);
     rfp2.geneData.setRFPObserved(index, 2);
+    rfp2.geneData.setCodonCount(index, 1);
 
     codon = "TTT";
     index = SequenceSummary::codonToIndex(codon);
     rfp2.geneData.setRFPObserved(index, 4);
+    rfp2.geneData.setCodonCount(index, 2);
 
     codon = "GCT";
     index = SequenceSummary::codonToIndex(codon);
     rfp3.geneData.setRFPObserved(index, 0);
+    rfp3.geneData.setCodonCount(index, 1);
 
     codon = "ATG";
     index = SequenceSummary::codonToIndex(codon);
     rfp3.geneData.setRFPObserved(index, 13);
+    rfp3.geneData.setCodonCount(index, 5);
 
     testGenome.addGene(rfp1, false);
     testGenome.addGene(rfp2, false);
@@ -1625,6 +1697,57 @@ int testGenome(std::string testFileDir)
     //------ writePANSEFile Function ------//
     //-------------------------------------//
 
+    // Write the genome read in by readPANSEFile to a file, read it in
+    // again, and then compare its validity again.
+    testGenome.clear();
+
+    file = testFileDir + "/" + "testWritePANSE.csv";
+    genome.writePANSEFile(file, false);
+    testGenome.readPANSEFile(file);
+
+    if (genome == testGenome)
+        std::cout << "Genome writePANSEFile --- Pass\n";
+    else
+    {
+        std::cerr << "Error in writePANSEFile. Genomes are not equivalent.\n";
+        globalError = 1;
+    }
+
+    //--------------------------------------------------------//
+    //------ writeGenomeCache and readGenomeCache Functions ------//
+    //--------------------------------------------------------//
+
+    // Cache the genome read by readPANSEFile, read the cache back in and
+    // compare. A cache is only used while its source files are unchanged.
+    testGenome.clear();
+
+    file = testFileDir + "/" + "testGenomeCache.ribgenome";
+    std::vector <std::string> sourceFiles(1, testFileDir + "/" + "readPANSE.csv");
+    genome.writeGenomeCache(file, sourceFiles);
+
+    if (!testGenome.readGenomeCache(file, sourceFiles) || !(genome == testGenome))
+    {
+        std::cerr << "Error in readGenomeCache. Genomes are not equivalent.\n";
+        error = 1;
+        globalError = 1;
+    }
+
+    // The cache does not belong to these source files, so it must be rejected
+    // and leave the genome untouched.
+    sourceFiles[0] = testFileDir + "/" + "testReadRFP.csv";
+    if (testGenome.readGenomeCache(file, sourceFiles) || !(genome == testGenome))
+    {
+        std::cerr << "Error in readGenomeCache. A stale cache was used.\n";
+        error = 1;
+        globalError = 1;
+    }
+
+    if (!error)
+        std::cout << "Genome writeGenomeCache and readGenomeCache --- Pass\n";
+    else
+        error = 0; //Reset for next function.
+
+
     /* readObservedPhiValues Testing Function
      *
      * Compares a genome with the readObservedPhiValues function's created genome.
@@ -1760,6 +1883,1661 @@ int testUtility()
 }
 
 
+/* fillTestGenome
+ * Adds numGenes genes of 150 codons with a deterministic codon usage and RFP counts to genome. Used by the tests
+ * running MCMC updates, which need a genome but do not depend on its content.
+*/
+static void fillTestGenome(Genome &genome, unsigned numGenes)
+{
+	const char *codons[] = {"GCA", "GCC", "GCG", "GCT", "TGC", "TGT", "GAC", "GAT", "GAA", "GAG", "TTC", "TTT", "GGA",
+		"GGC", "GGG", "GGT", "CAC", "CAT", "ATA", "ATC", "ATT", "AAA", "AAG", "CTA", "CTC", "CTG", "CTT", "TTA", "TTG",
+		"AAC", "AAT", "CCA", "CCC", "CCG", "CCT", "CAA", "CAG", "AGA", "AGG", "CGA", "CGC", "CGG", "CGT", "TCA", "TCC",
+		"TCG", "TCT", "ACA", "ACC", "ACG", "ACT", "GTA", "GTC", "GTG", "GTT", "TAC", "TAT", "AGC", "AGT", "ATG", "TGG"};
+
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		std::string seq = "ATG";
+		for (unsigned j = 0u; j < 150u; j++)
+		{
+			seq += codons[(i * 7u + j * 13u + (j * j) % 11u) % 61u];
+		}
+		seq += "TAA";
+		Gene gene(seq, "gene" + std::to_string(i), "test gene");
+		for (unsigned j = 0u; j < 61u; j++)
+		{
+			gene.geneData.setRFPObserved(j, (i + j) % 3u == 0u ? (i + j) % 17u : 0u);
+		}
+		genome.addGene(gene);
+	}
+}
+
+
+/* testMCMCAllocations
+ * Runs a short MCMC chain for the ROC, FONSE and RFP models as warm-up, then calls the codon specific parameter,
+ * hyper parameter and synthesis rate updates of further iterations while counting heap allocations. Any allocation
+ * in these steady state iterations is an error. Needs COUNT_ALLOCATIONS, otherwise the test is skipped.
+*/
+int testMCMCAllocations()
+{
+	int globalError = 0;
+#ifndef COUNT_ALLOCATIONS
+	std::cout << "MCMC allocations --- Skipped, compile with COUNT_ALLOCATIONS to count allocations\n";
+#else
+	const unsigned numGenes = 20u;
+	const unsigned numMixtures = 2u;
+	const unsigned samples = 10u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+
+	ROCParameter rocParameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	rocParameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel rocModel;
+	rocModel.setParameter(rocParameter);
+
+	FONSEParameter fonseParameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	fonseParameter.InitializeSynthesisRate(genome, 1.0);
+	FONSEModel fonseModel;
+	fonseModel.setParameter(fonseParameter);
+
+	RFPParameter rfpParameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	rfpParameter.InitializeSynthesisRate(genome, 1.0);
+	RFPModel rfpModel;
+	rfpModel.setParameter(rfpParameter);
+
+	Model *models[] = {&rocModel, &fonseModel, &rfpModel};
+	const char *modelNames[] = {"ROC", "FONSE", "RFP"};
+	for (unsigned m = 0u; m < 3u; m++)
+	{
+		Model &model = *models[m];
+		MCMCAlgorithm mcmc(samples, 1u, 5u, true, true, true);
+		mcmc.run(genome, model, 1u, 0u); // warm-up, sizes all scratch space
+
+		allocationCount = 0ul;
+		countAllocations = true;
+		for (unsigned iteration = 1u; iteration <= samples; iteration++)
+		{
+			model.proposeCodonSpecificParameter();
+			mcmc.acceptRejectCodonSpecificParameter(genome, model, iteration);
+			model.updateGibbsSampledHyperParameters(genome);
+			model.proposeHyperParameters();
+			mcmc.acceptRejectHyperParameter(genome, model, iteration);
+			model.proposeSynthesisRateLevels();
+			mcmc.acceptRejectSynthesisRateLevelForAllGenes(genome, model, iteration);
+		}
+		countAllocations = false;
+
+		if (allocationCount != 0ul)
+		{
+			std::cerr << "Error in MCMC iteration for " << modelNames[m] << ": " << allocationCount
+				<< " allocations after warm-up.\n";
+			globalError = 1;
+		}
+		else
+			std::cout << "MCMC allocations " << modelNames[m] << " --- Pass\n";
+	}
+#endif
+	return globalError;
+}
+
+
+/* testMixtureLogLikelihoodRatios
+ * Moves the codon specific parameters and synthesis rates of a ROC model with four mixture elements away from their
+ * initial values, then checks that calculateLogLikelihoodRatiosPerGene, which shares terms between mixture elements
+ * with the same mutation or selection category, gives the same values as calculateLogLikelihoodRatioPerGene called
+ * for every mixture element. Done for all three mutation/selection states.
+*/
+int testMixtureLogLikelihoodRatios()
+{
+	int globalError = 0;
+	const unsigned numGenes = 20u;
+	const unsigned numMixtures = 4u;
+	const char *states[] = {"allUnique", "mutationShared", "selectionShared"};
+
+	Genome genome;
+	fillTestGenome(genome, numGenes - 1);
+	// a gene without most amino acids, to check that the right ones are skipped
+	Gene shortGene("ATGAGCAGTAGCGCAGCCAAGTAA", "short", "test gene");
+	genome.addGene(shortGene);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+
+	for (unsigned s = 0u; s < 3u; s++)
+	{
+		ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, states[s]);
+		parameter.InitializeSynthesisRate(genome, 1.0);
+		ROCModel model;
+		model.setParameter(parameter);
+
+		for (unsigned step = 0u; step < 5u; step++)
+		{
+			model.proposeCodonSpecificParameter();
+			for (unsigned g = 0u; g < model.getGroupListSize(); g++)
+			{
+				model.updateCodonSpecificParameter(model.getGrouping(g));
+			}
+		}
+		model.proposeSynthesisRateLevels();
+
+		std::vector<unsigned> mixtureElements;
+		for (unsigned k = 0u; k < model.getNumSynthesisRateCategories(); k++)
+		{
+			std::vector<unsigned> elements = model.getMixtureElementsOfSelectionCategory(k);
+			mixtureElements.insert(mixtureElements.end(), elements.begin(), elements.end());
+		}
+
+		unsigned numMixtureTerms = mixtureElements.size();
+		std::vector<double> shared(numMixtureTerms * 5);
+		std::vector<double> single(numMixtureTerms * 5);
+		model.prepareLogLikelihoodRatiosPerGene(mixtureElements, 1u);
+
+		bool error = false;
+		for (unsigned i = 0u; i < numGenes && !error; i++)
+		{
+			model.calculateLogLikelihoodRatiosPerGene(genome.getGene(i), i, mixtureElements, &shared[0]);
+			for (unsigned n = 0u; n < numMixtureTerms; n++)
+			{
+				model.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, mixtureElements[n], &single[n * 5]);
+			}
+			for (unsigned j = 0u; j < numMixtureTerms * 5; j++)
+			{
+				if (std::fabs(shared[j] - single[j]) > 1e-8 * std::max(1.0, std::fabs(single[j])))
+				{
+					std::cerr << "Error in calculateLogLikelihoodRatiosPerGene for " << states[s] << ": gene " << i
+						<< ", value " << j << " is " << shared[j] << ", should be " << single[j] << ".\n";
+					error = true;
+					globalError = 1;
+					break;
+				}
+			}
+		}
+		if (!error)
+			std::cout << "Mixture log likelihood ratios " << states[s] << " --- Pass\n";
+	}
+	return globalError;
+}
+
+
+/* testRFPLikelihoodCache
+ * RFPModel keeps the likelihood of every gene and codon between codon specific parameter updates and recomputes a cell
+ * when phi, the mixture assignment or the parameters of its codon changed. Runs a sequence of proposals, accepted and
+ * rejected codons, new synthesis rates, mixture reassignments and parameters set from outside, and checks after each
+ * step that the cached log likelihood ratios are identical to those of a new model without a cache. Every other step
+ * uses calculateLogLikelihoodRatioPerGroupingPerCategory instead of the single pass over all codons.
+*/
+int testRFPLikelihoodCache()
+{
+	int globalError = 0;
+	const unsigned numGenes = 24u;
+	const unsigned numMixtures = 2u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+	RFPParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	parameter.InitializeSynthesisRate(genome, 1.0);
+	RFPModel model;
+	model.setParameter(parameter);
+	unsigned numGroupings = model.getGroupListSize();
+
+	bool error = false;
+	for (unsigned step = 0u; step < 8u && !error; step++)
+	{
+		model.proposeCodonSpecificParameter();
+		std::vector<double> cached(numGroupings);
+		if (step % 2u == 0u)
+		{
+			model.calculateLogLikelihoodRatioForAllGroupings(genome, cached);
+		}
+		else
+		{
+			for (unsigned g = 0u; g < numGroupings; g++)
+			{
+				model.calculateLogLikelihoodRatioPerGroupingPerCategory(model.getGrouping(g), genome, cached[g]);
+			}
+		}
+
+		RFPModel uncachedModel;
+		uncachedModel.setParameter(parameter);
+		std::vector<double> uncached;
+		uncachedModel.calculateLogLikelihoodRatioForAllGroupings(genome, uncached);
+
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			// the single pass adds up the genes in the same order as the uncached model, the per codon reduction may not
+			double tolerance = step % 2u == 0u ? 0.0 : 1e-10 * std::max(1.0, std::fabs(uncached[g]));
+			if (!(std::fabs(cached[g] - uncached[g]) <= tolerance))
+			{
+				std::cerr << "Error in the RFP likelihood cache after step " << step << ": codon " << model.getGrouping(g)
+					<< " has log likelihood ratio " << cached[g] << ", should be " << uncached[g] << ".\n";
+				error = true;
+				break;
+			}
+		}
+
+		// accept a third of the codons, the rest is rejected
+		for (unsigned g = step % 3u; g < numGroupings; g += 3u)
+		{
+			model.updateCodonSpecificParameter(model.getGrouping(g));
+		}
+
+		// new synthesis rates for some genes
+		model.proposeSynthesisRateLevels();
+		for (unsigned i = step % 4u; i < numGenes; i += 4u)
+		{
+			model.updateSynthesisRate(i, model.getMixtureAssignment(i));
+		}
+
+		// move some genes to the other mixture element
+		for (unsigned i = step % 5u; i < numGenes; i += 5u)
+		{
+			model.setMixtureAssignment(i, (model.getMixtureAssignment(i) + 1u) % numMixtures);
+		}
+
+		// parameters set outside of updateCodonSpecificParameter, as when initializing or reading a restart file
+		std::string codon = model.getGrouping((step * 7u) % numGroupings);
+		if (step % 2u == 0u)
+			parameter.initAlpha(parameter.getParameterForCategory(0u, RFPParameter::alp, codon, false) * 1.5, 0u, codon);
+		else
+			parameter.initLambdaPrime(parameter.getParameterForCategory(1u, RFPParameter::lmPri, codon, false) * 0.5, 1u, codon);
+	}
+	if (error)
+		globalError = 1;
+	else
+		std::cout << "RFP likelihood cache --- Pass\n";
+	return globalError;
+}
+
+
+/* testPANSELogLikelihoodRatios
+ * PANSEModel only visits the positions with an RFP count and accounts for the others through the codon count. Compares
+ * its codon specific log likelihood ratios (single pass over all codons and per codon) and the current log likelihood
+ * of each gene with a dense reference that evaluates the negative binomial at every position of every gene.
+*/
+int testPANSELogLikelihoodRatios()
+{
+	int globalError = 0;
+	const unsigned numGenes = 40u;
+	const unsigned numMixtures = 2u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		// mostly empty positions, some ones and a few larger counts, the start and stop codon included
+		Gene &gene = genome.getGene(i);
+		std::vector<unsigned> counts(152u, 0u);
+		for (unsigned j = 0u; j < counts.size(); j++)
+		{
+			unsigned draw = (i * 31u + j * 17u + (j * j) % 7u) % 23u;
+			counts[j] = draw < 15u ? 0u : (draw < 20u ? 1u : draw - 18u);
+		}
+		gene.addRFP_count(counts);
+	}
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+	PANSEParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	parameter.InitializeSynthesisRate(genome, 1.0);
+	PANSEModel model;
+	model.setParameter(parameter);
+	unsigned numGroupings = model.getGroupListSize();
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		std::string codon = model.getGrouping(g);
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			parameter.initAlpha(0.5 + 0.1 * ((g + k) % 13u), k, codon);
+			parameter.initLambdaPrime(0.3 + 0.05 * ((g * 3u + k) % 17u), k, codon);
+		}
+	}
+	model.proposeCodonSpecificParameter();
+
+	// dense reference: every position of every gene, grouped by the codon at the position
+	std::vector<unsigned> codonToGrouping(65u, numGroupings);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		codonToGrouping[SequenceSummary::codonToIndex(model.getGrouping(g))] = g;
+	}
+	std::vector<double> referenceRatios(numGroupings, 0.0);
+	std::vector<double> referenceLogLikelihood(numGenes, 0.0);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		SequenceSummary &geneData = genome.getGene(i).geneData;
+		std::vector<unsigned> codonIndices;
+		geneData.getCodonIndexSequence(codonIndices);
+		std::vector<unsigned> counts = geneData.getRFP_count();
+		unsigned mixtureElement = parameter.getMixtureAssignment(i);
+		unsigned alphaCategory = parameter.getMutationCategory(mixtureElement);
+		unsigned lambdaPrimeCategory = parameter.getSelectionCategory(mixtureElement);
+		double phi = parameter.getSynthesisRate(i, parameter.getSynthesisRateCategory(mixtureElement), false);
+		for (unsigned j = 0u; j < codonIndices.size(); j++)
+		{
+			unsigned g = codonToGrouping[codonIndices[j]];
+			if (g == numGroupings) continue;
+			double count = j < counts.size() ? counts[j] : 0.0;
+			double logLikelihood[2];
+			for (unsigned proposed = 0u; proposed < 2u; proposed++)
+			{
+				double alpha = parameter.getParameterForCategory(alphaCategory, PANSEParameter::alp, g, proposed == 1u);
+				double lambdaPrime = parameter.getParameterForCategory(lambdaPrimeCategory, PANSEParameter::lmPri, g,
+					proposed == 1u);
+				logLikelihood[proposed] = std::lgamma(alpha + count) - std::lgamma(alpha) + count * std::log(phi / (lambdaPrime + phi))
+					+ alpha * std::log(lambdaPrime / (lambdaPrime + phi));
+			}
+			referenceRatios[g] += logLikelihood[1] - logLikelihood[0];
+			referenceLogLikelihood[i] += logLikelihood[0];
+		}
+	}
+
+	std::vector<double> ratios;
+	model.calculateLogLikelihoodRatioForAllGroupings(genome, ratios);
+	for (unsigned g = 0u; g < numGroupings; g++)
+	{
+		double ratio;
+		model.calculateLogLikelihoodRatioPerGroupingPerCategory(model.getGrouping(g), genome, ratio);
+		double tolerance = 1e-10 * std::max(1.0, std::fabs(referenceRatios[g]));
+		if (!(std::fabs(ratios[g] - referenceRatios[g]) <= tolerance && std::fabs(ratio - referenceRatios[g]) <= tolerance))
+		{
+			std::cerr << "Error in PANSE codon specific log likelihood ratios: codon " << model.getGrouping(g) << " gives "
+				<< ratios[g] << " (all codons) and " << ratio << " (per codon), should be " << referenceRatios[g] << ".\n";
+			globalError = 1;
+		}
+	}
+
+	model.proposeSynthesisRateLevels();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		unsigned mixtureElement = parameter.getMixtureAssignment(i);
+		double phi = parameter.getSynthesisRate(i, parameter.getSynthesisRateCategory(mixtureElement), false);
+		double stdDevSynthesisRate = parameter.getStdDevSynthesisRate(0u);
+		double logPhiProbability = Parameter::densityLogNorm(phi, -(stdDevSynthesisRate * stdDevSynthesisRate) / 2,
+			stdDevSynthesisRate, true);
+		double logProbabilityRatio[5];
+		model.calculateLogLikelihoodRatioPerGene(genome.getGene(i), i, mixtureElement, logProbabilityRatio);
+		double logLikelihood = logProbabilityRatio[3] - logPhiProbability;
+		if (!(std::fabs(logLikelihood - referenceLogLikelihood[i]) <= 1e-10 * std::max(1.0, std::fabs(referenceLogLikelihood[i]))))
+		{
+			std::cerr << "Error in PANSE log likelihood of gene " << i << ": " << logLikelihood << ", should be "
+				<< referenceLogLikelihood[i] << ".\n";
+			globalError = 1;
+		}
+	}
+
+	if (!globalError)
+		std::cout << "PANSE log likelihood ratios --- Pass\n";
+	return globalError;
+}
+
+
+/* testDelayedAcceptanceRatios
+ * Checks calculateLogLikelihoodRatioForGroupings of ROC and FONSE: using all genes it has to match
+ * calculateLogLikelihoodRatioForAllGroupings for the flagged groupings, and the estimates from the two halves of the
+ * genome (stride 2) have to add up to twice the exact ratios, as the prior is included once in each estimate.
+*/
+int testDelayedAcceptanceRatios()
+{
+	int globalError = 0;
+	const unsigned numGenes = 20u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes, 0u);
+	std::vector<double> stdDevSynthesisRate(1, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+
+	ROCParameter rocParameter(stdDevSynthesisRate, 1u, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	rocParameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel rocModel;
+	rocModel.setParameter(rocParameter);
+	FONSEParameter fonseParameter(stdDevSynthesisRate, 1u, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	fonseParameter.InitializeSynthesisRate(genome, 1.0);
+	FONSEModel fonseModel;
+	fonseModel.setParameter(fonseParameter);
+
+	Model *models[] = {&rocModel, &fonseModel};
+	const char *names[] = {"ROC", "FONSE"};
+	for (unsigned m = 0u; m < 2u; m++)
+	{
+		Model &model = *models[m];
+		model.proposeCodonSpecificParameter();
+		unsigned numGroupings = model.getGroupListSize();
+
+		std::vector<double> exact, masked, firstHalf, secondHalf;
+		std::vector<char> mask(numGroupings);
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			mask[g] = g % 2u;
+		}
+		model.calculateLogLikelihoodRatioForAllGroupings(genome, exact);
+		model.calculateLogLikelihoodRatioForGroupings(genome, 0u, 1u, &mask[0], masked);
+		model.calculateLogLikelihoodRatioForGroupings(genome, 0u, 2u, NULL, firstHalf);
+		model.calculateLogLikelihoodRatioForGroupings(genome, 1u, 2u, NULL, secondHalf);
+
+		bool error = false;
+		if (!model.hasSubsampleSurrogate())
+		{
+			std::cerr << "Error in hasSubsampleSurrogate for " << names[m] << ": the gene subsample is used.\n";
+			error = true;
+		}
+		for (unsigned g = 0u; g < numGroupings; g++)
+		{
+			double tolerance = 1e-8 * std::max(1.0, std::fabs(exact[g]));
+			if (mask[g] && std::fabs(masked[g] - exact[g]) > tolerance)
+			{
+				std::cerr << "Error in calculateLogLikelihoodRatioForGroupings for " << names[m] << ": grouping "
+					<< model.getGrouping(g) << " is " << masked[g] << ", should be " << exact[g] << ".\n";
+				error = true;
+			}
+			if (std::fabs(firstHalf[g] + secondHalf[g] - 2.0 * exact[g]) > 2.0 * tolerance)
+			{
+				std::cerr << "Error in calculateLogLikelihoodRatioForGroupings for " << names[m] << ": estimates of grouping "
+					<< model.getGrouping(g) << " add up to " << firstHalf[g] + secondHalf[g] << ", should be "
+					<< 2.0 * exact[g] << ".\n";
+				error = true;
+			}
+		}
+		if (error)
+			globalError = 1;
+		else
+			std::cout << "Delayed acceptance ratios " << names[m] << " --- Pass\n";
+	}
+	return globalError;
+}
+
+
+/* testCodonSpecificParameterGradient
+ * Checks the gradient and the negative second derivatives of ROCModel::calculateLogPosteriorGradientForAllGroupings
+ * against central differences of the log posterior, with two mixture elements sharing the mutation category.
+*/
+int testCodonSpecificParameterGradient()
+{
+	int globalError = 0;
+	const unsigned numGenes = 20u;
+	const unsigned numMixtures = 2u;
+	const double h = 1e-4;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+	ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "mutationShared");
+	parameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel model;
+	model.setParameter(parameter);
+	for (unsigned step = 0u; step < 5u; step++)
+	{
+		model.proposeCodonSpecificParameter();
+		for (unsigned g = 0u; g < model.getGroupListSize(); g++)
+		{
+			model.updateCodonSpecificParameter(model.getGrouping(g));
+		}
+	}
+
+	std::vector<double> values, logPosterior, gradient, curvature, shiftedLogPosterior, unused;
+	std::vector<unsigned> groupingOffsets;
+	model.getCodonSpecificParameterVector(values, groupingOffsets);
+	model.setProposedCodonSpecificParameterVector(values);
+	model.calculateLogPosteriorGradientForAllGroupings(genome, logPosterior, gradient, &curvature);
+
+	for (unsigned g = 0u; g + 1 < groupingOffsets.size(); g++)
+	{
+		for (unsigned j = groupingOffsets[g]; j < groupingOffsets[g + 1]; j++)
+		{
+			double value = values[j];
+			values[j] = value + h;
+			model.setProposedCodonSpecificParameterVector(values);
+			model.calculateLogPosteriorGradientForAllGroupings(genome, shiftedLogPosterior, unused, NULL);
+			double up = shiftedLogPosterior[g];
+			values[j] = value - h;
+			model.setProposedCodonSpecificParameterVector(values);
+			model.calculateLogPosteriorGradientForAllGroupings(genome, shiftedLogPosterior, unused, NULL);
+			double down = shiftedLogPosterior[g];
+			values[j] = value;
+
+			double difference = (up - down) / (2.0 * h);
+			double secondDifference = -(up - 2.0 * logPosterior[g] + down) / (h * h);
+			if (std::fabs(gradient[j] - difference) > 1e-4 * std::max(1.0, std::fabs(difference)))
+			{
+				std::cerr << "Error in calculateLogPosteriorGradientForAllGroupings: derivative " << j << " of grouping "
+					<< model.getGrouping(g) << " is " << gradient[j] << ", should be " << difference << ".\n";
+				globalError = 1;
+			}
+			if (std::fabs(curvature[j] - secondDifference) > 1e-2 * std::max(1.0, std::fabs(secondDifference)))
+			{
+				std::cerr << "Error in calculateLogPosteriorGradientForAllGroupings: second derivative " << j
+					<< " of grouping " << model.getGrouping(g) << " is " << curvature[j] << ", should be "
+					<< secondDifference << ".\n";
+				globalError = 1;
+			}
+		}
+	}
+	if (!globalError)
+		std::cout << "Codon specific parameter gradient --- Pass\n";
+	return globalError;
+}
+
+
+/* testPosteriorMode
+ * Runs ROCModel::findPosteriorMode from perturbed codon specific parameters, with two mixture elements sharing the
+ * mutation category. Checks that the search converges, that the gradient of the codon specific parameters vanishes at
+ * the mode and that the proposal covariance matrices set from the Hessian have positive, finite variances.
+*/
+int testPosteriorMode()
+{
+	int globalError = 0;
+	const unsigned numGenes = 20u;
+	const unsigned numMixtures = 2u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+	ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "mutationShared");
+	parameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel model;
+	model.setParameter(parameter);
+	for (unsigned step = 0u; step < 5u; step++)
+	{
+		model.proposeCodonSpecificParameter();
+		for (unsigned g = 0u; g < model.getGroupListSize(); g++)
+		{
+			model.updateCodonSpecificParameter(model.getGrouping(g));
+		}
+	}
+
+	if (!model.findPosteriorMode(genome, 200u))
+	{
+		std::cerr << "Error in findPosteriorMode: search did not converge.\n";
+		globalError = 1;
+	}
+
+	std::vector<double> values, logPosterior, gradient;
+	std::vector<unsigned> groupingOffsets;
+	model.getCodonSpecificParameterVector(values, groupingOffsets);
+	model.setProposedCodonSpecificParameterVector(values);
+	model.calculateLogPosteriorGradientForAllGroupings(genome, logPosterior, gradient, NULL);
+	for (unsigned j = 0u; j < gradient.size(); j++)
+	{
+		if (!(std::fabs(gradient[j]) < 1e-3))
+		{
+			std::cerr << "Error in findPosteriorMode: derivative " << j << " is " << gradient[j] << " at the mode.\n";
+			globalError = 1;
+		}
+	}
+
+	for (unsigned g = 0u; g < model.getGroupListSize(); g++)
+	{
+		CovarianceMatrix &covarianceMatrix = parameter.getCovarianceMatrixForAA(model.getGrouping(g));
+		std::vector<double> &matrix = *covarianceMatrix.getCovMatrix();
+		int numVariates = covarianceMatrix.getNumVariates();
+		for (int j = 0; j < numVariates; j++)
+		{
+			double variance = matrix[j * numVariates + j];
+			if (!(variance > 0.0 && std::isfinite(variance)))
+			{
+				std::cerr << "Error in findPosteriorMode: proposal variance " << j << " of grouping "
+					<< model.getGrouping(g) << " is " << variance << ".\n";
+				globalError = 1;
+			}
+		}
+	}
+	if (!globalError)
+		std::cout << "Posterior mode --- Pass\n";
+	return globalError;
+}
+
+
+/* testMixtureAssignmentSampler
+ * Checks the probabilities and log normalizing constants of MixtureAssignmentSampler against a direct calculation,
+ * including log posteriors that underflow when exponentiated without shifting. Then checks the assignments for
+ * given uniform numbers, the counts per mixture element, and that drawn assignments are valid.
+*/
+int testMixtureAssignmentSampler()
+{
+	int globalError = 0;
+	const unsigned numGenes = 1000u;
+	const unsigned numMixtures = 3u;
+	double mixtureProbabilities[] = {0.2, 0.3, 0.5};
+
+	MixtureAssignmentSampler sampler;
+	sampler.resize(numGenes, numMixtures);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		double *logPosterior = sampler.getLogPosterior(i);
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			logPosterior[k] = -1100.0 + (double)((i * 7u + k * 5u) % 13u) * 0.5 - (i % 2u == 0u ? 0.0 : 500.0);
+		}
+	}
+	sampler.calculateProbabilities(mixtureProbabilities);
+
+	bool error = false;
+	for (unsigned i = 0u; i < numGenes && !error; i++)
+	{
+		double *logPosterior = sampler.getLogPosterior(i);
+		double *probabilities = sampler.getProbabilities(i);
+		double shift = (i % 2u == 0u ? -1100.0 : -1600.0);
+		double expected[3];
+		double sum = 0.0;
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			expected[k] = mixtureProbabilities[k] * std::exp(logPosterior[k] - shift);
+			sum += expected[k];
+		}
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			if (std::fabs(probabilities[k] - expected[k] / sum) > 1e-12)
+			{
+				std::cerr << "Error in calculateProbabilities: probability " << k << " of gene " << i << " is "
+					<< probabilities[k] << ", should be " << expected[k] / sum << ".\n";
+				error = true;
+			}
+		}
+		double logNormalizingConstant = shift + std::log(sum);
+		if (std::fabs(sampler.getLogNormalizingConstant(i) - logNormalizingConstant) > 1e-9)
+		{
+			std::cerr << "Error in calculateProbabilities: log normalizing constant of gene " << i << " is "
+				<< sampler.getLogNormalizingConstant(i) << ", should be " << logNormalizingConstant << ".\n";
+			error = true;
+		}
+	}
+	if (error)
+		globalError = 1;
+	else
+		std::cout << "MixtureAssignmentSampler calculateProbabilities --- Pass\n";
+
+	// every gene is assigned where the cumulative sum of its probabilities reaches its uniform number
+	std::vector<double> uniformNumbers(numGenes);
+	unsigned expectedCounts[] = {0u, 0u, 0u};
+	error = false;
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		uniformNumbers[i] = (i % 10u) / 10.0 + 0.05;
+	}
+	uniformNumbers[0] = 0.0;
+	uniformNumbers[1] = 1.0;
+	sampler.assign(&uniformNumbers[0]);
+	sampler.countAssignments();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		double *probabilities = sampler.getProbabilities(i);
+		unsigned expected = 0u;
+		double cumsum = 0.0;
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			cumsum += probabilities[k];
+			if (uniformNumbers[i] <= cumsum)
+			{
+				expected = k;
+				break;
+			}
+		}
+		expectedCounts[expected]++;
+		if (sampler.getAssignment(i) != expected)
+		{
+			std::cerr << "Error in assign: gene " << i << " is assigned to " << sampler.getAssignment(i)
+				<< ", should be " << expected << ".\n";
+			error = true;
+		}
+	}
+	if (sampler.getAssignment(0) != 0u)
+	{
+		std::cerr << "Error in assign: a uniform number of 0 should assign to the first mixture element.\n";
+		error = true;
+	}
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		if (sampler.getCounts()[k] != expectedCounts[k])
+		{
+			std::cerr << "Error in countAssignments: mixture element " << k << " has " << sampler.getCounts()[k]
+				<< " genes, should be " << expectedCounts[k] << ".\n";
+			error = true;
+		}
+	}
+	if (error)
+		globalError = 1;
+	else
+		std::cout << "MixtureAssignmentSampler assign and countAssignments --- Pass\n";
+
+	sampler.drawAssignments();
+	sampler.countAssignments();
+	double total = 0.0;
+	error = false;
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		if (sampler.getAssignment(i) >= numMixtures)
+		{
+			std::cerr << "Error in drawAssignments: gene " << i << " is assigned to mixture element "
+				<< sampler.getAssignment(i) << ".\n";
+			error = true;
+		}
+	}
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		total += sampler.getCounts()[k];
+	}
+	if (total != numGenes)
+	{
+		std::cerr << "Error in drawAssignments: " << total << " genes counted, should be " << numGenes << ".\n";
+		error = true;
+	}
+	if (error)
+		globalError = 1;
+	else
+		std::cout << "MixtureAssignmentSampler drawAssignments --- Pass\n";
+
+	return globalError;
+}
+
+
+/* testJobConfig
+ * Reads a job file with every supported kind of value and checks the values returned by the getters, then checks
+ * that malformed lines and values of the wrong type are reported with their line numbers.
+*/
+int testJobConfig()
+{
+	int globalError = 0;
+	bool error = false;
+
+	JobConfig config;
+	std::string job = "# comment\n"
+		"top = 1\n"
+		"[job]\n"
+		"model = \"ROC\" # trailing comment\n"
+		"seed = -42\n"
+		"name = 'C:\\runs\\a'\n"
+		"escaped = \"a\\\"b\\tc\"\n"
+		"[mcmc]\n"
+		"samples = 1_000\n"
+		"fraction = 2.5e-1\n"
+		"hmc = true\n"
+		"files = [\"a.fasta\",\n"
+		"  \"b.fasta\", # second file\n"
+		"]\n"
+		"matrix = [[1, 1], [2, 1]]\n"
+		"values = [1, 2.5]\n";
+	if (!config.readString(job))
+	{
+		std::cerr << "Error in JobConfig::readString: valid job reported as invalid.\n";
+		error = true;
+	}
+	if (config.getInteger("top") != 1 || config.getString("job.model") != "ROC" || config.getInteger("job.seed") != -42)
+	{
+		std::cerr << "Error in JobConfig: top, job.model or job.seed read incorrectly.\n";
+		error = true;
+	}
+	if (config.getString("job.name") != "C:\\runs\\a" || config.getString("job.escaped") != "a\"b\tc")
+	{
+		std::cerr << "Error in JobConfig::getString: literal or escaped string read incorrectly.\n";
+		error = true;
+	}
+	if (config.getUnsigned("mcmc.samples") != 1000u || config.getDouble("mcmc.fraction") != 0.25
+			|| config.getDouble("mcmc.samples") != 1000.0 || !config.getBool("mcmc.hmc"))
+	{
+		std::cerr << "Error in JobConfig: numbers or booleans read incorrectly.\n";
+		error = true;
+	}
+	std::vector<std::string> files = config.getStringArray("mcmc.files");
+	std::vector<std::string> model = config.getStringArray("job.model");
+	if (files.size() != 2u || files[0] != "a.fasta" || files[1] != "b.fasta" || model.size() != 1u || model[0] != "ROC")
+	{
+		std::cerr << "Error in JobConfig::getStringArray: array over several lines or single string read incorrectly.\n";
+		error = true;
+	}
+	std::vector<std::vector<unsigned>> matrix = config.getUnsignedMatrix("mcmc.matrix");
+	std::vector<double> values = config.getDoubleArray("mcmc.values");
+	if (matrix.size() != 2u || matrix[1].size() != 2u || matrix[1][0] != 2u || values.size() != 2u || values[1] != 2.5)
+	{
+		std::cerr << "Error in JobConfig: matrix or array of numbers read incorrectly.\n";
+		error = true;
+	}
+	if (config.hasKey("samples") || config.getUnsigned("mcmc.thinning", 10u) != 10u || config.hasError())
+	{
+		std::cerr << "Error in JobConfig: missing key is not handled.\n";
+		error = true;
+	}
+	if (error)
+		globalError = 1;
+	else
+		std::cout << "JobConfig read --- Pass\n";
+
+	error = false;
+	JobConfig badConfig;
+	std::string badJob = "a = 1\n"
+		"b = ROC\n"
+		"[c\n"
+		"d = \"open\n"
+		"a = 2\n"
+		"e = [1 2]\n";
+	if (badConfig.readString(badJob) || badConfig.getErrors().size() != 5u)
+	{
+		std::cerr << "Error in JobConfig::readString: " << badConfig.getErrors().size()
+			<< " errors found, should be 5.\n";
+		error = true;
+	}
+	else
+	{
+		std::vector<std::string> errors = badConfig.getErrors();
+		const char *lines[] = {"line 2:", "line 3:", "line 4:", "line 5:", "line 6:"};
+		for (unsigned i = 0u; i < errors.size(); i++)
+		{
+			if (errors[i].compare(0, strlen(lines[i]), lines[i]) != 0)
+			{
+				std::cerr << "Error in JobConfig::readString: error \"" << errors[i] << "\" should be on "
+					<< lines[i] << "\n";
+				error = true;
+			}
+		}
+	}
+	JobConfig typeConfig;
+	typeConfig.readString("cores = \"2\"\n");
+	if (typeConfig.getUnsigned("cores", 1u) != 1u || !typeConfig.hasError())
+	{
+		std::cerr << "Error in JobConfig::getUnsigned: string value accepted as integer.\n";
+		error = true;
+	}
+	if (error)
+		globalError = 1;
+	else
+		std::cout << "JobConfig errors --- Pass\n";
+
+	return globalError;
+}
+
+
+/* testSimulateGenome
+ * Simulates the test genome with ROC and FONSE models whose codon specific parameters were moved away from their
+ * initial values. Checks that the simulated genes keep the ids and amino acid sequences, that the ROC codon counts are
+ * close to their expectation, that simulating the genes in several calls gives the same sequences, and that
+ * simulateGenomeToFile writes the same genes.
+*/
+int testSimulateGenome(std::string testFileDir)
+{
+	int globalError = 0;
+	const unsigned numGenes = 200u;
+	const unsigned numMixtures = 2u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+
+	ROCParameter rocParameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	rocParameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel rocModel;
+	rocModel.setParameter(rocParameter);
+
+	FONSEParameter fonseParameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	fonseParameter.InitializeSynthesisRate(genome, 1.0);
+	FONSEModel fonseModel;
+	fonseModel.setParameter(fonseParameter);
+
+	Model *models[] = {&rocModel, &fonseModel};
+	const char *modelNames[] = {"ROC", "FONSE"};
+	for (unsigned m = 0u; m < 2u; m++)
+	{
+		Model &model = *models[m];
+		bool error = false;
+		for (unsigned step = 0u; step < 10u; step++)
+		{
+			model.proposeCodonSpecificParameter();
+			for (unsigned g = 0u; g < model.getGroupListSize(); g++)
+			{
+				model.updateCodonSpecificParameter(model.getGrouping(g));
+			}
+		}
+
+		model.simulateGenome(genome);
+		if (genome.getGenomeSize(true) != numGenes)
+		{
+			std::cerr << "Error in simulateGenome for " << modelNames[m] << ": " << genome.getGenomeSize(true)
+				<< " simulated genes instead of " << numGenes << ".\n";
+			globalError = 1;
+			continue;
+		}
+
+		std::vector<double> expectedCounts(64, 0.0);
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			Gene &gene = genome.getGene(i);
+			Gene &simulatedGene = genome.getGene(i, true);
+			std::string seq = gene.getSequence();
+			std::string simulatedSeq = simulatedGene.getSequence();
+			bool sameAminoAcids = seq.size() == simulatedSeq.size() && simulatedSeq.compare(0, 3, "ATG") == 0;
+			for (unsigned j = 3u; sameAminoAcids && j + 3u < seq.size(); j += 3u)
+			{
+				std::string codon = seq.substr(j, 3);
+				std::string simulatedCodon = simulatedSeq.substr(j, 3);
+				sameAminoAcids = SequenceSummary::codonToAA(codon) == SequenceSummary::codonToAA(simulatedCodon);
+			}
+			std::string stopCodon = simulatedSeq.substr(simulatedSeq.size() - 3);
+			if (!sameAminoAcids || SequenceSummary::codonToAA(stopCodon) != "X")
+			{
+				std::cerr << "Error in simulateGenome for " << modelNames[m] << ": amino acid sequence of gene " << i
+					<< " not kept.\n";
+				error = true;
+			}
+			if (simulatedGene.getId() != "Simulated Gene" || simulatedGene.getDescription() != gene.getId())
+			{
+				std::cerr << "Error in simulateGenome for " << modelNames[m] << ": gene " << i << " has id "
+					<< simulatedGene.getId() << " and description " << simulatedGene.getDescription() << ".\n";
+				error = true;
+			}
+
+			if (m != 0u) continue;
+			unsigned mixtureElement = rocModel.getMixtureAssignment(i);
+			double phi = rocModel.getSynthesisRate(i, rocModel.getSynthesisRateCategory(mixtureElement), false);
+			for (unsigned g = 0u; g < rocModel.getGroupListSize(); g++)
+			{
+				std::string aa = rocModel.getGrouping(g);
+				unsigned aaStart, aaEnd;
+				double mutation[5], selection[5], codonProb[6];
+				SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, false);
+				rocModel.getParameterForCategory(rocModel.getMutationCategory(mixtureElement), ROCParameter::dM, aa, false, mutation);
+				rocModel.getParameterForCategory(rocModel.getSelectionCategory(mixtureElement), ROCParameter::dEta, aa, false, selection);
+				rocModel.calculateCodonProbabilityVector(aaEnd - aaStart, mutation, selection, phi, codonProb);
+				for (unsigned k = aaStart; k < aaEnd; k++)
+				{
+					expectedCounts[k] += gene.geneData.getAACountForAA(SequenceSummary::AAToAAIndex(aa)) * codonProb[k - aaStart];
+				}
+			}
+		}
+
+		// counts of a codon are binomial, so 5 standard deviations are a very wide margin
+		for (unsigned k = 0u; m == 0u && k < 61u; k++)
+		{
+			if (expectedCounts[k] == 0.0) continue;
+			double observed = 0.0;
+			for (unsigned i = 0u; i < numGenes; i++)
+			{
+				observed += genome.getGene(i, true).geneData.getCodonCountForCodon(k);
+			}
+			if (std::fabs(observed - expectedCounts[k]) > 5.0 * std::sqrt(expectedCounts[k]) + 1.0)
+			{
+				std::cerr << "Error in simulateGenome for ROC: codon " << SequenceSummary::codonArray[k] << " simulated "
+					<< observed << " times, expected " << expectedCounts[k] << ".\n";
+				error = true;
+			}
+		}
+
+		std::vector<std::string> sequences, firstBlock, secondBlock;
+		model.simulateCodonSequences(genome, 0u, numGenes, 17u, sequences);
+		model.simulateCodonSequences(genome, 0u, 77u, 17u, firstBlock);
+		model.simulateCodonSequences(genome, 77u, numGenes - 77u, 17u, secondBlock);
+		firstBlock.insert(firstBlock.end(), secondBlock.begin(), secondBlock.end());
+		if (sequences != firstBlock)
+		{
+			std::cerr << "Error in simulateCodonSequences for " << modelNames[m] << ": simulating in two calls gives "
+				<< "different sequences.\n";
+			error = true;
+		}
+
+		std::string file = testFileDir + "/" + "testSimulate.fasta";
+		Genome fileGenome;
+		model.simulateGenomeToFile(genome, file);
+		fileGenome.readFasta(file);
+		bool sameGenes = fileGenome.getGenomeSize() == numGenes;
+		for (unsigned i = 0u; sameGenes && i < numGenes; i++)
+		{
+			Gene &gene = fileGenome.getGene(i);
+			sameGenes = gene.getId() == genome.getGene(i).getId();
+			for (unsigned aaIndex = 0u; sameGenes && aaIndex < 22u; aaIndex++)
+			{
+				sameGenes = gene.geneData.getAACountForAA(aaIndex) == genome.getGene(i, true).geneData.getAACountForAA(aaIndex);
+			}
+		}
+		if (!sameGenes)
+		{
+			std::cerr << "Error in simulateGenomeToFile for " << modelNames[m] << ": genes read back differ from the "
+				<< "simulated genes.\n";
+			error = true;
+		}
+		std::remove(file.c_str());
+
+		if (error)
+			globalError = 1;
+		else
+			std::cout << "Simulate genome " << modelNames[m] << " --- Pass\n";
+		genome.setGenomeSize(0u, true);
+	}
+	return globalError;
+}
+
+
+/* testSelectionCoefficients
+ * Runs a short ROC chain with two mixture elements and compares calculateSelectionCoefficients against selection
+ * coefficients built from getCodonSpecificPosteriorMean and getSynthesisRatePosteriorMean, for the row major and the
+ * column major layout.
+*/
+int testSelectionCoefficients()
+{
+	int globalError = 0;
+	const unsigned numGenes = 20u;
+	const unsigned numMixtures = 2u;
+	const unsigned samples = 10u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+	ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	parameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel model;
+	model.setParameter(parameter);
+	MCMCAlgorithm mcmc(samples, 1u, 5u, true, true, true);
+	mcmc.run(genome, model, 1u, 0u);
+
+	for (unsigned mixture = 0u; mixture < numMixtures; mixture++)
+	{
+		bool error = false;
+		std::vector<std::vector<double>> selectionCoefficients = parameter.calculateSelectionCoefficients(5u, mixture);
+		unsigned numCodons = selectionCoefficients.empty() ? 0u : selectionCoefficients[0].size();
+		std::vector<double> columnMajor(numGenes * numCodons);
+		parameter.calculateSelectionCoefficients(5u, mixture, columnMajor.data(), 1u, numGenes);
+
+		for (unsigned i = 0u; i < numGenes && !error; i++)
+		{
+			std::vector<double> expected;
+			double phi = parameter.getSynthesisRatePosteriorMean(5u, i, mixture);
+			for (unsigned g = 0u; g < parameter.getGroupListSize(); g++)
+			{
+				std::string aa = parameter.getGrouping(g);
+				unsigned aaStart, aaEnd;
+				SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, true);
+				std::vector<double> selection;
+				double minValue = 0.0;
+				for (unsigned k = aaStart; k < aaEnd; k++)
+				{
+					std::string codon = SequenceSummary::codonArrayParameter[k];
+					selection.push_back(parameter.getCodonSpecificPosteriorMean(mixture, 5u, codon, Parameter::dEta));
+					minValue = std::min(minValue, selection.back());
+				}
+				selection.push_back(0.0);
+				for (unsigned k = 0u; k < selection.size(); k++)
+				{
+					expected.push_back(phi * (selection[k] - minValue));
+				}
+			}
+
+			if (selectionCoefficients[i].size() != expected.size())
+			{
+				std::cerr << "Error in calculateSelectionCoefficients: " << selectionCoefficients[i].size()
+					<< " coefficients for gene " << i << " instead of " << expected.size() << ".\n";
+				error = true;
+				break;
+			}
+			for (unsigned k = 0u; k < expected.size(); k++)
+			{
+				double tolerance = 1e-12 * std::max(1.0, std::fabs(expected[k]));
+				if (std::fabs(selectionCoefficients[i][k] - expected[k]) > tolerance
+					|| std::fabs(columnMajor[k * numGenes + i] - expected[k]) > tolerance)
+				{
+					std::cerr << "Error in calculateSelectionCoefficients: coefficient " << k << " of gene " << i
+						<< " in mixture " << mixture << " is " << selectionCoefficients[i][k] << " (row major) and "
+						<< columnMajor[k * numGenes + i] << " (column major), expected " << expected[k] << ".\n";
+					error = true;
+					break;
+				}
+			}
+		}
+		if (error)
+			globalError = 1;
+	}
+	if (!globalError)
+		std::cout << "Selection coefficients --- Pass\n";
+	return globalError;
+}
+
+
+int testCodonEncoding()
+{
+	int globalError = 0;
+
+	// codon and amino acid lookups against the string tables they replace
+	unsigned expectedStart = 0u;
+	unsigned expectedParameterStart = 0u;
+	for (unsigned a = 0u; a < 22u; a++)
+	{
+		std::string aa = SequenceSummary::AminoAcidArray[a];
+		unsigned aaStart, aaEnd, parameterStart, parameterEnd;
+		SequenceSummary::AAToCodonRange(aa, aaStart, aaEnd, false);
+		SequenceSummary::AAToCodonRange(aa, parameterStart, parameterEnd, true);
+		bool hasParameters = aa != "M" && aa != "W" && aa != "X";
+		if (SequenceSummary::AAToAAIndex(aa) != a || aaStart != expectedStart || aaEnd <= aaStart
+			|| parameterStart != expectedParameterStart
+			|| parameterEnd - parameterStart != (hasParameters ? aaEnd - aaStart - 1u : 0u)
+			|| SequenceSummary::GetNumCodonsForAA(aa) != aaEnd - aaStart
+			|| SequenceSummary::GetNumCodonsForAA(aa, true) != parameterEnd - parameterStart)
+		{
+			std::cerr << "Error in codon encoding: amino acid " << aa << " has index "
+				<< SequenceSummary::AAToAAIndex(aa) << ", codons " << aaStart << " to " << aaEnd << " and parameters "
+				<< parameterStart << " to " << parameterEnd << ".\n";
+			globalError = 1;
+		}
+		for (unsigned i = aaStart; i < aaEnd; i++)
+		{
+			std::string codon = SequenceSummary::codonArray[i];
+			std::string rna = codon;
+			std::replace(rna.begin(), rna.end(), 'T', 'u');
+			unsigned parameterIndex = SequenceSummary::codonToIndex(codon, true);
+			bool isReference = i + 1u == aaEnd || !hasParameters;
+			if (SequenceSummary::codonToIndex(codon) != i || SequenceSummary::codonToIndex(rna) != i
+				|| SequenceSummary::codonToAA(codon) != aa || SequenceSummary::codonToAAIndex(rna) != a
+				|| (isReference ? parameterIndex != 64u : (parameterIndex != parameterStart + i - aaStart
+				|| SequenceSummary::codonArrayParameter[parameterIndex] != codon)))
+			{
+				std::cerr << "Error in codon encoding: codon " << codon << " (" << rna << ") has index "
+					<< SequenceSummary::codonToIndex(codon) << ", parameter index " << parameterIndex
+					<< " and amino acid " << SequenceSummary::codonToAA(codon) << ", expected " << i << " and " << aa
+					<< ".\n";
+				globalError = 1;
+			}
+		}
+		expectedStart = aaEnd;
+		expectedParameterStart = parameterEnd;
+	}
+	if (expectedStart != 64u || expectedParameterStart != 40u)
+	{
+		std::cerr << "Error in codon encoding: amino acids cover " << expectedStart << " codons and "
+			<< expectedParameterStart << " parameters.\n";
+		globalError = 1;
+	}
+
+	std::string invalid[] = {"GNA", "GC", "", "G-A", "XYZ"};
+	for (unsigned i = 0u; i < 5u; i++)
+	{
+		if (SequenceSummary::codonToIndex(invalid[i]) != 64u || SequenceSummary::codonToAA(invalid[i]) != "#")
+		{
+			std::cerr << "Error in codon encoding: invalid codon \"" << invalid[i] << "\" was recognized.\n";
+			globalError = 1;
+		}
+	}
+
+	// unknown codons are skipped, lower case and a trailing partial codon are handled
+	SequenceSummary SS;
+	SS.processSequence("atgNNNgcaGCAagTtaGC");
+	if (SS.getAACountForAA("M") != 1u || SS.getAACountForAA("A") != 2u || SS.getAACountForAA("Z") != 1u
+		|| SS.getAACountForAA("X") != 1u || SS.getCodonCountForCodon(0u) != 2u
+		|| *SS.getCodonPositions(0u) != std::vector<unsigned>({2u, 3u}))
+	{
+		std::cerr << "Error in codon encoding: processSequence counted " << SS.getAACountForAA("M") << " M, "
+			<< SS.getAACountForAA("A") << " A, " << SS.getAACountForAA("Z") << " Z and " << SS.getAACountForAA("X")
+			<< " stop codons.\n";
+		globalError = 1;
+	}
+
+	if (!globalError)
+		std::cout << "Codon encoding --- Pass\n";
+	return globalError;
+}
+
+
+int testCodonTable()
+{
+	int globalError = 0;
+
+	// the generated standard code has to be the compile time one, including the name tables
+	const GeneticCode& standard = CodonEncoding::standardCode;
+	CodonTable table1(1, true);
+	const GeneticCode& generated = table1.getGeneticCode();
+	if (generated.numAA != standard.numAA || generated.numParameterCodons != standard.numParameterCodons
+		|| std::memcmp(generated.packedToCodonIndex, standard.packedToCodonIndex, sizeof(standard.packedToCodonIndex))
+		|| std::memcmp(generated.codonToAA, standard.codonToAA, sizeof(standard.codonToAA))
+		|| std::memcmp(generated.codonToParameter, standard.codonToParameter, sizeof(standard.codonToParameter))
+		|| std::memcmp(generated.parameterToCodon, standard.parameterToCodon, standard.numParameterCodons)
+		|| std::memcmp(generated.aaCodonStart, standard.aaCodonStart, standard.numAA + 1u)
+		|| std::memcmp(generated.aaParameterStart, standard.aaParameterStart, standard.numAA + 1u)
+		|| std::memcmp(generated.letterToAA, standard.letterToAA, sizeof(standard.letterToAA))
+		|| std::memcmp(generated.codonNames, standard.codonNames, sizeof(standard.codonNames))
+		|| std::string(generated.aaLetters) != standard.aaLetters)
+	{
+		std::cerr << "Error in CodonTable: table 1 differs from the standard code.\n";
+		globalError = 1;
+	}
+
+	// vertebrate mitochondrial code: ATA is M, TGA is W, AGA and AGG are stop codons
+	CodonTable::useCodonTable(2, true);
+	std::vector<std::string> groupList = SequenceSummary::aminoAcidsWithParameters();
+	if (CodonTable::getActiveCodonTable() != 2u || SequenceSummary::numAminoAcids() != 22u
+		|| SequenceSummary::numSenseCodons() != 60u || SequenceSummary::numParameterCodons() != 39u
+		|| SequenceSummary::GetNumCodonsForAA("M") != 2u || SequenceSummary::GetNumCodonsForAA("W", true) != 1u
+		|| SequenceSummary::GetNumCodonsForAA("R") != 4u || SequenceSummary::GetNumCodonsForAA("X") != 4u
+		|| SequenceSummary::codonToAA("AGA") != "X" || SequenceSummary::codonToAA("TGA") != "W"
+		|| std::find(groupList.begin(), groupList.end(), "M") == groupList.end()
+		|| SequenceSummary::codonArray[SequenceSummary::codonToIndex("ATA")] != "ATA")
+	{
+		std::cerr << "Error in CodonTable: table 2 has " << SequenceSummary::numAminoAcids() << " amino acids, "
+			<< SequenceSummary::numSenseCodons() << " sense codons and " << SequenceSummary::numParameterCodons()
+			<< " parameters.\n";
+		globalError = 1;
+	}
+	SequenceSummary SS("ATGATATGAAGATGGcgaTAA");
+	if (SS.getAACountForAA("M") != 2u || SS.getAACountForAA("W") != 2u || SS.getAACountForAA("X") != 2u
+		|| SS.getAACountForAA("R") != 1u || SS.getCodonCountForCodon(SequenceSummary::codonToIndex("TGA")) != 1u)
+	{
+		std::cerr << "Error in CodonTable: processSequence with table 2 counted " << SS.getAACountForAA("M") << " M, "
+			<< SS.getAACountForAA("W") << " W and " << SS.getAACountForAA("X") << " stop codons.\n";
+		globalError = 1;
+	}
+
+	// yeast mitochondrial code: CTN is threonine, outside its codon box it becomes its own amino acid
+	CodonTable::useCodonTable(3, true);
+	if (SequenceSummary::codonToAA("CTG") != CodonTable::Thr4_1 || SequenceSummary::GetNumCodonsForAA("T") != 4u
+		|| SequenceSummary::GetNumCodonsForAA(CodonTable::Thr4_1) != 4u)
+	{
+		std::cerr << "Error in CodonTable: table 3 codes CTG for " << SequenceSummary::codonToAA("CTG") << ".\n";
+		globalError = 1;
+	}
+
+	CodonTable::useCodonTable(1, true);
+	if (!CodonEncoding::isStandardCode() || SequenceSummary::AminoAcidArray.size() != 22u
+		|| SequenceSummary::codonArray[63] != "TGA" || SequenceSummary::codonArrayParameter.size() != 40u)
+	{
+		std::cerr << "Error in CodonTable: the standard code was not restored.\n";
+		globalError = 1;
+	}
+
+	if (!globalError)
+		std::cout << "CodonTable --- Pass\n";
+	return globalError;
+}
+
+/* testHyperParameterLogLikelihoodRatios
+ * Checks ROCModel::calculateLogLikelihoodRatioForHyperParameters, which works on cached log synthesis rates and log
+ * observed synthesis rates, against the densities of every gene. Some genes miss an observed value, and some synthesis
+ * rates are accepted between the checks to test that the cached logs are kept up to date. Before the last check the
+ * observed values are read again and a new run is started, which has to gather them anew.
+*/
+int testHyperParameterLogLikelihoodRatios()
+{
+	int globalError = 0;
+	const unsigned numGenes = 30u;
+	const unsigned numSets = 2u;
+
+	Genome genome;
+	fillTestGenome(genome, numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		std::vector<double> observed(numSets);
+		for (unsigned s = 0u; s < numSets; s++)
+		{
+			observed[s] = (i + s) % 7u == 0u ? -1.0 : 0.2 + 0.1 * ((i * 3u + s) % 13u);
+		}
+		genome.getGene(i).setObservedSynthesisRateValues(observed);
+	}
+
+	for (unsigned numMixtures = 1u; numMixtures <= 2u; numMixtures++)
+	{
+		std::vector<unsigned> geneAssignment(numGenes);
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			geneAssignment[i] = i % numMixtures;
+		}
+		std::vector<double> stdDevSynthesisRate(numMixtures, 1.0);
+		std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+		ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+		parameter.InitializeSynthesisRate(genome, 1.0);
+		parameter.setNumObservedPhiSets(numSets);
+		ROCModel model(true);
+		model.setParameter(parameter);
+
+		bool error = false;
+		for (unsigned step = 0u; step < 3u && !error; step++)
+		{
+			model.proposeHyperParameters();
+			std::vector<double> ratios;
+			model.calculateLogLikelihoodRatioForHyperParameters(genome, step, ratios);
+
+			std::vector<double> expected(numSets + 1u, 0.0);
+			for (unsigned k = 0u; k < model.getNumSynthesisRateCategories(); k++)
+			{
+				expected[0] -= std::log(model.getStdDevSynthesisRate(k, false)) - std::log(model.getStdDevSynthesisRate(k, true));
+			}
+			for (unsigned j = 0u; j < numGenes; j++)
+			{
+				unsigned mixture = model.getMixtureAssignment(j);
+				unsigned k = model.getSynthesisRateCategory(mixture);
+				double phi = model.getSynthesisRate(j, mixture, false);
+				double current = model.getStdDevSynthesisRate(k, false);
+				double proposed = model.getStdDevSynthesisRate(k, true);
+				expected[0] += Parameter::densityLogNorm(phi, -(proposed * proposed) * 0.5, proposed, true)
+					- Parameter::densityLogNorm(phi, -(current * current) * 0.5, current, true);
+				for (unsigned s = 0u; s < numSets; s++)
+				{
+					double obsPhi = genome.getGene(j).getObservedSynthesisRate(s);
+					if (obsPhi <= -1.0) continue;
+					double noise = model.getObservedSynthesisNoise(s);
+					expected[s + 1u] += Parameter::densityNorm(std::log(obsPhi), std::log(phi) + model.getNoiseOffset(s, true), noise, true)
+						- Parameter::densityNorm(std::log(obsPhi), std::log(phi) + model.getNoiseOffset(s, false), noise, true);
+				}
+			}
+
+			for (unsigned r = 0u; r < numSets + 1u; r++)
+			{
+				if (ratios.size() != numSets + 1u || std::fabs(ratios[r] - expected[r]) > 1e-8 * std::max(1.0, std::fabs(expected[r])))
+				{
+					std::cerr << "Error in calculateLogLikelihoodRatioForHyperParameters with " << numMixtures
+						<< " mixtures: ratio " << r << " is " << (r < ratios.size() ? ratios[r] : 0.0) << ", should be "
+						<< expected[r] << ".\n";
+					error = true;
+					globalError = 1;
+					break;
+				}
+			}
+
+			// accept new synthesis rates for some genes, their cached logs have to follow
+			model.proposeSynthesisRateLevels();
+			for (unsigned j = step; j < numGenes; j += 3u)
+			{
+				model.updateSynthesisRate(j, model.getMixtureAssignment(j));
+			}
+
+			if (step == 1u)
+			{
+				for (unsigned i = 0u; i < numGenes; i++)
+				{
+					std::vector<double> observed(numSets);
+					for (unsigned s = 0u; s < numSets; s++)
+					{
+						observed[s] = (i + s) % 5u == 0u ? -1.0 : 0.3 + 0.2 * ((i * 7u + s) % 11u);
+					}
+					genome.getGene(i).setObservedSynthesisRateValues(observed);
+				}
+				model.initTraces(1u, numGenes);
+			}
+		}
+		if (!error)
+			std::cout << "Hyper parameter log likelihood ratios with " << numMixtures << " mixtures --- Pass\n";
+	}
+	return globalError;
+}
+
+/* LBFGSTestObjective
+ * f(x) = sum x + sin(pi x) / (3 pi), decreasing but not convex: the derivative alternates between 4/3 at even and 2/3
+ * at odd integers. Rosenbrock's function instead if rosenbrock is set.
+*/
+class LBFGSTestObjective: public LBFGSObjective
+{
+	public:
+		bool rosenbrock;
+		explicit LBFGSTestObjective(bool _rosenbrock) : rosenbrock(_rosenbrock) {}
+		double evaluate(std::vector<double> &x, std::vector<double> &gradient)
+		{
+			const double pi = 3.14159265358979323846;
+			gradient.resize(x.size());
+			if (rosenbrock)
+			{
+				double a = 1.0 - x[0], b = x[1] - x[0] * x[0];
+				gradient[0] = -2.0 * a - 400.0 * x[0] * b;
+				gradient[1] = 200.0 * b;
+				return a * a + 100.0 * b * b;
+			}
+			double value = 0.0;
+			for (unsigned j = 0u; j < x.size(); j++)
+			{
+				value += x[j] + std::sin(pi * x[j]) / (3.0 * pi);
+				gradient[j] = 1.0 + std::cos(pi * x[j]) / 3.0;
+			}
+			return value;
+		}
+};
+
+
+/* testLBFGSOptimizer
+ * Minimizes Rosenbrock's function. Then takes two steps on a non-convex function with room for a single correction
+ * pair: the first pair (x 0 to -1) is stored, the second (x -1 to -2) has negative curvature and has to be rejected
+ * without touching the stored pair.
+*/
+int testLBFGSOptimizer()
+{
+	int globalError = 0;
+
+	LBFGSTestObjective rosenbrock(true);
+	LBFGSOptimizer optimizer;
+	std::vector<double> x(2u, -1.0);
+	optimizer.minimize(rosenbrock, x, 500u, 1e-15);
+	if (!(std::fabs(x[0] - 1.0) < 1e-4 && std::fabs(x[1] - 1.0) < 1e-4))
+	{
+		std::cerr << "Error in LBFGSOptimizer::minimize: Rosenbrock minimum found at (" << x[0] << ", " << x[1]
+			<< "), should be (1, 1).\n";
+		globalError = 1;
+	}
+
+	LBFGSTestObjective nonConvex(false);
+	LBFGSOptimizer singlePair(1u);
+	x.assign(1u, 0.0);
+	singlePair.minimize(nonConvex, x, 2u, 0.0);
+	double positionChange = singlePair.positionChanges[0][0];
+	double gradientChange = singlePair.gradientChanges[0][0];
+	if (!(std::fabs(x[0] + 2.0) < 1e-12 && singlePair.numStored == 1u && std::fabs(positionChange + 1.0) < 1e-12
+			&& std::fabs(gradientChange + 2.0 / 3.0) < 1e-12
+			&& std::fabs(singlePair.curvatures[0] * positionChange * gradientChange - 1.0) < 1e-12))
+	{
+		std::cerr << "Error in LBFGSOptimizer::minimize: after a step without positive curvature x is " << x[0]
+			<< " and the stored pair is (" << positionChange << ", " << gradientChange << ", "
+			<< singlePair.curvatures[0] << "), should be -2 and (-1, -2/3, 1.5).\n";
+		globalError = 1;
+	}
+	if (!globalError)
+		std::cout << "LBFGS optimizer --- Pass\n";
+	return globalError;
+}
+
+
+/* testCrossValidation
+ * Checks that k-fold splits hold out every gene exactly once and train on the rest, and that bootstrap samples hold
+ * out exactly the genes not drawn. Then compares the posterior predictive log likelihood of a two mixture ROC model,
+ * whose traces hold a single sample, with the integral over log(phi) on a fine grid.
+*/
+int testCrossValidation()
+{
+	int globalError = 0;
+	const unsigned numGenes = 23u;
+
+	for (unsigned numFolds = 2u; numFolds <= 5u; numFolds++)
+	{
+		std::vector<std::vector<unsigned>> trainingGenes, heldOutGenes;
+		CrossValidation::createFolds(numGenes, numFolds, 7u, trainingGenes, heldOutGenes);
+		std::vector<unsigned> timesHeldOut(numGenes, 0u);
+		for (unsigned f = 0u; f < heldOutGenes.size(); f++)
+		{
+			std::vector<bool> inFold(numGenes, false);
+			for (unsigned i = 0u; i < heldOutGenes[f].size(); i++)
+			{
+				timesHeldOut[heldOutGenes[f][i]]++;
+				inFold[heldOutGenes[f][i]] = true;
+			}
+			bool complement = trainingGenes[f].size() + heldOutGenes[f].size() == numGenes;
+			for (unsigned i = 0u; complement && i < trainingGenes[f].size(); i++)
+			{
+				complement = !inFold[trainingGenes[f][i]];
+			}
+			if (!complement || heldOutGenes[f].size() < numGenes / numFolds
+					|| heldOutGenes[f].size() > numGenes / numFolds + 1u)
+			{
+				std::cerr << "Error in createFolds: fold " << f << " of " << numFolds << " holds out "
+					<< heldOutGenes[f].size() << " genes and does not train on the others.\n";
+				globalError = 1;
+			}
+		}
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			if (heldOutGenes.size() != numFolds || timesHeldOut[i] != 1u)
+			{
+				std::cerr << "Error in createFolds: gene " << i << " is held out " << timesHeldOut[i] << " times with "
+					<< numFolds << " folds.\n";
+				globalError = 1;
+				break;
+			}
+		}
+	}
+
+	for (unsigned seed = 0u; seed < 5u; seed++)
+	{
+		std::vector<unsigned> trainingGenes, heldOutGenes;
+		CrossValidation::createBootstrapSample(numGenes, seed, trainingGenes, heldOutGenes);
+		std::vector<bool> drawn(numGenes, false);
+		for (unsigned i = 0u; i < trainingGenes.size(); i++)
+		{
+			drawn[trainingGenes[i]] = true;
+		}
+		unsigned numDrawn = 0u;
+		for (unsigned i = 0u; i < numGenes; i++)
+		{
+			if (drawn[i]) numDrawn++;
+		}
+		bool outOfBag = numDrawn + heldOutGenes.size() == numGenes;
+		for (unsigned i = 0u; outOfBag && i < heldOutGenes.size(); i++)
+		{
+			outOfBag = !drawn[heldOutGenes[i]];
+		}
+		if (trainingGenes.size() != numGenes || !outOfBag)
+		{
+			std::cerr << "Error in createBootstrapSample: " << trainingGenes.size() << " draws for " << numGenes
+				<< " genes, the held out genes are not the ones left out.\n";
+			globalError = 1;
+		}
+	}
+	if (!globalError)
+		std::cout << "Cross validation gene sets --- Pass\n";
+
+	const unsigned numTestGenes = 8u;
+	const unsigned numMixtures = 2u;
+	Genome genome;
+	fillTestGenome(genome, numTestGenes);
+	std::vector<unsigned> geneAssignment(numTestGenes);
+	for (unsigned i = 0u; i < numTestGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(1u, 0.8);
+	stdDevSynthesisRate.push_back(1.3);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+	ROCParameter parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true, "allUnique");
+	parameter.InitializeSynthesisRate(genome, 1.0);
+	ROCModel model;
+	model.setParameter(parameter);
+	for (unsigned step = 0u; step < 5u; step++)
+	{
+		model.proposeCodonSpecificParameter();
+		for (unsigned g = 0u; g < model.getGroupListSize(); g++)
+		{
+			model.updateCodonSpecificParameter(model.getGrouping(g));
+		}
+	}
+	model.setCategoryProbability(0u, 0.3);
+	model.setCategoryProbability(1u, 0.7);
+	model.initTraces(1u, numTestGenes);
+	model.updateTracesWithInitialValues(genome);
+	model.updateStdDevSynthesisRateTrace(0u);
+	model.updateMixtureProbabilitiesTrace(0u);
+	model.setLastIteration(0u);
+
+	CrossValidation crossValidation;
+	std::vector<double> predictive = crossValidation.calculatePredictiveLogLikelihoods(genome, model, parameter, 1u);
+
+	// trapezoid rule over log(phi), the integrand is negligible outside of [-12, 12]
+	const double step = 2e-4;
+	std::vector<double> phiValues;
+	for (double logPhi = -12.0; logPhi <= 12.0; logPhi += step)
+	{
+		phiValues.push_back(std::exp(logPhi));
+	}
+	std::vector<double> logLikelihoods;
+	for (unsigned i = 0u; i < numTestGenes && predictive.size() == numTestGenes; i++)
+	{
+		std::vector<double> logIntegrals(numMixtures);
+		for (unsigned k = 0u; k < numMixtures; k++)
+		{
+			double sd = model.getStdDevSynthesisRate(model.getSynthesisRateCategory(k), false);
+			model.calculateLogLikelihoodPerGene(genome.getGene(i), k, phiValues, logLikelihoods);
+			double maxValue = -std::numeric_limits<double>::infinity();
+			for (unsigned j = 0u; j < phiValues.size(); j++)
+			{
+				logLikelihoods[j] += Parameter::densityNorm(std::log(phiValues[j]), -(sd * sd) * 0.5, sd, true);
+				maxValue = std::max(maxValue, logLikelihoods[j]);
+			}
+			double sum = 0.0;
+			for (unsigned j = 0u; j < phiValues.size(); j++)
+			{
+				sum += std::exp(logLikelihoods[j] - maxValue);
+			}
+			logIntegrals[k] = std::log(model.getCategoryProbability(k)) + maxValue + std::log(sum * step);
+		}
+		double maxIntegral = std::max(logIntegrals[0], logIntegrals[1]);
+		double expected = maxIntegral + std::log(std::exp(logIntegrals[0] - maxIntegral)
+			+ std::exp(logIntegrals[1] - maxIntegral));
+
+		if (!(std::fabs(predictive[i] - expected) < 1e-5 * std::max(1.0, std::fabs(expected))))
+		{
+			std::cerr << "Error in calculatePredictiveLogLikelihoods: gene " << i << " is " << predictive[i]
+				<< ", should be " << expected << ".\n";
+			globalError = 1;
+		}
+	}
+	if (predictive.size() != numTestGenes)
+	{
+		std::cerr << "Error in calculatePredictiveLogLikelihoods: " << predictive.size() << " values for "
+			<< numTestGenes << " genes.\n";
+		globalError = 1;
+	}
+	if (!globalError)
+		std::cout << "Posterior predictive log likelihood --- Pass\n";
+	return globalError;
+}
+
 // -----------------------------------------------------------------------------------------------------//
 // ---------------------------------------- R SECTION --------------------------------------------------//
 // -----------------------------------------------------------------------------------------------------//
@@ -1775,5 +3553,21 @@ RCPP_MODULE(Test_mod)
 	function("testGene", &testGene);
 	function("testGenome", &testGenome);
 	function("testUtility", &testUtility);
+	function("testMCMCAllocations", &testMCMCAllocations);
+	function("testMixtureLogLikelihoodRatios", &testMixtureLogLikelihoodRatios);
+	function("testMixtureAssignmentSampler", &testMixtureAssignmentSampler);
+	function("testRFPLikelihoodCache", &testRFPLikelihoodCache);
+	function("testPANSELogLikelihoodRatios", &testPANSELogLikelihoodRatios);
+	function("testDelayedAcceptanceRatios", &testDelayedAcceptanceRatios);
+	function("testCodonSpecificParameterGradient", &testCodonSpecificParameterGradient);
+	function("testPosteriorMode", &testPosteriorMode);
+	function("testJobConfig", &testJobConfig);
+	function("testSimulateGenome", &testSimulateGenome);
+	function("testSelectionCoefficients", &testSelectionCoefficients);
+	function("testCodonEncoding", &testCodonEncoding);
+	function("testCodonTable", &testCodonTable);
+	function("testHyperParameterLogLikelihoodRatios", &testHyperParameterLogLikelihoodRatios);
+	function("testCrossValidation", &testCrossValidation);
+	function("testLBFGSOptimizer", &testLBFGSOptimizer);
 }
 #endif
@@ -293,7 +293,7 @@ std::vector<std::vector<std::vector<double>>> Trace::getSynthesisRateAcceptanceR
 std::vector<double> Trace::getCodonSpecficAcceptanceRatioTraceForAA(std::string aa)
 {
 	aa[0] = (char)std::toupper(aa[0]);
-	unsigned aaIndex = SequenceSummary::aaToIndex.find(aa)->second;
+	unsigned aaIndex = SequenceSummary::AAToAAIndex(aa);
 	return codonSpecificAcceptanceRatioTrace[aaIndex];
 }
 
@@ -354,6 +354,20 @@ std::vector<std::vector<std::vector<std::vector<double>>>>* Trace::getCodonSpeci
 }
 
 
+//Not copied, order: gene, samples
+std::vector<std::vector<double>>* Trace::getSynthesisRateTraceForCategory(unsigned expressionCategory)
+{
+	return &synthesisRateTrace[expressionCategory];
+}
+
+
+//Not copied, order: gene, samples
+std::vector<std::vector<unsigned>>* Trace::getMixtureAssignmentTraceForGenes()
+{
+	return &mixtureAssignmentTrace;
+}
+
+
 //----------------------------------//
 //---------- ROC Specific ----------//
 //----------------------------------//
@@ -0,0 +1,159 @@
+#ifndef CODONENCODING_H
+#define CODONENCODING_H
+
+
+// Lookup tables of one genetic code. Codon indices group the codons by amino acid in the order of aaLetters, the
+// codons of an amino acid in alphabetical order with the reference codon last and the stop codons (X) at the end.
+// Nucleotides are encoded in two bits (A = 0, C = 1, G = 2, T/U = 3, lower case accepted), a codon as
+// 16 * first + 4 * second + third. Parameter indices number the codons of every amino acid except its reference codon;
+// amino acids with a single codon and stop codons have none. All lookups are constexpr, so they can be used in
+// constant expressions and cost one array access at run time.
+struct GeneticCode
+{
+	static constexpr unsigned numCodons = 64u;
+	static constexpr unsigned maxNumAA = 25u; // the 22 of the standard code and leucine, serine and threonine split off
+	static constexpr unsigned maxCodonsPerAA = 6u; // the models store at most five parameters per amino acid
+	static constexpr unsigned invalidNucleotide = 4u;
+	static constexpr unsigned invalidCodon = 64u;
+	static constexpr unsigned invalidAA = 25u;
+
+	unsigned tableId; // NCBI translation table
+	bool splitAA; // serine, leucine and threonine codons outside their standard codon box have their own amino acid
+	unsigned numAA; // including X, which is always last
+	unsigned numParameterCodons;
+	unsigned char packedToCodonIndex[numCodons];
+	unsigned char codonToAA[numCodons];
+	unsigned char codonToParameter[numCodons]; // invalidCodon for codons without parameter
+	unsigned char parameterToCodon[numCodons];
+	unsigned char aaCodonStart[maxNumAA + 1]; // aaCodonStart[numAA] is the end of X
+	unsigned char aaParameterStart[maxNumAA + 1];
+	unsigned char letterToAA[26]; // A to Z, invalidAA for letters that are not amino acids of this code
+	char aaLetters[maxNumAA + 1];
+	char codonNames[numCodons][4];
+
+	static constexpr unsigned nucleotideToCode(char nucleotide)
+	{
+		return (nucleotide == 'A' || nucleotide == 'a') ? 0u : (nucleotide == 'C' || nucleotide == 'c') ? 1u :
+			(nucleotide == 'G' || nucleotide == 'g') ? 2u :
+			(nucleotide == 'T' || nucleotide == 't' || nucleotide == 'U' || nucleotide == 'u') ? 3u : invalidNucleotide;
+	}
+
+	// invalidCodon if a nucleotide is not valid
+	constexpr unsigned codonIndex(char first, char second, char third) const
+	{
+		return (nucleotideToCode(first) | nucleotideToCode(second) | nucleotideToCode(third)) > 3u ? invalidCodon :
+			packedToCodonIndex[nucleotideToCode(first) * 16u + nucleotideToCode(second) * 4u + nucleotideToCode(third)];
+	}
+
+	constexpr unsigned codonIndex(const char *codon) const
+	{
+		return codonIndex(codon[0], codon[1], codon[2]);
+	}
+
+	constexpr unsigned codonToAAIndex(unsigned codonIndex) const
+	{
+		return codonIndex < numCodons ? codonToAA[codonIndex] : invalidAA;
+	}
+
+	// invalidCodon for reference codons, amino acids with a single codon and stop codons
+	constexpr unsigned codonToParameterIndex(unsigned codonIndex) const
+	{
+		return codonIndex < numCodons ? codonToParameter[codonIndex] : invalidCodon;
+	}
+
+	constexpr unsigned parameterToCodonIndex(unsigned parameterIndex) const
+	{
+		return parameterIndex < numParameterCodons ? parameterToCodon[parameterIndex] : invalidCodon;
+	}
+
+	// amino acid index of a one letter code (upper case), invalidAA for other characters
+	constexpr unsigned aaIndex(char aa) const
+	{
+		return (aa >= 'A' && aa <= 'Z') ? letterToAA[aa - 'A'] : invalidAA;
+	}
+
+	constexpr char aaLetter(unsigned aaIndex) const
+	{
+		return aaIndex < numAA ? aaLetters[aaIndex] : '#';
+	}
+
+	// codons of an amino acid are [aaCodonBegin, aaCodonEnd), its parameters [aaParameterBegin, aaParameterEnd)
+	constexpr unsigned aaCodonBegin(unsigned aaIndex) const
+	{
+		return aaIndex < numAA ? aaCodonStart[aaIndex] : 0u;
+	}
+
+	constexpr unsigned aaCodonEnd(unsigned aaIndex) const
+	{
+		return aaIndex < numAA ? aaCodonStart[aaIndex + 1] : 0u;
+	}
+
+	constexpr unsigned aaParameterBegin(unsigned aaIndex) const
+	{
+		return aaIndex < numAA ? aaParameterStart[aaIndex] : 0u;
+	}
+
+	constexpr unsigned aaParameterEnd(unsigned aaIndex) const
+	{
+		return aaIndex < numAA ? aaParameterStart[aaIndex + 1] : 0u;
+	}
+
+	constexpr unsigned numCodonsForAA(unsigned aaIndex, bool forParamVector = false) const
+	{
+		return forParamVector ? aaParameterEnd(aaIndex) - aaParameterBegin(aaIndex) :
+			aaCodonEnd(aaIndex) - aaCodonBegin(aaIndex);
+	}
+
+	// first stop codon, all codons before it are sense codons
+	constexpr unsigned numSenseCodons() const
+	{
+		return aaCodonStart[numAA - 1];
+	}
+};
+
+
+// The standard code as a compile time constant and the genetic code selected for the analysis. The selected code is
+// process wide: select it (CodonTable::useCodonTable) before genomes are read and parameters are set up, never while
+// a model is running. Code paths that matter for speed check isStandardCode() once and use standardCode directly, so
+// the compiler can fold its tables.
+class CodonEncoding
+{
+	private:
+		static const GeneticCode *active;
+		static GeneticCode selected;
+
+	public:
+		static constexpr GeneticCode standardCode = {1u, true, 22u, 40u,
+			{21, 30, 22, 31, 48, 49, 50, 51, 38, 59, 39, 60, 18, 19, 29, 20, 36, 16, 37, 17, 32, 33, 34, 35, 40, 41, 42, 43, 23,
+				24, 25, 26, 8, 6, 9, 7, 0, 1, 2, 3, 12, 13, 14, 15, 52, 53, 54, 55, 61, 57, 62, 58, 44, 45, 46, 47, 63, 4, 56, 5,
+				27, 10, 28, 11},
+			{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 5, 5, 6, 6, 7, 7, 7, 8, 8, 9, 9, 9, 9, 9, 9, 10, 11, 11, 12, 12, 12, 12,
+				13, 13, 14, 14, 14, 14, 14, 14, 15, 15, 15, 15, 16, 16, 16, 16, 17, 17, 17, 17, 18, 19, 19, 20, 20, 21, 21, 21},
+			{0, 1, 2, 64, 3, 64, 4, 64, 5, 64, 6, 64, 7, 8, 9, 64, 10, 64, 11, 12, 64, 13, 64, 14, 15, 16, 17, 18, 64, 64, 19,
+				64, 20, 21, 22, 64, 23, 64, 24, 25, 26, 27, 28, 64, 29, 30, 31, 64, 32, 33, 34, 64, 35, 36, 37, 64, 64, 38, 64,
+				39, 64, 64, 64, 64},
+			{0, 1, 2, 4, 6, 8, 10, 12, 13, 14, 16, 18, 19, 21, 23, 24, 25, 26, 27, 30, 32, 33, 34, 36, 38, 39, 40, 41, 42, 44,
+				45, 46, 48, 49, 50, 52, 53, 54, 57, 59},
+			{0, 4, 6, 8, 10, 12, 16, 18, 21, 23, 29, 30, 32, 36, 38, 44, 48, 52, 56, 57, 59, 61, 64},
+			{0, 3, 4, 5, 6, 7, 10, 11, 13, 14, 19, 19, 20, 23, 24, 29, 32, 35, 38, 38, 39, 40, 40},
+			{0, 25, 1, 2, 3, 4, 5, 6, 7, 25, 8, 9, 10, 11, 25, 12, 13, 14, 15, 16, 25, 17, 18, 21, 19, 20},
+			"ACDEFGHIKLMNPQRSTVWYZX",
+			{"GCA", "GCC", "GCG", "GCT", "TGC", "TGT", "GAC", "GAT", "GAA", "GAG", "TTC", "TTT", "GGA", "GGC", "GGG", "GGT",
+				"CAC", "CAT", "ATA", "ATC", "ATT", "AAA", "AAG", "CTA", "CTC", "CTG", "CTT", "TTA", "TTG", "ATG", "AAC", "AAT",
+				"CCA", "CCC", "CCG", "CCT", "CAA", "CAG", "AGA", "AGG", "CGA", "CGC", "CGG", "CGT", "TCA", "TCC", "TCG", "TCT",
+				"ACA", "ACC", "ACG", "ACT", "GTA", "GTC", "GTG", "GTT", "TGG", "TAC", "TAT", "AGC", "AGT", "TAA", "TAG", "TGA"}};
+
+		static const GeneticCode& activeCode()
+		{
+			return *active;
+		}
+
+		static bool isStandardCode()
+		{
+			return active == &standardCode;
+		}
+
+		static void setActiveCode(const GeneticCode &code);
+};
+
+#endif // CODONENCODING_H
@@ -2,11 +2,8 @@
 #define CodonTable_H
 
 #include <string>
-#include <map>
-#include <algorithm>
-#include <cctype>
 #include <vector>
-#include <array>
+#include "CodonEncoding.h"
 
 class CodonTable
 {
@@ -14,7 +11,9 @@ class CodonTable
 
         unsigned tableId;
         bool splitAA;
-        std::vector<std::vector<unsigned>> codon_mapping; // dim: AA, codon
+        GeneticCode code; // lookup tables, generated once by setupCodonTable
+
+        static const char *translationTables[25]; // NCBI amino acids of the codons in TCAG order, NULL if not a table
 
 
 
@@ -22,17 +21,9 @@ class CodonTable
         static const std::string Ser2;
         static const std::string Ser1; // necessary for codon table 12
         static const std::string Thr4_1; // necessary for codon table 3
-        static const std::string Thr4_2; // necessary for codon table 3
         static const std::string Leu1; // necessary for codon table 16, 22
 
-		static const std::string AminoAcidArray[]; // dim: table, AA
-		static const unsigned numCodonsPerAAForTable[25][26]; // dim: table, AA
 		static const std::string codonTableDefinition[25];
-		static const std::string codonArray[];
-		static const std::string codonArrayParameter[];
-		static const std::map<std::string, unsigned> aaToIndex;
-		static const std::map<std::string, unsigned> codonToIndexWithReference;
-		static const std::map<std::string, unsigned> codonToIndexWithoutReference;
 
 
         //Constructors & destructors:
@@ -43,9 +34,18 @@ class CodonTable
         CodonTable& operator=(const CodonTable& other);
 
         void setupCodonTable();
+        unsigned getTableId();
+        bool getSplitAA();
+        const GeneticCode& getGeneticCode();
         unsigned AAToAAIndex(std::string aa);
         unsigned getNumCodons(std::string aa);
         unsigned getNumCodons(unsigned aa);
+        std::vector<std::string> getAminoAcids();
+        std::vector<std::string> AAToCodon(std::string aa, bool forParamVector = false);
+        void activate();
+
+        static void useCodonTable(unsigned tableId, bool splitAA = true);
+        static unsigned getActiveCodonTable();
 
 };
 
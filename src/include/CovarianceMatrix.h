@@ -14,9 +14,10 @@ class CovarianceMatrix
     private:
         std::vector<double> covMatrix;
         std::vector<double> choleskiMatrix;
+        std::vector<double> packedCholeskiMatrix; // nonzero (lower) part of choleskiMatrix, row by row
         int numVariates; //make static const again
 
-		double sampleMean(std::vector<double> sampleVector, unsigned samples, unsigned lastIteration);
+		double sampleMean(std::vector<double> &sampleVector, unsigned samples, unsigned lastIteration);
 
     public:
         //Constructors & Destructors:
@@ -36,12 +37,14 @@ class CovarianceMatrix
 	    void initCovarianceMatrix(unsigned _numVariates);
 		void setDiag(double val);
         void choleskiDecomposition();
+        bool invert();
 	    void printCovarianceMatrix();
         void printCholeskiMatrix();
         std::vector<double>* getCovMatrix();
         int getNumVariates();
         std::vector<double> transformIidNumersIntoCovaryingNumbers(std::vector<double> iidnumbers);
-		void calculateSampleCovariance(std::vector<std::vector<std::vector<std::vector<double>>>> codonSpecificParameterTrace, std::string aa, unsigned samples, unsigned lastIteration);
+        void transformIidNumersIntoCovaryingNumbers(const double *iidnumbers, double *covnumbers);
+		void calculateSampleCovariance(std::vector<std::vector<std::vector<std::vector<double>>>> &codonSpecificParameterTrace, std::string aa, unsigned samples, unsigned lastIteration);
 
 #ifndef STANDALONE
     void setCovarianceMatrix(SEXP _matrix);
@@ -0,0 +1,46 @@
+#ifndef CROSSVALIDATION_H
+#define CROSSVALIDATION_H
+
+#include <vector>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include "base/Model.h"
+
+// Gene sets for k-fold cross validation and bootstrap runs, and the posterior predictive log likelihood of genes a
+// run was not fit to. The runs themselves are driven by the job runner, see runCrossValidationJob in main.cpp.
+class CrossValidation
+{
+	private:
+		double stepWidth; // quadrature step in standard deviations of the integrand at its mode
+
+		double integrateSynthesisRate(Gene& gene, Model& model, unsigned mixtureElement, double mean, double sd,
+				double &mode, std::vector<double> &phiValues, std::vector<double> &logLikelihoods,
+				std::vector<double> &logTerms);
+
+	public:
+		//Constructors & Destructors:
+		explicit CrossValidation(double _stepWidth = 0.5);
+		virtual ~CrossValidation();
+
+
+
+		//Gene Set Functions:
+		static void createFolds(unsigned numGenes, unsigned numFolds, unsigned seed,
+				std::vector<std::vector<unsigned>> &trainingGenes, std::vector<std::vector<unsigned>> &heldOutGenes);
+		static void createBootstrapSample(unsigned numGenes, unsigned seed, std::vector<unsigned> &trainingGenes,
+				std::vector<unsigned> &heldOutGenes);
+
+
+
+		//Predictive Functions:
+		std::vector<double> calculatePredictiveLogLikelihoods(Genome& genome, Model& model, Parameter& parameter,
+				unsigned samples);
+		double getStepWidth();
+
+
+	protected:
+};
+
+#endif // CROSSVALIDATION_H
@@ -8,6 +8,15 @@ class FONSEModel : public Model
 {
 	private:
 		FONSEParameter *parameter;
+
+		//Per grouping values gathered by calculateLogLikelihoodRatioForAllGroupings, kept between iterations
+		std::vector<std::string> groupingNames;
+		std::vector<unsigned> groupingAAIndex;
+		std::vector<double> groupingMutation; // [grouping][mutation category][5]
+		std::vector<double> groupingMutationProposed;
+		std::vector<double> groupingSelection; // [grouping][selection category][5]
+		std::vector<double> groupingSelectionProposed;
+
 		double calculateLogLikelihoodRatioPerAA(Gene& gene, std::string grouping, double *mutation, double *selection, double phiValue);
 		double calculateMutationPrior(std::string grouping, bool proposed = false);
 
@@ -22,6 +31,12 @@ class FONSEModel : public Model
 		virtual void calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex, unsigned k, double* logProbabilityRatio);
 		virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome, double& logAcceptanceRatioForAllMixtures);
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> &logProbabilityRatio);
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios);
+		virtual void calculateLogLikelihoodRatioForGroupings(Genome& genome, unsigned firstGene, unsigned geneStride,
+				const char* groupingMask, std::vector<double> &logAcceptanceRatios);
+		virtual bool hasSubsampleSurrogate();
+		virtual void calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+				std::vector<double> &logLikelihoods);
 
 
 
@@ -104,6 +119,8 @@ class FONSEModel : public Model
 		virtual void updateHyperParameter(unsigned hp);
 
 		virtual void simulateGenome(Genome &genome);
+		virtual void simulateCodonSequences(Genome &genome, unsigned firstGene, unsigned numGenes, unsigned seed,
+				std::vector<std::string> &sequences);
 		virtual void printHyperParameters();
 		void setParameter(FONSEParameter &_parameter);
 		virtual double calculateAllPriors();
@@ -44,6 +44,7 @@ class Gene
 		void setDescription(std::string _desc);
 		std::string getSequence();
 		void setSequence(std::string _seq);
+		void setSummarizedSequence(std::string _seq);
 		std::vector <unsigned> getRFP_count(); //Only for unit testing.
 		void addRFP_count(std::vector <unsigned> RFP_counts);
 		SequenceSummary *getSequenceSummary();
@@ -7,6 +7,7 @@
 #include <fstream>
 #include <sstream>
 #include <cmath>
+#include <memory>
 
 #ifndef STANDALONE
 #include <Rcpp.h>
@@ -19,11 +20,24 @@ class Genome
 {
 	private:
 
-		std::vector<Gene> genes;
-		std::vector<Gene> simulatedGenes;
+		//Genes are stored once and shared by a genome, its copies and the subsets made by getGenomeForGeneIndicies.
+		//Functions changing the genes make a private copy first, genes reached through getGene must not be changed
+		//while the storage is shared (see isGeneStorageShared).
+		struct GeneSet
+		{
+			std::shared_ptr<std::vector<Gene>> storage;
+			std::vector<unsigned> view; //indices into storage if isView, all of storage otherwise
+			bool isView;
+		};
+
+		GeneSet geneSet;
+		GeneSet simulatedGeneSet;
 		std::vector <unsigned> numGenesWithPhi; //Number of phi sets is vector size, value is number of genes
 												//with a phi value for that set. Values should currently be equal.
 
+		std::vector<Gene>& getOwnGenes(bool simulated);
+		const Gene& geneAt(unsigned index, bool simulated) const;
+
 	public:
 
 		//Constructors & Destructors:
@@ -39,8 +53,10 @@ class Genome
 		void readRFPFile(std::string filename);
 		void writeRFPFile(std::string filename, bool simulated = false);
 		void readPANSEFile(std::string filename, bool Append = false);
-		//TODO: Add writePANSEFile function
+		void writePANSEFile(std::string filename, bool simulated = false);
 		void readObservedPhiValues(std::string filename, bool byId = true);
+		void writeGenomeCache(std::string filename, std::vector<std::string> sourceFiles, bool withPositions = true);
+		bool readGenomeCache(std::string filename, std::vector<std::string> sourceFiles, bool Append = false);
 
 
 		//Gene Functions:
@@ -49,12 +65,14 @@ class Genome
 		unsigned getNumGenesWithPhiForIndex(unsigned index);
 		Gene& getGene(unsigned index, bool simulated = false);
 		Gene& getGene(std::string id, bool simulated = false);
+		bool isGeneStorageShared(bool simulated = false);
 
 
 		//Other Functions:
 		unsigned getGenomeSize(bool simulated = false);
+		void setGenomeSize(unsigned size, bool simulated = false);
 		void clear();
-		Genome getGenomeForGeneIndicies(std::vector <unsigned> indicies, bool simulated = false); //NOTE: If simulated is true, it will return a genome with the simulated genes, but the returned genome's genes vector will contain the simulated genes.
+		Genome getGenomeForGeneIndicies(std::vector <unsigned> indicies, bool simulated = false); //NOTE: The returned genome shares the genes of this genome, the selected genes are simulated genes there if simulated is true.
 		std::vector<unsigned> getCodonCountsPerGene(std::string codon);
 
 
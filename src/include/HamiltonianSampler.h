@@ -0,0 +1,75 @@
+#ifndef HAMILTONIANSAMPLER_H
+#define HAMILTONIANSAMPLER_H
+
+#include <vector>
+#include <cmath>
+#include <limits>
+
+#include "base/Model.h"
+
+class HamiltonianSampler
+{
+	private:
+		unsigned numSteps; // leapfrog steps per trajectory
+		double targetAcceptance;
+		bool initialized;
+		bool adapting;
+
+		unsigned numGroupings;
+		std::vector<unsigned> groupingOffsets; // [grouping + 1], see Model::getCodonSpecificParameterVector
+		std::vector<double> inverseMetric; // [parameter], diagonal
+		std::vector<double> stepSize; // [grouping]
+
+		//Step size adaptation by dual averaging (Hoffman & Gelman 2014):
+		unsigned adaptationCount;
+		std::vector<double> logStepSizeTarget; // [grouping]
+		std::vector<double> logStepSizeAverage; // [grouping]
+		std::vector<double> acceptanceStatistic; // [grouping]
+
+		//Metric adaptation from the variance of the parameters over windows of doubling length:
+		unsigned windowSize;
+		unsigned windowCount;
+		std::vector<double> windowMean; // [parameter]
+		std::vector<double> windowSquares; // [parameter], sum of squared deviations from windowMean
+
+		//Trajectory scratch space:
+		std::vector<double> initialPosition; // [parameter]
+		std::vector<double> position; // [parameter]
+		std::vector<double> momentum; // [parameter]
+		std::vector<double> gradient; // [parameter]
+		std::vector<double> curvature; // [parameter]
+		std::vector<double> initialLogPosterior; // [grouping]
+		std::vector<double> logPosterior; // [grouping]
+		std::vector<double> trajectoryStepSize; // [grouping]
+
+		void initialize(Genome& genome, Model& model);
+		void restartStepSizeAdaptation();
+		void adaptStepSize(std::vector<double> &logAcceptanceRatios);
+		void accumulateWindow();
+		void updateMetric();
+		double calculateKineticEnergy(unsigned grouping);
+
+	public:
+		//Constructors & Destructors:
+		HamiltonianSampler();
+		virtual ~HamiltonianSampler();
+
+
+
+		//Sampling Functions:
+		void reset();
+		void proposeCodonSpecificParameter(Genome& genome, Model& model, bool adapt, std::vector<double> &logAcceptanceRatios);
+
+
+
+		//Getter & Setter Functions:
+		unsigned getNumSteps();
+		void setNumSteps(unsigned steps);
+		double getStepSize(unsigned grouping);
+		double getInverseMetric(unsigned index);
+
+
+	protected:
+};
+
+#endif // HAMILTONIANSAMPLER_H
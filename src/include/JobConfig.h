@@ -0,0 +1,74 @@
+#ifndef JOBCONFIG_H
+#define JOBCONFIG_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <fstream>
+#include <sstream>
+#include <cstdlib>
+#include <cerrno>
+#include <cctype>
+
+
+// Reader for the subset of TOML used by job files: [tables], key = value pairs with strings, integers, floats,
+// booleans and (nested) arrays of those, and # comments. Keys are stored as "table.key". Inline tables, arrays of
+// tables and dates are not supported.
+class JobConfig
+{
+	private:
+		enum ValueType {stringValue, integerValue, floatValue, booleanValue, arrayValue};
+
+		struct Value
+		{
+			ValueType type;
+			std::string text; // unquoted string or the literal as written
+			std::vector<Value> items; // arrayValue only
+			unsigned line;
+		};
+
+		std::map<std::string, Value> values;
+		std::vector<std::string> errors;
+
+		bool parseValue(std::string &line, size_t &pos, unsigned lineNumber, Value &value, std::istream &input,
+			unsigned &lastLine);
+		bool parseString(const std::string &line, size_t &pos, unsigned lineNumber, std::string &text);
+		bool parseKey(const std::string &line, size_t &pos, unsigned lineNumber, std::string &key);
+		void addError(unsigned lineNumber, std::string message);
+		bool convertToDouble(const Value &value, double &out);
+		const Value* findValue(std::string key, ValueType type, std::string typeName);
+
+	public:
+		//Constructors & Destructors:
+		JobConfig();
+		virtual ~JobConfig();
+
+
+
+		//Reading Functions:
+		bool readFile(std::string filename);
+		bool readString(std::string text);
+		bool read(std::istream &input);
+
+
+
+		//Getter Functions:
+		bool hasKey(std::string key);
+		std::vector<std::string> getKeys();
+		std::string getString(std::string key, std::string defaultValue = "");
+		long getInteger(std::string key, long defaultValue = 0);
+		unsigned getUnsigned(std::string key, unsigned defaultValue = 0u);
+		double getDouble(std::string key, double defaultValue = 0.0);
+		bool getBool(std::string key, bool defaultValue = false);
+		std::vector<std::string> getStringArray(std::string key);
+		std::vector<double> getDoubleArray(std::string key);
+		std::vector<std::vector<unsigned>> getUnsignedMatrix(std::string key);
+
+		bool hasError();
+		std::vector<std::string> getErrors();
+
+
+	protected:
+};
+
+#endif // JOBCONFIG_H
@@ -0,0 +1,55 @@
+#ifndef LBFGSOPTIMIZER_H
+#define LBFGSOPTIMIZER_H
+
+#include <vector>
+#include <cmath>
+#include <limits>
+
+
+// Function to minimize. evaluate returns the value at x and stores the gradient.
+class LBFGSObjective
+{
+	public:
+		virtual ~LBFGSObjective() {}
+		virtual double evaluate(std::vector<double> &x, std::vector<double> &gradient) = 0;
+};
+
+
+class LBFGSOptimizer
+{
+	friend int testLBFGSOptimizer(); // checks the stored correction pairs
+
+	private:
+		unsigned historySize;
+		unsigned numStored; // number of stored correction pairs, at most historySize
+		unsigned newest; // index of the newest pair in the ring buffers
+		std::vector<std::vector<double>> positionChanges; // [pair][parameter]
+		std::vector<std::vector<double>> gradientChanges; // [pair][parameter]
+		std::vector<double> curvatures; // [pair], 1 / (gradient change * position change)
+		std::vector<double> weights; // [pair], scratch of the two loop recursion
+		std::vector<double> gradient;
+		std::vector<double> direction;
+		std::vector<double> trialPosition;
+		std::vector<double> trialGradient;
+		std::vector<double> positionChange; // pair of the last step until it is accepted
+		std::vector<double> gradientChange;
+		double value;
+
+		void calculateDirection();
+
+	public:
+		//Constructors & Destructors:
+		explicit LBFGSOptimizer(unsigned _historySize = 7u);
+		virtual ~LBFGSOptimizer();
+
+
+
+		//Optimization Functions:
+		unsigned minimize(LBFGSObjective &objective, std::vector<double> &x, unsigned maxIterations, double tolerance);
+		double getValue();
+
+
+	protected:
+};
+
+#endif // LBFGSOPTIMIZER_H
@@ -15,11 +15,15 @@
 #include "ROC/ROCModel.h"
 #include "RFP/RFPModel.h"
 #include "FONSE/FONSEModel.h"
+#include "MixtureAssignmentSampler.h"
+#include "HamiltonianSampler.h"
 
 
 
 class MCMCAlgorithm
 {
+	friend int testMCMCAllocations(); // drives single iterations of the accept/reject functions
+
 	private:
 		unsigned samples;
 		unsigned thining;
@@ -44,10 +48,69 @@ class MCMCAlgorithm
 		bool multipleFiles;
 
 
+		//Threading:
+		std::string threadAffinity; // "none", "close" or "spread"
+		std::vector<int> unpinnedCpus; // cpus the calling thread could run on before pinThreads
+		std::vector<double> geneLogProbabilityRatios; // [gene][mixture][5], see calculateLogProbabilityRatiosForAllGenes
+		double parallelWallTime;
+		std::vector<double> threadComputeTime;
+
+
+		//Profiling:
+		enum ProfilePhase {CSP_PHASE, HYPER_PHASE, PHI_PHASE, TRACE_PHASE, ADAPTATION_PHASE, RESTART_PHASE, GEWEKE_PHASE,
+			NUM_PROFILE_PHASES};
+		bool profiling;
+		std::string profileFile; // JSON report written at the end of a run, empty for none
+		std::vector<double> phaseTime; // [ProfilePhase] seconds
+		std::vector<unsigned> phaseCalls; // [ProfilePhase]
+		std::chrono::steady_clock::time_point runStart;
+
+
+		//Iteration scratch space, sized by initIterationScratch so the MCMC loop does not allocate:
+		std::vector<std::vector<unsigned>> mixtureElementsOfCategory; // [synthesis rate category]
+		std::vector<unsigned> mixtureElements; // all of mixtureElementsOfCategory in order
+		std::vector<double> synthesisRateScratch; // per gene sums and probabilities, see acceptRejectSynthesisRateLevelForAllGenes
+		MixtureAssignmentSampler mixtureSampler; // mixture probabilities and assignments of all genes
+
+		//Delayed acceptance:
+		bool delayedAcceptance;
+		double delayedAcceptanceFraction; // fraction of genes used by the first stage
+		bool delayedAcceptanceActive; // delayedAcceptance and supported by the model of the current run
+		std::vector<double> surrogateLogAcceptanceRatios; // [grouping], first stage
+		std::vector<char> delayedAcceptanceMask; // [grouping], proposals that passed the first stage
+		unsigned long firstStageProposals;
+		unsigned long firstStagePassed;
+
+		//Hamiltonian Monte Carlo:
+		bool hamiltonian;
+		bool hamiltonianActive; // hamiltonian and supported by the model of the current run
+		HamiltonianSampler hamiltonianSampler;
+		std::vector<double> logAcceptanceRatios; // [grouping]
+		std::vector<double> hyperParameterLogProbabilityRatios;
+
+		//Posterior mode start:
+		bool posteriorModeStart;
+		unsigned posteriorModeRounds; // maximum number of optimization rounds
+
+
 		//Acceptance Rejection Functions:
 		double acceptRejectSynthesisRateLevelForAllGenes(Genome& genome, Model& model, int iteration);
 		void acceptRejectCodonSpecificParameter(Genome& genome, Model& model, int iteration);
 		void acceptRejectHyperParameter(Genome &genome, Model& model, int iteration);
+		void calculateLogProbabilityRatiosForAllGenes(Genome& genome, Model& model, std::vector<unsigned> &mixtureElements);
+		void initIterationScratch(Genome& genome, Model& model);
+
+		//Threading Functions:
+		void pinThreads(unsigned numCores);
+		void unpinThreads();
+		void printParallelTimes();
+
+		//Profiling Functions:
+		std::chrono::steady_clock::time_point startPhase();
+		void stopPhase(ProfilePhase phase, std::chrono::steady_clock::time_point start,
+			ProfilePhase enclosingPhase = NUM_PROFILE_PHASES);
+		void printProfile();
+		void writeProfile();
 
 	public:
 
@@ -63,6 +126,7 @@ class MCMCAlgorithm
 		//MCMC Functions:
 		void run(Genome& genome, Model& model, unsigned numCores = 1u, unsigned divergenceIterations = 0u);
 		void varyInitialConditions(Genome& genome, Model& model, unsigned divergenceIterations);
+		void findPosteriorMode(Genome& genome, Model& model);
 		double calculateGewekeScore(unsigned current_iteration);
 
 		bool isEstimateSynthesisRate();
@@ -78,6 +142,16 @@ class MCMCAlgorithm
 		void setRestartFileSettings(std::string filename, unsigned interval, bool multiple);
 		void setStepsToAdapt(unsigned steps);
 		int getStepsToAdapt();
+		void setThreadAffinity(std::string affinity);
+		std::string getThreadAffinity();
+		void setProfiling(bool in, std::string filename);
+		bool isProfiling();
+		void setDelayedAcceptance(bool in, double fraction);
+		bool isDelayedAcceptance();
+		void setHamiltonianMonteCarlo(bool in, unsigned steps);
+		bool isHamiltonianMonteCarlo();
+		void setPosteriorModeStart(bool in, unsigned rounds);
+		bool isPosteriorModeStart();
 
 		std::vector<double> getLogLikelihoodTrace();
 		double getLogLikelihoodPosteriorMean(unsigned samples);
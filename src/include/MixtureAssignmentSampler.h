@@ -0,0 +1,52 @@
+#ifndef MIXTUREASSIGNMENTSAMPLER_H
+#define MIXTUREASSIGNMENTSAMPLER_H
+
+#include <vector>
+#include <cmath>
+
+#include "base/Parameter.h"
+
+class MixtureAssignmentSampler
+{
+	private:
+		unsigned numGenes;
+		unsigned numMixtures;
+
+		std::vector<double> logPosterior; // [gene][mixture], unnormalized
+		std::vector<double> probabilities; // [gene][mixture]
+		std::vector<double> logNormalizingConstant; // [gene]
+		std::vector<double> referenceValues; // [gene], U(0,1) draws of drawAssignments
+		std::vector<unsigned> assignments; // [gene]
+		std::vector<double> partialCounts; // [thread][mixture], see countAssignments
+		std::vector<double> counts; // [mixture]
+
+	public:
+		//Constructors & Destructors:
+		MixtureAssignmentSampler();
+		virtual ~MixtureAssignmentSampler();
+
+
+
+		//Sampling Functions:
+		void resize(unsigned _numGenes, unsigned _numMixtures);
+		void calculateProbabilities(const double *mixtureProbabilities);
+		void drawAssignments();
+		void assign(const double *uniformNumbers);
+		void countAssignments();
+
+
+
+		//Getter Functions:
+		unsigned getNumGenes();
+		unsigned getNumMixtures();
+		double* getLogPosterior(unsigned gene);
+		double* getProbabilities(unsigned gene);
+		double getLogNormalizingConstant(unsigned gene);
+		unsigned getAssignment(unsigned gene);
+		double* getCounts();
+
+
+	protected:
+};
+
+#endif // MIXTUREASSIGNMENTSAMPLER_H
@@ -1,17 +1,37 @@
 #ifndef PANSEMODEL_H
 #define PANSEMODEL_H
 
+#include <vector>
+#include <limits>
+#include <algorithm>
 
 #include "../base/Model.h"
 #include "PANSEParameter.h"
 
 
-class PANSEModel: public Model {
+class PANSEModel: public Model
+{
 	private:
 		PANSEParameter *parameter;
 
-		virtual double calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime,
-				unsigned currRFPObserved, unsigned currNumCodonsInMRNA, double phiValue);
+		//Terms shared by all positions of a codon. Indexed by [category][codon] and keyed by the alpha and lambda prime
+		//value they were computed with, see refreshCodonTerms.
+		std::vector<std::vector<double>> termAlpha;
+		std::vector<std::vector<double>> termLogAlpha;
+		std::vector<std::vector<double>> termLogGammaAlpha;
+		std::vector<std::vector<double>> termLambdaPrime;
+		std::vector<std::vector<double>> termLogLambdaPrime;
+		unsigned numCodons;
+
+		double calculateLogLikelihoodPerCodonPerGene(double alpha, double logAlpha, double logGammaAlpha,
+				double lambdaPrime, double logLambdaPrime, const unsigned* rfpCounts, unsigned numRFPCounts,
+				unsigned numCodonsInMRNA, double phiValue, double logPhiValue);
+		double calculateLogGammaRatioSum(double alpha, double logAlpha, double logGammaAlpha, const unsigned* rfpCounts,
+				unsigned numRFPCounts, unsigned &rfpSum);
+		void refreshCodonTerms();
+		void calculateProposedCodonTerms(unsigned codonIndex, std::vector<double> &alpha, std::vector<double> &logAlpha,
+				std::vector<double> &logGammaAlpha, std::vector<double> &lambdaPrime,
+				std::vector<double> &logLambdaPrime);
 
 
 	public:
@@ -20,154 +40,103 @@ class PANSEModel: public Model {
 		virtual ~PANSEModel();
 
 
-		//Likelihood ratio functions
+		//Likelihood Ratio Functions:
 		virtual void calculateLogLikelihoodRatioPerGene(Gene& gene, unsigned geneIndex, unsigned k,
 				double* logProbabilityRatio);
 		virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome,
 				double& logAcceptanceRatioForAllMixtures);
+		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
+				std::vector <double> &logProbabilityRatio);
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios);
+		virtual void prepareLogLikelihoodRatiosPerGene(std::vector<unsigned> &mixtureElements, unsigned numThreads);
 
 
-		//Other functions:
-		void setParameter(PANSEParameter &_parameter);
-		virtual void simulateGenome(Genome &genome);
+
+		//Initialization and Restart Functions:
+		virtual void initTraces(unsigned samples, unsigned num_genes);
+		virtual void writeRestartFile(std::string filename);
+
+
+
+		//Category Functions:
+		virtual double getCategoryProbability(unsigned i);
+		virtual unsigned getMutationCategory(unsigned mixture);
+		virtual unsigned getSelectionCategory(unsigned mixture);
+		virtual unsigned getSynthesisRateCategory(unsigned mixture);
+		virtual std::vector<unsigned> getMixtureElementsOfSelectionCategory(unsigned k);
+
+
+
+		//Group List Functions:
+		virtual unsigned getGroupListSize();
+		virtual std::string getGrouping(unsigned index);
+
+
+
+		//stdDevSynthesisRate Functions:
+		virtual double getStdDevSynthesisRate(unsigned selectionCategory, bool proposed = false);
+		virtual double getCurrentStdDevSynthesisRateProposalWidth();
+		virtual void updateStdDevSynthesisRate();
+
+
+
+		//Synthesis Rate Functions:
+		virtual double getSynthesisRate(unsigned index, unsigned mixture, bool proposed = false);
+		virtual void updateSynthesisRate(unsigned i, unsigned k);
+
 
 
-		//Parameter wrapper functions:
-		virtual void initTraces(unsigned samples, unsigned num_genes)
-		{
-			parameter->initAllTraces(samples, num_genes);
-		}
-		virtual void writeRestartFile(std::string filename)
-		{
-			return parameter->writeEntireRestartFile(filename);
-		}
-		virtual double getSphi(bool proposed = false)
-		{
-			return parameter->getSphi(proposed);
-		}
-		virtual unsigned getNumMixtureElements()
-		{
-			return parameter->getNumMixtureElements();
-		}
-		virtual double getCategoryProbability(unsigned i)
-		{
-			return parameter->getCategoryProbability(i);
-		}
-		virtual void proposeCodonSpecificParameter()
-		{
-			parameter->proposeCodonSpecificParameter();
-		}
-		virtual void adaptCodonSpecificParameterProposalWidth(unsigned adaptiveWidth)
-		{
-			parameter->adaptCodonSpecificParameterProposalWidth(adaptiveWidth);
-		}
-		virtual void updateCodonSpecificParameter(std::string aa)
-		{
-			parameter->updateCodonSpecificParameter(aa);
-		}
-		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string codon)
-		{
-			parameter->updateCodonSpecificParameterTrace(sample, codon);
-		}
-		virtual void proposeSPhi()
-		{
-			parameter->proposeSphi();
-		}
-		virtual unsigned getMixtureAssignment(unsigned index)
-		{
-			return parameter->getMixtureAssignment(index);
-		}
-		virtual unsigned getSynthesisRateCategory(unsigned mixture)
-		{
-			return parameter->getSynthesisRateCategory(mixture);
-		}
-		virtual unsigned getSelectionCategory(unsigned mixture)
-		{
-			return parameter->getSelectionCategory(mixture);
-		}
-		virtual unsigned getMutationCategory(unsigned mixture)
-		{
-			return parameter->getMutationCategory(mixture);
-		}
-		virtual double getSynthesisRate(unsigned index, unsigned mixture, bool proposed = false)
-		{
-			return parameter->getSynthesisRate(index, mixture, proposed);
-		}
-		virtual double getCurrentSphiProposalWidth()
-		{
-			return parameter->getCurrentSphiProposalWidth();
-		}
-		virtual void updateSphi()
-		{
-			parameter->updateSphi();
-		}
-		virtual void updateSphiTrace(unsigned sample)
-		{
-			parameter->updateSphiTrace(sample);
-		}
-		virtual void adaptSphiProposalWidth(unsigned adaptiveWidth)
-		{
-			parameter->adaptSphiProposalWidth(adaptiveWidth);
-		}
-		virtual void proposeSynthesisRateLevels()
-		{
-			parameter->proposeSynthesisRateLevels();
-		}
-		virtual unsigned getNumSynthesisRateCategories()
-		{
-			return parameter->getNumSynthesisRateCategories();
-		}
-		virtual std::vector<unsigned> getMixtureElementsOfSelectionCategory(unsigned k)
-		{
-			return parameter->getMixtureElementsOfSelectionCategory(k);
-		}
-		virtual void updateSynthesisRate(unsigned i, unsigned k)
-		{
-			parameter->updateSynthesisRate(i, k);
-		}
-		virtual void setMixtureAssignment(unsigned i, unsigned catOfGene)
-		{
-			parameter->setMixtureAssignment(i, catOfGene);
-		}
-		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i)
-		{
-			parameter->updateSynthesisRateTrace(sample, i);
-		}
-		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i)
-		{
-			parameter->updateMixtureAssignmentTrace(sample, i);
-		}
-		virtual void setCategoryProbability(unsigned mixture, double value)
-		{
-			parameter->setCategoryProbability(mixture, value);
-		}
-		virtual void updateMixtureProbabilitiesTrace(unsigned sample)
-		{
-			parameter->updateMixtureProbabilitiesTrace(sample);
-		}
-		virtual void adaptSynthesisRateProposalWidth(unsigned adaptiveWidth)
-		{
-			parameter->adaptSynthesisRateProposalWidth(adaptiveWidth);
-		}
-		virtual double getParameterForCategory(unsigned category, unsigned param, std::string codon, bool proposal)
-		{
-			return parameter->getParameterForCategory(category, param, codon, proposal);
-		}
-		virtual unsigned getListSize() //TODO: should not be static
-		{
-			return 61;
-		}
-		virtual std::string getGrouping(unsigned index)
-		{
-			return parameter->getGrouping(index);
-		}
-		virtual unsigned getGroupListSize() {return parameter->getGroupListSize();}
-
-		// R wrapper
-		std::vector<double> CalculateProbabilitiesForCodons(std::vector<double> mutation, std::vector<double> selection,
-				double phi);
+		//Iteration Functions:
+		virtual unsigned getLastIteration();
+		virtual void setLastIteration(unsigned iteration);
+
+
+
+		//Trace Functions:
+		virtual void updateStdDevSynthesisRateTrace(unsigned sample);
+		virtual void updateSynthesisRateTrace(unsigned sample, unsigned i);
+		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned i);
+		virtual void updateMixtureProbabilitiesTrace(unsigned sample);
+		virtual void updateCodonSpecificParameterTrace(unsigned sample, std::string codon);
+		virtual void updateHyperParameterTraces(unsigned sample);
+		virtual void updateTracesWithInitialValues(Genome &genome);
+
+
+
+		//Adaptive Width Functions:
+		virtual void adaptStdDevSynthesisRateProposalWidth(unsigned adaptiveWidth, bool adapt = true);
+		virtual void adaptSynthesisRateProposalWidth(unsigned adaptiveWidth, bool adapt = true);
+		virtual void adaptCodonSpecificParameterProposalWidth(unsigned adaptiveWidth, unsigned lastIteration, bool adapt = true);
+		virtual void adaptHyperParameterProposalWidths(unsigned adaptiveWidth, bool adapt = true);
+
+
+
+		//Other Functions:
+		virtual void proposeCodonSpecificParameter();
+		virtual void proposeHyperParameters();
+		virtual void proposeSynthesisRateLevels();
+
+		virtual unsigned getNumPhiGroupings();
+		virtual unsigned getMixtureAssignment(unsigned index);
+		virtual unsigned getNumMixtureElements();
+		virtual unsigned getNumSynthesisRateCategories();
+
+		virtual void setNumPhiGroupings(unsigned value);
+		virtual void setMixtureAssignment(unsigned i, unsigned catOfGene);
+		virtual void setCategoryProbability(unsigned mixture, double value);
+
+		virtual void updateCodonSpecificParameter(std::string aa);
+		virtual void updateGibbsSampledHyperParameters(Genome &genome);
+		virtual void updateAllHyperParameter();
+		virtual void updateHyperParameter(unsigned hp);
+
+		virtual void simulateGenome(Genome &genome);
+		virtual void printHyperParameters();
+		void setParameter(PANSEParameter &_parameter);
+		virtual double calculateAllPriors();
+		virtual double getParameterForCategory(unsigned category, unsigned param, std::string codon, bool proposal);
 
 	protected:
 };
 
-#endif //PANSEMODEL_H
+#endif // PANSEMODEL_H
@@ -1,11 +1,6 @@
 #ifndef PANSEPARAMETER_H
 #define PANSEPARAMETER_H
 
-
-#include "PANSETrace.h"
-#include "../base/Parameter.h"
-
-
 #include <vector>
 #include <random>
 #include <string>
@@ -16,125 +11,111 @@
 #include <Rcpp.h>
 #endif
 
+#include "../base/Trace.h"
+#include "../base/Parameter.h"
 
 class PANSEParameter: public Parameter {
 	private:
-		//Codon Specific Parameters:
-		std::vector<std::vector<double>> currentAlphaParameter;
-		std::vector<std::vector<double>> proposedAlphaParameter;
-		std::vector<std::vector<double>> currentLambdaPrimeParameter;
-		std::vector<std::vector<double>> proposedLambdaPrimeParameter;
-		std::vector<std::vector<double>> lambdaValues;
-		std::vector<unsigned> numAcceptForAlphaAndLambdaPrime;
+
+		std::vector<std::vector<double>> lambdaValues; //Currently not used.
 		double bias_csp;
-		std::vector<double> std_csp; //TODO: proposal bias and std for codon specific parameter, probably can move up to Parameter
 
-		//Functions:
-		std::vector<double> propose(std::vector<double> currentParam, double (*proposal)(double a, double b), double A,
-				std::vector<double> B);
 
 
 	public:
-		//Constructors & destructors:
+
+
+
+
+		//Constructors & Destructors:
 		explicit PANSEParameter();
 		PANSEParameter(std::string filename);
-		PANSEParameter(std::vector<double> sphi, unsigned _numMixtures, std::vector<unsigned> geneAssignment,
+		PANSEParameter(std::vector<double> stdDevSynthesisRate, unsigned _numMixtures, std::vector<unsigned> geneAssignment,
 				std::vector<std::vector<unsigned>> thetaKMatrix, bool splitSer = true,
 				std::string _mutationSelectionState = "allUnique");
-		virtual ~PANSEParameter();
 		PANSEParameter& operator=(const PANSEParameter& rhs);
+		virtual ~PANSEParameter();
 
 
-		//Initialization functions:
-		void initPANSEParameterSet();
-		void initAlpha(double alphaValue, unsigned mixtureElement, std::string codon);
-		void initLambdaPrime(double lambdaPrimeValue, unsigned mixtureElement, std::string codon);
-		void initMutationSelectionCategories(std::vector<std::string> files, unsigned numCategories,
-				unsigned paramType); //TODO: function needs to be changed
-
 
-		//Restart file functions:
+		//Initialization, Restart, Index Checking:
+		void initPANSEParameterSet();
+		void initPANSEValuesFromFile(std::string filename);
 		void writeEntireRestartFile(std::string filename);
 		void writePANSERestartFile(std::string filename);
 		void initFromRestartFile(std::string filename);
-		void initPANSEValuesFromFile(std::string filename);
 
-
-		//Trace functions:
-		PANSETrace& getTraceObject();
 		void initAllTraces(unsigned samples, unsigned num_genes);
-		virtual void updateSphiTrace(unsigned sample);
-		virtual void updateSynthesisRateTrace(unsigned sample, unsigned geneIndex);
-		virtual void updateMixtureAssignmentTrace(unsigned sample, unsigned geneIndex);
-		virtual void updateMixtureProbabilitiesTrace(unsigned samples);
+		void initAlpha(double alphaValue, unsigned mixtureElement, std::string codon); //R?
+		void initLambdaPrime(double lambdaPrimeValue, unsigned mixtureElement, std::string codon); //R?
+		void initMutationSelectionCategories(std::vector<std::string> files, unsigned numCategories,
+				unsigned paramType); //TODO: function needs to be changed
+
+
+
+		//Trace Functions:
 		void updateCodonSpecificParameterTrace(unsigned sample, std::string codon);
 
 
-		//Codon specific parameter functions:
-		void updateCodonSpecificParameter(std::string grouping);
+
+		//CSP Functions:
 		double getCurrentCodonSpecificProposalWidth(unsigned index);
-		std::vector<std::vector<double>> getCurrentAlphaParameter();
-		std::vector<std::vector<double>> getCurrentLambdaPrimeParameter();
 		void proposeCodonSpecificParameter();
+		void updateCodonSpecificParameter(std::string grouping);
 
 
-		//Proposal widths:
-		void adaptCodonSpecificParameterProposalWidth(unsigned adaptationWidth); //may make virtual
-		virtual void adaptSphiProposalWidth(unsigned adaptationWidth);
-		virtual void adaptSynthesisRateProposalWidth(unsigned adaptationWidth);
-
-
-		//Posterior mean functions:
-		virtual double getSphiPosteriorMean(unsigned samples, unsigned mixture);
-		virtual double getSynthesisRatePosteriorMean(unsigned samples, unsigned geneIndex, unsigned mixtureElement);
-		double getAlphaPosteriorMean(unsigned mixtureElement, unsigned samples, std::string &codon);
-		double getLambdaPrimePosteriorMean(unsigned mixtureElement, unsigned samples, std::string &codon);
 
+		//Adaptive Width Functions:
+		void adaptCodonSpecificParameterProposalWidth(unsigned adaptationWidth, unsigned lastIteration, bool adapt); //may make virtual
 
-		//Variance functions:
-		virtual double getSphiVariance(unsigned samples, unsigned mixture, bool unbiased = true);
-		virtual double getSynthesisRateVariance(unsigned samples, unsigned geneIndex, unsigned mixtureElement,
-				bool unbiased = true);
-		double getAlphaVariance(unsigned mixtureElement, unsigned samples, std::string &codon, bool unbiased = true);
-		double getLambdaPrimeVariance(unsigned mixtureElement, unsigned samples, std::string &codon, bool unbiased =
-				true);
 
 
 		//Other functions:
 		double getParameterForCategory(unsigned category, unsigned paramType, std::string codon, bool proposal);
-		virtual std::vector<double> getEstimatedMixtureAssignmentProbabilities(unsigned samples, unsigned geneIndex);
+		double getParameterForCategory(unsigned category, unsigned paramType, unsigned codonIndex, bool proposal);
+		void calculatePANSEMean(Genome& genome);
 
 
-		//Statics:
-		static const unsigned alp;
-		static const unsigned lmPri;
 
 
-		std::vector<std::vector<double>> calculateSelectionCoefficients(unsigned sample, unsigned mixture); //TODO: need?
 
+		//R Section:
+
+#ifndef STANDALONE
+
+
+		//Constructors & Destructors:
+		PANSEParameter(std::vector<double> stdDevSynthesisRate, std::vector<unsigned> geneAssignment, std::vector<unsigned> _matrix,
+			bool splitSer = true);
+		PANSEParameter(std::vector<double> stdDevSynthesisRate, unsigned _numMixtures, std::vector<unsigned> geneAssignment, bool splitSer = true,
+			std::string _mutationSelectionState = "allUnique");
 
 
-		//R wrappers:
+
+		//Initialization, Restart, Index Checking:
 		void initAlphaR(double alphaValue, unsigned mixtureElement, std::string codon);
 		void initLambdaPrimeR(double lambdaPrimeValue, unsigned mixtureElement, std::string codon);
-		double getParameterForCategoryR(unsigned mixtureElement, unsigned paramType, std::string codon, bool proposal);
 		void initMutationSelectionCategoriesR(std::vector<std::string> files, unsigned numCategories, std::string paramType);
-		double getAlphaPosteriorMeanForCodon(unsigned mixtureElement, unsigned samples, std::string codon);
-		double getLambdaPrimePosteriorMeanForCodon(unsigned mixtureElement, unsigned samples, std::string codon);
-		double getAlphaVarianceForCodon(unsigned mixtureElement, unsigned samples, std::string codon, bool unbiased);
-		double getLambdaPrimeVarianceForCodon(unsigned mixtureElement, unsigned samples, std::string codon, bool unbiased);
+
+		//CSP Functions:
+		std::vector<std::vector<double>> getProposedAlphaParameter();
+		std::vector<std::vector<double>> getProposedLambdaPrimeParameter();
+		std::vector<std::vector<double>> getCurrentAlphaParameter();
+		std::vector<std::vector<double>> getCurrentLambdaPrimeParameter();
+		void setProposedAlphaParameter(std::vector<std::vector<double>> alpha);
+		void setProposedLambdaPrimeParameter(std::vector<std::vector<double>> lambdaPrime);
+		void setCurrentAlphaParameter(std::vector<std::vector<double>> alpha);
+		void setCurrentLambdaPrimeParameter(std::vector<std::vector<double>> lambdaPrime);
 
 
-#ifndef STANDALONE
-		SEXP calculateSelectionCoefficientsR(unsigned sample, unsigned mixture);
-		RFPParameter(double sphi, std::vector<unsigned> geneAssignment, std::vector<unsigned> _matrix,
-			bool splitSer = true);
-		RFPParameter(double sphi, unsigned _numMixtures, std::vector<unsigned> geneAssignment, bool splitSer = true,
-			std::string _mutationSelectionState = "allUnique");
-#endif
 
+		//Other Functions:
+		double getParameterForCategoryR(unsigned mixtureElement, unsigned paramType, std::string codon, bool proposal);
+
+#endif //STANDALONE
 
 	protected:
+
 };
 
-#endif //PANSEPARAMETER_H
+#endif // PANSEPARAMETER_H
@@ -2,6 +2,9 @@
 #define RFPMODEL_H
 
 #include <sstream>
+#include <vector>
+#include <limits>
+#include <algorithm>
 
 #include "../base/Model.h"
 #include "RFPParameter.h"
@@ -12,8 +15,31 @@ class RFPModel: public Model
 	private:
 		RFPParameter *parameter;
 
-		double calculateLogLikelihoodPerCodonPerGene(double currAlpha, double currLambdaPrime,
-				unsigned currRFPObserved, unsigned currNumCodonsInMRNA, double phiValue);
+		//Likelihood cache for the codon specific parameter update. Indexed by [gene * numCodons + codon].
+		//A cell is reused as long as the phi value and mixture element it was computed with are unchanged.
+		std::vector<double> currentCodonLogLikelihood;
+		std::vector<double> proposedCodonLogLikelihood;
+		std::vector<double> cellSynthesisRate;
+		std::vector<unsigned> cellMixtureElement;
+		std::vector<double> logSynthesisRate; //log(phi) per gene, keyed by cachedSynthesisRate
+		std::vector<double> cachedSynthesisRate;
+		std::vector<std::vector<double>> cellAlpha; //[category][codon] alpha the column was computed with
+		std::vector<std::vector<double>> cellLambdaPrime; //[category][codon]
+		std::vector<std::vector<double>> cellLogLambdaPrime; //[category][codon]
+		std::vector<std::vector<double>> proposedAlpha; //[category][codon], see prepareProposedCodonColumn
+		std::vector<std::vector<double>> proposedLambdaPrime;
+		std::vector<std::vector<double>> proposedLogLambdaPrime;
+		unsigned numCodons;
+		std::vector<char> codonColumnCurrent; //[codon] scratch for calculateLogLikelihoodRatioForAllGroupings
+
+		double calculateLogLikelihoodPerCodonPerGene(double alphaTimesNumCodons, double logGammaRatio, double lambdaPrime,
+				double logLambdaPrime, unsigned rfpObserved, double phiValue, double logPhiValue);
+		double calculateLogGammaRatio(double alphaTimesNumCodons, unsigned rfpObserved);
+		void resizeLikelihoodCache(unsigned numGenes);
+		bool isCodonColumnCurrent(unsigned codonIndex);
+		void prepareProposedCodonColumn(unsigned codonIndex);
+		bool updateCodonLogLikelihoodCell(Gene& gene, unsigned geneIndex, unsigned codonIndex, bool columnCurrent);
+		double getLogSynthesisRate(unsigned geneIndex, double phiValue);
 
 
 	public:
@@ -29,6 +55,9 @@ class RFPModel: public Model
 				double& logAcceptanceRatioForAllMixtures);
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
 				std::vector <double> &logProbabilityRatio);
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios);
+		virtual void calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+				std::vector<double> &logLikelihoods);
 
 
 
@@ -111,6 +140,7 @@ class RFPModel: public Model
 		virtual void updateHyperParameter(unsigned hp);
 
 		virtual void simulateGenome(Genome &genome);
+		virtual void simulateGenomeToFile(Genome &genome, std::string filename);
 		virtual void printHyperParameters();
 		void setParameter(RFPParameter &_parameter);
 		virtual double calculateAllPriors();
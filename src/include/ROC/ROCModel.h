@@ -3,6 +3,7 @@
 
 #include "../base/Model.h"
 #include "ROCParameter.h"
+#include "../LBFGSOptimizer.h"
 
 class ROCModel : public Model
 {
@@ -10,9 +11,64 @@ class ROCModel : public Model
 		ROCParameter *parameter;
 		bool withPhi;
 
+		//Per grouping values gathered by calculateLogLikelihoodRatioForAllGroupings, kept between iterations
+		std::vector<std::string> groupingNames;
+		std::vector<unsigned> groupingAAIndex;
+		std::vector<unsigned> groupingAAStart;
+		std::vector<unsigned> groupingNumCodons;
+		std::vector<double> groupingMutation; // [grouping][mutation category][5]
+		std::vector<double> groupingMutationProposed;
+		std::vector<double> groupingSelection; // [grouping][selection category][5]
+		std::vector<double> groupingSelectionProposed;
+
+		//Gene independent terms of the synthesis rate sweep, gathered by prepareLogLikelihoodRatiosPerGene
+		std::vector<unsigned> termMutationCategory; // [mixture term]
+		std::vector<unsigned> termSelectionCategory; // [mixture term]
+		std::vector<double> sweepMutation; // [grouping][mutation category][5]
+		std::vector<double> sweepExpMutation; // [grouping][mutation category][5], exp(-mutation)
+		std::vector<double> sweepSelection; // [grouping][selection category][5], selection - shift
+		std::vector<double> sweepSelectionShift; // [grouping][selection category], min(0, min(selection))
+		std::vector<double> sweepScratch; // [thread][sweepScratchStride], see calculateLogLikelihoodRatiosPerGene
+		unsigned sweepScratchStride;
+
+		//Layout of the flattened codon specific parameters, see getCodonSpecificParameterVector
+		std::vector<unsigned> groupingParameterOffset; // [grouping + 1]
+		std::vector<double> partialGradient; // [thread][gradient, curvature, log likelihood]
+
+		//Observed synthesis rates of the genome, gathered once per run by cacheObservedSynthesisRates
+		bool observedSynthesisRatesCached;
+		std::vector<double> observedLogSynthesisRate; // [observed phi set][gene], 0 where not observed
+		std::vector<double> observedSynthesisRateMask; // [observed phi set][gene], 1 where observed, 0 otherwise
+		std::vector<double> hyperLogSynthesisRate; // [gene], log(phi) in the synthesis rate category of the gene
+		std::vector<double> partialHyperParameter; // [thread][sum, one per observed phi set]
+		std::vector<double> hyperStdDevOffset; // [synthesis rate category], log(proposed sd) - log(current sd)
+		std::vector<double> hyperNoiseOffset; // [observed phi set]
+		std::vector<double> hyperNoiseOffsetProposed; // [observed phi set]
+		std::vector<double> hyperNoiseScale; // [observed phi set], 0.5 / noise^2
+
+		//Scratch of calculateLogPosteriorForPosteriorMode
+		std::vector<double> modeLogSynthesisRate; // [gene]
+		std::vector<double> modeSynthesisRateDerivative; // [gene]
+		std::vector<double> modeLogPosterior; // [grouping]
+
+		void initGroupings();
 		double calculateLogLikelihoodPerAAPerGene(unsigned numCodons, int codonCount[], double mutation[], double selection[], double phiValue);
 		double calculateMutationPrior(std::string grouping, bool proposed = false); // TODO add to FONSE as well? // cedric
 		void obtainCodonCount(SequenceSummary *seqsum, std::string curAA, int codonCount[]);
+		void setCodonSpecificParameterVector(std::vector<double> &values, bool proposed);
+		void calculateLogPosteriorGradient(Genome& genome, std::vector<double> *logSynthesisRate,
+					std::vector<double> &logPosterior, std::vector<double> &gradient, std::vector<double> *curvature,
+					std::vector<double> *synthesisRateDerivative);
+		void calculateSynthesisRateCurvature(Genome& genome, std::vector<double> &logSynthesisRate,
+					std::vector<double> &curvature);
+		void findStdDevSynthesisRateMode(Genome& genome, std::vector<double> &logSynthesisRate,
+					std::vector<double> &curvature);
+		double calculateExpectedLogSynthesisRatePrior(std::vector<double> &logPhi, std::vector<double> &logPhiVariance,
+					double stdDevSynthesisRate);
+		void findNoiseOffsetMode(Genome& genome, std::vector<double> &logSynthesisRate);
+		void setProposalCovarianceToInverseHessian(Genome& genome);
+		void cacheObservedSynthesisRates(Genome& genome);
+		void gatherLogSynthesisRates(unsigned numGenes);
 
     public:
 		//Constructors & Destructors:
@@ -28,6 +84,31 @@ class ROCModel : public Model
 					double& logAcceptanceRatioForAllMixtures);
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration,
 					std::vector <double> &logProbabilityRatio);
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios);
+		virtual void calculateLogLikelihoodRatioForGroupings(Genome& genome, unsigned firstGene, unsigned geneStride,
+					const char* groupingMask, std::vector<double> &logAcceptanceRatios);
+		virtual bool hasSubsampleSurrogate();
+		virtual void prepareLogLikelihoodRatiosPerGene(std::vector<unsigned> &mixtureElements, unsigned numThreads);
+		virtual void calculateLogLikelihoodRatiosPerGene(Gene& gene, unsigned geneIndex, std::vector<unsigned> &mixtureElements,
+					double* logProbabilityRatios);
+		virtual void calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+					std::vector<double> &logLikelihoods);
+
+
+
+		//Gradient Functions:
+		virtual bool hasCodonSpecificParameterGradient();
+		virtual void getCodonSpecificParameterVector(std::vector<double> &values, std::vector<unsigned> &groupingOffsets);
+		virtual void setProposedCodonSpecificParameterVector(std::vector<double> &values);
+		virtual void calculateLogPosteriorGradientForAllGroupings(Genome& genome, std::vector<double> &logPosterior,
+					std::vector<double> &gradient, std::vector<double> *curvature);
+
+
+
+		//Posterior Mode Functions:
+		virtual bool findPosteriorMode(Genome& genome, unsigned maxIterations);
+		double calculateLogPosteriorForPosteriorMode(Genome& genome, std::vector<double> &values, std::vector<double> &gradient);
+
 
 
 		//Initialization and Restart Functions:
@@ -109,6 +190,8 @@ class ROCModel : public Model
 		virtual void updateHyperParameter(unsigned hp);
 
 		void simulateGenome(Genome &genome);
+		virtual void simulateCodonSequences(Genome &genome, unsigned firstGene, unsigned numGenes, unsigned seed,
+				std::vector<std::string> &sequences);
 		virtual void printHyperParameters();
 		void setParameter(ROCParameter &_parameter);
 		virtual double calculateAllPriors();
@@ -136,4 +219,20 @@ class ROCModel : public Model
     protected:
 };
 
+
+
+// Negative log posterior of the codon specific parameters and log(phi) of all genes, see
+// ROCModel::calculateLogPosteriorForPosteriorMode
+class ROCPosteriorModeObjective : public LBFGSObjective
+{
+	private:
+		ROCModel *model;
+		Genome *genome;
+
+	public:
+		ROCPosteriorModeObjective(ROCModel &_model, Genome &_genome);
+		virtual ~ROCPosteriorModeObjective();
+		virtual double evaluate(std::vector<double> &x, std::vector<double> &gradient);
+};
+
 #endif // ROCMODEL_H
@@ -115,6 +115,7 @@ class ROCParameter : public Parameter
 		//Other Functions:
 		void setNumObservedPhiSets(unsigned _phiGroupings);
 		void getParameterForCategory(unsigned category, unsigned parameter, std::string aa, bool proposal, double *returnValue);
+		void setParameterForCategory(unsigned category, unsigned parameter, std::string aa, bool proposal, double *values);
 
 
 
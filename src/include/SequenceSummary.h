@@ -10,6 +10,7 @@
 #include <array>
 #include <iostream>
 #include "Utility.h"
+#include "CodonEncoding.h"
 
 #ifndef STANDALONE
 #include <Rcpp.h>
@@ -22,20 +23,28 @@ class SequenceSummary
 
 		std::array<unsigned, 64> ncodons; //64 for the number of codons.
 		std::array<unsigned, 64> RFPObserved; //64 for the number of codons.
-		std::array<unsigned, 22> naa; //22 for the number of amino acids.
+		std::array<unsigned, GeneticCode::maxNumAA> naa; //indexed like SequenceSummary::AminoAcidArray
 		std::vector <std::vector <unsigned>> codonPositions;
-		std::vector <unsigned> RFP_count; //index is number of position
+		// per position RFP counts (PANSE), stored sparse: the positions with a count > 0 in increasing order and their
+		// counts, like one row of a CSR matrix
+		std::vector <unsigned> RFP_countPositions;
+		std::vector <unsigned> RFP_countValues;
+		unsigned RFP_countLength; // number of positions, including those without counts
+		// the same counts grouped by codon: the counts at positions of codon i are
+		// RFP_countByCodon[RFP_countCodonStart[i]] to RFP_countByCodon[RFP_countCodonStart[i + 1] - 1]
+		std::vector <unsigned> RFP_countCodonStart;
+		std::vector <unsigned> RFP_countByCodon;
+
+		bool countCodons(const std::string& sequence, const GeneticCode& code);
+		void groupRFP_countByCodon();
 
 	public:
 
 		//Static Member Variables:
 		static const std::string Ser2;
-		static const std::vector<std::string> AminoAcidArray;
-		static const std::string codonArray[];
-		static const std::string codonArrayParameter[];
-		static const std::map<std::string, unsigned> aaToIndex;
-		static const std::map<std::string, unsigned> codonToIndexWithReference;
-		static const std::map<std::string, unsigned> codonToIndexWithoutReference;
+		static std::vector<std::string> AminoAcidArray; // names of the active genetic code, see setGeneticCode
+		static std::vector<std::string> codonArray;
+		static std::vector<std::string> codonArrayParameter;
 
 
 		//Constructors & Destructors:
@@ -55,10 +64,19 @@ class SequenceSummary
 		unsigned getRFPObserved(std::string codon);
 		unsigned getRFPObserved(unsigned codonIndex);
 		void setRFPObserved(unsigned codonIndex, unsigned value);
+		void setCodonCount(unsigned codonIndex, unsigned count);
 		std::vector <unsigned> *getCodonPositions(std::string codon);
 		std::vector <unsigned> *getCodonPositions(unsigned index);
+		void getCodonIndexSequence(std::vector <unsigned> &codonIndices);
+		void setCodonPositions(const unsigned char *codonIndices, unsigned length);
 		std::vector <unsigned> getRFP_count();
 		void setRFP_count(std::vector <unsigned> arg);
+		void setSparseRFP_count(std::vector <unsigned> &positions, std::vector <unsigned> &counts, unsigned length);
+		const std::vector <unsigned> &getRFP_countPositions() const;
+		const std::vector <unsigned> &getRFP_countValues() const;
+		unsigned getRFP_countLength() const;
+		const std::vector <unsigned> &getRFP_countCodonStart() const;
+		const std::vector <unsigned> &getRFP_countByCodon() const;
 
 
 		//Other Functions:
@@ -67,19 +85,24 @@ class SequenceSummary
 
 
 		//Static Functions:
-		static unsigned AAToAAIndex(std::string aa); //Moving to CT
+		static unsigned AAToAAIndex(const std::string& aa); //Moving to CT
 		static void AAIndexToCodonRange(unsigned aaIndex, unsigned& start, unsigned& end, bool forParamVector = false); //Moving to CT
-		static void AAToCodonRange(std::string aa, unsigned& start, unsigned& end, bool forParamVector = false); //Moving to CT
+		static void AAToCodonRange(const std::string& aa, unsigned& start, unsigned& end, bool forParamVector = false); //Moving to CT
 		static std::vector<std::string> AAToCodon(std::string aa, bool forParamVector = false); //Moving to CT, but used in R currently
-		static std::string codonToAA(std::string& codon); //Moving to CT
-		static unsigned codonToIndex(std::string& codon, bool forParamVector = false); //Moving to CT
-		static unsigned codonToAAIndex(std::string& codon); //Moving to CT
+		static std::string codonToAA(const std::string& codon); //Moving to CT
+		static unsigned codonToIndex(const std::string& codon, bool forParamVector = false); //Moving to CT
+		static unsigned codonToAAIndex(const std::string& codon); //Moving to CT
 		static std::string indexToAA(unsigned aaIndex); //Moving to CT
 		static std::string indexToCodon(unsigned index, bool forParamVector = false); //Moving to CT
-		static unsigned GetNumCodonsForAA(std::string& aa, bool forParamVector = false); //Moving to CT
+		static unsigned GetNumCodonsForAA(const std::string& aa, bool forParamVector = false); //Moving to CT
 		static char complimentNucleotide(char ch); //TODO: Testing (c++)
 		static std::vector<std::string> aminoAcids(); //Moving to CT, but used in R currently
+		static std::vector<std::string> aminoAcidsWithParameters(); //Moving to CT
 		static std::vector<std::string> codons(); //Moving to CT, but used in R currently
+		static unsigned numAminoAcids(); //Moving to CT
+		static unsigned numParameterCodons(); //Moving to CT
+		static unsigned numSenseCodons(); //Moving to CT
+		static void setGeneticCode(const GeneticCode& code); //Moving to CT
 
 
 	protected:
@@ -6,12 +6,34 @@
 #include "Gene.h"
 #include "Genome.h"
 #include "Utility.h"
+#include "MCMCAlgorithm.h"
+#include "PANSE/PANSEModel.h"
+#include "MixtureAssignmentSampler.h"
+#include "JobConfig.h"
+#include "CodonTable.h"
+#include "CrossValidation.h"
 
 
 int testSequenceSummary();
 int testGene();
 int testGenome(std::string testFileDir);
 int testUtility();
+int testMCMCAllocations();
+int testMixtureLogLikelihoodRatios();
+int testMixtureAssignmentSampler();
+int testRFPLikelihoodCache();
+int testPANSELogLikelihoodRatios();
+int testDelayedAcceptanceRatios();
+int testCodonSpecificParameterGradient();
+int testPosteriorMode();
+int testJobConfig();
+int testSimulateGenome(std::string testFileDir);
+int testSelectionCoefficients();
+int testCodonEncoding();
+int testCodonTable();
+int testHyperParameterLogLikelihoodRatios();
+int testCrossValidation();
+int testLBFGSOptimizer();
 
 //Blank header
 #endif // Testing_H
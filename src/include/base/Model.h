@@ -21,11 +21,45 @@ class Model
         virtual void calculateLogLikelihoodRatioPerGroupingPerCategory(std::string grouping, Genome& genome,
         		double& logAcceptanceRatioForAllMixtures) = 0;
 		virtual void calculateLogLikelihoodRatioForHyperParameters(Genome &genome, unsigned iteration, std::vector <double> &logProbabilityRatio) = 0;
+		virtual void calculateLogLikelihoodRatioForAllGroupings(Genome& genome, std::vector<double> &logAcceptanceRatios);
+		virtual void calculateLogLikelihoodRatioForGroupings(Genome& genome, unsigned firstGene, unsigned geneStride,
+				const char* groupingMask, std::vector<double> &logAcceptanceRatios);
+		virtual bool hasSubsampleSurrogate();
+		virtual void prepareLogLikelihoodRatiosPerGene(std::vector<unsigned> &mixtureElements, unsigned numThreads);
+		virtual void calculateLogLikelihoodRatiosPerGene(Gene& gene, unsigned geneIndex, std::vector<unsigned> &mixtureElements,
+				double* logProbabilityRatios);
 
 		virtual double calculateAllPriors() = 0;
 
 
 
+		//Gradient Functions:
+		virtual bool hasCodonSpecificParameterGradient();
+		virtual void getCodonSpecificParameterVector(std::vector<double> &values, std::vector<unsigned> &groupingOffsets);
+		virtual void setProposedCodonSpecificParameterVector(std::vector<double> &values);
+		virtual void calculateLogPosteriorGradientForAllGroupings(Genome& genome, std::vector<double> &logPosterior,
+				std::vector<double> &gradient, std::vector<double> *curvature);
+
+
+
+		//Posterior Mode Functions:
+		virtual bool findPosteriorMode(Genome& genome, unsigned maxIterations);
+
+
+
+		//Predictive Functions:
+		virtual void calculateLogLikelihoodPerGene(Gene& gene, unsigned mixtureElement, std::vector<double> &phiValues,
+				std::vector<double> &logLikelihoods);
+
+
+
+		//Simulation Functions:
+		virtual void simulateGenomeToFile(Genome &genome, std::string filename);
+		virtual void simulateCodonSequences(Genome &genome, unsigned firstGene, unsigned numGenes, unsigned seed,
+				std::vector<std::string> &sequences);
+
+
+
 		//Initialization and Restart Functions:
 		virtual void initTraces(unsigned samples, unsigned num_genes) = 0;
 		virtual void writeRestartFile(std::string filename) = 0;
@@ -107,6 +141,14 @@ class Model
 		virtual void printHyperParameters() = 0;
 
 	protected:
+		void simulateGenomeInBlocks(Genome &genome, std::string filename);
+
+		//Scratch space of the likelihood ratio functions. Kept between calls so an MCMC iteration does not allocate.
+		std::vector<double> partialLikelihood; // [thread][current, proposed][grouping], see calculateLogLikelihoodRatioForAllGroupings
+		std::vector<double> currentStdDevSynthesisRate; // [category], see calculateLogLikelihoodRatioForHyperParameters
+		std::vector<double> currentMphi;
+		std::vector<double> proposedStdDevSynthesisRate;
+		std::vector<double> proposedMphi;
 };
 
 #endif // MODEL_H
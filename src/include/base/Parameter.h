@@ -48,7 +48,7 @@ class Parameter {
 		static const unsigned lmPri;
 
 #ifdef STANDALONE
-		static std::default_random_engine generator; // static to make sure that the same generator is during the runtime.
+		static thread_local std::default_random_engine generator; // one per thread, so concurrent cross validation runs each draw from their own
 #endif
 
 
@@ -116,6 +116,7 @@ class Parameter {
 
 		//Synthesis Rate Functions:
 		double getSynthesisRate(unsigned geneIndex, unsigned mixtureElement, bool proposed = false);
+		double getLogSynthesisRate(unsigned geneIndex, unsigned mixtureElement);
 		double getCurrentSynthesisRateProposalWidth(unsigned expressionCategory, unsigned geneIndex);
 		double getSynthesisRateProposalWidth(unsigned geneIndex, unsigned mixtureElement);
 		void proposeSynthesisRateLevels();
@@ -138,6 +139,7 @@ class Parameter {
 		void updateSynthesisRateTrace(unsigned sample, unsigned geneIndex);
 		void updateMixtureAssignmentTrace(unsigned sample, unsigned geneIndex);
 		void updateMixtureProbabilitiesTrace(unsigned samples);
+		void setToTraceSample(unsigned sample);
 
 
 		//Adaptive Width Functions:
@@ -149,6 +151,7 @@ class Parameter {
 		//Posterior, Variance, and Estimates Functions:
 		double getStdDevSynthesisRatePosteriorMean(unsigned samples, unsigned mixture);
 		double getSynthesisRatePosteriorMean(unsigned samples, unsigned geneIndex, unsigned mixtureElement);
+		void getSynthesisRatePosteriorMeans(unsigned samples, unsigned mixtureElement, double *posteriorMeans);
 
 		double getCodonSpecificPosteriorMean(unsigned mixtureElement, unsigned samples, std::string &codon, unsigned paramType,
 			bool withoutReference = true);
@@ -172,6 +175,8 @@ class Parameter {
 		unsigned getMixtureAssignment(unsigned gene);
 		virtual void setNumObservedPhiSets(unsigned _phiGroupings);
 		virtual std::vector <std::vector <double> > calculateSelectionCoefficients(unsigned sample, unsigned mixture);
+		void calculateSelectionCoefficients(unsigned samples, unsigned mixture, double *selectionCoefficients,
+				unsigned geneStride, unsigned codonStride);
 
 		
 
@@ -180,6 +185,8 @@ class Parameter {
 		static void drawIidRandomVector(unsigned draws, double mean, double sd, double (*proposal)(double a, double b),
 				double* randomNumbers);
 		static void drawIidRandomVector(unsigned draws, double r, double (*proposal)(double r), double* randomNumber);
+		static void drawIidNormalVector(unsigned draws, double* randomNumbers);
+		static void drawUniformVector(unsigned draws, double* randomNumbers);
 		static double randNorm(double mean, double sd);
 		static double randLogNorm(double m, double s);
 		static double randExp(double r);
@@ -272,6 +279,15 @@ class Parameter {
 		std::vector<std::string> groupList;
 		unsigned maxGrouping;
 
+		//Batched codon specific parameter proposals, see proposeCovaryingCodonSpecificParameters:
+		std::vector<double> proposalIidNumbers; // standard normals of all groupings
+		std::vector<double> proposalCovaryingNumbers; // one grouping
+		std::vector<unsigned> proposalOffset; // [grouping] first draw of the grouping in proposalIidNumbers
+		std::vector<unsigned> proposalCodonStart; // [grouping]
+		std::vector<unsigned> proposalAAIndex; // [grouping]
+		void proposeCovaryingCodonSpecificParameters(unsigned mutationType, unsigned selectionType);
+		void updateLogSynthesisRateLevels();
+
 
 		std::vector<double> stdDevSynthesisRate_proposed;
 		std::vector<double> stdDevSynthesisRate;
@@ -284,6 +300,7 @@ class Parameter {
 
 		std::vector<std::vector<double>> proposedSynthesisRateLevel;
 		std::vector<std::vector<double>> currentSynthesisRateLevel;
+		std::vector<std::vector<double>> currentLogSynthesisRateLevel; // log(currentSynthesisRateLevel), kept in step
 		std::vector<std::vector<unsigned>> numAcceptForSynthesisRate;
 
 		unsigned lastIteration;
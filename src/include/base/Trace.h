@@ -112,6 +112,8 @@ public:
         unsigned getSynthesisRateCategory(unsigned mixtureElement);
         unsigned getCodonSpecificCategory(unsigned mixtureElement, unsigned paramType);
 		std::vector<std::vector<std::vector<std::vector<double>>>>* getCodonSpecificParameterTrace();
+		std::vector<std::vector<double>>* getSynthesisRateTraceForCategory(unsigned expressionCategory);
+		std::vector<std::vector<unsigned>>* getMixtureAssignmentTraceForGenes();
 
         //ROC Specific:
         std::vector<double> getCodonSpecificParameterTraceByMixtureElementForCodon(unsigned mixtureElement, std::string& codon, unsigned paramType,
@@ -931,4 +931,1186 @@ int main()
 	}
 }
 
-#endif // Hollis
\ No newline at end of file
+#endif // Hollis
+
+
+
+#ifdef RUNNER
+/* Headless runner for batch jobs on a cluster. Build with
+ *   cd src && g++ -std=c++11 -O2 -fopenmp -DSTANDALONE -DRUNNER *.cpp -o ribModelRunner
+ * and start a job with
+ *   ribModelRunner job.toml
+ * See inst/exampleJob.toml for the keys of a job file. The exit codes follow sysexits.h, so a scheduler can tell a
+ * broken job file or missing input apart from a failed run.
+*/
+#include "include/JobConfig.h"
+#include "include/CodonTable.h"
+#include "include/CrossValidation.h"
+#include <fstream>
+#include <iomanip>
+#include <stdexcept>
+
+//Open MP
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+const int runnerOk = 0;
+const int runnerUsageError = 64; // wrong command line
+const int runnerDataError = 65; // invalid job file or input data
+const int runnerNoInput = 66; // input file can not be opened
+const int runnerSoftwareError = 70; // the run failed
+const int runnerCantCreate = 73; // output file can not be written
+
+
+bool fileExists(std::string filename)
+{
+	std::ifstream file(filename.c_str());
+	return file.good();
+}
+
+
+int reportConfigErrors(JobConfig &config, std::string filename)
+{
+	std::vector<std::string> errors = config.getErrors();
+	for (unsigned i = 0u; i < errors.size(); i++)
+	{
+		std::cerr << filename << ": " << errors[i] << "\n";
+	}
+	return runnerDataError;
+}
+
+
+/* readJobGenome (NOT EXPOSED)
+ * Arguments: job file, model name, genome to fill
+ * Reads the [genome] table: fasta (one file or a list of files, appended in order) for ROC and FONSE, rfp for RFP, and
+ * optionally observed_phi (with observed_phi_by_id) for ROC. codon_table and split_amino_acids select the genetic code
+ * before anything is read. With cache set, the genome is loaded from that .ribgenome file if it is current, otherwise
+ * it is read from the files and the cache is (re)written. Returns an exit code.
+*/
+int readJobGenome(JobConfig &config, std::string modelName, Genome &genome)
+{
+	std::vector<std::string> files;
+	if (modelName == "RFP")
+		files.push_back(config.getString("genome.rfp"));
+	else
+		files = config.getStringArray("genome.fasta");
+	std::string phiFile = config.getString("genome.observed_phi");
+	bool byId = config.getBool("genome.observed_phi_by_id", true);
+	std::string cacheFile = config.getString("genome.cache");
+	unsigned codonTable = config.getUnsigned("genome.codon_table", 1u);
+	bool splitAA = config.getBool("genome.split_amino_acids", true);
+	if (config.hasError()) return runnerDataError;
+
+	if (files.empty() || files[0].empty())
+	{
+		std::cerr << "No genome given, set genome." << (modelName == "RFP" ? "rfp" : "fasta") << "\n";
+		return runnerDataError;
+	}
+	if (!phiFile.empty()) files.push_back(phiFile);
+	for (unsigned i = 0u; i < files.size(); i++)
+	{
+		if (!fileExists(files[i]))
+		{
+			std::cerr << "Can not open input file " << files[i] << "\n";
+			return runnerNoInput;
+		}
+	}
+	CodonTable::useCodonTable(codonTable, splitAA);
+	if (!cacheFile.empty() && fileExists(cacheFile) && genome.readGenomeCache(cacheFile, files))
+	{
+		std::cout << "Genome read from cache " << cacheFile << "\n";
+		return genome.getGenomeSize() == 0u ? runnerDataError : runnerOk;
+	}
+	std::vector<std::string> sourceFiles = files;
+	if (!phiFile.empty()) files.pop_back();
+
+	if (modelName == "RFP")
+		genome.readRFPFile(files[0]);
+	else
+	{
+		for (unsigned i = 0u; i < files.size(); i++)
+		{
+			genome.readFasta(files[i], i != 0u);
+		}
+	}
+	if (genome.getGenomeSize() == 0u)
+	{
+		std::cerr << "Genome is empty\n";
+		return runnerDataError;
+	}
+	if (!phiFile.empty())
+		genome.readObservedPhiValues(phiFile, byId);
+	if (!cacheFile.empty())
+		genome.writeGenomeCache(cacheFile, sourceFiles);
+	return runnerOk;
+}
+
+
+void initCodonSpecificParameterFiles(JobConfig &config, ROCParameter &parameter)
+{
+	std::vector<std::string> files = config.getStringArray("parameter.mutation_files");
+	if (!files.empty()) parameter.initMutationCategories(files, parameter.getNumMutationCategories());
+	files = config.getStringArray("parameter.selection_files");
+	if (!files.empty()) parameter.initSelectionCategories(files, parameter.getNumSelectionCategories());
+}
+
+
+void initCodonSpecificParameterFiles(JobConfig &config, FONSEParameter &parameter)
+{
+	std::vector<std::string> files = config.getStringArray("parameter.mutation_files");
+	if (!files.empty()) parameter.initMutationCategories(files, parameter.getNumMutationCategories());
+	files = config.getStringArray("parameter.selection_files");
+	if (!files.empty()) parameter.initSelectionCategories(files, parameter.getNumSelectionCategories());
+}
+
+
+void initCodonSpecificParameterFiles(JobConfig &config, RFPParameter &parameter)
+{
+	std::vector<std::string> files = config.getStringArray("parameter.alpha_files");
+	if (!files.empty()) parameter.initMutationSelectionCategories(files, parameter.getNumMutationCategories(), Parameter::alp);
+	files = config.getStringArray("parameter.lambda_prime_files");
+	if (!files.empty())
+		parameter.initMutationSelectionCategories(files, parameter.getNumSelectionCategories(), Parameter::lmPri);
+}
+
+
+/* createJobParameter (NOT EXPOSED)
+ * Arguments: job file, genome, exit code, indices of the genes of the job genome that genome holds (NULL if it is the
+ * job genome)
+ * Builds the parameter object from parameter.restart_file, or from the mixture settings of the [parameter] table like
+ * initializeParameterObject in R. Genes are assigned to mixtures by parameter.gene_assignment (1 based, one entry
+ * per gene of the job genome) or uniformly at random. Returns NULL and sets the exit code if the settings are invalid.
+*/
+template <class ParameterType>
+ParameterType* createJobParameter(JobConfig &config, Genome &genome, int &status,
+		std::vector<unsigned> *geneIndices = NULL)
+{
+	status = runnerOk;
+	std::string restartFile = config.getString("parameter.restart_file");
+	if (!restartFile.empty())
+	{
+		if (!fileExists(restartFile))
+		{
+			std::cerr << "Can not open input file " << restartFile << "\n";
+			status = runnerNoInput;
+			return NULL;
+		}
+		return new ParameterType(restartFile);
+	}
+
+	unsigned numGenes = genome.getGenomeSize();
+	unsigned numMixtures = config.getUnsigned("parameter.mixtures", 1u);
+	std::string mixtureDefinition = config.getString("parameter.mixture_definition", Parameter::allUnique);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix = config.getUnsignedMatrix("parameter.mixture_definition_matrix");
+	bool splitSer = config.getBool("parameter.split_serine", true);
+	std::vector<double> stdDevSynthesisRate = config.getDoubleArray("parameter.stddev_synthesis_rate");
+	std::vector<double> assignment = config.getDoubleArray("parameter.gene_assignment");
+	if (config.hasError())
+	{
+		status = runnerDataError;
+		return NULL;
+	}
+	if (geneIndices != NULL && !assignment.empty())
+	{
+		std::vector<double> subsetAssignment;
+		for (unsigned i = 0u; i < geneIndices->size() && (*geneIndices)[i] < assignment.size(); i++)
+		{
+			subsetAssignment.push_back(assignment[(*geneIndices)[i]]);
+		}
+		assignment.swap(subsetAssignment);
+	}
+
+	std::string error = "";
+	if (numMixtures == 0u)
+		error = "parameter.mixtures must be at least 1";
+	else if (mixtureDefinition != Parameter::allUnique && mixtureDefinition != Parameter::mutationShared
+			&& mixtureDefinition != Parameter::selectionShared)
+		error = "Unknown parameter.mixture_definition " + mixtureDefinition;
+	if (stdDevSynthesisRate.empty()) stdDevSynthesisRate.push_back(2.0);
+	if (stdDevSynthesisRate.size() == 1u) stdDevSynthesisRate.resize(numMixtures, stdDevSynthesisRate[0]);
+	if (error.empty() && stdDevSynthesisRate.size() != numMixtures)
+		error = "parameter.stddev_synthesis_rate must have one value per mixture";
+	for (unsigned i = 0u; error.empty() && i < mixtureDefinitionMatrix.size(); i++)
+	{
+		if (mixtureDefinitionMatrix.size() != numMixtures || mixtureDefinitionMatrix[i].size() != 2u
+				|| mixtureDefinitionMatrix[i][0] == 0u || mixtureDefinitionMatrix[i][1] == 0u)
+			error = "parameter.mixture_definition_matrix must have one row [mutation, selection] of categories "
+				"starting at 1 per mixture";
+	}
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	if (!assignment.empty())
+	{
+		if (error.empty() && assignment.size() != numGenes)
+			error = "parameter.gene_assignment must have one entry per gene";
+		for (unsigned i = 0u; error.empty() && i < numGenes; i++)
+		{
+			if (assignment[i] < 1.0 || assignment[i] > numMixtures || assignment[i] != std::floor(assignment[i]))
+				error = "Gene is assigned to non existing mixture";
+			geneAssignment[i] = (unsigned)assignment[i] - 1u;
+		}
+	}
+	else
+	{
+		std::uniform_int_distribution<unsigned> distribution(0u, numMixtures - 1u);
+		for (unsigned i = 0u; error.empty() && i < numGenes; i++)
+		{
+			geneAssignment[i] = distribution(Parameter::generator);
+		}
+	}
+	if (!error.empty())
+	{
+		std::cerr << error << "\n";
+		status = runnerDataError;
+		return NULL;
+	}
+
+	ParameterType *parameter = new ParameterType(stdDevSynthesisRate, numMixtures, geneAssignment,
+		mixtureDefinitionMatrix, splitSer, mixtureDefinition);
+	initCodonSpecificParameterFiles(config, *parameter);
+	if (config.hasError())
+	{
+		delete parameter;
+		status = runnerDataError;
+		return NULL;
+	}
+	parameter->InitializeSynthesisRate(genome, stdDevSynthesisRate[0]);
+	return parameter;
+}
+
+
+bool openOutput(std::ofstream &out, std::string filename)
+{
+	out.open(filename.c_str());
+	if (!out)
+		std::cerr << "Can not write " << filename << "\n";
+	return out.good();
+}
+
+
+/* writeJobOutput (NOT EXPOSED)
+ * Arguments: output prefix, column separator, file extension, genome, parameter, mcmc object, model name, number of
+ * samples to summarize
+ * Writes the log likelihood and stdDevSynthesisRate traces, and posterior mean and standard deviation of the synthesis
+ * rates and codon specific parameters over the last samples. Returns an exit code.
+*/
+int writeJobOutput(std::string prefix, std::string separator, std::string extension, Genome &genome,
+		Parameter &parameter, MCMCAlgorithm &mcmc, std::string modelName, unsigned samples)
+{
+	std::ofstream out;
+	std::string filename;
+
+	filename = prefix + ".logLikelihood." + extension;
+	if (!openOutput(out, filename)) return runnerCantCreate;
+	std::vector<double> logLikelihoodTrace = mcmc.getLogLikelihoodTrace();
+	out << "sample" << separator << "logLikelihood\n" << std::setprecision(12);
+	for (unsigned i = 0u; i < logLikelihoodTrace.size(); i++)
+	{
+		out << i << separator << logLikelihoodTrace[i] << "\n";
+	}
+	out.close();
+
+	filename = prefix + ".stdDevSynthesisRate." + extension;
+	if (!openOutput(out, filename)) return runnerCantCreate;
+	Trace &trace = parameter.getTraceObject();
+	unsigned numSelectionCategories = parameter.getNumSelectionCategories();
+	std::vector<std::vector<double>> stdDevSynthesisRateTraces(numSelectionCategories);
+	out << "sample";
+	for (unsigned k = 0u; k < numSelectionCategories; k++)
+	{
+		stdDevSynthesisRateTraces[k] = trace.getStdDevSynthesisRateTrace(k);
+		out << separator << "category" << k + 1;
+	}
+	out << "\n" << std::setprecision(12);
+	for (unsigned i = 0u; numSelectionCategories > 0u && i < stdDevSynthesisRateTraces[0].size(); i++)
+	{
+		out << i;
+		for (unsigned k = 0u; k < numSelectionCategories; k++)
+		{
+			out << separator << stdDevSynthesisRateTraces[k][i];
+		}
+		out << "\n";
+	}
+	out.close();
+
+	filename = prefix + ".synthesisRate." + extension;
+	if (!openOutput(out, filename)) return runnerCantCreate;
+	out << "gene" << separator << "mixture" << separator << "mean" << separator << "sd\n" << std::setprecision(12);
+	for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+	{
+		unsigned mixture = parameter.getEstimatedMixtureAssignment(samples, i);
+		out << genome.getGene(i).getId() << separator << mixture + 1 << separator
+			<< parameter.getSynthesisRatePosteriorMean(samples, i, mixture) << separator
+			<< std::sqrt(parameter.getSynthesisRateVariance(samples, i, mixture)) << "\n";
+	}
+	out.close();
+
+	filename = prefix + ".codonSpecific." + extension;
+	if (!openOutput(out, filename)) return runnerCantCreate;
+	std::string names[2];
+	if (modelName == "RFP")
+	{
+		names[0] = "alpha";
+		names[1] = "lambdaPrime";
+	}
+	else
+	{
+		names[0] = "dM";
+		names[1] = modelName == "FONSE" ? "dOmega" : "dEta";
+	}
+	out << "mixture" << separator << "group" << separator << "codon" << separator << "parameter" << separator << "mean"
+		<< separator << "sd\n" << std::setprecision(12);
+	std::vector<std::string> groupList = parameter.getGroupList();
+	for (unsigned mixture = 0u; mixture < parameter.getNumMixtureElements(); mixture++)
+	{
+		for (unsigned g = 0u; g < groupList.size(); g++)
+		{
+			std::vector<std::string> codons;
+			if (modelName == "RFP")
+				codons.push_back(groupList[g]);
+			else
+				codons = SequenceSummary::AAToCodon(groupList[g], true);
+			for (unsigned paramType = 0u; paramType < 2u; paramType++)
+			{
+				for (unsigned c = 0u; c < codons.size(); c++)
+				{
+					out << mixture + 1 << separator << groupList[g] << separator << codons[c] << separator << names[paramType]
+						<< separator << parameter.getCodonSpecificPosteriorMean(mixture, samples, codons[c], paramType, modelName != "RFP")
+						<< separator << std::sqrt(parameter.getCodonSpecificVariance(mixture, samples, codons[c], paramType,
+							true, modelName != "RFP")) << "\n";
+				}
+			}
+		}
+	}
+	out.close();
+	return runnerOk;
+}
+
+
+/* createJobMCMC (NOT EXPOSED)
+ * Arguments: job file, exit code
+ * Builds the mcmc object from the [mcmc] table. Returns NULL and sets the exit code if the settings are invalid.
+*/
+MCMCAlgorithm* createJobMCMC(JobConfig &config, int &status)
+{
+	status = runnerOk;
+	unsigned samples = config.getUnsigned("mcmc.samples", 1000u);
+	unsigned thining = config.getUnsigned("mcmc.thinning", 10u);
+	unsigned adaptiveWidth = config.getUnsigned("mcmc.adaptive_width", 100u);
+	if (config.hasError())
+	{
+		status = runnerDataError;
+		return NULL;
+	}
+	if (samples == 0u || thining == 0u)
+	{
+		std::cerr << "mcmc.samples and mcmc.thinning must be at least 1\n";
+		status = runnerDataError;
+		return NULL;
+	}
+
+	MCMCAlgorithm *mcmc = new MCMCAlgorithm(samples, thining, adaptiveWidth,
+		config.getBool("mcmc.estimate_synthesis_rate", true), config.getBool("mcmc.estimate_codon_specific_parameter", true),
+		config.getBool("mcmc.estimate_hyper_parameter", true));
+	mcmc->setEstimateMixtureAssignment(config.getBool("mcmc.estimate_mixture_assignment", true));
+	if (config.hasKey("mcmc.steps_to_adapt")) mcmc->setStepsToAdapt(config.getUnsigned("mcmc.steps_to_adapt"));
+	mcmc->setThreadAffinity(config.getString("mcmc.thread_affinity", "none"));
+	mcmc->setProfiling(config.getBool("mcmc.profile", false), config.getString("mcmc.profile_file"));
+	mcmc->setDelayedAcceptance(config.getBool("mcmc.delayed_acceptance", false),
+		config.getDouble("mcmc.delayed_acceptance_fraction", 0.1));
+	unsigned hamiltonianSteps = config.getUnsigned("mcmc.hamiltonian_steps", 0u);
+	mcmc->setHamiltonianMonteCarlo(hamiltonianSteps != 0u, hamiltonianSteps == 0u ? 10u : hamiltonianSteps);
+	mcmc->setPosteriorModeStart(config.getBool("mcmc.posterior_mode", false),
+		config.getUnsigned("mcmc.posterior_mode_rounds", 50u));
+	if (config.hasError())
+	{
+		delete mcmc;
+		status = runnerDataError;
+		return NULL;
+	}
+	return mcmc;
+}
+
+
+/* runJob (NOT EXPOSED)
+ * Arguments: job file, genome, model, model name
+ * Sets up the parameter and mcmc objects from the job file, runs the MCMC and writes the output. Returns an exit code.
+*/
+template <class ParameterType, class ModelType>
+int runJob(JobConfig &config, Genome &genome, ModelType &model, std::string modelName)
+{
+	unsigned samples = config.getUnsigned("mcmc.samples", 1000u);
+	unsigned divergenceIterations = config.getUnsigned("mcmc.divergence_iterations", 0u);
+	unsigned cores = config.getUnsigned("job.cores", 1u);
+	std::string prefix = config.getString("output.prefix", "ribModel");
+	std::string format = config.getString("output.format", "csv");
+	unsigned summarySamples = config.getUnsigned("output.summary_samples", samples / 2u);
+	std::string checkpointFile = config.getString("checkpoint.file");
+	unsigned checkpointInterval = config.getUnsigned("checkpoint.interval", 100u);
+	bool checkpointMultiple = config.getBool("checkpoint.multiple", false);
+	if (config.hasError()) return runnerDataError;
+	if (cores == 0u || (format != "csv" && format != "tsv"))
+	{
+		std::cerr << "job.cores must be at least 1 and output.format csv or tsv\n";
+		return runnerDataError;
+	}
+
+	int status;
+	MCMCAlgorithm *mcmc = createJobMCMC(config, status);
+	if (mcmc == NULL) return status;
+	if (!checkpointFile.empty()) mcmc->setRestartFileSettings(checkpointFile, checkpointInterval, checkpointMultiple);
+
+	// fail before the run rather than after it if the output can not be written
+	std::ofstream out;
+	if (!openOutput(out, prefix + ".logLikelihood." + format))
+	{
+		delete mcmc;
+		return runnerCantCreate;
+	}
+	out.close();
+
+	ParameterType *parameter = createJobParameter<ParameterType>(config, genome, status);
+	if (parameter == NULL)
+	{
+		delete mcmc;
+		return status;
+	}
+
+	model.setParameter(*parameter);
+	try
+	{
+		mcmc->run(genome, model, cores, divergenceIterations);
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "Run failed: " << e.what() << "\n";
+		delete parameter;
+		delete mcmc;
+		return runnerSoftwareError;
+	}
+
+	if (summarySamples == 0u || summarySamples > samples) summarySamples = samples;
+	status = writeJobOutput(prefix, format == "csv" ? "," : "\t", format, genome, *parameter, *mcmc, modelName,
+		summarySamples);
+	if (status == runnerOk)
+	{
+		std::string restartFile = prefix + ".restart";
+		model.writeRestartFile(restartFile);
+		if (!fileExists(restartFile))
+		{
+			std::cerr << "Can not write " << restartFile << "\n";
+			status = runnerCantCreate;
+		}
+	}
+	delete parameter;
+	delete mcmc;
+	return status;
+}
+
+
+/* runCrossValidationJob (NOT EXPOSED)
+ * Arguments: job file, genome, model, model name
+ * Runs the MCMC of the job on the training genes of every k-fold split or bootstrap replicate set up by the
+ * [crossvalidation] table and scores each run by the posterior predictive log likelihood of the genes it did not see.
+ * Runs go concurrently, each with its own parameter, model and mcmc object on a subset of the genome that shares its
+ * genes, and split job.cores between them. Every run reseeds the generator of its thread with a seed drawn up front,
+ * so the result does not depend on which thread a run lands on. Writes the score of every run and gene and returns
+ * an exit code.
+*/
+template <class ParameterType, class ModelType>
+int runCrossValidationJob(JobConfig &config, Genome &genome, ModelType &model, std::string modelName)
+{
+	std::string method = config.getString("crossvalidation.method", "kfold");
+	unsigned numFolds = config.getUnsigned("crossvalidation.folds", 5u);
+	unsigned replicates = config.getUnsigned("crossvalidation.replicates", 100u);
+	double quadratureStep = config.getDouble("crossvalidation.quadrature_step", 0.5);
+	bool writeRuns = config.getBool("crossvalidation.write_runs", false);
+	unsigned samples = config.getUnsigned("mcmc.samples", 1000u);
+	unsigned divergenceIterations = config.getUnsigned("mcmc.divergence_iterations", 0u);
+	unsigned cores = config.getUnsigned("job.cores", 1u);
+	std::string prefix = config.getString("output.prefix", "ribModel");
+	std::string format = config.getString("output.format", "csv");
+	unsigned summarySamples = config.getUnsigned("output.summary_samples", samples / 2u);
+	unsigned posteriorSamples = config.getUnsigned("crossvalidation.posterior_samples", summarySamples);
+	unsigned numRuns = method == "bootstrap" ? replicates : numFolds;
+	unsigned concurrentRuns = config.getUnsigned("crossvalidation.concurrent_runs", std::min(numRuns, cores));
+	if (config.hasError()) return runnerDataError;
+
+	unsigned numGenes = genome.getGenomeSize();
+	std::string error = "";
+	if (method != "kfold" && method != "bootstrap")
+		error = "Unknown crossvalidation.method " + method + ", use kfold or bootstrap";
+	else if (method == "kfold" && (numFolds < 2u || numFolds > numGenes))
+		error = "crossvalidation.folds must be at least 2 and at most the number of genes";
+	else if (numRuns == 0u || concurrentRuns == 0u)
+		error = "crossvalidation.replicates and concurrent_runs must be at least 1";
+	else if (!(quadratureStep > 0.0))
+		error = "crossvalidation.quadrature_step must be positive";
+	else if (cores == 0u || (format != "csv" && format != "tsv"))
+		error = "job.cores must be at least 1 and output.format csv or tsv";
+	else if (config.hasKey("parameter.restart_file"))
+		error = "parameter.restart_file can not be used for cross validation, every run starts from the settings";
+	if (!error.empty())
+	{
+		std::cerr << error << "\n";
+		return runnerDataError;
+	}
+	if (concurrentRuns > numRuns) concurrentRuns = numRuns;
+	if (summarySamples == 0u || summarySamples > samples) summarySamples = samples;
+	std::string separator = format == "csv" ? "," : "\t";
+
+	std::ofstream out;
+	if (!openOutput(out, prefix + ".crossValidation." + format)) return runnerCantCreate;
+	out.close();
+
+	std::uniform_int_distribution<unsigned> seedDistribution;
+	std::vector<std::vector<unsigned>> trainingGenes;
+	std::vector<std::vector<unsigned>> heldOutGenes;
+	if (method == "kfold")
+		CrossValidation::createFolds(numGenes, numFolds, seedDistribution(Parameter::generator), trainingGenes,
+			heldOutGenes);
+	else
+	{
+		trainingGenes.resize(numRuns);
+		heldOutGenes.resize(numRuns);
+		for (unsigned r = 0u; r < numRuns; r++)
+		{
+			CrossValidation::createBootstrapSample(numGenes, seedDistribution(Parameter::generator), trainingGenes[r],
+				heldOutGenes[r]);
+		}
+	}
+
+	// everything that reads the job file or draws from the main generator is set up before the runs start
+	int status = runnerOk;
+	std::vector<unsigned> seeds(numRuns);
+	std::vector<Genome> trainingGenomes(numRuns);
+	std::vector<Genome> heldOutGenomes(numRuns);
+	std::vector<MCMCAlgorithm*> mcmcs(numRuns, NULL);
+	std::vector<ParameterType*> parameters(numRuns, NULL);
+	for (unsigned r = 0u; r < numRuns && status == runnerOk; r++)
+	{
+		seeds[r] = seedDistribution(Parameter::generator);
+		trainingGenomes[r] = genome.getGenomeForGeneIndicies(trainingGenes[r]);
+		heldOutGenomes[r] = genome.getGenomeForGeneIndicies(heldOutGenes[r]);
+		mcmcs[r] = createJobMCMC(config, status);
+		if (mcmcs[r] == NULL) break;
+		// runs share the cores, pinning the threads of every run would work against each other
+		mcmcs[r]->setThreadAffinity("none");
+		mcmcs[r]->setProfiling(false, "");
+		parameters[r] = createJobParameter<ParameterType>(config, trainingGenomes[r], status, &trainingGenes[r]);
+	}
+	if (status != runnerOk)
+	{
+		for (unsigned r = 0u; r < numRuns; r++)
+		{
+			delete parameters[r];
+			delete mcmcs[r];
+		}
+		return status;
+	}
+
+	CrossValidation crossValidation(quadratureStep);
+	std::vector<std::vector<double>> predictiveLogLikelihoods(numRuns);
+	std::vector<int> runStatus(numRuns, runnerOk);
+	unsigned coresPerRun = std::max(1u, cores / concurrentRuns);
+	std::cout << "Cross validation: " << numRuns << " runs, " << concurrentRuns << " at a time with " << coresPerRun
+		<< " cores each\n";
+#ifndef __APPLE__
+	omp_set_max_active_levels(2);
+#pragma omp parallel for schedule(dynamic, 1) num_threads(concurrentRuns)
+#endif
+	for (int r = 0; r < (int)numRuns; r++)
+	{
+		Parameter::generator.seed(seeds[r]);
+		ModelType runModel(model);
+		runModel.setParameter(*parameters[r]);
+		try
+		{
+			mcmcs[r]->run(trainingGenomes[r], runModel, coresPerRun, divergenceIterations);
+			if (writeRuns)
+				runStatus[r] = writeJobOutput(prefix + ".run" + std::to_string(r + 1), separator, format,
+					trainingGenomes[r], *parameters[r], *mcmcs[r], modelName, summarySamples);
+			predictiveLogLikelihoods[r] = crossValidation.calculatePredictiveLogLikelihoods(heldOutGenomes[r], runModel,
+				*parameters[r], posteriorSamples);
+		}
+		catch (std::exception &e)
+		{
+#ifndef __APPLE__
+#pragma omp critical(runnerOutput)
+#endif
+			std::cerr << "Run " << r + 1 << " failed: " << e.what() << "\n";
+			runStatus[r] = runnerSoftwareError;
+		}
+		delete parameters[r];
+		delete mcmcs[r];
+		parameters[r] = NULL;
+		mcmcs[r] = NULL;
+	}
+
+	if (!openOutput(out, prefix + ".crossValidation." + format)) return runnerCantCreate;
+	std::ofstream geneOut;
+	if (!openOutput(geneOut, prefix + ".crossValidationGenes." + format)) return runnerCantCreate;
+	out << "run" << separator << "trainingGenes" << separator << "heldOutGenes" << separator << "predictiveLogLikelihood"
+		<< separator << "perGeneMean" << separator << "perGeneSd\n" << std::setprecision(12);
+	geneOut << "gene" << separator << "run" << separator << "predictiveLogLikelihood\n" << std::setprecision(12);
+
+	// the "all" row sums over every held-out gene of the successful runs, for k-fold that is every gene once
+	double totalSum = 0.0;
+	double totalSumOfSquares = 0.0;
+	unsigned totalCount = 0u;
+	for (unsigned r = 0u; r < numRuns; r++)
+	{
+		if (runStatus[r] == runnerSoftwareError)
+		{
+			status = runnerSoftwareError;
+			continue;
+		}
+		if (runStatus[r] != runnerOk && status == runnerOk) status = runStatus[r];
+		double sum = 0.0;
+		double sumOfSquares = 0.0;
+		unsigned count = (unsigned)predictiveLogLikelihoods[r].size();
+		for (unsigned i = 0u; i < count; i++)
+		{
+			double value = predictiveLogLikelihoods[r][i];
+			sum += value;
+			sumOfSquares += value * value;
+			geneOut << heldOutGenomes[r].getGene(i).getId() << separator << r + 1 << separator << value << "\n";
+		}
+		double mean = count == 0u ? std::numeric_limits<double>::quiet_NaN() : sum / count;
+		double sd = count < 2u ? std::numeric_limits<double>::quiet_NaN()
+			: std::sqrt(std::max(0.0, (sumOfSquares - sum * mean) / (count - 1u)));
+		out << r + 1 << separator << trainingGenes[r].size() << separator << count << separator << sum << separator << mean
+			<< separator << sd << "\n";
+		totalSum += sum;
+		totalSumOfSquares += sumOfSquares;
+		totalCount += count;
+	}
+	double totalMean = totalCount == 0u ? std::numeric_limits<double>::quiet_NaN() : totalSum / totalCount;
+	double totalSd = totalCount < 2u ? std::numeric_limits<double>::quiet_NaN()
+		: std::sqrt(std::max(0.0, (totalSumOfSquares - totalSum * totalMean) / (totalCount - 1u)));
+	out << "all" << separator << numGenes << separator << totalCount << separator << totalSum << separator << totalMean
+		<< separator << totalSd << "\n";
+	out.close();
+	geneOut.close();
+	std::cout << "Predictive log likelihood of " << totalCount << " held-out genes: " << totalSum << " (" << totalMean
+		<< " per gene)\n";
+	return status;
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc != 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " job.toml\n";
+		return runnerUsageError;
+	}
+
+	std::string jobFile = argv[1];
+	JobConfig config;
+	if (!fileExists(jobFile))
+	{
+		std::cerr << "Can not open job file " << jobFile << "\n";
+		return runnerNoInput;
+	}
+	if (!config.readFile(jobFile)) return reportConfigErrors(config, jobFile);
+
+	std::string modelName = config.getString("job.model", "ROC");
+	if (config.hasKey("job.seed"))
+	{
+		Parameter::generator.seed((unsigned)config.getInteger("job.seed"));
+	}
+	if (config.hasError()) return reportConfigErrors(config, jobFile);
+	if (modelName != "ROC" && modelName != "RFP" && modelName != "FONSE")
+	{
+		std::cerr << "Unknown job.model " << modelName << ", use ROC, RFP or FONSE\n";
+		return runnerDataError;
+	}
+
+	Genome genome;
+	int status = readJobGenome(config, modelName, genome);
+	if (status != runnerOk)
+	{
+		if (config.hasError()) reportConfigErrors(config, jobFile);
+		return status;
+	}
+
+	bool crossValidation = config.hasKey("crossvalidation.method");
+	if (modelName == "ROC")
+	{
+		ROCModel model(!config.getString("genome.observed_phi").empty());
+		status = crossValidation ? runCrossValidationJob<ROCParameter>(config, genome, model, modelName)
+			: runJob<ROCParameter>(config, genome, model, modelName);
+	}
+	else if (modelName == "RFP")
+	{
+		RFPModel model;
+		status = crossValidation ? runCrossValidationJob<RFPParameter>(config, genome, model, modelName)
+			: runJob<RFPParameter>(config, genome, model, modelName);
+	}
+	else
+	{
+		FONSEModel model;
+		status = crossValidation ? runCrossValidationJob<FONSEParameter>(config, genome, model, modelName)
+			: runJob<FONSEParameter>(config, genome, model, modelName);
+	}
+	if (config.hasError()) reportConfigErrors(config, jobFile);
+	return status;
+}
+#endif // RUNNER
+
+
+
+#ifdef BENCHMARK
+/* Benchmark suite on synthetic genomes. Build with
+ *   cd src && g++ -std=c++11 -O2 -fopenmp -DSTANDALONE -DBENCHMARK *.cpp -o ribModelBenchmark
+ * and run as ribModelBenchmark [benchmark.toml]; see inst/benchmark.toml for the settings and their defaults. For
+ * every combination of model, genome size and number of mixtures a genome is simulated with the model's
+ * simulateGenome, written and read back, and fit by a short MCMC run. The time of every step, the MCMC phase profile
+ * and the time of the posterior summary functions are written as JSON, so runs of different versions can be compared.
+ * With the same seed, settings and number of cores the synthetic genomes are identical between runs.
+*/
+#include "include/JobConfig.h"
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#ifndef __APPLE__
+#include <omp.h>
+#endif
+
+
+struct BenchmarkSettings
+{
+	unsigned samples;
+	unsigned thining;
+	unsigned adaptiveWidth;
+	unsigned summarySamples;
+	unsigned cores;
+	double medianLength; // codons
+	double lengthSd; // of the log length
+	unsigned minLength;
+	unsigned maxLength;
+	double stdDevSynthesisRate;
+	std::string prefix; // of the files written during the benchmark
+};
+
+
+double secondsSince(std::chrono::steady_clock::time_point start)
+{
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+
+/* generateTemplateGenome (NOT EXPOSED)
+ * Arguments: genome to fill, number of genes, benchmark settings
+ * Adds genes with uniformly drawn sense codons and log normal lengths (in codons, truncated to [minLength,
+ * maxLength]). simulateGenome only uses the amino acid sequence of these genes.
+*/
+void generateTemplateGenome(Genome &genome, unsigned numGenes, BenchmarkSettings &settings)
+{
+	std::lognormal_distribution<double> lengthDistribution(std::log(settings.medianLength), settings.lengthSd);
+	std::uniform_int_distribution<unsigned> codonDistribution(0u, 60u);
+	std::uniform_int_distribution<unsigned> stopDistribution(61u, 63u);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		double length = lengthDistribution(Parameter::generator);
+		unsigned numCodons = (unsigned)std::min((double)settings.maxLength, std::max((double)settings.minLength, length));
+		std::string seq = "ATG";
+		seq.reserve(3u * (numCodons + 2u));
+		for (unsigned j = 0u; j < numCodons; j++)
+		{
+			seq += SequenceSummary::codonArray[codonDistribution(Parameter::generator)];
+		}
+		seq += SequenceSummary::codonArray[stopDistribution(Parameter::generator)];
+		genome.addGene(Gene(seq, "gene" + std::to_string(i), "synthetic gene"));
+	}
+}
+
+
+/* writeCodonSpecificParameterFiles (NOT EXPOSED)
+ * Arguments: parameter, file prefix, number of categories, files to fill
+ * Draws codon specific parameters from N(0, 0.5) and writes one file per category in the format read by
+ * initMutationCategories and initSelectionCategories.
+*/
+void writeCodonSpecificParameterFiles(Parameter &parameter, std::string prefix, unsigned numCategories,
+		std::vector<std::string> &files)
+{
+	std::normal_distribution<double> distribution(0.0, 0.5);
+	std::vector<std::string> groupList = parameter.getGroupList();
+	files.resize(numCategories);
+	for (unsigned k = 0u; k < numCategories; k++)
+	{
+		files[k] = prefix + std::to_string(k) + ".csv";
+		std::ofstream out(files[k].c_str());
+		out << "AA,Codon,Value,Std_deviation\n";
+		for (unsigned g = 0u; g < groupList.size(); g++)
+		{
+			std::vector<std::string> codons = SequenceSummary::AAToCodon(groupList[g], true);
+			for (unsigned c = 0u; c < codons.size(); c++)
+			{
+				out << groupList[g] << "," << codons[c] << "," << distribution(Parameter::generator) << ",0\n";
+			}
+		}
+	}
+}
+
+
+void initBenchmarkParameter(ROCParameter &parameter, std::string prefix)
+{
+	std::vector<std::string> files;
+	writeCodonSpecificParameterFiles(parameter, prefix + ".mutation", parameter.getNumMutationCategories(), files);
+	parameter.initMutationCategories(files, parameter.getNumMutationCategories());
+	writeCodonSpecificParameterFiles(parameter, prefix + ".selection", parameter.getNumSelectionCategories(), files);
+	parameter.initSelectionCategories(files, parameter.getNumSelectionCategories());
+}
+
+
+void initBenchmarkParameter(FONSEParameter &parameter, std::string prefix)
+{
+	std::vector<std::string> files;
+	writeCodonSpecificParameterFiles(parameter, prefix + ".mutation", parameter.getNumMutationCategories(), files);
+	parameter.initMutationCategories(files, parameter.getNumMutationCategories());
+	writeCodonSpecificParameterFiles(parameter, prefix + ".selection", parameter.getNumSelectionCategories(), files);
+	parameter.initSelectionCategories(files, parameter.getNumSelectionCategories());
+}
+
+
+void initBenchmarkParameter(RFPParameter &/*parameter*/, std::string /*prefix*/)
+{
+	// the default alpha and lambda prime of 1 are kept
+}
+
+
+/* runBenchmarkCase (NOT EXPOSED)
+ * Arguments: settings, model name, number of genes, number of mixtures, stream to write the JSON object of the case to
+ * Genes are assigned to mixtures in turn. The MCMC run starts from a new parameter object with the same settings, so
+ * it does not start at the true values.
+*/
+template <class ParameterType, class ModelType>
+void runBenchmarkCase(BenchmarkSettings &settings, std::string modelName, unsigned numGenes, unsigned numMixtures,
+		std::ostream &json)
+{
+	std::string casePrefix = settings.prefix + "." + modelName + "." + std::to_string(numGenes) + "."
+		+ std::to_string(numMixtures);
+	std::vector<std::pair<std::string, double>> times;
+	std::chrono::steady_clock::time_point start;
+
+	start = std::chrono::steady_clock::now();
+	Genome templateGenome;
+	generateTemplateGenome(templateGenome, numGenes, settings);
+	times.push_back(std::make_pair("generateTemplateGenome", secondsSince(start)));
+
+	std::vector<unsigned> geneAssignment(numGenes);
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		geneAssignment[i] = i % numMixtures;
+	}
+	std::vector<double> stdDevSynthesisRate(numMixtures, settings.stdDevSynthesisRate);
+	std::vector<std::vector<unsigned>> mixtureDefinitionMatrix;
+
+	start = std::chrono::steady_clock::now();
+	ParameterType trueParameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true,
+		Parameter::allUnique);
+	initBenchmarkParameter(trueParameter, casePrefix);
+	trueParameter.InitializeSynthesisRate(templateGenome, settings.stdDevSynthesisRate);
+	ModelType simulationModel;
+	simulationModel.setParameter(trueParameter);
+	times.push_back(std::make_pair("initializeTrueParameter", secondsSince(start)));
+
+	start = std::chrono::steady_clock::now();
+	simulationModel.simulateGenome(templateGenome);
+	times.push_back(std::make_pair("simulateGenome", secondsSince(start)));
+
+	Genome simulatedGenome;
+	for (unsigned i = 0u; i < templateGenome.getGenomeSize(true); i++)
+	{
+		simulatedGenome.addGene(templateGenome.getGene(i, true));
+	}
+	templateGenome.clear();
+
+	Genome genome;
+	std::string genomeFile = casePrefix + (modelName == "RFP" ? ".rfp.csv" : ".fasta");
+	start = std::chrono::steady_clock::now();
+	if (modelName == "RFP")
+		simulatedGenome.writeRFPFile(genomeFile);
+	else
+		simulatedGenome.writeFasta(genomeFile);
+	times.push_back(std::make_pair(modelName == "RFP" ? "writeRFPFile" : "writeFasta", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	if (modelName == "RFP")
+		genome.readRFPFile(genomeFile);
+	else
+		genome.readFasta(genomeFile);
+	times.push_back(std::make_pair(modelName == "RFP" ? "readRFPFile" : "readFasta", secondsSince(start)));
+	simulatedGenome.clear();
+
+	start = std::chrono::steady_clock::now();
+	ParameterType parameter(stdDevSynthesisRate, numMixtures, geneAssignment, mixtureDefinitionMatrix, true,
+		Parameter::allUnique);
+	parameter.InitializeSynthesisRate(genome, settings.stdDevSynthesisRate);
+	ModelType model;
+	model.setParameter(parameter);
+	times.push_back(std::make_pair("initializeParameter", secondsSince(start)));
+
+	MCMCAlgorithm mcmc(settings.samples, settings.thining, settings.adaptiveWidth, true, true, true);
+	std::string profileFile = casePrefix + ".profile.json";
+	mcmc.setProfiling(true, profileFile);
+	start = std::chrono::steady_clock::now();
+	mcmc.run(genome, model, settings.cores, 0u);
+	times.push_back(std::make_pair("mcmc", secondsSince(start)));
+
+	std::string restartFile = casePrefix + ".restart";
+	start = std::chrono::steady_clock::now();
+	model.writeRestartFile(restartFile);
+	times.push_back(std::make_pair("writeRestartFile", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	ParameterType restartParameter(restartFile);
+	times.push_back(std::make_pair("readRestartFile", secondsSince(start)));
+
+	// posterior summaries, the checksum keeps the calls from being optimized away
+	std::vector<std::pair<std::string, double>> summaryTimes;
+	unsigned samples = std::min(settings.summarySamples, settings.samples);
+	double checksum = 0.0;
+	start = std::chrono::steady_clock::now();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		checksum += parameter.getEstimatedMixtureAssignment(samples, i);
+	}
+	summaryTimes.push_back(std::make_pair("getEstimatedMixtureAssignment", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		checksum += parameter.getEstimatedMixtureAssignmentProbabilities(samples, i)[0];
+	}
+	summaryTimes.push_back(std::make_pair("getEstimatedMixtureAssignmentProbabilities", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		checksum += parameter.getSynthesisRatePosteriorMean(samples, i, geneAssignment[i]);
+	}
+	summaryTimes.push_back(std::make_pair("getSynthesisRatePosteriorMean", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	for (unsigned i = 0u; i < numGenes; i++)
+	{
+		checksum += parameter.getSynthesisRateVariance(samples, i, geneAssignment[i]);
+	}
+	summaryTimes.push_back(std::make_pair("getSynthesisRateVariance", secondsSince(start)));
+
+	std::vector<std::string> codons;
+	std::vector<std::string> groupList = parameter.getGroupList();
+	for (unsigned g = 0u; g < groupList.size(); g++)
+	{
+		std::vector<std::string> groupCodons;
+		if (modelName == "RFP")
+			groupCodons.push_back(groupList[g]);
+		else
+			groupCodons = SequenceSummary::AAToCodon(groupList[g], true);
+		codons.insert(codons.end(), groupCodons.begin(), groupCodons.end());
+	}
+	bool withoutReference = modelName != "RFP";
+	std::vector<double> probs(1, 0.5);
+	start = std::chrono::steady_clock::now();
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		for (unsigned c = 0u; c < codons.size(); c++)
+		{
+			checksum += parameter.getCodonSpecificPosteriorMean(k, samples, codons[c], 0u, withoutReference);
+			checksum += parameter.getCodonSpecificPosteriorMean(k, samples, codons[c], 1u, withoutReference);
+		}
+	}
+	summaryTimes.push_back(std::make_pair("getCodonSpecificPosteriorMean", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		for (unsigned c = 0u; c < codons.size(); c++)
+		{
+			checksum += parameter.getCodonSpecificVariance(k, samples, codons[c], 0u, true, withoutReference);
+			checksum += parameter.getCodonSpecificVariance(k, samples, codons[c], 1u, true, withoutReference);
+		}
+	}
+	summaryTimes.push_back(std::make_pair("getCodonSpecificVariance", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		for (unsigned c = 0u; c < codons.size(); c++)
+		{
+			checksum += parameter.getCodonSpecificQuantile(k, samples, codons[c], 0u, probs, withoutReference)[0];
+			checksum += parameter.getCodonSpecificQuantile(k, samples, codons[c], 1u, probs, withoutReference)[0];
+		}
+	}
+	summaryTimes.push_back(std::make_pair("getCodonSpecificQuantile", secondsSince(start)));
+	start = std::chrono::steady_clock::now();
+	for (unsigned k = 0u; k < numMixtures; k++)
+	{
+		checksum += parameter.getStdDevSynthesisRatePosteriorMean(samples, k);
+	}
+	checksum += mcmc.getLogLikelihoodPosteriorMean(samples);
+	summaryTimes.push_back(std::make_pair("hyperParameterPosteriorMeans", secondsSince(start)));
+
+	unsigned numCodons = 0u;
+	for (unsigned i = 0u; i < genome.getGenomeSize(); i++)
+	{
+		numCodons += genome.getGene(i).getSequence().size() / 3u;
+	}
+
+	std::ifstream profile(profileFile.c_str());
+	std::string profileLine;
+	std::string profileJson;
+	while (std::getline(profile, profileLine))
+	{
+		profileJson += (profileJson.empty() ? "" : "\n      ") + profileLine;
+	}
+	if (profileJson.empty()) profileJson = "null";
+
+	json << std::setprecision(9);
+	json << "    {\n";
+	json << "      \"model\": \"" << modelName << "\",\n";
+	json << "      \"genes\": " << numGenes << ",\n";
+	json << "      \"codons\": " << numCodons << ",\n";
+	json << "      \"mixtures\": " << numMixtures << ",\n";
+	json << "      \"times\": {";
+	for (unsigned i = 0u; i < times.size(); i++)
+	{
+		json << (i > 0u ? ", " : "") << "\"" << times[i].first << "\": " << times[i].second;
+	}
+	json << "},\n";
+	json << "      \"summaryTimes\": {";
+	for (unsigned i = 0u; i < summaryTimes.size(); i++)
+	{
+		json << (i > 0u ? ", " : "") << "\"" << summaryTimes[i].first << "\": " << summaryTimes[i].second;
+	}
+	json << "},\n";
+	json << "      \"checksum\": " << (std::isfinite(checksum) ? checksum : 0.0) << ",\n";
+	json << "      \"mcmcProfile\": " << profileJson << "\n";
+	json << "    }";
+}
+
+
+int main(int argc, char *argv[])
+{
+	if (argc > 2)
+	{
+		std::cerr << "Usage: " << argv[0] << " [benchmark.toml]\n";
+		return 64;
+	}
+	JobConfig config;
+	if (argc == 2 && !config.readFile(argv[1]))
+	{
+		std::vector<std::string> errors = config.getErrors();
+		for (unsigned i = 0u; i < errors.size(); i++)
+		{
+			std::cerr << argv[1] << ": " << errors[i] << "\n";
+		}
+		return 65;
+	}
+
+	BenchmarkSettings settings;
+	std::vector<std::string> models = config.getStringArray("benchmark.models");
+	std::vector<double> genes = config.getDoubleArray("benchmark.genes");
+	std::vector<double> mixtures = config.getDoubleArray("benchmark.mixtures");
+	unsigned seed = config.getUnsigned("benchmark.seed", 1u);
+	std::string output = config.getString("benchmark.output", "benchmark.json");
+	settings.prefix = config.getString("benchmark.prefix", "benchmark");
+	settings.cores = config.getUnsigned("benchmark.cores", 1u);
+	settings.medianLength = config.getDouble("genome.median_length", 300.0);
+	settings.lengthSd = config.getDouble("genome.length_sd", 0.6);
+	settings.minLength = config.getUnsigned("genome.min_length", 50u);
+	settings.maxLength = config.getUnsigned("genome.max_length", 5000u);
+	settings.stdDevSynthesisRate = config.getDouble("genome.stddev_synthesis_rate", 1.0);
+	settings.samples = config.getUnsigned("mcmc.samples", 20u);
+	settings.thining = config.getUnsigned("mcmc.thinning", 5u);
+	settings.adaptiveWidth = config.getUnsigned("mcmc.adaptive_width", 10u);
+	settings.summarySamples = config.getUnsigned("mcmc.summary_samples", 10u);
+	if (models.empty())
+	{
+		models.push_back("ROC");
+		models.push_back("FONSE");
+		models.push_back("RFP");
+	}
+	if (genes.empty()) genes.push_back(1000.0);
+	if (mixtures.empty()) mixtures.push_back(1.0);
+	for (unsigned i = 0u; i < models.size(); i++)
+	{
+		if (models[i] != "ROC" && models[i] != "FONSE" && models[i] != "RFP")
+			std::cerr << "Unknown model " << models[i] << " in benchmark.models\n";
+	}
+	if (config.hasError() || settings.samples == 0u || settings.thining == 0u || settings.cores == 0u
+			|| settings.minLength == 0u || settings.minLength > settings.maxLength)
+	{
+		std::vector<std::string> errors = config.getErrors();
+		for (unsigned i = 0u; i < errors.size(); i++)
+		{
+			std::cerr << argv[1] << ": " << errors[i] << "\n";
+		}
+		std::cerr << "Invalid benchmark settings\n";
+		return 65;
+	}
+
+	std::ostringstream cases;
+	bool first = true;
+	for (unsigned m = 0u; m < models.size(); m++)
+	{
+		for (unsigned n = 0u; n < genes.size(); n++)
+		{
+			for (unsigned k = 0u; k < mixtures.size(); k++)
+			{
+				if (models[m] != "ROC" && models[m] != "FONSE" && models[m] != "RFP") continue;
+				unsigned numGenes = (unsigned)genes[n];
+				unsigned numMixtures = (unsigned)mixtures[k];
+				if (numGenes == 0u || numMixtures == 0u || numMixtures > numGenes) continue;
+
+				// every case starts from the same seed, so adding cases does not change the others
+				Parameter::generator.seed(seed);
+				std::cout << "Benchmark " << models[m] << " with " << numGenes << " genes and " << numMixtures
+					<< " mixtures\n";
+				if (!first) cases << ",\n";
+				first = false;
+				if (models[m] == "ROC")
+				{
+					runBenchmarkCase<ROCParameter, ROCModel>(settings, models[m], numGenes, numMixtures, cases);
+				}
+				else if (models[m] == "FONSE")
+				{
+					runBenchmarkCase<FONSEParameter, FONSEModel>(settings, models[m], numGenes, numMixtures, cases);
+				}
+				else
+				{
+					runBenchmarkCase<RFPParameter, RFPModel>(settings, models[m], numGenes, numMixtures, cases);
+				}
+			}
+		}
+	}
+
+	std::ofstream out(output.c_str());
+	if (!out)
+	{
+		std::cerr << "Can not write " << output << "\n";
+		return 73;
+	}
+	char date[32];
+	std::time_t now = std::time(NULL);
+	std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+	unsigned maxThreads = 1u;
+#ifndef __APPLE__
+	maxThreads = omp_get_max_threads();
+#endif
+	out << std::setprecision(9);
+	out << "{\n";
+	out << "  \"date\": \"" << date << "\",\n";
+	out << "  \"compiler\": \"" << __VERSION__ << "\",\n";
+	out << "  \"maxThreads\": " << maxThreads << ",\n";
+	out << "  \"settings\": {\"seed\": " << seed << ", \"cores\": " << settings.cores << ", \"samples\": "
+		<< settings.samples << ", \"thinning\": " << settings.thining << ", \"adaptiveWidth\": " << settings.adaptiveWidth
+		<< ", \"summarySamples\": " << settings.summarySamples << ", \"medianLength\": " << settings.medianLength
+		<< ", \"lengthSd\": " << settings.lengthSd << ", \"minLength\": " << settings.minLength << ", \"maxLength\": "
+		<< settings.maxLength << ", \"stdDevSynthesisRate\": " << settings.stdDevSynthesisRate << "},\n";
+	out << "  \"cases\": [\n" << cases.str() << "\n  ]\n";
+	out << "}\n";
+	std::cout << "Benchmark results written to " << output << "\n";
+	return 0;
+}
+#endif // BENCHMARK